@@ -0,0 +1,265 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+// 基准测试公共工具：基于阻塞套接字的 keep-alive 压测客户端
+
+struct LoadConfig {
+    std::string host = "127.0.0.1";  // IPv4、IPv6 或 "unix:/path"
+    int port = 9006;
+    int connections = 16;       // 并发连接数（每个连接一个线程）
+    int duration_ms = 2000;     // 压测时长
+    bool reconnect = false;     // 每个请求新建连接，模拟不复用上游连接的反向代理
+    std::string request = "GET /bench HTTP/1.1\r\nHost: localhost\r\n\r\n";
+};
+
+struct LoadResult {
+    uint64_t requests = 0;
+    uint64_t errors = 0;
+    double seconds = 0;
+    double rps = 0;
+    double p50_us = 0;
+    double p99_us = 0;
+};
+
+inline int bench_connect(const std::string& host, int port) {
+    sockaddr_storage addr{};
+    socklen_t addr_len;
+    if (host.compare(0, 5, "unix:") == 0) {
+        auto& un = reinterpret_cast<sockaddr_un&>(addr);
+        un.sun_family = AF_UNIX;
+        strncpy(un.sun_path, host.c_str() + 5, sizeof(un.sun_path) - 1);
+        addr_len = sizeof(un);
+    } else if (host.find(':') != std::string::npos) {
+        auto& in6 = reinterpret_cast<sockaddr_in6&>(addr);
+        in6.sin6_family = AF_INET6;
+        in6.sin6_port = htons(port);
+        inet_pton(AF_INET6, host.c_str(), &in6.sin6_addr);
+        addr_len = sizeof(in6);
+    } else {
+        auto& in = reinterpret_cast<sockaddr_in&>(addr);
+        in.sin_family = AF_INET;
+        in.sin_port = htons(port);
+        inet_pton(AF_INET, host.c_str(), &in.sin_addr);
+        addr_len = sizeof(in);
+    }
+    int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), addr_len) < 0) {
+        close(fd);
+        return -1;
+    }
+    if (addr.ss_family != AF_UNIX) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+inline bool bench_send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+// 从连接中读取一个完整响应（头部 + Content-Length 指定的响应体），多读的字节留在 pending 中
+inline bool bench_read_response(int fd, std::string& pending, std::string* response = nullptr) {
+    char buf[16384];
+    size_t header_end;
+    while ((header_end = pending.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            return false;
+        }
+        pending.append(buf, n);
+    }
+    size_t content_length = 0;
+    std::string head = pending.substr(0, header_end);
+    std::transform(head.begin(), head.end(), head.begin(), ::tolower);
+    size_t pos = head.find("\r\ncontent-length:");
+    if (pos != std::string::npos) {
+        content_length = std::strtoull(head.c_str() + pos + 17, nullptr, 10);
+    }
+    size_t total = header_end + 4 + content_length;
+    while (pending.size() < total) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            return false;
+        }
+        pending.append(buf, n);
+    }
+    if (response) {
+        response->assign(pending, 0, total);
+    }
+    pending.erase(0, total);
+    return true;
+}
+
+inline int64_t bench_monotonic_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+inline long bench_rss_kb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmRSS:") == 0) {
+            return std::atol(line.c_str() + 6);
+        }
+    }
+    return 0;
+}
+
+// 大量连接的基准测试需要把文件描述符上限提到硬上限
+inline void bench_raise_fd_limit() {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+inline double bench_percentile(std::vector<uint32_t>& samples, double p) {
+    if (samples.empty()) {
+        return 0;
+    }
+    size_t idx = static_cast<size_t>(p * (samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+    return samples[idx];
+}
+
+// 每个连接一个线程，循环发送请求并等待响应，统计吞吐和延迟分位数
+inline LoadResult run_load(const LoadConfig& config) {
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> errors{0};
+    std::vector<std::vector<uint32_t>> latencies(config.connections);
+    std::vector<std::thread> clients;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < config.connections; ++i) {
+        clients.emplace_back([&, i]() {
+            int fd = config.reconnect ? -1 : bench_connect(config.host, config.port);
+            std::string pending;
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto t0 = std::chrono::steady_clock::now();
+                if (config.reconnect) {
+                    // 建连耗时计入该请求的延迟
+                    fd = bench_connect(config.host, config.port);
+                    pending.clear();
+                }
+                if (fd < 0) {
+                    errors.fetch_add(1);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    fd = config.reconnect ? -1 : bench_connect(config.host, config.port);
+                    continue;
+                }
+                if (!bench_send_all(fd, config.request) || !bench_read_response(fd, pending)) {
+                    errors.fetch_add(1);
+                    close(fd);
+                    pending.clear();
+                    fd = config.reconnect ? -1 : bench_connect(config.host, config.port);
+                    continue;
+                }
+                auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - t0).count();
+                latencies[i].push_back(static_cast<uint32_t>(us));
+                requests.fetch_add(1, std::memory_order_relaxed);
+                if (config.reconnect) {
+                    close(fd);
+                    fd = -1;
+                }
+            }
+            if (fd >= 0) {
+                close(fd);
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(config.duration_ms));
+    stop.store(true);
+    for (auto& t : clients) {
+        t.join();
+    }
+
+    LoadResult result;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    result.requests = requests.load();
+    result.errors = errors.load();
+    result.rps = result.requests / result.seconds;
+
+    std::vector<uint32_t> all;
+    for (auto& v : latencies) {
+        all.insert(all.end(), v.begin(), v.end());
+    }
+    result.p50_us = bench_percentile(all, 0.50);
+    result.p99_us = bench_percentile(all, 0.99);
+    return result;
+}
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+#include <cstdlib>
+#include <new>
+
+// 微基准的分配计数：替换全局operator new，统计分配次数与字节数。替换函数不能声明为inline，
+// 因此只在定义了BENCH_COUNT_ALLOCATIONS后包含本头文件的那个翻译单元（基准程序本身）中生效
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_allocated_bytes{0};
+
+static void* bench_counted_alloc(size_t size, size_t alignment) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    size = size ? size : 1;
+    // aligned_alloc要求长度是对齐值的整数倍
+    void* p = alignment ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+                        : std::malloc(size);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new(size_t size) { return bench_counted_alloc(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) {
+    return bench_counted_alloc(size, static_cast<size_t>(alignment));
+}
+
+// 各种operator delete都交给free；GCC看到free释放operator new的结果会误报，这里两者已一起替换
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+#pragma GCC diagnostic pop
+#endif // BENCH_COUNT_ALLOCATIONS
+
+#endif // BENCH_COMMON_H
@@ -0,0 +1,86 @@
+#include "core/compression.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#ifdef XKOJ_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+// 响应压缩微基准：题目列表、榜单一类的JSON在不同压缩级别下的压缩率与耗时，
+// 并对比每次deflateInit/deflateEnd与复用每线程上下文（deflateReset）的单次开销
+// 用法: bench_compression [响应体字节数] [次数]
+
+#ifdef XKOJ_HAVE_ZLIB
+// 不复用上下文：每个响应分配并释放一次zlib状态
+static size_t compress_fresh(const std::string& in, int level, std::string& out) {
+    z_stream zs{};
+    deflateInit2(&zs, level, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY);
+    out.resize(deflateBound(&zs, in.size()) + 16);
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(in.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+    deflate(&zs, Z_FINISH);
+    out.resize(out.size() - zs.avail_out);
+    deflateEnd(&zs);
+    return out.size();
+}
+#endif
+
+int main(int argc, char* argv[]) {
+#ifdef XKOJ_HAVE_ZLIB
+    size_t size = argc > 1 ? std::atoi(argv[1]) : 64 * 1024;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+    std::string json = "{\"problems\":[";
+    for (int i = 0; json.size() < size; ++i) {
+        json += "{\"id\":" + std::to_string(1000 + i) + ",\"title\":\"Problem " + std::to_string(i) +
+                "\",\"tags\":[\"dp\",\"graph\"],\"accepted\":" + std::to_string(i * 37 % 9973) +
+                ",\"submitted\":" + std::to_string(i * 91 % 20011) + ",\"difficulty\":" + std::to_string(i % 5) + "},";
+    }
+    json += "{}]}";
+
+    std::cout << "body: " << json.size() << " bytes JSON, " << iterations << " iterations\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::string out;
+    for (int level : {1, 6, 9}) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            compression::compress(ContentCoding::GZIP, level, json, out);
+        }
+        double reused_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() /
+                           iterations;
+        size_t compressed = out.size();
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            compress_fresh(json, level, out);
+        }
+        double fresh_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() /
+                          iterations;
+        std::cout << "level " << level << ": " << compressed << " bytes (" << double(json.size()) / compressed
+                  << "x), reused context " << reused_us << " us, fresh context " << fresh_us << " us, "
+                  << json.size() / reused_us << " MB/s\n";
+    }
+
+    // 流式：每段同步刷新的额外开销
+    for (size_t piece : {512, 4096, 16384}) {
+        StreamCompressor stream(ContentCoding::GZIP, 6);
+        std::string streamed;
+        for (size_t offset = 0; offset < json.size(); offset += piece) {
+            stream.write(std::string_view(json).substr(offset, piece), streamed);
+        }
+        stream.write({}, streamed, true);
+        std::cout << "streaming " << piece << "-byte chunks: " << streamed.size() << " bytes ("
+                  << double(json.size()) / streamed.size() << "x)\n";
+    }
+    return 0;
+#else
+    (void)argc;
+    (void)argv;
+    std::cout << "built without zlib" << std::endl;
+    return 0;
+#endif
+}
@@ -0,0 +1,173 @@
+#include "core/connection_table.h"
+#include <iostream>
+#include <iomanip>
+#include <unordered_map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+
+// 连接查找争用基准：10k并发连接下，对比旧的 unordered_map + 互斥锁与fd下标连接表
+// 模拟一个Reactor分片：Reactor线程按事件查找连接并交给工作线程，工作线程偶尔关闭连接（随后fd被复用）。
+// 旧实现中工作线程同样在共享表上查找和删除；新实现中工作线程只提交待移除的句柄。
+
+struct FakeConnection {
+    int fd;
+    explicit FakeConnection(int f) : fd(f) {}
+};
+
+static constexpr int BASE_FD = 16;
+
+struct Result {
+    double reactor_ns = 0;   // Reactor线程每次事件查找的耗时
+    double worker_ns = 0;    // 工作线程每次操作的耗时
+};
+
+template<typename Reactor, typename Worker>
+static Result run(int workers, int duration_ms, Reactor&& reactor_step, Worker&& worker_step) {
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> worker_ops{0};
+    std::vector<std::thread> threads;
+    for (int w = 0; w < workers; ++w) {
+        threads.emplace_back([&, w]() {
+            std::mt19937 rng(w + 1);
+            uint64_t ops = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                worker_step(rng, ops);
+                ++ops;
+            }
+            worker_ops.fetch_add(ops);
+        });
+    }
+
+    std::mt19937 rng(0);
+    uint64_t reactor_ops = 0;
+    auto begin = std::chrono::steady_clock::now();
+    auto end = begin + std::chrono::milliseconds(duration_ms);
+    while (std::chrono::steady_clock::now() < end) {
+        for (int i = 0; i < 256; ++i) {
+            reactor_step(rng);
+        }
+        reactor_ops += 256;
+    }
+    stop.store(true);
+    for (auto& t : threads) {
+        t.join();
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+
+    Result result;
+    result.reactor_ns = ns / reactor_ops;
+    result.worker_ns = workers > 0 ? ns * workers / std::max<uint64_t>(1, worker_ops.load()) : 0;
+    return result;
+}
+
+static void print(const std::string& name, int workers, const Result& r) {
+    std::cout << std::left << std::setw(24) << name
+              << std::setw(10) << workers
+              << std::setw(18) << std::fixed << std::setprecision(1) << r.reactor_ns
+              << std::setw(18) << r.worker_ns << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int connections = argc > 1 ? std::atoi(argv[1]) : 10000;
+    int duration_ms = argc > 2 ? std::atoi(argv[2]) : 1000;
+    const int close_every = 100;  // 工作线程每处理100个事件关闭一个连接
+
+    std::cout << "connections: " << connections << std::endl;
+    std::cout << std::left << std::setw(24) << "table"
+              << std::setw(10) << "workers"
+              << std::setw(18) << "reactor ns/event"
+              << std::setw(18) << "worker ns/op" << std::endl;
+
+    for (int workers : {0, 1, 2, 4, 8}) {
+        // 旧实现：共享表由一把锁保护
+        {
+            std::unordered_map<int, std::shared_ptr<FakeConnection>> map;
+            std::mutex mutex;
+            for (int i = 0; i < connections; ++i) {
+                map[BASE_FD + i] = std::make_shared<FakeConnection>(BASE_FD + i);
+            }
+            std::vector<std::shared_ptr<FakeConnection>> sink(1);
+            Result r = run(workers, duration_ms,
+                [&](std::mt19937& rng) {
+                    int fd = BASE_FD + static_cast<int>(rng() % connections);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    auto it = map.find(fd);
+                    if (it != map.end()) {
+                        sink[0] = it->second;
+                    } else {
+                        // fd已被关闭，模拟accept复用该fd
+                        map[fd] = std::make_shared<FakeConnection>(fd);
+                    }
+                },
+                [&](std::mt19937& rng, uint64_t ops) {
+                    int fd = BASE_FD + static_cast<int>(rng() % connections);
+                    std::shared_ptr<FakeConnection> conn;
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (ops % close_every == 0) {
+                        map.erase(fd);
+                    } else {
+                        auto it = map.find(fd);
+                        if (it != map.end()) {
+                            conn = it->second;
+                        }
+                    }
+                });
+            print("mutex + unordered_map", workers, r);
+        }
+
+        // 新实现：连接表只由Reactor线程访问，工作线程关闭连接时只提交句柄
+        {
+            ConnectionTable<FakeConnection> table;
+            std::vector<uint64_t> handles(connections);
+            for (int i = 0; i < connections; ++i) {
+                handles[i] = table.insert(BASE_FD + i, std::make_shared<FakeConnection>(BASE_FD + i));
+            }
+            std::mutex released_mutex;
+            std::vector<uint64_t> released;
+            std::vector<uint64_t> drained;
+            std::vector<std::shared_ptr<FakeConnection>> sink(1);
+            uint64_t events = 0;
+            Result r = run(workers, duration_ms,
+                [&](std::mt19937& rng) {
+                    int index = static_cast<int>(rng() % connections);
+                    const auto& conn = table.find(handles[index]);
+                    if (conn) {
+                        sink[0] = conn;
+                    } else {
+                        handles[index] = table.insert(BASE_FD + index,
+                                                      std::make_shared<FakeConnection>(BASE_FD + index));
+                    }
+                    // 与事件循环一致：每批事件之后移除已关闭的连接
+                    if (++events % 64 == 0) {
+                        {
+                            std::lock_guard<std::mutex> lock(released_mutex);
+                            drained.swap(released);
+                        }
+                        for (uint64_t handle : drained) {
+                            table.remove(handle);
+                        }
+                        drained.clear();
+                    }
+                },
+                [&](std::mt19937& rng, uint64_t ops) {
+                    if (ops % close_every == 0) {
+                        int fd = BASE_FD + static_cast<int>(rng() % connections);
+                        // 工作线程持有的是连接对象本身，这里只需构造其句柄
+                        uint64_t handle = (1ULL << 32) | static_cast<uint32_t>(fd);
+                        std::lock_guard<std::mutex> lock(released_mutex);
+                        released.push_back(handle);
+                    } else {
+                        // 连接由Reactor随任务传入，工作线程不再查表
+                        (void)rng();
+                    }
+                });
+            print("ConnectionTable", workers, r);
+        }
+    }
+    return 0;
+}
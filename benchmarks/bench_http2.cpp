@@ -0,0 +1,141 @@
+#include "core/http_server.h"
+#include "core/http_request.h"
+#include "core/http_response.h"
+#include "core/http2.h"
+#include "bench_common.h"
+#include <iostream>
+#include <iomanip>
+
+// 页面加载扇出：一个页面引用若干小资源（题面图片、样式、脚本），分别用
+// 浏览器式的HTTP/1.1（每页新建最多6条keep-alive连接，每条连接上串行请求）
+// 和一条HTTP/2连接（全部请求一次发出，多路复用）取完全部资源，比较每页耗时与连接数。
+// 回环上没有网络往返时延，HTTP/2在真实网络上的优势只会更大。
+// 用法: bench_http2 [资源数] [资源大小] [页面数] [HTTP/1.1并行连接数]
+
+static double load_page_http1(int port, int assets, int parallel) {
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<int> next{0};
+    std::vector<std::thread> workers;
+    for (int c = 0; c < std::min(parallel, assets); ++c) {
+        workers.emplace_back([&] {
+            int fd = bench_connect("127.0.0.1", port);
+            std::string pending;
+            int i;
+            while (fd >= 0 && (i = next++) < assets) {
+                std::string request = "GET /asset?id=" + std::to_string(i) + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+                if (!bench_send_all(fd, request) || !bench_read_response(fd, pending)) {
+                    break;
+                }
+            }
+            if (fd >= 0) {
+                close(fd);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 连接前言、SETTINGS与全部请求一次写出，读到全部流结束为止
+static double load_page_http2(int port, int assets) {
+    auto start = std::chrono::steady_clock::now();
+    int fd = bench_connect("127.0.0.1", port);
+    if (fd < 0) {
+        return 0;
+    }
+    auto frame = [](std::string& out, uint8_t type, uint8_t flags, uint32_t id, const std::string& payload) {
+        http2::append_frame_header(out, static_cast<uint32_t>(payload.size()), type, flags, id);
+        out += payload;
+    };
+    // 与浏览器一样放大连接与流的接收窗口，响应体不受默认的64KB窗口限制
+    std::string out = http2::CONNECTION_PREFACE;
+    frame(out, http2::SETTINGS, 0, 0, std::string("\x00\x04\x00\x40\x00\x00", 6));
+    frame(out, http2::WINDOW_UPDATE, 0, 0, std::string("\x00\xff\x00\x00", 4));
+    HpackEncoder encoder;
+    for (int i = 0; i < assets; ++i) {
+        std::string block;
+        encoder.begin_block(block);
+        encoder.encode(":method", "GET", block);
+        encoder.encode(":scheme", "http", block);
+        encoder.encode(":path", "/asset?id=" + std::to_string(i), block, HpackEncoder::Indexing::NONE);
+        encoder.encode(":authority", "localhost", block);
+        frame(out, http2::HEADERS, http2::FLAG_END_HEADERS | http2::FLAG_END_STREAM, 2 * i + 1, block);
+    }
+    bench_send_all(fd, out);
+
+    std::string data;
+    char buf[65536];
+    int ended = 0;
+    while (ended < assets) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            break;
+        }
+        data.append(buf, n);
+        size_t pos = 0;
+        while (data.size() - pos >= http2::FRAME_HEADER_SIZE) {
+            auto header = http2::parse_frame_header(std::string_view(data).substr(pos));
+            if (data.size() - pos < http2::FRAME_HEADER_SIZE + header.length) {
+                break;
+            }
+            if ((header.type == http2::DATA || header.type == http2::HEADERS) &&
+                (header.flags & http2::FLAG_END_STREAM)) {
+                ++ended;
+            }
+            else if (header.type == http2::SETTINGS && !(header.flags & http2::FLAG_ACK)) {
+                std::string ack;
+                frame(ack, http2::SETTINGS, http2::FLAG_ACK, 0, "");
+                bench_send_all(fd, ack);
+            }
+            pos += http2::FRAME_HEADER_SIZE + header.length;
+        }
+        data.erase(0, pos);
+    }
+    close(fd);
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    int assets = argc > 1 ? std::atoi(argv[1]) : 60;
+    size_t asset_size = argc > 2 ? std::atoi(argv[2]) : 4096;
+    int pages = argc > 3 ? std::atoi(argv[3]) : 200;
+    int parallel = argc > 4 ? std::atoi(argv[4]) : 6;
+    const int port = 19420;
+
+    HttpServer::ServerConfig config;
+    config.port = port;
+    config.enable_logging = false;
+    config.http2_max_concurrent_streams = std::max<uint32_t>(100, assets);
+    HttpServer server(config);
+    const std::string body(asset_size, 'a');
+    server.get("/asset", [&body](const HttpRequest&, HttpResponse& res) {
+        res.set_header("Content-Type", "image/png");
+        res.set_body(body);
+    });
+    if (!server.start()) {
+        std::cerr << "Failed to start server" << std::endl;
+        return 1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::vector<uint32_t> http1_us;
+    std::vector<uint32_t> http2_us;
+    for (int i = 0; i < pages; ++i) {
+        http1_us.push_back(static_cast<uint32_t>(load_page_http1(port, assets, parallel)));
+        http2_us.push_back(static_cast<uint32_t>(load_page_http2(port, assets)));
+    }
+    uint64_t streams = server.stats().total_http2_streams.load();
+    server.stop();
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "page:               " << assets << " assets x " << asset_size << " bytes, " << pages << " loads\n"
+              << "HTTP/1.1 (us/page): p50=" << bench_percentile(http1_us, 0.5)
+              << " p99=" << bench_percentile(http1_us, 0.99) << "  (" << std::min(parallel, assets)
+              << " connections/page)\n"
+              << "HTTP/2   (us/page): p50=" << bench_percentile(http2_us, 0.5)
+              << " p99=" << bench_percentile(http2_us, 0.99) << "  (1 connection/page, "
+              << streams << " streams total)" << std::endl;
+    return 0;
+}
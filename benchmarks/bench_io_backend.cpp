@@ -0,0 +1,61 @@
+#include "core/http_server.h"
+#include "core/http_request.h"
+#include "core/http_response.h"
+#include "bench_common.h"
+#include <iostream>
+#include <iomanip>
+
+// I/O后端对比基准：相同负载下分别以epoll与io_uring运行，比较吞吐、延迟与每请求的系统调用数
+// 用法: bench_io_backend [reactor数] [并发连接数] [每轮时长ms]
+int main(int argc, char* argv[]) {
+    int reactors = argc > 1 ? std::atoi(argv[1]) : 1;
+    int connections = argc > 2 ? std::atoi(argv[2]) : 64;
+    int duration_ms = argc > 3 ? std::atoi(argv[3]) : 3000;
+
+    std::cout << std::left << std::setw(10) << "backend"
+              << std::setw(14) << "requests/s"
+              << std::setw(12) << "p50(us)"
+              << std::setw(12) << "p99(us)"
+              << std::setw(16) << "recv+send/req"
+              << std::setw(14) << "enters/req"
+              << "errors" << std::endl;
+
+    int port = 19200;
+    for (const char* backend : {"epoll", "io_uring"}) {
+        HttpServer::ServerConfig config;
+        config.port = ++port;
+        config.host = "127.0.0.1";
+        config.reactor_count = reactors;
+        config.io_backend = backend;
+        config.enable_logging = false;
+
+        HttpServer server(config);
+        server.get("/bench", [](const HttpRequest&, HttpResponse& res) {
+            res.text("ok");
+        });
+        if (!server.start()) {
+            std::cerr << "Failed to start server with " << backend << std::endl;
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        LoadConfig load;
+        load.port = config.port;
+        load.connections = connections;
+        load.duration_ms = duration_ms;
+        LoadResult result = run_load(load);
+
+        const auto& stats = server.stats();
+        double requests = std::max<uint64_t>(1, stats.total_requests.load());
+        double io_calls = stats.total_recv_calls.load() + stats.total_send_calls.load();
+        std::cout << std::left << std::setw(10) << backend
+                  << std::setw(14) << std::fixed << std::setprecision(0) << result.rps
+                  << std::setw(12) << result.p50_us
+                  << std::setw(12) << result.p99_us
+                  << std::setw(16) << std::setprecision(2) << io_calls / requests
+                  << std::setw(14) << stats.total_ring_enters.load() / requests
+                  << result.errors << std::endl;
+        server.stop();
+    }
+    return 0;
+}
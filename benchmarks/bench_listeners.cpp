@@ -0,0 +1,75 @@
+#include "core/http_server.h"
+#include "core/http_request.h"
+#include "core/http_response.h"
+#include "bench_common.h"
+#include <iostream>
+#include <iomanip>
+
+// 反向代理一跳的监听方式对比：IPv4回环、IPv6回环、Unix域套接字，
+// 分别测量复用连接与每请求新建连接（代理不保持上游长连接）两种情况
+// 用法: bench_listeners [并发连接数] [每轮时长ms]
+int main(int argc, char* argv[]) {
+    int connections = argc > 1 ? std::atoi(argv[1]) : 16;
+    int duration_ms = argc > 2 ? std::atoi(argv[2]) : 2000;
+    const std::string unix_path = "/tmp/xkoj_bench_listeners.sock";
+
+    HttpServer::ServerConfig config;
+    config.port = 19300;
+    config.enable_logging = false;
+    HttpServer::ListenerConfig ipv4;
+    ipv4.address = "127.0.0.1";
+    HttpServer::ListenerConfig ipv6;
+    ipv6.address = "::1";
+    ipv6.port = 19301;
+    HttpServer::ListenerConfig local;
+    local.address = "unix:" + unix_path;
+    config.listeners = {ipv4, ipv6, local};
+
+    HttpServer server(config);
+    server.get("/bench", [](const HttpRequest&, HttpResponse& res) {
+        res.text("ok");
+    });
+    if (!server.start()) {
+        std::cerr << "Failed to start server" << std::endl;
+        return 1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::cout << std::left << std::setw(12) << "listener"
+              << std::setw(12) << "mode"
+              << std::setw(14) << "requests/s"
+              << std::setw(12) << "p50(us)"
+              << std::setw(12) << "p99(us)"
+              << "errors" << std::endl;
+
+    struct Target {
+        const char* name;
+        std::string host;
+        int port;
+    };
+    const Target targets[] = {
+        {"tcp4", "127.0.0.1", config.port},
+        {"tcp6", "::1", ipv6.port},
+        {"unix", "unix:" + unix_path, 0},
+    };
+    for (bool reconnect : {false, true}) {
+        for (const auto& target : targets) {
+            LoadConfig load;
+            load.host = target.host;
+            load.port = target.port;
+            load.connections = connections;
+            load.duration_ms = duration_ms;
+            load.reconnect = reconnect;
+            LoadResult result = run_load(load);
+
+            std::cout << std::left << std::setw(12) << target.name
+                      << std::setw(12) << (reconnect ? "reconnect" : "keep-alive")
+                      << std::setw(14) << std::fixed << std::setprecision(0) << result.rps
+                      << std::setw(12) << result.p50_us
+                      << std::setw(12) << result.p99_us
+                      << result.errors << std::endl;
+        }
+    }
+    server.stop();
+    return 0;
+}
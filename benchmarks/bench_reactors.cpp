@@ -0,0 +1,58 @@
+#include "core/http_server.h"
+#include "core/http_request.h"
+#include "core/http_response.h"
+#include "bench_common.h"
+#include <iostream>
+#include <iomanip>
+
+// 多Reactor扩展性基准：随Reactor数量增加测量每秒请求数
+// 用法: bench_reactors [最大reactor数] [并发连接数] [每轮时长ms]
+int main(int argc, char* argv[]) {
+    int max_reactors = argc > 1 ? std::atoi(argv[1]) : std::thread::hardware_concurrency();
+    int connections = argc > 2 ? std::atoi(argv[2]) : 64;
+    int duration_ms = argc > 3 ? std::atoi(argv[3]) : 3000;
+    max_reactors = std::max(1, max_reactors);
+
+    std::cout << std::left << std::setw(10) << "reactors"
+              << std::setw(14) << "requests/s"
+              << std::setw(12) << "p50(us)"
+              << std::setw(12) << "p99(us)"
+              << "errors" << std::endl;
+
+    int port = 19100;
+    for (int reactors = 1; reactors <= max_reactors; reactors *= 2) {
+        HttpServer::ServerConfig config;
+        config.port = ++port;
+        config.host = "127.0.0.1";
+        config.reactor_count = reactors;
+        config.enable_logging = false;
+
+        HttpServer server(config);
+        server.get("/bench", [](const HttpRequest&, HttpResponse& res) {
+            res.text("ok");
+        });
+        if (!server.start()) {
+            std::cerr << "Failed to start server with " << reactors << " reactors" << std::endl;
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        LoadConfig load;
+        load.port = config.port;
+        load.connections = connections;
+        load.duration_ms = duration_ms;
+        LoadResult result = run_load(load);
+
+        std::cout << std::left << std::setw(10) << reactors
+                  << std::setw(14) << std::fixed << std::setprecision(0) << result.rps
+                  << std::setw(12) << result.p50_us
+                  << std::setw(12) << result.p99_us
+                  << result.errors << std::endl;
+        server.stop();
+
+        if (reactors < max_reactors && reactors * 2 > max_reactors) {
+            reactors = max_reactors / 2;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "core/http_server.h"
+#include "core/http_response.h"
+#define BENCH_COUNT_ALLOCATIONS
+#include "bench_common.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/uio.h>
+
+// 响应序列化微基准：对比旧的 ostringstream 拼接 + write 与分散写出（writev）路径
+// 每种响应体大小下统计单个响应的耗时和堆上复制的字节数
+
+// 旧版 HttpResponse::to_string 的实现
+static std::string legacy_to_string(const HttpResponse& response) {
+    std::ostringstream out;
+    out << response.status_line();
+    for (const auto& [key, value] : response.headers()) {
+        std::string header_name = key;
+        bool capitalize_next = true;
+        for (char& c : header_name) {
+            if (capitalize_next) {
+                c = std::toupper(c);
+                capitalize_next = false;
+            } else if (c == '-') {
+                capitalize_next = true;
+            }
+        }
+        out << header_name << ": " << value << "\r\n";
+    }
+    out << response.render_cookies();
+    out << "\r\n";
+    out << response.body();
+    return out.str();
+}
+
+static void fill_response(HttpResponse& response, std::string&& body) {
+    response.set_header("Server", "XKOJ/1.0");
+    response.set_header("Date", "Sat, 17 Oct 2026 00:00:00 GMT");
+    response.set_header("Connection", "keep-alive");
+    response.set_header("Keep-Alive", "timeout=5");
+    response.set_cookie(HttpResponse::Cookie("session", "2f7c1e9a0b7d4c39a1f0"));
+    response.json(std::move(body));
+}
+
+template<typename F>
+static void run_case(const std::string& name, size_t body_size, int iterations, F&& fn) {
+    fn();
+    uint64_t bytes_before = g_allocated_bytes.load();
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    uint64_t bytes = g_allocated_bytes.load() - bytes_before;
+
+    std::cout << std::left << std::setw(12) << body_size
+              << std::setw(12) << name
+              << std::setw(14) << std::fixed << std::setprecision(0) << ns / iterations
+              << std::setw(18) << bytes / iterations << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+    int sink = open("/dev/null", O_WRONLY);
+
+    std::cout << std::left << std::setw(12) << "body"
+              << std::setw(12) << "path"
+              << std::setw(14) << "ns/response"
+              << std::setw(18) << "heap bytes/resp" << std::endl;
+
+    for (size_t body_size : {64UL, 4096UL, 262144UL, 4194304UL}) {
+        const std::string payload(body_size, 'x');
+        int n = body_size > 65536 ? std::max(1, iterations / 20) : iterations;
+
+        // 两条路径都包含处理器生成响应体的那一次复制
+        run_case("legacy", body_size, n, [&]() {
+            HttpResponse response;
+            fill_response(response, std::string(payload));
+            std::string wire = legacy_to_string(response);
+            ssize_t ignored = write(sink, wire.data(), wire.size());
+            (void)ignored;
+        });
+
+        run_case("writev", body_size, n, [&]() {
+            HttpResponse response;
+            fill_response(response, std::string(payload));
+            const std::string& status_line = response.status_line();
+            std::string headers = response.render_headers();
+            std::string cookies = response.render_cookies();
+            std::string body = response.take_body();
+            struct iovec iov[5] = {
+                {const_cast<char*>(status_line.data()), status_line.size()},
+                {headers.data(), headers.size()},
+                {cookies.data(), cookies.size()},
+                {const_cast<char*>("\r\n"), 2},
+                {body.data(), body.size()},
+            };
+            ssize_t ignored = writev(sink, iov, 5);
+            (void)ignored;
+        });
+    }
+
+    close(sink);
+    return 0;
+}
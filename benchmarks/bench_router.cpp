@@ -0,0 +1,128 @@
+#include "core/http_server.h"
+#include "core/http_request.h"
+#include "core/router.h"
+#define BENCH_COUNT_ALLOCATIONS
+#include "bench_common.h"
+#include <iostream>
+#include <iomanip>
+#include <regex>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+
+// 路由匹配微基准：500条OJ风格的路由下，对比旧的逐条std::regex_match与radix tree，
+// 统计每次匹配的耗时与内存分配次数（含路径参数的提取）
+// 用法: bench_router [路由数] [次数]
+
+// 旧版 Route::compile_path：:name替换为捕获组，逐条按注册顺序匹配
+struct RegexRoute {
+    HttpMethod method;
+    std::regex pattern;
+    std::vector<std::string> param_names;
+};
+
+static RegexRoute compile_regex_route(HttpMethod method, const std::string& path) {
+    RegexRoute route{method, std::regex(), {}};
+    std::regex param_regex(R"(:([a-zA-Z_][a-zA-Z0-9_]*))");
+    for (std::sregex_iterator it(path.begin(), path.end(), param_regex), end; it != end; ++it) {
+        route.param_names.push_back(it->str(1));
+    }
+    std::string pattern = std::regex_replace(path, std::regex(R"(\.)"), R"(\.)");
+    pattern = std::regex_replace(pattern, std::regex(R"(\*)"), R"(.*)");
+    pattern = std::regex_replace(pattern, param_regex, R"(([^/]+))");
+    route.pattern = std::regex("^" + pattern + "$");
+    return route;
+}
+
+int main(int argc, char* argv[]) {
+    size_t route_count = argc > 1 ? std::atoi(argv[1]) : 500;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 20000;
+
+    // 资源 × 操作生成路由，方法分布与OJ接口相近
+    const char* resources[] = {"users", "problems", "submissions", "contests", "blogs", "discussions",
+                               "groups", "tags", "solutions", "announcements"};
+    const char* actions[] = {"", "/:id", "/:id/stats", "/:id/comments", "/:id/comments/:cid", "/search",
+                             "/recent", "/:id/like", "/:id/history", "/export"};
+    std::vector<std::pair<HttpMethod, std::string>> patterns;
+    for (int version = 1; patterns.size() < route_count; ++version) {
+        for (const char* resource : resources) {
+            for (const char* action : actions) {
+                std::string path = "/api/v" + std::to_string(version) + "/" + resource + action;
+                patterns.emplace_back(HttpMethod::GET, path);
+                if (action[0] == '\0' || std::string(action) == "/:id") {
+                    patterns.emplace_back(HttpMethod::POST, path);
+                }
+            }
+        }
+    }
+    patterns.resize(route_count);
+
+    std::vector<RegexRoute> regex_routes;
+    std::vector<std::unique_ptr<Route>> routes;
+    Router router;
+    for (const auto& [method, path] : patterns) {
+        regex_routes.push_back(compile_regex_route(method, path));
+        routes.push_back(std::make_unique<Route>(method, path, [](const HttpRequest&, HttpResponse&) {}));
+        router.add(method, path, routes.back().get());
+    }
+    std::string last_version = patterns.back().second.substr(5, patterns.back().second.find('/', 5) - 5);
+
+    // 靠前、居中、靠后注册的路由与未命中的路径
+    const std::vector<std::pair<std::string, std::string>> cases = {
+        {"first (static)", "/api/v1/users"},
+        {"early (1 param)", "/api/v1/problems/1001"},
+        {"middle (2 params)", "/api/v3/contests/12/comments/345"},
+        {"last registered", "/api/" + last_version + "/users/42/stats"},
+        {"miss", "/api/v1/unknown/path"},
+    };
+
+    std::cout << route_count << " routes" << std::endl;
+    std::cout << std::left << std::setw(20) << "path"
+              << std::setw(16) << "regex ns"
+              << std::setw(16) << "radix ns"
+              << std::setw(14) << "speedup"
+              << std::setw(16) << "regex allocs"
+              << "radix allocs" << std::endl;
+    for (const auto& [name, path] : cases) {
+        size_t matched_regex = 0;
+        uint64_t allocs = g_allocations.load();
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            std::smatch matches;
+            for (const auto& route : regex_routes) {
+                if (route.method == HttpMethod::GET && std::regex_match(path, matches, route.pattern)) {
+                    matched_regex += matches.size();
+                    break;
+                }
+            }
+        }
+        double regex_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() /
+                          iterations;
+        double regex_allocs = double(g_allocations.load() - allocs) / iterations;
+
+        size_t matched_radix = 0;
+        allocs = g_allocations.load();
+        begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations * 10; ++i) {
+            RouteParams params;
+            if (router.find(HttpMethod::GET, path, params)) {
+                matched_radix += params.count + 1;
+            }
+        }
+        double radix_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() /
+                          (iterations * 10.0);
+        double radix_allocs = double(g_allocations.load() - allocs) / (iterations * 10.0);
+
+        std::cout << std::left << std::setw(20) << name
+                  << std::setw(16) << std::fixed << std::setprecision(0) << regex_ns
+                  << std::setw(16) << std::setprecision(1) << radix_ns
+                  << std::setw(14) << std::setprecision(0) << regex_ns / radix_ns
+                  << std::setw(16) << std::setprecision(1) << regex_allocs
+                  << radix_allocs << std::endl;
+        if ((matched_regex == 0) != (matched_radix == 0)) {
+            std::cerr << "mismatch on " << path << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
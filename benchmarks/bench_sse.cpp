@@ -0,0 +1,188 @@
+#include "core/http_server.h"
+#include "core/http_request.h"
+#include "core/http_response.h"
+#include "core/event_channel.h"
+#include "bench_common.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+
+// SSE广播：大量空闲订阅者时服务器的内存占用与一次publish送达全部订阅者的延迟。
+// 订阅者由fork出的子进程以epoll持有（单进程文件描述符上限不足以同时容纳两端），
+// 事件内容携带发布时的CLOCK_MONOTONIC时间戳，子进程收到时计算延迟并经管道回报。
+// 用法: bench_sse [订阅者数] [事件数] [事件大小] [发布间隔ms]
+
+// 子进程：建立全部订阅后通知父进程，接收到expected个事件或超时后回报延迟分布
+static int run_subscribers(int port, int subscribers, uint64_t expected, int ready_fd, int result_fd) {
+    int epfd = epoll_create1(0);
+    std::unordered_map<int, std::string> buffers;
+    const std::string request = "GET /events HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    int connected = 0;
+    for (int i = 0; i < subscribers; ++i) {
+        int fd = bench_connect("127.0.0.1", port);
+        if (fd < 0 || !bench_send_all(fd, request)) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            continue;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+        buffers[fd];
+        ++connected;
+    }
+    ssize_t ignored = write(ready_fd, &connected, sizeof(connected));
+    (void)ignored;
+
+    std::vector<int64_t> latencies;
+    latencies.reserve(expected);
+    std::vector<epoll_event> events(1024);
+    char buf[65536];
+    int64_t deadline = bench_monotonic_ns() + 120LL * 1000000000LL;
+    while (latencies.size() < expected && bench_monotonic_ns() < deadline) {
+        int n = epoll_wait(epfd, events.data(), static_cast<int>(events.size()), 100);
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            std::string& data = buffers[fd];
+            ssize_t got;
+            while ((got = recv(fd, buf, sizeof(buf), 0)) > 0) {
+                data.append(buf, got);
+            }
+            int64_t now = bench_monotonic_ns();
+            if (got == 0) {
+                epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+            }
+            // 逐个取出完整的data行，首个字段为发布时间戳
+            size_t pos = 0;
+            size_t consumed = 0;
+            while ((pos = data.find("data: ", pos)) != std::string::npos) {
+                size_t end = data.find('\n', pos);
+                if (end == std::string::npos) {
+                    break;
+                }
+                latencies.push_back(now - std::atoll(data.c_str() + pos + 6));
+                pos = end + 1;
+                consumed = pos;
+            }
+            data.erase(0, consumed);
+        }
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) -> double {
+        if (latencies.empty()) {
+            return 0;
+        }
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(latencies.size() * p))] / 1000.0;
+    };
+    std::ostringstream out;
+    out << latencies.size() << ' ' << percentile(0.5) << ' ' << percentile(0.99) << ' ' << percentile(1.0);
+    std::string report = out.str();
+    ignored = write(result_fd, report.data(), report.size());
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int subscribers = argc > 1 ? std::atoi(argv[1]) : 10000;
+    int event_count = argc > 2 ? std::atoi(argv[2]) : 50;
+    size_t payload = argc > 3 ? std::atoi(argv[3]) : 64;
+    int interval_ms = argc > 4 ? std::atoi(argv[4]) : 100;
+    const int port = 19400;
+    bench_raise_fd_limit();
+
+    // 先fork再启动服务器线程
+    int ready_pipe[2];
+    int result_pipe[2];
+    if (pipe(ready_pipe) < 0 || pipe(result_pipe) < 0) {
+        return 1;
+    }
+    long rss_before = bench_rss_kb();
+    pid_t child = fork();
+    if (child == 0) {
+        close(ready_pipe[0]);
+        close(result_pipe[0]);
+        // 等待服务器就绪
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        _exit(run_subscribers(port, subscribers, static_cast<uint64_t>(subscribers) * event_count,
+                              ready_pipe[1], result_pipe[1]));
+    }
+    close(ready_pipe[1]);
+    close(result_pipe[1]);
+
+    HttpServer::ServerConfig config;
+    config.port = port;
+    config.enable_logging = false;
+    config.max_connections = subscribers + 64;
+    HttpServer server(config);
+    server.get("/events", [&server](const HttpRequest& req, HttpResponse& res) {
+        server.subscribe(req, res, server.event_channel("bench"));
+    });
+    auto channel = server.event_channel("bench");
+    if (!server.start()) {
+        std::cerr << "Failed to start server" << std::endl;
+        kill(child, SIGKILL);
+        return 1;
+    }
+    long rss_started = bench_rss_kb();
+
+    int connected = 0;
+    if (read(ready_pipe[0], &connected, sizeof(connected)) != sizeof(connected)) {
+        std::cerr << "Subscriber process failed" << std::endl;
+        server.stop();
+        return 1;
+    }
+    for (int i = 0; i < 3000 && channel->subscriber_count() < static_cast<size_t>(connected); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    size_t subscribed = channel->subscriber_count();
+    long rss_subscribed = bench_rss_kb();
+
+    std::vector<double> publish_us;
+    for (int i = 0; i < event_count; ++i) {
+        std::string data = std::to_string(bench_monotonic_ns()) + ' ';
+        if (data.size() < payload) {
+            data.append(payload - data.size(), 'x');
+        }
+        auto start = std::chrono::steady_clock::now();
+        channel->publish(data, "status");
+        publish_us.push_back(std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start).count());
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+    }
+
+    std::string report;
+    char buf[256];
+    ssize_t n;
+    while ((n = read(result_pipe[0], buf, sizeof(buf))) > 0) {
+        report.append(buf, n);
+    }
+    waitpid(child, nullptr, 0);
+    long rss_after = bench_rss_kb();
+    server.stop();
+
+    uint64_t received = 0;
+    double p50 = 0, p99 = 0, max = 0;
+    std::istringstream(report) >> received >> p50 >> p99 >> max;
+    std::sort(publish_us.begin(), publish_us.end());
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "subscribers:            " << subscribed << " / " << subscribers << "\n"
+              << "server RSS (KB):        before=" << rss_before << " started=" << rss_started
+              << " subscribed=" << rss_subscribed << " after=" << rss_after << "\n"
+              << "RSS per subscriber (B): "
+              << (subscribed ? (rss_subscribed - rss_started) * 1024.0 / subscribed : 0) << "\n"
+              << "events:                 " << event_count << " x " << payload << " bytes, "
+              << received << " deliveries received\n"
+              << "publish() (us):         p50=" << (publish_us.empty() ? 0 : publish_us[publish_us.size() / 2])
+              << " max=" << (publish_us.empty() ? 0 : publish_us.back()) << "\n"
+              << "delivery latency (us):  p50=" << p50 << " p99=" << p99 << " max=" << max << std::endl;
+    return 0;
+}
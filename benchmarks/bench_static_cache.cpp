@@ -0,0 +1,81 @@
+#include "core/http_server.h"
+#include "core/http_request.h"
+#include "core/http_response.h"
+#include "bench_common.h"
+#include <iostream>
+#include <iomanip>
+#include <sys/stat.h>
+
+// 静态文件缓存基准：同一组静态资源分别以sendfile（每次stat+open）与内存缓存发送，
+// 并比较携带Accept-Encoding: gzip时按请求压缩与使用预先生成的gzip变体
+// 用法: bench_static_cache [文件字节数] [并发连接数] [每轮时长ms]
+int main(int argc, char* argv[]) {
+    size_t size = argc > 1 ? std::atoi(argv[1]) : 16 * 1024;
+    int connections = argc > 2 ? std::atoi(argv[2]) : 32;
+    int duration_ms = argc > 3 ? std::atoi(argv[3]) : 2000;
+
+    char dir_template[] = "/tmp/xkoj_bench_static_XXXXXX";
+    std::string root = mkdtemp(dir_template);
+    std::string content;
+    for (int i = 0; content.size() < size; ++i) {
+        content += "function problem" + std::to_string(i) + "() { return " + std::to_string(i * 37 % 9973) + "; }\n";
+    }
+    content.resize(size);
+    {
+        std::ofstream out(root + "/app.js", std::ios::binary);
+        out << content;
+    }
+
+    std::cout << "file: " << content.size() << " bytes" << std::endl;
+    std::cout << std::left << std::setw(10) << "cache"
+              << std::setw(10) << "encoding"
+              << std::setw(14) << "requests/s"
+              << std::setw(12) << "p50(us)"
+              << std::setw(12) << "p99(us)"
+              << std::setw(10) << "hit%"
+              << "errors" << std::endl;
+
+    int port = 19440;
+    for (bool cached : {false, true}) {
+        HttpServer::ServerConfig config;
+        config.port = ++port;
+        config.host = "127.0.0.1";
+        config.enable_logging = false;
+        config.static_cache_bytes = cached ? 64 * 1024 * 1024 : 0;
+
+        HttpServer server(config);
+        server.static_files("/static", root);
+        if (!server.start()) {
+            std::cerr << "Failed to start server" << std::endl;
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        for (const char* encoding : {"identity", "gzip"}) {
+            LoadConfig load;
+            load.port = config.port;
+            load.connections = connections;
+            load.duration_ms = duration_ms;
+            load.request = std::string("GET /static/app.js HTTP/1.1\r\nHost: localhost\r\nAccept-Encoding: ") +
+                           encoding + "\r\n\r\n";
+            const auto& stats = server.static_cache().stats();
+            uint64_t hits = stats.hits.load();
+            uint64_t lookups = hits + stats.misses.load();
+            LoadResult result = run_load(load);
+            hits = stats.hits.load() - hits;
+            lookups = stats.hits.load() + stats.misses.load() - lookups;
+            std::cout << std::left << std::setw(10) << (cached ? "on" : "off")
+                      << std::setw(10) << encoding
+                      << std::setw(14) << std::fixed << std::setprecision(0) << result.rps
+                      << std::setw(12) << result.p50_us
+                      << std::setw(12) << result.p99_us
+                      << std::setw(10) << std::setprecision(1) << (lookups ? 100.0 * hits / lookups : 0)
+                      << result.errors << std::endl;
+        }
+        server.stop();
+    }
+
+    unlink((root + "/app.js").c_str());
+    rmdir(root.c_str());
+    return 0;
+}
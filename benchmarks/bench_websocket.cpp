@@ -0,0 +1,238 @@
+#include "core/http_server.h"
+#include "core/http_request.h"
+#include "core/http_response.h"
+#include "core/websocket.h"
+#include "bench_common.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+#include <mutex>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+// WebSocket广播：大量空闲连接时服务器的内存占用，以及一条消息扇出到全部连接的耗时与送达延迟。
+// 客户端由fork出的子进程以epoll持有；同一连接上的消息按序到达，第k个帧对应第k条消息，
+// 发布时间写在父子进程共享的内存中，消息内容可以压缩。
+// 用法: bench_websocket [连接数] [消息数] [消息大小] [发布间隔ms] [是否协商压缩0/1]
+
+// 子进程：完成全部握手后通知父进程，收到expected个帧或超时后回报延迟分布
+static int run_clients(int port, int clients, bool deflate, uint64_t expected,
+                       const std::atomic<int64_t>* published, int ready_fd, int result_fd) {
+    int epfd = epoll_create1(0);
+    struct Client {
+        std::string data;
+        size_t received = 0;
+        bool upgraded = false;
+    };
+    std::unordered_map<int, Client> states;
+    std::string request = "GET /ws HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n";
+    if (deflate) {
+        request += "Sec-WebSocket-Extensions: permessage-deflate\r\n";
+    }
+    request += "\r\n";
+    int connected = 0;
+    for (int i = 0; i < clients; ++i) {
+        int fd = bench_connect("127.0.0.1", port);
+        if (fd < 0 || !bench_send_all(fd, request)) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            continue;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+        states[fd];
+        ++connected;
+    }
+
+    std::vector<int64_t> latencies;
+    latencies.reserve(expected);
+    std::vector<epoll_event> events(1024);
+    char buf[65536];
+    WebSocketFrameParser parser(SIZE_MAX, false);
+    WebSocketFrameParser::Frame frame;
+    int upgraded = 0;
+    bool ready_sent = false;
+    int64_t deadline = bench_monotonic_ns() + 120LL * 1000000000LL;
+    while (latencies.size() < expected && bench_monotonic_ns() < deadline) {
+        int n = epoll_wait(epfd, events.data(), static_cast<int>(events.size()), 100);
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            Client& client = states[fd];
+            ssize_t got;
+            while ((got = recv(fd, buf, sizeof(buf), 0)) > 0) {
+                client.data.append(buf, got);
+            }
+            int64_t now = bench_monotonic_ns();
+            if (got == 0) {
+                epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+            }
+            if (!client.upgraded) {
+                size_t end = client.data.find("\r\n\r\n");
+                if (end == std::string::npos) {
+                    continue;
+                }
+                client.upgraded = true;
+                client.data.erase(0, end + 4);
+                ++upgraded;
+            }
+            size_t consumed = 0;
+            while (parser.parse(client.data, consumed, frame) == WebSocketFrameParser::Result::FRAME) {
+                client.data.erase(0, consumed);
+                latencies.push_back(now - published[client.received++].load());
+            }
+        }
+        if (!ready_sent && upgraded == connected) {
+            ssize_t ignored = write(ready_fd, &connected, sizeof(connected));
+            (void)ignored;
+            ready_sent = true;
+        }
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) -> double {
+        if (latencies.empty()) {
+            return 0;
+        }
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(latencies.size() * p))] / 1000.0;
+    };
+    std::ostringstream out;
+    out << latencies.size() << ' ' << percentile(0.5) << ' ' << percentile(0.99) << ' ' << percentile(1.0);
+    std::string report = out.str();
+    ssize_t ignored = write(result_fd, report.data(), report.size());
+    (void)ignored;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int clients = argc > 1 ? std::atoi(argv[1]) : 10000;
+    int message_count = argc > 2 ? std::atoi(argv[2]) : 50;
+    size_t payload = argc > 3 ? std::atoi(argv[3]) : 512;
+    int interval_ms = argc > 4 ? std::atoi(argv[4]) : 100;
+    bool deflate = argc > 5 ? std::atoi(argv[5]) != 0 : true;
+    const int port = 19410;
+    bench_raise_fd_limit();
+
+    // 发布时间表在fork前映射，父进程写入、子进程读取
+    auto* published = static_cast<std::atomic<int64_t>*>(
+        mmap(nullptr, sizeof(std::atomic<int64_t>) * message_count, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+    if (published == MAP_FAILED) {
+        return 1;
+    }
+    int ready_pipe[2];
+    int result_pipe[2];
+    if (pipe(ready_pipe) < 0 || pipe(result_pipe) < 0) {
+        return 1;
+    }
+    long rss_before = bench_rss_kb();
+    pid_t child = fork();
+    if (child == 0) {
+        close(ready_pipe[0]);
+        close(result_pipe[0]);
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        _exit(run_clients(port, clients, deflate, static_cast<uint64_t>(clients) * message_count,
+                          published, ready_pipe[1], result_pipe[1]));
+    }
+    close(ready_pipe[1]);
+    close(result_pipe[1]);
+
+    HttpServer::ServerConfig config;
+    config.port = port;
+    config.enable_logging = false;
+    config.max_connections = clients + 64;
+    HttpServer server(config);
+    std::mutex sockets_mutex;
+    std::vector<std::shared_ptr<WebSocket>> sockets;
+    server.websocket("/ws", [&](const HttpRequest&, const std::shared_ptr<WebSocket>& ws) {
+        std::lock_guard<std::mutex> lock(sockets_mutex);
+        sockets.push_back(ws);
+    });
+    if (!server.start()) {
+        std::cerr << "Failed to start server" << std::endl;
+        kill(child, SIGKILL);
+        return 1;
+    }
+    long rss_started = bench_rss_kb();
+
+    int connected = 0;
+    if (read(ready_pipe[0], &connected, sizeof(connected)) != sizeof(connected)) {
+        std::cerr << "Client process failed" << std::endl;
+        server.stop();
+        return 1;
+    }
+    // 101响应先于处理器返回写出，等待全部处理器登记完连接
+    std::vector<std::shared_ptr<WebSocket>> targets;
+    for (int i = 0; i < 3000 && targets.size() < static_cast<size_t>(connected); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::lock_guard<std::mutex> lock(sockets_mutex);
+        targets = sockets;
+    }
+    long rss_connected = bench_rss_kb();
+
+    // 榜单增量一类的JSON文本，压缩率接近真实消息
+    std::string body = "{\"type\":\"scoreboard\",\"rows\":[";
+    for (int rank = 1; body.size() < payload; ++rank) {
+        body += "{\"rank\":" + std::to_string(rank) + ",\"user\":\"team" + std::to_string(rank) +
+                "\",\"solved\":" + std::to_string(rank % 9) + ",\"penalty\":" + std::to_string(rank * 37) + "},";
+    }
+    body += "{}]}";
+
+    std::vector<double> prepare_us;
+    std::vector<double> fanout_us;
+    size_t frame_size = 0;
+    for (int i = 0; i < message_count; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        published[i].store(bench_monotonic_ns());
+        auto message = WebSocket::prepare(body);
+        auto prepared = std::chrono::steady_clock::now();
+        for (auto& ws : targets) {
+            ws->send(message);
+        }
+        auto done = std::chrono::steady_clock::now();
+        prepare_us.push_back(std::chrono::duration<double, std::micro>(prepared - start).count());
+        fanout_us.push_back(std::chrono::duration<double, std::micro>(done - prepared).count());
+        frame_size = deflate && message->deflated_frame ? message->deflated_frame->size() : message->frame->size();
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+    }
+
+    std::string report;
+    char buf[256];
+    ssize_t n;
+    while ((n = read(result_pipe[0], buf, sizeof(buf))) > 0) {
+        report.append(buf, n);
+    }
+    waitpid(child, nullptr, 0);
+    targets.clear();
+    server.stop();
+
+    uint64_t received = 0;
+    double p50 = 0, p99 = 0, max = 0;
+    std::istringstream(report) >> received >> p50 >> p99 >> max;
+    std::sort(prepare_us.begin(), prepare_us.end());
+    std::sort(fanout_us.begin(), fanout_us.end());
+    auto median = [](const std::vector<double>& v) { return v.empty() ? 0 : v[v.size() / 2]; };
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "connections:            " << connected << " / " << clients
+              << (deflate ? " (permessage-deflate)" : "") << "\n"
+              << "server RSS (KB):        before=" << rss_before << " started=" << rss_started
+              << " connected=" << rss_connected << "\n"
+              << "RSS per connection (B): "
+              << (connected ? (rss_connected - rss_started) * 1024.0 / connected : 0) << "\n"
+              << "messages:               " << message_count << " x " << body.size() << " bytes, frame "
+              << frame_size << " bytes, " << received << " frames received\n"
+              << "prepare() (us):         p50=" << median(prepare_us) << "\n"
+              << "fan-out (us):           p50=" << median(fanout_us)
+              << " max=" << (fanout_us.empty() ? 0 : fanout_us.back()) << "\n"
+              << "delivery latency (us):  p50=" << p50 << " p99=" << p99 << " max=" << max << std::endl;
+    return 0;
+}
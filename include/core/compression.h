@@ -0,0 +1,40 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+// 响应体压缩（gzip/deflate，需要zlib）
+// 缓冲响应用工作线程复用的上下文一次压缩完；流式响应各自持有一个上下文，
+// 每段数据同步刷新后写出，客户端不必等到响应结束才能解压。
+
+enum class ContentCoding { IDENTITY, GZIP, DEFLATE };
+
+namespace compression {
+// 按Accept-Encoding选择编码：q值最高者，相同时gzip优先；没有可用编码或不支持zlib时为IDENTITY
+ContentCoding negotiate(std::string_view accept_encoding);
+const char* coding_name(ContentCoding coding);
+// 文本、JSON、JavaScript、XML、SVG等值得压缩；图片、音视频、压缩包等已压缩的类型以及SSE事件流跳过
+bool compressible_type(std::string_view content_type);
+// 一次性压缩，使用当前线程的上下文；失败或结果不比输入小时返回false
+bool compress(ContentCoding coding, int level, std::string_view in, std::string& out);
+}
+
+class StreamCompressor {
+public:
+    StreamCompressor(ContentCoding coding, int level);
+    ~StreamCompressor();
+    StreamCompressor(const StreamCompressor&) = delete;
+    StreamCompressor& operator=(const StreamCompressor&) = delete;
+
+    bool ok() const;
+    // 压缩in追加到out并刷新到字节边界；finish时写出压缩流的结尾，之后不能再写
+    bool write(std::string_view in, std::string& out, bool finish = false);
+
+private:
+    struct State;
+    std::unique_ptr<State> state_;
+};
+
+#endif // COMPRESSION_H
@@ -0,0 +1,91 @@
+#ifndef CONNECTION_TABLE_H
+#define CONNECTION_TABLE_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+
+// 以fd为下标的连接表
+// fd是小而稠密的整数，直接用作数组下标；每个槽位带有代数计数器，句柄由代数和fd组成，
+// fd被新连接复用后旧句柄自动失效。只由拥有它的Reactor线程访问，查找无锁且无等待。
+template<typename T>
+class ConnectionTable {
+public:
+    using Handle = uint64_t;
+
+    explicit ConnectionTable(size_t initial_capacity = 1024) : slots_(initial_capacity) {}
+
+    static int fd_of(Handle handle) { return static_cast<int>(handle & 0xffffffffu); }
+    // 代数为0的句柄是直接登记的裸fd（如监听套接字），不属于任何连接
+    static bool is_raw_fd(Handle handle) { return (handle >> 32) == 0; }
+
+    // 登记新连接，返回其句柄（代数从1开始，句柄不会与裸fd相同）
+    Handle insert(int fd, std::shared_ptr<T> conn) {
+        size_t index = static_cast<size_t>(fd);
+        if (index >= slots_.size()) {
+            slots_.resize(std::max(index + 1, slots_.size() * 2));
+        }
+        Slot& slot = slots_[index];
+        if (++slot.generation == 0) {
+            slot.generation = 1;
+        }
+        if (!slot.conn) {
+            ++size_;
+        }
+        slot.conn = std::move(conn);
+        return (static_cast<Handle>(slot.generation) << 32) | static_cast<uint32_t>(fd);
+    }
+
+    // 句柄已失效（连接已移除或fd已被复用）时返回空
+    const std::shared_ptr<T>& find(Handle handle) const {
+        static const std::shared_ptr<T> empty;
+        size_t index = static_cast<size_t>(fd_of(handle));
+        if (index >= slots_.size()) {
+            return empty;
+        }
+        const Slot& slot = slots_[index];
+        return slot.generation == static_cast<uint32_t>(handle >> 32) ? slot.conn : empty;
+    }
+
+    // 仅当句柄仍有效时移除，旧连接的延迟移除不会影响复用同一fd的新连接
+    void remove(Handle handle) {
+        size_t index = static_cast<size_t>(fd_of(handle));
+        if (index < slots_.size() && slots_[index].conn &&
+            slots_[index].generation == static_cast<uint32_t>(handle >> 32)) {
+            slots_[index].conn.reset();
+            --size_;
+        }
+    }
+
+    template<typename F>
+    void for_each(F&& fn) {
+        for (auto& slot : slots_) {
+            if (slot.conn) {
+                fn(slot.conn);
+            }
+        }
+    }
+
+    void clear() {
+        for (auto& slot : slots_) {
+            slot.conn.reset();
+        }
+        size_ = 0;
+    }
+
+    size_t size() const { return size_; }
+
+private:
+    struct Slot {
+        uint32_t generation = 0;
+        std::shared_ptr<T> conn;
+    };
+
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+};
+
+#endif // CONNECTION_TABLE_H
@@ -0,0 +1,63 @@
+#ifndef EVENT_CHANNEL_H
+#define EVENT_CHANNEL_H
+
+#include "core/http_server.h"
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Server-Sent Events频道
+// 订阅连接在处理器返回后保持打开，不占用工作线程；publish把事件格式化一次，
+// 各订阅连接的输出队列共享同一份帧，由发布方线程直接写出（io_uring后端交给Reactor批量发送）。
+// 最近replay_capacity个事件保留在环形缓冲区中，断线重连时按Last-Event-ID补发。
+// 输出积压超过output_high_water_mark的订阅者被断开，由客户端带Last-Event-ID重连。
+// 线程安全；锁顺序为频道锁在前、连接的output_mutex在后。
+class EventChannel {
+public:
+    EventChannel(HttpServer& server, std::string name, size_t replay_capacity);
+
+    // 推送一个事件，返回分配的事件ID（从1开始递增）；data中的换行拆成多个data字段
+    uint64_t publish(std::string_view data, std::string_view event = {});
+    size_t subscriber_count() const;
+    uint64_t last_event_id() const;
+    const std::string& name() const { return name_; }
+    // 结束全部订阅的响应并关闭连接，此后的订阅照常加入
+    void close();
+
+private:
+    friend class HttpServer;
+    using Connection = HttpServer::Connection;
+
+    struct Event {
+        uint64_t id;
+        std::shared_ptr<const std::string> frame;          // 原始事件帧（HTTP/1.0按连接关闭界定）
+        std::shared_ptr<const std::string> chunked_frame;  // 加上分块长度与结尾的帧
+    };
+
+    struct Subscriber {
+        std::weak_ptr<Connection> conn;
+        uint64_t sequence;
+        bool chunked;
+        int64_t last_sent_ms;
+    };
+
+    HttpServer& server_;
+    std::string name_;
+    size_t replay_capacity_;
+    mutable std::mutex mutex_;
+    uint64_t next_id_ = 1;
+    std::deque<Event> replay_;
+    std::vector<Subscriber> subscribers_;
+
+    // 加入订阅并补发after_id之后的事件；resume为false时不补发
+    void add_subscriber(Connection& conn, uint64_t sequence, bool chunked, bool resume, uint64_t after_id);
+    // 空闲达到interval_ms的订阅者发送注释行，写失败的连接在此被发现并移除
+    void send_heartbeats(int64_t now, int64_t interval_ms);
+    // 调用方持有mutex_；返回false表示订阅者已失效，应从列表中移除
+    bool deliver(Subscriber& subscriber, HttpServer::OutputChunk chunk, int64_t now);
+};
+
+#endif // EVENT_CHANNEL_H
@@ -0,0 +1,91 @@
+#ifndef HPACK_H
+#define HPACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// HPACK头部压缩（RFC 7541）
+// 编码端与解码端各自维护动态表，两端必须按头部块在连接上的顺序依次处理，调用方负责串行化。
+
+struct HpackHeader {
+    std::string name;
+    std::string value;
+};
+
+// 动态表：新条目在前，条目大小按名称与值长度加32计算
+class HpackTable {
+public:
+    explicit HpackTable(size_t max_size = 4096) : max_size_(max_size) {}
+
+    void add(std::string name, std::string value);
+    void set_max_size(size_t max_size);
+    size_t max_size() const { return max_size_; }
+    size_t size() const { return size_; }
+    size_t count() const { return entries_.size(); }
+    // index从1开始，包含静态表的61个条目
+    const HpackHeader* get(size_t index) const;
+    // 返回完全匹配的索引，name_index为只匹配名称的索引；均为0表示未找到
+    size_t find(std::string_view name, std::string_view value, size_t& name_index) const;
+
+    static constexpr size_t STATIC_COUNT = 61;
+
+private:
+    size_t max_size_;
+    size_t size_ = 0;
+    std::deque<HpackHeader> entries_;
+
+    void evict(size_t needed);
+};
+
+class HpackDecoder {
+public:
+    enum class Result { OK, TOO_LARGE, ERROR };
+
+    // max_table_size为本端通告的SETTINGS_HEADER_TABLE_SIZE，对端的表大小更新不能超过它；
+    // 头部列表（按RFC 7540计算）超过max_list_size时仍完整解码以保持动态表同步，返回TOO_LARGE
+    explicit HpackDecoder(size_t max_table_size = 4096, size_t max_list_size = SIZE_MAX)
+        : table_(max_table_size), max_table_size_(max_table_size), max_list_size_(max_list_size) {}
+
+    // 解码一个完整的头部块；ERROR对应连接级COMPRESSION_ERROR
+    Result decode(std::string_view block, std::vector<HpackHeader>& headers);
+
+private:
+    HpackTable table_;
+    size_t max_table_size_;
+    size_t max_list_size_;
+};
+
+class HpackEncoder {
+public:
+    explicit HpackEncoder(size_t max_table_size = 4096) : table_(max_table_size) {}
+
+    enum class Indexing { INCREMENTAL, NONE, NEVER };
+
+    // 对端通过SETTINGS_HEADER_TABLE_SIZE限制本端动态表，在下一个头部块开头通告新大小
+    void set_max_table_size(size_t max_size);
+    // 每个头部块开始时调用
+    void begin_block(std::string& out);
+    // 名称必须为小写；完全匹配时输出索引，否则按indexing输出字面量，值用Huffman编码更短时使用
+    void encode(std::string_view name, std::string_view value, std::string& out,
+                Indexing indexing = Indexing::INCREMENTAL);
+
+private:
+    HpackTable table_;
+    size_t pending_table_size_ = SIZE_MAX;  // 待通告的表大小，SIZE_MAX表示没有
+    size_t min_table_size_ = SIZE_MAX;      // 两次头部块之间出现过的最小值，须先于最终值通告
+};
+
+namespace hpack {
+// 前缀整数：prefix_bits位前缀，first_byte的高位由调用方给出
+void encode_integer(uint64_t value, int prefix_bits, uint8_t first_byte, std::string& out);
+bool decode_integer(std::string_view in, size_t& pos, int prefix_bits, uint64_t& value);
+void huffman_encode(std::string_view in, std::string& out);
+size_t huffman_encoded_size(std::string_view in);
+bool huffman_decode(std::string_view in, std::string& out);
+}
+
+#endif // HPACK_H
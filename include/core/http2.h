@@ -0,0 +1,191 @@
+#ifndef HTTP2_H
+#define HTTP2_H
+
+#include "http_server.h"
+#include "http_request.h"
+#include "hpack.h"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <mutex>
+
+// HTTP/2明文（h2c，RFC 9113）：连接前言或Upgrade: h2c之后，连接上的字节按帧解析。
+// 持有连接的线程解析帧并维护流的接收状态，完整的请求作为流交给线程池，由原有的路由处理；
+// 各流的响应帧经连接输出队列按产生顺序写出。不支持服务器推送，PRIORITY帧被忽略
+
+namespace http2 {
+constexpr char CONNECTION_PREFACE[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr size_t PREFACE_SIZE = sizeof(CONNECTION_PREFACE) - 1;
+constexpr size_t FRAME_HEADER_SIZE = 9;
+constexpr uint32_t DEFAULT_WINDOW_SIZE = 65535;
+constexpr uint32_t MAX_WINDOW_SIZE = 0x7fffffff;
+constexpr uint32_t DEFAULT_MAX_FRAME_SIZE = 16384;
+constexpr uint32_t MAX_FRAME_SIZE_LIMIT = 16777215;
+
+enum FrameType : uint8_t {
+    DATA = 0x0,
+    HEADERS = 0x1,
+    PRIORITY = 0x2,
+    RST_STREAM = 0x3,
+    SETTINGS = 0x4,
+    PUSH_PROMISE = 0x5,
+    PING = 0x6,
+    GOAWAY = 0x7,
+    WINDOW_UPDATE = 0x8,
+    CONTINUATION = 0x9
+};
+
+enum FrameFlag : uint8_t {
+    FLAG_END_STREAM = 0x1,
+    FLAG_ACK = 0x1,
+    FLAG_END_HEADERS = 0x4,
+    FLAG_PADDED = 0x8,
+    FLAG_PRIORITY = 0x20
+};
+
+enum ErrorCode : uint32_t {
+    NO_ERROR = 0x0,
+    PROTOCOL_ERROR = 0x1,
+    INTERNAL_ERROR = 0x2,
+    FLOW_CONTROL_ERROR = 0x3,
+    SETTINGS_TIMEOUT = 0x4,
+    STREAM_CLOSED = 0x5,
+    FRAME_SIZE_ERROR = 0x6,
+    REFUSED_STREAM = 0x7,
+    CANCEL = 0x8,
+    COMPRESSION_ERROR = 0x9,
+    CONNECT_ERROR = 0xa,
+    ENHANCE_YOUR_CALM = 0xb,
+    INADEQUATE_SECURITY = 0xc,
+    HTTP_1_1_REQUIRED = 0xd
+};
+
+enum SettingId : uint16_t {
+    SETTINGS_HEADER_TABLE_SIZE = 0x1,
+    SETTINGS_ENABLE_PUSH = 0x2,
+    SETTINGS_MAX_CONCURRENT_STREAMS = 0x3,
+    SETTINGS_INITIAL_WINDOW_SIZE = 0x4,
+    SETTINGS_MAX_FRAME_SIZE = 0x5,
+    SETTINGS_MAX_HEADER_LIST_SIZE = 0x6
+};
+
+struct FrameHeader {
+    uint32_t length = 0;
+    uint8_t type = 0;
+    uint8_t flags = 0;
+    uint32_t stream_id = 0;
+};
+
+// in至少包含FRAME_HEADER_SIZE字节
+FrameHeader parse_frame_header(std::string_view in);
+void append_frame_header(std::string& out, uint32_t length, uint8_t type, uint8_t flags, uint32_t stream_id);
+}
+
+class Http2Session {
+public:
+    // 一个流：接收端字段只由持有者线程访问，发送端字段由mutex_保护
+    struct Stream {
+        uint32_t id = 0;
+        HttpRequest request;
+        std::string method;
+        std::string path;
+        std::string authority;
+        int64_t content_length = -1;
+        std::string body;
+        bool headers_done = false;      // 已收到请求头（之后的HEADERS只能是尾部）
+        bool request_complete = false;  // 对端已结束流
+        HttpStatus error_status = HttpStatus::OK;  // 请求过大时直接以此回复
+        int64_t recv_window = http2::DEFAULT_WINDOW_SIZE;
+        uint32_t recv_unacked = 0;
+
+        int64_t send_window = 0;
+        std::string pending;            // 超出流量控制窗口、尚未成帧的响应体
+        size_t pending_offset = 0;
+        std::shared_ptr<const FileBody> file;  // 文件响应体按窗口读入DATA帧
+        size_t file_sent = 0;
+        std::deque<BodyPart> parts;     // 多段响应体中尚未移入pending/file的部分
+        bool end_after_pending = false; // 待发送数据发完后结束流
+        bool end_sent = false;
+        bool closed = false;            // 已从流表移除（正常结束或被重置）
+    };
+
+    Http2Session(HttpServer& server, HttpServer::Connection& conn, uint64_t sequence);
+
+    // 持有者线程：应用Upgrade请求HTTP2-Settings头解码后的对端设置，发送101（Upgrade时）与本端SETTINGS；
+    // 对端设置无效时返回false，连接上什么都没有发送
+    bool start(bool upgrade, std::string_view client_settings);
+    // Upgrade时原请求成为1号流，请求已完整（对端半关闭）；收到对端前言与SETTINGS后才交给线程池，
+    // 响应按对端的设置发送，也不会在客户端切换协议前涌入大量数据
+    void open_upgrade_stream(HttpRequest&& request);
+    // 持有者线程：解析缓冲区中的完整帧并移除，请求完整的流加入ready；
+    // 返回false表示连接错误，GOAWAY已发出，写完后关闭连接
+    bool receive(std::string& buffer, std::vector<std::shared_ptr<Stream>>& ready);
+    // 工作线程：路由请求并发送响应
+    void handle_stream(const std::shared_ptr<Stream>& stream);
+    // 排空：通告GOAWAY，处理中的流结束后关闭连接
+    void go_away();
+
+    // 校验并解码HTTP2-Settings头（base64url），失败时返回false
+    static bool decode_settings_header(const std::string& value, std::string& payload);
+
+private:
+    class ResponseWriter;
+
+    HttpServer& server_;
+    HttpServer::Connection& conn_;
+    uint64_t sequence_;  // 所有帧写入同一序号，在连接输出队列中按enqueue顺序排列
+
+    // 接收端，只由持有者线程访问
+    bool preface_received_ = false;
+    bool settings_received_ = false;
+    HpackDecoder decoder_;
+    uint32_t continuation_stream_ = 0;  // 正在接收CONTINUATION的流，0表示没有
+    uint8_t continuation_flags_ = 0;
+    std::string header_block_;
+    int64_t conn_recv_window_ = http2::DEFAULT_WINDOW_SIZE;
+    uint32_t conn_recv_unacked_ = 0;
+    std::shared_ptr<Stream> upgrade_stream_;
+
+    // 发送端与流表
+    std::mutex mutex_;
+    std::unordered_map<uint32_t, std::shared_ptr<Stream>> streams_;
+    uint32_t last_stream_id_ = 0;
+    HpackEncoder encoder_;
+    int64_t conn_send_window_ = http2::DEFAULT_WINDOW_SIZE;
+    uint32_t peer_initial_window_ = http2::DEFAULT_WINDOW_SIZE;
+    uint32_t peer_max_frame_size_ = http2::DEFAULT_MAX_FRAME_SIZE;
+    bool goaway_sent_ = false;
+
+    // 接收端的帧处理，返回false表示连接错误
+    bool handle_frame(const http2::FrameHeader& header, std::string_view payload,
+                      std::string& control, std::vector<std::shared_ptr<Stream>>& ready);
+    bool handle_headers(const http2::FrameHeader& header, std::string_view payload,
+                        std::string& control, std::vector<std::shared_ptr<Stream>>& ready);
+    bool handle_header_block(uint32_t stream_id, uint8_t flags, std::string& control,
+                             std::vector<std::shared_ptr<Stream>>& ready);
+    bool handle_data(const http2::FrameHeader& header, std::string_view payload,
+                     std::string& control, std::vector<std::shared_ptr<Stream>>& ready);
+    bool apply_settings(std::string_view payload, uint32_t& error);
+    bool handle_window_update(const http2::FrameHeader& header, std::string_view payload, std::string& control);
+    void finish_request(const std::shared_ptr<Stream>& stream, std::vector<std::shared_ptr<Stream>>& ready);
+    bool fail(uint32_t error, std::string& control);
+    void reset_frame(uint32_t stream_id, uint32_t error, std::string& control);
+
+    // 发送端，调用方持有mutex_；帧在同一把锁内进入连接输出队列，头部块的HPACK状态与写出顺序一致
+    void send_response_locked(Stream& stream, HttpResponse& response, bool head);
+    void send_headers_locked(Stream& stream, HttpResponse& response, bool end_stream,
+                             std::vector<HttpServer::OutputChunk>& chunks);
+    void flush_stream_locked(Stream& stream, std::vector<HttpServer::OutputChunk>& chunks);
+    void reset_stream_locked(Stream& stream, uint32_t error);
+    void close_stream_locked(Stream& stream);
+    void flush_all_locked();
+    void send_locked(std::vector<HttpServer::OutputChunk>& chunks);
+    void close_after_flush();
+    size_t pending_bytes(const Stream& stream) const;
+    void open_stream_locked(const std::shared_ptr<Stream>& stream);
+};
+
+#endif // HTTP2_H
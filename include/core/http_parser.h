@@ -0,0 +1,149 @@
+#ifndef HTTP_PARSER_H
+#define HTTP_PARSER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+enum class HttpStatus;
+
+// 请求体解码器：按Content-Length或chunked分帧逐段取出请求体，可在任意字节边界暂停。
+// 取出的数据是指向输入的string_view，不复制；块扩展与trailer字段被忽略
+class BodyDecoder {
+public:
+    enum class Result { DATA, INCOMPLETE, DONE, ERROR };
+
+    void reset(uint64_t content_length);  // 定长请求体
+    void reset_chunked();
+
+    // 从in的开头解码：consumed为本次消费的字节数（含分块框架）；返回DATA时data为其中
+    // 一段请求体（指向in内部，至多max_data字节），INCOMPLETE表示in已全部消费、需要更多数据
+    Result decode(std::string_view in, size_t& consumed, std::string_view& data,
+                  size_t max_data = SIZE_MAX);
+
+    bool chunked() const { return chunked_; }
+    bool done() const { return state_ == State::DONE; }
+    uint64_t decoded_size() const { return decoded_size_; }
+
+private:
+    enum class State { DATA, SIZE, SIZE_EXT, SIZE_LF, DATA_CR, DATA_LF,
+                       TRAILER, TRAILER_LINE, TRAILER_LF, DONE, ERROR };
+
+    static constexpr size_t MAX_LINE_LENGTH = 4096;  // 块扩展、全部trailer各自的上限
+
+    State state_ = State::DONE;
+    bool chunked_ = false;
+    uint64_t remaining_ = 0;      // 当前块（或定长请求体）尚未取出的字节数
+    uint64_t decoded_size_ = 0;
+    size_t size_digits_ = 0;
+    size_t line_length_ = 0;
+
+    void start_chunk();
+    void end_size_line();
+};
+
+// 增量式HTTP/1.1请求解析器
+// 可在任意字节边界暂停并在更多数据到达后继续；解析结果均为指向调用方缓冲区的
+// string_view，不复制任何数据。缓冲区在两次parse之间可以增长或重新分配，
+// 但解析完成后的视图只在缓冲区下次修改前有效。
+class HttpParser {
+public:
+    // HEADERS仅在开启pause_after_headers时出现：请求头已完整、请求体尚未读取
+    enum class Result { INCOMPLETE, HEADERS, COMPLETE, ERROR };
+
+    struct Header {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    struct Limits {
+        size_t max_header_size = 8192;          // 请求行 + 头部
+        size_t max_request_size = 1024 * 1024;  // 请求体
+        size_t max_header_count = 100;
+    };
+
+    HttpParser();
+    explicit HttpParser(const Limits& limits);
+
+    // data 必须从当前请求的第一个字节开始，包含目前已接收的全部数据
+    Result parse(std::string_view data);
+
+    // 准备解析下一个请求（保留内部容器容量，避免重复分配）
+    void reset();
+    void set_limits(const Limits& limits) { limits_ = limits; }
+
+    // 带请求体的请求在请求头完整时先返回HEADERS，由调用方决定流式读取（stream_body）
+    // 还是再次parse继续缓冲；请求体大小限制在继续缓冲时才检查
+    void set_pause_after_headers(bool pause) { pause_after_headers_ = pause; }
+    // HEADERS之后调用：下次parse即返回COMPLETE，message_size只含请求头，
+    // 请求体由调用方用body_decoder()从后续字节中解出，不受max_request_size限制
+    void stream_body();
+    bool body_streaming() const { return streaming_; }
+    const BodyDecoder& body_decoder() const { return decoder_; }
+
+    // 解析结果（仅在parse返回COMPLETE后有效）
+    std::string_view method() const { return method_; }
+    std::string_view target() const { return target_; }
+    std::string_view path() const { return path_; }
+    std::string_view query() const { return query_; }
+    std::string_view version() const { return version_; }
+    std::string_view body() const { return body_; }  // chunked请求体为解码后的副本
+    const std::vector<Header>& headers() const { return headers_; }
+    std::string_view header(std::string_view name) const;  // 大小写不敏感
+    size_t content_length() const { return content_length_; }
+    bool chunked() const { return chunked_; }
+    bool reading_body() const { return state_ == State::BODY; }  // 请求头已完整，等待请求体
+    bool keep_alive() const;
+
+    // 当前请求占用的总字节数（含请求前的空行），COMPLETE后即可从缓冲区消费
+    size_t message_size() const {
+        return header_end_ + (streaming_ ? 0 : chunked_ ? body_consumed_ : content_length_);
+    }
+
+    // 错误时对应的响应状态码
+    HttpStatus error_status() const { return error_status_; }
+
+    static bool iequals(std::string_view a, std::string_view b);
+
+private:
+    enum class State { REQUEST_LINE, HEADERS, BODY, COMPLETE, ERROR };
+
+    // 相对于缓冲区起点的区间，缓冲区重新分配后依然有效
+    struct Span {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+        std::string_view in(const char* base) const { return std::string_view(base + offset, length); }
+    };
+
+    Limits limits_;
+    State state_ = State::REQUEST_LINE;
+    size_t line_start_ = 0;
+    size_t scan_offset_ = 0;
+    size_t header_end_ = 0;
+    size_t content_length_ = 0;
+    bool has_content_length_ = false;
+    bool chunked_ = false;
+    bool pause_after_headers_ = false;
+    bool body_started_ = false;   // 已决定缓冲请求体并通过大小检查
+    bool streaming_ = false;
+    size_t body_consumed_ = 0;    // chunked：已消费的原始请求体字节数（含框架）
+    std::string decoded_body_;
+    BodyDecoder decoder_;
+    HttpStatus error_status_;
+
+    Span method_span_, target_span_, version_span_;
+    std::vector<std::pair<Span, Span>> header_spans_;
+
+    std::string_view method_, target_, path_, query_, version_, body_;
+    std::vector<Header> headers_;
+
+    Result fail(HttpStatus status);
+    Result buffer_body(std::string_view data);
+    bool parse_request_line(std::string_view line, size_t offset);
+    bool parse_header_line(std::string_view line, size_t offset);
+    void materialize(const char* base);
+};
+
+#endif // HTTP_PARSER_H
@@ -5,6 +5,22 @@
 #include <unordered_map>
 #include <vector>
 #include <memory>
+#include <functional>
+#include <string_view>
+#include <sys/types.h>
+#include "router.h"
+
+class HttpParser;
+
+// 流式请求体的数据来源，由服务器按连接实现
+class BodySource {
+public:
+    virtual ~BodySource() = default;
+    // 读取至多len字节：返回读取的字节数，0表示请求体已结束，-1表示出错
+    virtual ssize_t read(char* buf, size_t len) = 0;
+    // 请求体是否已完整读出（未读完时连接无法复用）
+    virtual bool complete() const = 0;
+};
 
 class HttpRequest {
 public:
@@ -49,11 +65,12 @@ public:
     bool has_param(const std::string& key) const;
     const std::unordered_map<std::string, std::string>& params() const { return params_; }
     
-    // 路径参数操作（RESTful路由参数，如 /user/:id 中的 id）
-    void set_path_param(const std::string& key, const std::string& value);
+    // 路径参数操作（RESTful路由参数，如 /user/:id 中的 id）：由路由匹配设置，值为path()中的区间
+    void set_path_params(const RouteParams& params) { path_params_ = params; }
+    std::string_view path_param(std::string_view key) const;  // 不分配内存，与请求对象同生命周期
     std::string get_path_param(const std::string& key) const;
     bool has_path_param(const std::string& key) const;
-    const std::unordered_map<std::string, std::string>& path_params() const { return path_params_; }
+    const RouteParams& path_params() const { return path_params_; }
     
     // 表单数据操作
     std::string get_form_data(const std::string& key) const;
@@ -68,6 +85,17 @@ public:
     
     // JSON数据处理
     std::string get_json() const { return body_; }
+
+    // 流式请求体（以HttpServer::stream注册的路由）：处理器在请求头到达后即被调用，
+    // body()为空，请求体经read_body按到达顺序边接收边读取，内存占用与请求体大小无关。
+    // 对普通请求read_body依次读出已缓冲的body()，处理器可统一按流式编写
+    // 返回读取的字节数，0表示请求体已读完，-1表示出错（连接断开、超时或分块格式错误）
+    ssize_t read_body(char* buf, size_t len) const;
+    // 逐段读取剩余请求体交给sink，sink返回false时停止；请求体完整读完时返回true
+    bool consume_body(const std::function<bool(std::string_view)>& sink) const;
+    bool body_streaming() const { return body_source_ != nullptr; }
+    bool body_complete() const;
+    void set_body_source(std::shared_ptr<BodySource> source) { body_source_ = std::move(source); }
     
     // 文件上传操作
     const std::vector<UploadedFile>& uploaded_files() const { return uploaded_files_; }
@@ -95,6 +123,9 @@ public:
     
     // 请求解析
     bool parse(const std::string& raw_request);
+    void populate(const HttpParser& parser);  // 从已完成的增量解析结果填充
+    // 由HTTP/2流构造：头部已经add_header加入，target为:path（可含查询串）
+    void populate(const std::string& method, std::string_view target, const std::string& version, std::string body);
     
     // 实用方法
     bool is_ajax() const;
@@ -118,11 +149,13 @@ private:
     std::string version_;
     std::string body_;
     std::string client_ip_;
+    std::shared_ptr<BodySource> body_source_;
+    mutable size_t body_offset_ = 0;  // read_body在已缓冲请求体中的读取位置
     
     // 各种参数映射
     std::unordered_map<std::string, std::string> headers_;
     std::unordered_map<std::string, std::string> params_;          // URL查询参数
-    std::unordered_map<std::string, std::string> path_params_;     // 路径参数
+    RouteParams path_params_;                                      // 路径参数
     std::unordered_map<std::string, std::string> form_data_;       // 表单数据
     std::unordered_map<std::string, std::string> cookies_;         // Cookie数据
     
@@ -138,6 +171,7 @@ private:
     
     // 解析辅助方法
     void parse_query_string();
+    void parse_query_and_form();  // populate的公共部分
     void parse_form_data();
     void parse_multipart_data();
     void parse_multipart_part(const std::string& part_data);
@@ -2,11 +2,14 @@
 #define HTTP_RESPONSE_H
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <fstream>
 #include <memory>
 #include <chrono>
+#include <ctime>
+#include <sys/stat.h>
 #include "http_server.h"
 
 class HttpResponse {
@@ -45,23 +48,36 @@ public:
     
     // 内容操作
     void set_body(const std::string& body);
+    void set_body(std::string&& body);
     void set_body(const char* data, size_t length);
     void append_body(const std::string& content);
     void clear_body();
-    const std::string& body() const { return body_; }
-    size_t body_size() const { return body_.size(); }
+    const std::string& body() const { return shared_body_ ? *shared_body_ : body_; }
+    size_t body_size() const { return body().size(); }
     
     // 便捷响应方法
-    void json(const std::string& json_str);
-    void html(const std::string& html_str);
-    void text(const std::string& text_str);
+    void json(std::string json_str);
+    void html(std::string html_str);
+    void text(std::string text_str);
     void xml(const std::string& xml_str);
     void css(const std::string& css_str);
     void javascript(const std::string& js_str);
     
-    // 文件响应
+    // 文件响应：响应体为文件区间，发送时使用sendfile，不读入内存
     void file(const std::string& file_path);
     void file(const std::string& file_path, const std::string& mime_type);
+    bool open_file_body(const std::string& file_path);            // 打开文件作为完整响应体，并设置校验器
+    void set_file_body(int fd, off_t offset, size_t length);      // 接管fd所有权
+    std::shared_ptr<const FileBody> file_body() const { return file_body_; }
+    bool has_file_body() const { return file_body_ != nullptr; }
+    // 共享的只读响应体（如静态文件缓存中的内容），写出时不复制
+    void set_shared_body(std::shared_ptr<const std::string> body);
+    std::shared_ptr<const std::string> shared_body() const { return shared_body_; }
+    // 由若干段组成的响应体（多区间的206），文件段同样以sendfile发送
+    void set_body_parts(std::vector<BodyPart> parts);
+    const std::vector<BodyPart>& body_parts() const { return body_parts_; }
+    bool has_body_parts() const { return !body_parts_.empty(); }
+    // 作为附件下载，支持Range断点续传
     void download(const std::string& file_path, const std::string& download_name = "");
     
     // 重定向
@@ -80,6 +96,11 @@ public:
     void set_cache_control(const std::string& cache_control);
     void set_etag(const std::string& etag);
     void set_last_modified(const std::string& last_modified);
+    // 文件校验器：ETag由inode、大小与修改时间生成，Last-Modified取修改时间，都不需要读取内容
+    void set_file_validators(const struct stat& file_stat);
+    static std::string file_etag(const struct stat& file_stat);
+    static std::string http_date(time_t time);                          // IMF-fixdate
+    static bool parse_http_date(const std::string& value, time_t& time);  // 兼容RFC 850与asctime格式
     void set_expires(const std::string& expires);
     void no_cache();
     void cache_forever();
@@ -90,13 +111,32 @@ public:
                          const std::vector<std::string>& methods,
                          const std::vector<std::string>& headers);
     
-    // 内容编码
-    void enable_gzip();
+    // 内容编码：服务器按Accept-Encoding自动压缩，含密钥等需防压缩侧信道的响应可以关闭
+    void disable_compression() { compression_disabled_ = true; }
+    bool compression_disabled() const { return compression_disabled_; }
     void set_content_encoding(const std::string& encoding);
     
+    // 条件请求（RFC 9110 13）：按请求的If-Match、If-None-Match等与响应的校验器求值，
+    // 结果为412或304时改写响应并返回true。只对GET/HEAD的2xx响应求值
+    bool evaluate_preconditions(const HttpRequest& request);
+    void not_modified();  // 转为304：去掉响应体及描述它的头部，保留校验器与缓存相关头部
+    // Range请求（RFC 9110 14）：文件或共享响应体的200响应标明Accept-Ranges，GET携带的Range
+    // 可满足时改写为206（单区间为文件的一段，多区间为multipart/byteranges），都不可满足时为416；
+    // If-Range不匹配、格式错误或区间过多时忽略Range，返回false
+    bool apply_range(const HttpRequest& request);
+    
     // 响应构建
     std::string to_string() const;
     std::vector<char> to_bytes() const;
+
+    // 分散写出：状态行、头部块、Cookie和响应体分别交给writev，响应体不必拼接复制
+    const std::string& status_line() const;  // 按状态码缓存，无需每次生成
+    std::string render_headers() const;      // 不含Set-Cookie，每行以CRLF结尾
+    std::string render_cookies() const;      // Set-Cookie行，无Cookie时为空
+    std::string take_body();  // 移出响应体（共享响应体时复制一份），Content-Length保持不变
+    // HEAD请求：与GET一样生成并协商编码，头部（含Content-Length）照常发送，响应体不写出
+    void omit_body() { body_omitted_ = true; }
+    bool body_omitted() const { return body_omitted_; }
     
     // 便捷状态设置
     void ok() { set_status(HttpStatus::OK); }
@@ -124,11 +164,15 @@ public:
     void render_template(const std::string& template_path, 
                         const std::unordered_map<std::string, std::string>& variables = {});
     
-    // 流式响应支持
-    void start_streaming();
-    void write_chunk(const std::string& chunk);
-    void end_streaming();
+    // 流式响应：start_streaming()立即发出状态行与头部（Transfer-Encoding: chunked），此后每次
+    // write_chunk作为一个分块写给客户端，输出积压超过上限时阻塞调用方；处理器返回时自动结束。
+    // 未接入连接（如单独构造的响应）时分块追加到响应体。返回false表示客户端已断开，应停止生成
+    bool start_streaming();
+    bool write_chunk(std::string_view chunk);
+    bool end_streaming();
     bool is_streaming() const { return streaming_; }
+    void set_stream(ResponseStream* stream) { stream_ = stream; }
+    ResponseStream* stream() const { return stream_; }
     
     // 响应验证
     bool is_valid() const;
@@ -140,9 +184,15 @@ private:
     HttpStatus status_;
     std::unordered_map<std::string, std::string> headers_;
     std::string body_;
+    std::shared_ptr<const FileBody> file_body_;
+    std::shared_ptr<const std::string> shared_body_;
+    std::vector<BodyPart> body_parts_;
     std::vector<Cookie> cookies_;
     bool streaming_;
-    bool headers_sent_;
+    bool stream_ended_;
+    ResponseStream* stream_ = nullptr;  // 由服务器设置，不持有
+    bool compression_disabled_ = false;
+    bool body_omitted_ = false;
     
     // 内部状态
     mutable bool content_length_set_;
@@ -150,7 +200,7 @@ private:
     mutable bool cache_valid_;
     
     // 辅助方法
-    std::string status_to_string(HttpStatus status) const;
+    static std::string status_to_string(HttpStatus status);
     std::string cookie_to_string(const Cookie& cookie) const;
     std::string get_mime_type(const std::string& file_path) const;
     std::string get_current_time_string() const;
@@ -163,9 +213,6 @@ private:
     std::string process_template(const std::string& template_content,
                                const std::unordered_map<std::string, std::string>& variables) const;
     
-    // 压缩支持
-    std::string compress_gzip(const std::string& data) const;
-    
     // MIME类型映射
     static const std::unordered_map<std::string, std::string> mime_types_;
     
@@ -6,22 +6,38 @@
 #include <memory>
 #include <vector>
 #include <string>
-#include <regex>
+#include <string_view>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <queue>
+#include <map>
+#include <deque>
 #include <atomic>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/epoll.h>
+#include <sys/uio.h>
 #include <errno.h>
 #include <signal.h>
+#include "http_parser.h"
+#include "timer_wheel.h"
+#include "connection_table.h"
+#include "io_uring.h"
+#include "compression.h"
+#include "static_cache.h"
+#include "router.h"
 
 class HttpRequest;
+class BodySource;
+class EventChannel;
+class WebSocket;
+class Http2Session;
 class HttpResponse;
 
 enum class HttpMethod {
@@ -63,13 +79,16 @@ enum class HttpStatus {
     CONFLICT = 409,
     GONE = 410,
     LENGTH_REQUIRED = 411,
+    PRECONDITION_FAILED = 412,
     PAYLOAD_TOO_LARGE = 413,
     URI_TOO_LONG = 414,
     UNSUPPORTED_MEDIA_TYPE = 415,
     RANGE_NOT_SATISFIABLE = 416,
     EXPECTATION_FAILED = 417,
     UNPROCESSABLE_ENTITY = 422,
+    UPGRADE_REQUIRED = 426,
     TOO_MANY_REQUESTS = 429,
+    REQUEST_HEADER_FIELDS_TOO_LARGE = 431,
     
     // 5xx Server Error
     INTERNAL_SERVER_ERROR = 500,
@@ -80,23 +99,55 @@ enum class HttpStatus {
     HTTP_VERSION_NOT_SUPPORTED = 505
 };
 
+// 文件响应体：持有已打开的文件，由输出路径通过sendfile直接从页缓存发送
+struct FileBody {
+    int fd = -1;
+    off_t offset = 0;
+    size_t length = 0;
+
+    FileBody(int file_fd, off_t file_offset, size_t file_length)
+        : fd(file_fd), offset(file_offset), length(file_length) {}
+    // 同一文件中的一段（Range请求），借用source的fd，不单独打开或关闭
+    FileBody(std::shared_ptr<const FileBody> source, off_t file_offset, size_t file_length)
+        : fd(source->fd), offset(file_offset), length(file_length), source_(std::move(source)) {}
+    ~FileBody() { if (fd >= 0 && !source_) close(fd); }
+    FileBody(const FileBody&) = delete;
+    FileBody& operator=(const FileBody&) = delete;
+
+private:
+    std::shared_ptr<const FileBody> source_;
+};
+
+// 多段响应体（multipart/byteranges）中的一段：先发送data，再发送file（可为空）
+struct BodyPart {
+    std::string data;
+    std::shared_ptr<const FileBody> file;
+};
+
+// 流式响应的写出端：HttpResponse::start_streaming()之后的数据经它直接进入连接的输出队列
+class ResponseStream {
+public:
+    virtual ~ResponseStream() = default;
+    virtual bool begin(HttpResponse& response) = 0;  // 发送状态行与头部
+    virtual bool write(std::string_view data) = 0;   // 发送一段响应体，输出积压超过上限时阻塞
+    virtual bool end() = 0;                          // 结束响应体
+};
+
 using RouteHandler = std::function<void(const HttpRequest&, HttpResponse&)>;
 using MiddlewareFunc = std::function<bool(const HttpRequest&, HttpResponse&)>;
 using ErrorHandler = std::function<void(const HttpRequest&, HttpResponse&, int error_code)>;
+using WebSocketHandler = std::function<void(const HttpRequest&, const std::shared_ptr<WebSocket>&)>;
 
 // 路由信息结构
 struct Route {
     HttpMethod method;
-    std::regex pattern;
     std::string original_path;
     RouteHandler handler;
     std::vector<MiddlewareFunc> middlewares;
-    std::vector<std::string> param_names;
+    std::vector<std::string> param_names;  // 按在模式中出现的顺序，由Router::add填写
+    bool stream_body = false;  // 请求头到达即调用处理器，请求体由处理器流式读取
 
     Route(HttpMethod m, const std::string& path, RouteHandler h);
-
-private:
-    void compile_path(const std::string& path);
 };
 
 // 线程池任务
@@ -113,6 +164,9 @@ public:
 
     template<typename F>
     void enqueue(F&& f);
+    // 排队任务已达max_queued（0表示不限）时不入队并返回false
+    template<typename F>
+    bool try_enqueue(F&& f, size_t max_queued);
 
     void shutdown();
 
@@ -128,17 +182,57 @@ private:
 
 class HttpServer {
 public:
+    // 监听地址：IPv4、IPv6（默认双栈）或 "unix:/path" 形式的Unix域套接字
+    struct ListenerConfig {
+        std::string address = "0.0.0.0";
+        int port = 0;                   // 0表示使用ServerConfig::port，Unix域套接字忽略
+        int backlog = 0;                // 0表示使用ServerConfig::max_connections
+        bool ipv6_only = false;         // IPv6地址默认同时接受IPv4映射连接
+        int defer_accept_seconds = 0;   // TCP_DEFER_ACCEPT：数据到达后才唤醒accept
+        int fastopen_queue = 0;         // TCP_FASTOPEN：等待中的TFO请求队列长度，0表示关闭
+        int unix_mode = 0666;           // Unix域套接字文件权限，便于同机反向代理以其他用户连接
+    };
+
+    // 连接数达到上限时的处理方式
+    enum class OverloadPolicy {
+        REJECT,        // 接受后立即回复预先生成的503（带Retry-After）并关闭
+        PAUSE_ACCEPT,  // 暂停accept，新连接留在内核backlog中，连接数回落后恢复
+        DROP_IDLE      // 关闭最久空闲的keep-alive连接腾出名额，没有空闲连接时按REJECT处理
+    };
+
     struct ServerConfig {
         int port = 9006;
         std::string host = "0.0.0.0";
+        std::vector<ListenerConfig> listeners;  // 为空时只监听host:port
         int thread_pool_size;
-        int max_connections = 1000;
-        int timeout_seconds = 30;
-        int keep_alive_timeout = 5;
+        int reactor_count = 1;  // 事件循环数量，<=0 表示按CPU核数
+        int max_connections = 1000;  // 同时存在的连接数上限，也是监听backlog的默认值
+        size_t max_queued_requests = 4096;  // 等待工作线程的连接数上限，超出时新请求以503拒绝，0表示不限
+        OverloadPolicy overload_policy = OverloadPolicy::REJECT;
+        int retry_after_seconds = 1;
+        // 热重启：新进程启动时经此Unix域套接字从旧进程接收监听套接字，旧进程随后停止accept并排空连接
+        std::string handoff_path;          // 空表示关闭
+        int drain_timeout_seconds = 30;    // 旧进程等待已有连接处理完毕的最长时间
+        int header_timeout_seconds = 10;  // 从请求首字节到请求头接收完毕的时限
+        int body_timeout_seconds = 30;    // 读取请求体时两次读取之间的最长间隔
+        int write_timeout_seconds = 30;   // 发送响应时两次写出进展之间的最长间隔
+        int keep_alive_timeout = 5;       // 两个请求之间的空闲时限
         bool enable_keep_alive = true;
-        bool enable_compression = true;
+        bool enable_compression = true;   // 按Accept-Encoding以gzip/deflate压缩文本类响应体（需要zlib）
+        int compression_level = 6;        // zlib压缩级别1-9，级别越高越省流量、越耗CPU
+        size_t compression_min_size = 1024;  // 小于此长度的响应体不压缩；流式响应总是压缩
+        size_t static_cache_bytes = 64 * 1024 * 1024;  // 静态文件缓存的内存预算（含gzip变体），0表示关闭
+        size_t static_cache_max_file_size = 4 * 1024 * 1024;  // 更大的文件不缓存，仍以sendfile发送
         size_t max_request_size = 1024 * 1024;  // 1MB
         size_t max_header_size = 8192;  // 8KB
+        size_t max_pipeline_depth = 16;  // 单个连接上同时处理中的管线化请求上限
+        size_t output_high_water_mark = 1024 * 1024;  // 输出队列超过此值时暂停读取，降到一半以下恢复
+        int sse_heartbeat_seconds = 15;   // SSE订阅连接空闲超过此时长时发送注释行，探测失效连接
+        size_t sse_replay_capacity = 256; // 每个事件频道为Last-Event-ID续传保留的最近事件数
+        bool websocket_deflate = true;    // 客户端提出时启用permessage-deflate（需要zlib），消息上限同max_request_size
+        bool enable_http2 = true;         // 接受h2c：连接前言（先验知识）或Upgrade: h2c
+        uint32_t http2_max_concurrent_streams = 100;  // 每个HTTP/2连接同时处理的流数
+        std::string io_backend = "epoll";  // "epoll" 或 "io_uring"，后者不可用时回退到epoll
         std::string server_name = "XKOJ/1.0";
         bool enable_cors = false;
         bool enable_logging = true;
@@ -156,7 +250,8 @@ public:
     // 启动和停止服务器
     bool start();
     void stop();
-    bool is_running() const {return running_.load();}
+    // 交出监听套接字并排空连接后也视为停止，调用方随后调用stop()释放资源
+    bool is_running() const {return running_.load() && !drained_.load();}
 
     // 路由注册
     void get(const std::string& path, RouteHandler handler);
@@ -167,6 +262,21 @@ public:
     void options(const std::string& path, RouteHandler handler);
     void head(const std::string& path, RouteHandler handler);
     void route(HttpMethod method, const std::string& path, RouteHandler handler);
+    // 流式请求体路由：请求头到达即在持有连接的工作线程中调用处理器，请求体不受max_request_size限制，
+    // 处理器经request.read_body()边接收边处理，读取期间占用该工作线程
+    void stream(HttpMethod method, const std::string& path, RouteHandler handler);
+
+    // Server-Sent Events：处理器调用subscribe后返回，连接保持打开且不占用工作线程，
+    // 事件由EventChannel::publish直接写入各订阅连接；请求带Last-Event-ID时先补发其后的事件
+    std::shared_ptr<EventChannel> event_channel(const std::string& name);  // 不存在时创建
+    void remove_event_channel(const std::string& name);  // 结束该频道全部订阅
+    bool subscribe(const HttpRequest& request, HttpResponse& response,
+                   const std::shared_ptr<EventChannel>& channel);
+
+    // WebSocket（RFC 6455）：处理器调用accept_websocket完成握手后接管连接，返回前注册消息回调；
+    // 握手请求无效时返回nullptr并已设置400/426响应。websocket()注册GET路由并在握手成功后调用handler
+    std::shared_ptr<WebSocket> accept_websocket(const HttpRequest& request, HttpResponse& response);
+    void websocket(const std::string& path, WebSocketHandler handler);
 
     // 中间件管理
     void use(MiddlewareFunc middleware);  // 全局中间件
@@ -189,37 +299,238 @@ public:
         std::atomic<uint64_t> active_connections{0};
         std::atomic<uint64_t> total_bytes_sent{0};
         std::atomic<uint64_t> total_bytes_received{0};
+        std::atomic<uint64_t> total_recv_calls{0};
+        std::atomic<uint64_t> total_send_calls{0};   // 工作线程直接发起的sendmsg/sendfile
+        std::atomic<uint64_t> total_ring_enters{0};  // io_uring后端的io_uring_enter调用
+        std::atomic<uint64_t> total_pipelined_requests{0};  // 到达时同连接上已有未完成请求
+        std::atomic<uint64_t> total_write_waits{0};  // 发送缓冲区满、等待EPOLLOUT的次数
+        std::atomic<uint64_t> total_timeouts{0};
+        std::atomic<uint64_t> total_dispatches{0};        // 取得连接所有权并交给工作线程的次数
+        std::atomic<uint64_t> total_coalesced_events{0};  // 连接已被持有、合并给持有者处理的事件数
+        std::atomic<uint64_t> total_rearms{0};
+        std::atomic<uint64_t> total_rearm_latency_us{0};  // 从分发到释放所有权、重新布防的累计耗时
+        std::atomic<uint64_t> total_shed_rejected{0};      // 超出连接上限、回复503后关闭的连接
+        std::atomic<uint64_t> total_shed_idle_dropped{0};  // 为新连接腾出名额而关闭的空闲连接
+        std::atomic<uint64_t> total_shed_requests{0};      // 请求队列已满、回复503后关闭的连接
+        std::atomic<uint64_t> total_accept_pauses{0};
+        std::atomic<uint64_t> total_streamed_responses{0};
+        std::atomic<uint64_t> total_stream_waits{0};  // 输出积压超过高水位、挂起流式响应生产方的次数
+        std::atomic<uint64_t> total_events_published{0};
+        std::atomic<uint64_t> total_event_deliveries{0};
+        std::atomic<uint64_t> total_slow_subscribers{0};  // 积压超限而被断开的推送连接（SSE订阅者与WebSocket）
+        std::atomic<uint64_t> total_websocket_upgrades{0};
+        std::atomic<uint64_t> total_websocket_messages{0};  // 收到的完整WebSocket消息
+        std::atomic<uint64_t> total_http2_sessions{0};
+        std::atomic<uint64_t> total_http2_streams{0};
+        std::atomic<uint64_t> total_compressed_responses{0};
+        std::atomic<uint64_t> total_compression_saved_bytes{0};  // 缓冲响应压缩前后的长度差
         std::chrono::steady_clock::time_point start_time;
     };
+    const Statistics& stats() const { return stats_; }
+    const StaticFileCache& static_cache() const { return *static_cache_; }
+
+    // 逗号分隔的头部值（如Connection、Upgrade）中是否含有指定记号，不区分大小写
+    static bool header_has_token(const std::string& value, const char* token);
 
 protected:
-    virtual void handle_request(int client_fd, const std::string& client_ip);
-    virtual bool parse_request(int client_fd, HttpRequest& request);
-    virtual void send_response(int client_fd, const HttpResponse& response);
+    struct Reactor;
+
+    enum class ParseResult { INCOMPLETE, COMPLETE, ERROR };
+    enum class OutputAction { NONE, CLOSE, RESUME_READ };
+
+    // 输出队列中的一个片段：自有数据、生命周期足够长的外部数据（如缓存的状态行）或文件区间
+    // 共享数据（如同时推送给所有订阅者的事件帧）只保存一份，由各连接的队列共同持有
+    struct OutputChunk {
+        std::string owned;
+        const char* external = nullptr;
+        size_t external_size = 0;
+        std::shared_ptr<const FileBody> file;
+        std::shared_ptr<const std::string> shared;
+
+        OutputChunk(std::string data) : owned(std::move(data)) {}
+        OutputChunk(const char* data, size_t size) : external(data), external_size(size) {}
+        OutputChunk(std::shared_ptr<const FileBody> body) : file(std::move(body)) {}
+        OutputChunk(std::shared_ptr<const std::string> data) : shared(std::move(data)) {}
+        const char* data() const { return external ? external : shared ? shared->data() : owned.data(); }
+        size_t size() const {
+            return file ? file->length : external ? external_size : shared ? shared->size() : owned.size();
+        }
+    };
+
+    // 已生成、等待前序响应写出的响应
+    struct PendingResponse {
+        std::vector<OutputChunk> chunks;
+        bool close_after = false;
+        bool complete = true;  // 流式响应尚未结束时为false，其后的响应需继续等待
+        size_t bytes = 0;
+    };
+
+    // 读方向所处阶段，决定适用的超时
+    enum class ReadPhase : uint8_t { IDLE, HEADER, BODY };
+
+    // io_uring请求类型，编码在user_data的低位
+    enum class RingOp : uint8_t { ACCEPT, RECV, SEND, POLL_OUT, WAKE, CANCEL };
+
+    // 连接管理
+    struct Connection : std::enable_shared_from_this<Connection> {
+        int fd = -1;
+        uint64_t handle = 0;  // 在所属Reactor连接表中的句柄，同时作为epoll事件数据
+        std::string ip;
+        Reactor* reactor = nullptr;
+        bool keep_alive = true;
+        std::atomic<bool> closed{false};
+        std::mutex io_mutex;  // 串行化同一连接上的读取与请求处理
+
+        // 读缓冲区及可跨epoll唤醒恢复的解析进度
+        std::string buffer;
+        size_t bytes_read = 0;
+        HttpParser parser;
+        uint64_t next_sequence = 0;   // 下一个请求的编号
+        std::atomic<bool> input_closed{false};  // 不再接受后续请求（Connection: close或解析错误）
+        std::atomic<ReadPhase> read_phase{ReadPhase::HEADER};
+        std::atomic<int64_t> request_start_ms{0};  // 当前请求首字节到达时间
+        std::atomic<int64_t> last_read_ms{0};
+
+        // 管线化：请求可并发执行，响应按请求编号顺序写回（以下字段由output_mutex保护）
+        std::mutex output_mutex;
+        uint64_t next_to_send = 0;
+        std::map<uint64_t, PendingResponse> completed;
+        size_t in_flight = 0;         // 已分发但响应尚未进入输出队列的请求数
+        bool read_paused = false;     // 管线深度或输出队列达到上限，暂停读取
+        bool peer_closed = false;     // 对端已关闭，写完剩余响应后关闭连接
+
+        // 输出队列：按顺序待发送的响应，发送缓冲区满时等待EPOLLOUT继续
+        std::deque<OutputChunk> output_queue;
+        size_t output_offset = 0;     // 队首片段已发送的字节数
+        size_t output_bytes = 0;      // 队列中尚未发送的字节总数
+        bool close_when_flushed = false;
+        int64_t last_write_ms = 0;    // 最近一次写出进展
+        int64_t idle_since_ms = 0;    // 最近一次变为空闲（无请求、无待发送数据）
+        std::condition_variable output_cv;  // 流式响应的生产方等待输出积压回落
+        size_t stream_waiters = 0;
+        std::atomic<bool> event_stream{false};  // SSE订阅连接：响应不会结束，事件由发布方直接写入
+        // 已升级为WebSocket或HTTP/2：此后的字节按帧解析，升级时由持有者设置一次，之后不再改变
+        std::shared_ptr<WebSocket> websocket;
+        std::shared_ptr<Http2Session> http2;
+        std::atomic<bool> upgraded{false};
+
+        // EPOLLONESHOT所有权：事件触发后fd在内核中失效，连接由唯一的工作线程持有，
+        // 持有者处理完毕后按当前状态重新布防；持有期间到达的事件合并给持有者
+        std::atomic<bool> owned{false};
+        std::atomic<uint32_t> missed_events{0};
+        std::atomic<uint32_t> armed_events{0};  // 内核中已布防的事件，0表示未布防
+        std::atomic<int64_t> owned_since_us{0};
+
+        // io_uring后端：Reactor收到的数据暂存于inbox，由持有连接的工作线程取走
+        std::mutex inbox_mutex;
+        std::string inbox;
+        bool inbox_eof = false;
+        std::condition_variable inbox_cv;  // 流式读取请求体的工作线程等待新数据
+        bool recv_stopped = false;    // 积压超限已取消接收，取走数据后恢复
+        bool send_busy = false;       // 发送已交给Reactor提交（output_mutex保护）
+        struct msghdr send_msg{};     // 在途sendmsg引用的数据，完成前保持有效
+        std::vector<struct iovec> send_iov;
+        uint32_t ring_ops = 0;        // 在途请求数，仅Reactor线程访问
+        bool recv_active = false;
+
+        // 超时：工作线程只更新截止时间，时间轮由所属Reactor线程独占维护
+        std::atomic<int64_t> deadline_ms{0};       // 0表示当前不受超时约束
+        std::atomic<uint64_t> scheduled_tick{0};   // 时间轮中有效定时器的到期tick，0表示没有
+    };
+
+    // 事件循环：每个Reactor独占一个epoll实例、每个监听地址一个SO_REUSEPORT监听套接字和一个连接分片
+    struct Reactor {
+        size_t index = 0;
+        // 与config_.listeners一一对应；Unix域套接字不支持SO_REUSEPORT，各Reactor持有同一套接字的副本
+        std::vector<int> listen_fds;
+        bool accept_paused = false;     // 连接数达到上限，暂停accept（PAUSE_ACCEPT策略）
+        bool draining = false;          // 监听套接字已交出并关闭
+        std::vector<bool> accepting;    // io_uring后端：各监听套接字的多路accept是否在途
+        std::vector<int> deferred_fds;  // io_uring后端：暂停生效前已被接受的连接，恢复后再登记
+        int epoll_fd = -1;
+        std::thread thread;
+        // 连接表仅由本Reactor线程访问，epoll事件携带的句柄无锁查找
+        ConnectionTable<Connection> connections;
+        // 已关闭、待从连接表移除的连接句柄（关闭可能发生在任意线程）
+        std::mutex released_mutex;
+        std::vector<uint64_t> released;
+
+        // 连接超时定时器，仅由本Reactor线程访问
+        TimerWheel<std::weak_ptr<Connection>> timers;
+        // 工作线程提前了截止时间、需要重新调度的连接
+        std::mutex timer_mutex;
+        std::vector<std::weak_ptr<Connection>> timer_requests;
+
+        // io_uring后端（ring为空时使用epoll）
+        std::unique_ptr<IoUring> ring;
+        int wake_fd = -1;                    // 工作线程提交请求后唤醒等待中的Reactor
+        std::atomic<bool> sleeping{false};
+        std::mutex ring_mutex;
+        std::vector<std::pair<std::shared_ptr<Connection>, RingOp>> ring_requests;
+        // 有在途请求的连接：内核仍在引用其缓冲区，完成前不得释放
+        std::unordered_map<Connection*, std::shared_ptr<Connection>> ring_refs;
+
+        void close_fds() {
+            for(int fd : listen_fds) { close(fd); }
+            listen_fds.clear();
+            for(int fd : deferred_fds) { close(fd); }
+            deferred_fds.clear();
+            if(epoll_fd >= 0) { close(epoll_fd); epoll_fd = -1; }
+            if(wake_fd >= 0) { close(wake_fd); wake_fd = -1; }
+        }
+        ~Reactor();
+    };
+
+    virtual void handle_request(Connection& conn, HttpRequest& request, uint64_t sequence);
+    // 中间件、路由匹配与静态文件，结果写入response
+    void route_request(HttpRequest& request, HttpResponse& response);
+    virtual ParseResult parse_request(Connection& conn, HttpRequest& request);
+    // 响应压缩：choose_encoding检查响应是否适合压缩并设置Vary，返回协商出的编码；
+    // 缓冲响应由compress_response整体压缩，流式响应由各自的流逐段压缩，set_encoding设置相应的头部
+    ContentCoding choose_encoding(const HttpRequest& request, HttpResponse& response, bool streaming);
+    void set_encoding(HttpResponse& response, ContentCoding coding);
+    void compress_response(const HttpRequest& request, HttpResponse& response);
+    // 响应体被移入输出队列，调用后response只保留状态和头部
+    virtual void send_response(Connection& conn, uint64_t sequence,
+                               HttpResponse& response, bool close_after);
     virtual void on_connection_accepted(int client_fd, const std::string& client_ip);
     virtual void on_connection_closed(int client_fd);
     virtual void on_error(const std::string& error_message);
 
 private:
+    friend class EventChannel;
+    friend class WebSocket;
+    friend class Http2Session;
+
     ServerConfig config_;
     std::atomic<bool> running_;
     std::atomic<bool> shutting_down_;
+
+    // 热重启
+    std::atomic<bool> draining_{false};   // 已把监听套接字交给新进程，只处理已有连接
+    std::atomic<bool> drained_{false};
+    std::atomic<bool> handed_off_{false};
+    int handoff_fd_ = -1;
+    std::thread handoff_thread_;
+    std::vector<std::vector<int>> inherited_fds_;  // 从旧进程接收、按config_.listeners归类的监听套接字
     
     // 网络相关
-    int server_fd_;
-    int epoll_fd_;
-    struct sockaddr_in server_addr_;
+    std::vector<std::unique_ptr<Reactor>> reactors_;
     
     // 线程池
     std::unique_ptr<ThreadPool> thread_pool_;
     
     // 路由和中间件
-    std::vector<std::unique_ptr<Route>> routes_;
+    std::vector<std::unique_ptr<Route>> routes_;  // 持有路由，router_按方法与路径索引
+    Router router_;
     std::vector<MiddlewareFunc> global_middlewares_;
     std::unordered_map<std::string, std::vector<MiddlewareFunc>> path_middlewares_;
     
     // 静态文件配置
     std::unordered_map<std::string, std::string> static_paths_;
+    std::unique_ptr<StaticFileCache> static_cache_;
+    // 缓存的gzip变体每个文件只压缩一次、此后每次命中复用，用最高级别换更小的传输量，不取compression_level
+    static constexpr int STATIC_GZIP_LEVEL = 9;
 
     // 错误处理
     std::unordered_map<int, ErrorHandler> error_handlers_;
@@ -228,44 +539,136 @@ private:
     // 统计信息
     mutable Statistics stats_;
 
-    // 连接管理
-    struct Connection {
-        int fd;
-        std::string ip;
-        std::chrono::steady_clock::time_point last_activity;
-        bool keep_alive;
-        std::string buffer;
-        size_t bytes_read;
-    };
-
-    std::unordered_map<int, Connection> connections_;
-    std::mutex connections_mutex_;
-    
-    // 主循环
-    std::thread main_thread_;
-    std::thread cleanup_thread_;
+    // 过载时直接写出的503响应，启动时生成一次
+    std::string overload_response_;
 
     // 网络相关私有方法
-    bool create_socket();
-    bool bind_socket();
-    bool listen_socket();
-    bool setup_epoll();
-    void main_loop();
-    void cleanup_loop();
-    void accept_connection();
-    void handle_client_data(int client_fd);
-    void close_connection(int client_fd);
+    bool open_listeners(Reactor& reactor);
+    int create_socket(const ListenerConfig& listener, const sockaddr_storage& addr);
+    bool bind_socket(int fd, const ListenerConfig& listener, const sockaddr_storage& addr, socklen_t addr_len);
+    bool listen_socket(int fd, const ListenerConfig& listener);
+    bool setup_epoll(Reactor& reactor);
+    void main_loop(Reactor& reactor);
+    void accept_connection(Reactor& reactor, int listen_fd);
+
+    // 准入控制：连接上限、请求队列上限与过载策略
+    bool admit_connection(Reactor& reactor);
+    bool drop_idle_connection(Reactor& reactor);
+    void reject_connection(int client_fd);
+    void shed_request(Connection& conn);
+    void pause_accept(Reactor& reactor);
+    void resume_accept(Reactor& reactor);
+    bool connection_idle(Connection& conn);
+
+    // 热重启：监听套接字经SCM_RIGHTS交接
+    static constexpr size_t HANDOFF_BATCH = 64;  // 每条消息携带的fd数
+    bool receive_listeners();
+    bool open_handoff_socket();
+    void handoff_loop();
+    bool send_listeners(int peer_fd);
+    void begin_drain(Reactor& reactor);
+    static bool same_address(const sockaddr_storage& a, const sockaddr_storage& b);
+    static bool parse_listen_address(const ListenerConfig& listener, sockaddr_storage& addr, socklen_t& addr_len);
+    static std::string listener_name(const ListenerConfig& listener);
+    static std::string peer_address(const sockaddr_storage& addr);
+    std::shared_ptr<Connection> create_connection(Reactor& reactor, int client_fd, const char* client_ip);
+    void dispatch_events(const std::shared_ptr<Connection>& conn, uint32_t events);
+    void process_events(const std::shared_ptr<Connection>& conn, uint32_t events);
+    void arm_events(Connection& conn);
+    void handle_connection(const std::shared_ptr<Connection>& conn);
+    bool collect_requests(Connection& conn, std::vector<std::pair<uint64_t, HttpRequest>>& batch);
+    bool input_allowed(Connection& conn);
+
+    // 超时管理
+    static constexpr int64_t TIMER_TICK_MS = 100;
+    static int64_t now_ms();
+    void update_deadline(Connection& conn);
+    void schedule_timer(Reactor& reactor, Connection& conn);
+    void process_timers(Reactor& reactor);
+    void close_connection(Connection& conn);
+    void release_connections(Reactor& reactor);
     
     // 请求处理相关
-    bool match_route(const HttpRequest& request, Route*& matched_route, 
-                    std::smatch& matches);
+    void add_route(std::unique_ptr<Route> route);
     void execute_middlewares(const std::vector<MiddlewareFunc>& middlewares,
                            const HttpRequest& request, HttpResponse& response);
+    void handle_error(const HttpRequest& request, HttpResponse& response, int status_code);
     void handle_static_file(const HttpRequest& request, HttpResponse& response);
-    void send_error_response(int client_fd, HttpStatus status, 
+    void serve_cached_file(const HttpRequest& request, HttpResponse& response, const StaticFileCache::Entry& entry);
+    void send_error_response(Connection& conn, uint64_t sequence, HttpStatus status,
                            const std::string& message = "");
+    bool wants_keep_alive(const HttpRequest& request) const;
+
+    // 流式请求体：处理器在持有连接的工作线程中直接从读缓冲区和套接字读取
+    class ConnectionBodySource;
+    bool has_streaming_routes_ = false;
+    bool streams_body(std::string_view method, std::string_view path);
+    std::shared_ptr<BodySource> open_body_stream(Connection& conn, const HttpRequest& request);
+    bool wait_readable(Connection& conn, int64_t deadline_ms);
+    bool poll_readable(Connection& conn, int wait_ms);  // 单次等待，最多wait_ms毫秒
+    bool finish_body_stream(Connection& conn, const HttpRequest& request);
+
+    // 流式响应：分块直接写入连接的输出队列，按请求编号与其他响应保持顺序。
+    // 由handle_request在栈上创建，生命周期覆盖处理器调用
+    class ConnectionResponseStream : public ResponseStream {
+    public:
+        ConnectionResponseStream(HttpServer& server, Connection& conn, const HttpRequest& request, uint64_t sequence)
+            : server_(server), conn_(conn), request_(request), sequence_(sequence) {}
+        bool begin(HttpResponse& response) override;
+        bool write(std::string_view data) override;
+        bool end() override;
+        bool started() const { return started_; }
+        // 转为SSE订阅：处理器返回后不结束响应，连接不再读取后续请求
+        void detach();
+        // 协议升级：发送101响应头后同样脱离，连接上此后的字节属于新协议
+        bool upgrade(HttpResponse& response);
+        bool detached() const { return detached_; }
+        Connection& connection() const { return conn_; }
+        uint64_t sequence() const { return sequence_; }
+        bool chunked() const { return chunked_; }
+
+    private:
+        HttpServer& server_;
+        Connection& conn_;
+        const HttpRequest& request_;
+        uint64_t sequence_;
+        bool started_ = false;
+        bool ended_ = false;
+        bool failed_ = false;
+        bool chunked_ = true;     // HTTP/1.0客户端不支持chunked，以关闭连接结束响应体
+        bool head_ = false;       // HEAD请求只发送头部
+        bool keep_alive_ = true;
+        bool detached_ = false;
+        std::unique_ptr<StreamCompressor> compressor_;  // 协商出压缩编码时逐段压缩
+
+        // 状态行与头部进入输出队列，响应尚未结束
+        void send_head(HttpResponse& response);
+    };
+    void enqueue_output(Connection& conn, uint64_t sequence, std::vector<OutputChunk> chunks,
+                        bool complete, bool close_after);
+    bool wait_output_drained(Connection& conn, uint64_t sequence);
+    size_t stream_backlog(Connection& conn, uint64_t sequence);
+    // 推送型连接（SSE、WebSocket）的写入：积压超过高水位时断开连接而不是无限缓存
+    bool push_output(Connection& conn, uint64_t sequence, std::vector<OutputChunk> chunks);
+
+    // WebSocket：持有连接的工作线程读取并解析帧，完整的消息交给回调
+    void handle_websocket(Connection& conn);
+    // 连接关闭时经线程池调用on_close
+    void notify_websocket_closed(Connection& conn);
+
+    // HTTP/2（h2c）：持有者在io_mutex下切换协议；upgrade_request非空时为Upgrade: h2c，
+    // 该请求成为1号流。此后持有者解析帧，完整的请求作为流交给线程池
+    bool start_http2(Connection& conn, uint64_t sequence, HttpRequest* upgrade_request);
+    void handle_http2(const std::shared_ptr<Connection>& conn);
+
+    // SSE事件频道；心跳由0号Reactor每秒检查一次
+    std::mutex channels_mutex_;
+    std::unordered_map<std::string, std::shared_ptr<EventChannel>> channels_;
+    int64_t next_heartbeat_scan_ms_ = 0;
+    void send_event_heartbeats();
     
     // 工具方法
+    static bool parse_method(std::string_view method, HttpMethod& result);  // 未知方法返回false
     HttpMethod string_to_method(const std::string& method);
     std::string method_to_string(HttpMethod method);
     std::string status_to_string(HttpStatus status);
@@ -275,11 +678,27 @@ private:
     std::string get_current_time_string();
     
     // 数据读写
-    ssize_t read_from_socket(int fd, char* buffer, size_t size);
-    ssize_t write_to_socket(int fd, const char* data, size_t size);
-    std::string read_request_line(int client_fd);
-    std::string read_headers(int client_fd);
-    std::string read_body(int client_fd, size_t content_length);
+    static constexpr size_t READ_CHUNK_SIZE = 16384;
+    static constexpr int MAX_IOVECS = 64;  // 单次sendmsg提交的最大片段数
+    static constexpr size_t SENDFILE_CHUNK_SIZE = 1024 * 1024;  // 单次sendfile的最大字节数
+    bool fill_read_buffer(Connection& conn);
+    OutputAction flush_output(Connection& conn);
+    void consume_output(Connection& conn, size_t bytes);
+    OutputAction finish_output(Connection& conn, bool progressed);
+    void apply_output_action(Connection& conn, OutputAction action);
+
+    // io_uring后端：多路accept、提供缓冲区的多路recv、由Reactor批量提交的发送
+    static constexpr unsigned RING_ENTRIES = 4096;
+    static constexpr unsigned RING_BUFFER_COUNT = 1024;  // 每个Reactor的接收缓冲区数，每个READ_CHUNK_SIZE字节
+    static constexpr uint16_t RING_BUFFER_GROUP = 0;
+    bool setup_uring(Reactor& reactor);
+    void uring_loop(Reactor& reactor);
+    void post_ring_request(Connection& conn, RingOp op);
+    // ACCEPT没有连接对象，listen_fd指明监听套接字
+    void submit_ring_op(Reactor& reactor, Connection* conn, RingOp op, int listen_fd = -1);
+    void register_ring_connection(Reactor& reactor, int client_fd);
+    OutputAction start_ring_send(Reactor& reactor, Connection& conn, bool progressed);
+    void handle_ring_completion(Reactor& reactor, uint64_t user_data, int32_t res, uint32_t flags);
     
     // 信号处理
     static void signal_handler(int signal);
@@ -303,4 +722,20 @@ void ThreadPool::enqueue(F&& f) {
     condition_.notify_one();
 }
 
+template<typename F>
+bool ThreadPool::try_enqueue(F&& f, size_t max_queued) {
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        if (stop_) {
+            return true;
+        }
+        if (max_queued > 0 && tasks_.size() >= max_queued) {
+            return false;
+        }
+        tasks_.emplace(std::forward<F>(f));
+    }
+    condition_.notify_one();
+    return true;
+}
+
 #endif // HTTP_SERVER_H
\ No newline at end of file
@@ -0,0 +1,91 @@
+#ifndef IO_URING_H
+#define IO_URING_H
+
+// 内核头文件提供多路接收与提供缓冲区环时启用io_uring后端；编译时定义XKOJ_DISABLE_IO_URING可强制关闭
+#if defined(__linux__) && !defined(XKOJ_DISABLE_IO_URING) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#if defined(IORING_RECV_MULTISHOT) && defined(IORING_ACCEPT_MULTISHOT) && defined(IORING_FEAT_EXT_ARG)
+#define XKOJ_HAVE_IO_URING 1
+#endif
+#endif
+
+#ifdef XKOJ_HAVE_IO_URING
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// io_uring的最小封装：直接使用系统调用，不依赖liburing
+// 只由创建它的事件循环线程使用，非线程安全
+class IoUring {
+public:
+    IoUring() = default;
+    ~IoUring();
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    bool init(unsigned entries, std::string& error);
+
+    // 注册提供缓冲区环：count个size字节的缓冲区，由内核在接收时自行挑选
+    bool setup_buffers(uint16_t group, unsigned count, unsigned size, std::string& error);
+    char* buffer(uint16_t id) { return buffers_ + static_cast<size_t>(id) * buffer_size_; }
+    // 数据取走后把缓冲区交还内核
+    void recycle_buffer(uint16_t id);
+
+    // SQ已满时先提交已有条目再取
+    io_uring_sqe* get_sqe();
+
+    // 提交所有待提交条目；wait为true时至少等待一个完成事件或超时
+    int submit(bool wait, int timeout_ms);
+    unsigned pending() const { return sqe_tail_ - *sq_tail_; }
+
+    // 依次处理所有已完成事件，返回处理的数量
+    template<typename F>
+    unsigned for_each_cqe(F&& fn) {
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        unsigned count = 0;
+        for (; head != tail; ++head, ++count) {
+            fn(cqes_[head & *cq_mask_]);
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        return count;
+    }
+
+private:
+    int ring_fd_ = -1;
+
+    void* sq_ptr_ = nullptr;
+    size_t sq_map_size_ = 0;
+    void* cq_ptr_ = nullptr;
+    size_t cq_map_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_map_size_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_mask_ = nullptr;
+    unsigned sq_entries_ = 0;
+    unsigned sqe_tail_ = 0;       // 已填写、尚未发布给内核的位置
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned* cq_mask_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+
+    io_uring_buf_ring* buf_ring_ = nullptr;
+    size_t buf_ring_size_ = 0;
+    char* buffers_ = nullptr;
+    size_t buffers_size_ = 0;
+    unsigned buffer_count_ = 0;
+    unsigned buffer_size_ = 0;
+    uint16_t buf_tail_ = 0;
+};
+
+#else
+
+// 不支持io_uring的平台上只保留类型，服务器总是回退到epoll
+class IoUring {};
+
+#endif // XKOJ_HAVE_IO_URING
+
+#endif // IO_URING_H
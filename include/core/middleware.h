@@ -97,7 +97,8 @@ public:
 private:
     StaticConfig config_;
     bool is_file_allowed(const std::string& file_path) const;
-    void serve_file(const std::string& file_path, HttpResponse& response) const;
+    void serve_file(const HttpRequest& request, const std::string& file_path, const struct stat& file_stat,
+                    HttpResponse& response) const;
     void serve_directory(const std::string& dir_path, HttpResponse& response) const;
 };
 
@@ -0,0 +1,66 @@
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// 路由表：所有方法共用一棵压缩前缀树（radix tree），每个节点按方法保存路由，匹配耗时只与路径长度有关，
+// 与路由数量无关。模式由静态文本、:name（匹配到下一个'/'为止的非空文本）与末尾的*或*name（匹配余下全部，
+// 可为空）组成；同一位置静态片段优先于:name，:name优先于*，较具体的分支失败时回溯。匹配过程不分配内存。
+
+struct Route;
+enum class HttpMethod;
+
+// 路径参数：名称指向路由的参数名，值以偏移和长度记录在请求路径中，请求对象复制或移动后仍然有效
+struct RouteParams {
+    static constexpr size_t MAX_PARAMS = 8;
+    struct Param {
+        std::string_view name;
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+    std::array<Param, MAX_PARAMS> items;
+    size_t count = 0;
+};
+
+class Router {
+public:
+    Router();
+    ~Router();
+    Router(const Router&) = delete;
+    Router& operator=(const Router&) = delete;
+
+    // 查找结果：route为请求方法的路由，HEAD未单独注册时使用GET的路由；
+    // 路径已注册时allow为该路径的Allow头部值（已注册的方法，有GET时含HEAD，总含OPTIONS），注册时生成
+    struct Match {
+        Route* route = nullptr;
+        const std::string* allow = nullptr;
+    };
+
+    // 参数名写入route->param_names；模式无效、参数超过MAX_PARAMS或同一方法下已有等价模式时返回false
+    bool add(HttpMethod method, const std::string& path, Route* route);
+    // 先按请求方法匹配，未匹配时再查找注册了其他方法的路径，以便回复405或OPTIONS
+    Match lookup(HttpMethod method, std::string_view path, RouteParams& params) const;
+    // 未匹配时返回nullptr
+    Route* find(HttpMethod method, std::string_view path, RouteParams& params) const {
+        return lookup(method, path, params).route;
+    }
+    size_t size() const { return size_; }
+
+private:
+    struct Node;
+    static constexpr size_t METHOD_COUNT = 9;
+
+    std::unique_ptr<Node> root_;
+    size_t size_ = 0;
+
+    static Node* insert_static(Node* node, std::string_view text);
+    // methods为方法位掩码，只在注册了其中某个方法的节点上结束匹配
+    static const Node* match(const Node* node, const char* begin, std::string_view rest, uint16_t methods,
+                             RouteParams& params);
+};
+
+#endif // ROUTER_H
@@ -0,0 +1,100 @@
+#ifndef STATIC_CACHE_H
+#define STATIC_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <sys/types.h>
+
+// 静态文件缓存：以URL映射出的文件路径为键缓存文件内容，按LRU淘汰，总字节数不超过预算；
+// 可压缩的类型在载入时生成一次gzip变体。后台线程经inotify监视静态目录（含子目录），
+// 文件变化时相关条目随即失效，因此命中时不需要stat或open；根目录路径中的符号链接改指向时
+// 重新解析根目录并清空缓存。线程安全。
+class StaticFileCache {
+public:
+    struct Entry {
+        std::string file_path;     // 解析符号链接后的实际路径，按它匹配inotify事件
+        std::string content_type;
+        std::shared_ptr<const std::string> body;
+        std::shared_ptr<const std::string> gzip_body;  // 不可压缩或压缩无收益时为空
+        std::string etag;          // 与未缓存时由stat生成的相同
+        time_t mtime = 0;
+
+        size_t bytes() const;
+    };
+
+    struct Stats {
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        std::atomic<uint64_t> evictions{0};      // 超出预算被淘汰的条目
+        std::atomic<uint64_t> invalidations{0};  // 文件变化而失效的条目
+        std::atomic<uint64_t> resident_bytes{0};
+        std::atomic<uint64_t> entries{0};
+    };
+
+    StaticFileCache(size_t budget, size_t max_file_size, int gzip_level);
+    ~StaticFileCache();
+
+    StaticFileCache(const StaticFileCache&) = delete;
+    StaticFileCache& operator=(const StaticFileCache&) = delete;
+
+    // 创建inotify实例并启动监视线程；失败时返回false，缓存保持停用
+    bool start();
+    void stop();
+    bool enabled() const { return running_.load(); }
+    // 监视目录树，只有其中的文件会被缓存；root可以含符号链接或多余的分隔符。可在start之后调用
+    bool watch(const std::string& root);
+
+    // 命中时返回条目并移到LRU头部
+    std::shared_ptr<const Entry> find(const std::string& key);
+    // 未命中时读入file_path并缓存在key下。文件过大、不是普通文件或不在监视范围内时返回nullptr，
+    // 由调用方按原方式发送；读入期间有文件失效时照常返回条目但不缓存
+    std::shared_ptr<const Entry> load(const std::string& key, const std::string& file_path,
+                                      const std::string& content_type);
+    void clear();
+    const Stats& stats() const { return stats_; }
+
+private:
+    using LruList = std::list<std::pair<std::string, std::shared_ptr<const Entry>>>;
+
+    size_t budget_;
+    size_t max_file_size_;
+    int gzip_level_;
+    Stats stats_;
+
+    std::mutex mutex_;
+    LruList lru_;  // 最近使用的在前
+    std::unordered_map<std::string, LruList::iterator> index_;
+    size_t resident_ = 0;
+    uint64_t generation_ = 0;  // 每次失效递增，读入期间变化的内容不进入缓存
+
+    // inotify：监视描述符到目录实际路径，由watch_mutex_保护
+    int inotify_fd_ = -1;
+    int wake_fd_ = -1;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+    std::mutex watch_mutex_;
+    std::unordered_map<int, std::string> watches_;
+    std::unordered_map<int, std::unordered_set<std::string>> links_;  // 根目录路径上符号链接所在目录的监视与链接名
+    std::vector<std::string> roots_;             // 已监视的根目录实际路径
+    std::vector<std::string> configured_roots_;  // watch()传入的原始路径，符号链接改指向后据此重新解析
+
+    void watch_loop();
+    void watch_tree(const std::string& dir);
+    void watch_links(const std::string& root);
+    void rewatch_roots();
+    void handle_events(const char* buf, size_t len);
+    // 移除path本身及其下的条目
+    void invalidate(const std::string& path);
+    bool watched(const std::string& real_path);
+    void evict_locked();
+};
+
+#endif // STATIC_CACHE_H
@@ -0,0 +1,99 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+
+// 分层时间轮
+// 以tick为单位调度，插入O(1)，每个tick只处理到期的槽位；较远的定时器放在高层，
+// 随时间推进逐层下移。不支持取消：调用方在到期回调中自行判断定时器是否仍然有效。
+// 非线程安全，由拥有它的事件循环线程独占使用。
+template<typename T>
+class TimerWheel {
+public:
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 6;
+    static constexpr uint64_t SLOTS = 1ULL << SLOT_BITS;
+
+    // 以当前tick为起点，丢弃所有已调度的定时器
+    void reset(uint64_t now_tick) {
+        for (auto& level : slots_) {
+            for (auto& slot : level) {
+                slot.clear();
+            }
+        }
+        current_ = now_tick;
+        size_ = 0;
+    }
+
+    void schedule(uint64_t expire_tick, T value) {
+        // 当前tick的槽位已处理过，已到期的定时器在下一个tick触发
+        place(Entry{std::max(expire_tick, current_ + 1), std::move(value)});
+        ++size_;
+    }
+
+    // 推进到now_tick，对每个到期的定时器调用 on_expire(T& value, uint64_t expire_tick)
+    template<typename F>
+    void advance(uint64_t now_tick, F&& on_expire) {
+        while (current_ < now_tick) {
+            ++current_;
+            cascade(1);
+
+            std::vector<Entry> expired;
+            expired.swap(slots_[0][current_ & (SLOTS - 1)]);
+            for (auto& entry : expired) {
+                if (entry.expire > current_) {
+                    place(std::move(entry));  // 超出时间轮范围而被截断的定时器
+                    continue;
+                }
+                --size_;
+                on_expire(entry.value, entry.expire);
+            }
+        }
+    }
+
+    uint64_t current_tick() const { return current_; }
+    size_t size() const { return size_; }
+
+private:
+    struct Entry {
+        uint64_t expire;
+        T value;
+    };
+
+    std::vector<Entry> slots_[LEVELS][SLOTS];
+    uint64_t current_ = 0;
+    size_t size_ = 0;
+
+    // 调用方保证 entry.expire >= current_；等于current_仅出现在降层时，随后即在本tick处理
+    void place(Entry&& entry) {
+        uint64_t expire = entry.expire;
+        uint64_t delta = expire - current_;
+        for (int level = 0; level < LEVELS; ++level) {
+            if (delta < (SLOTS << (level * SLOT_BITS)) || level == LEVELS - 1) {
+                uint64_t tick = level == LEVELS - 1 && delta >= (SLOTS << (level * SLOT_BITS)) ?
+                    current_ + (SLOTS << (level * SLOT_BITS)) - 1 : expire;
+                slots_[level][(tick >> (level * SLOT_BITS)) & (SLOTS - 1)].push_back(std::move(entry));
+                return;
+            }
+        }
+    }
+
+    // 低层转完一圈时，把上一层当前槽位的定时器重新分配到更低的层
+    void cascade(int level) {
+        if (level >= LEVELS || (current_ & ((1ULL << (level * SLOT_BITS)) - 1)) != 0) {
+            return;
+        }
+        cascade(level + 1);
+        std::vector<Entry> entries;
+        entries.swap(slots_[level][(current_ >> (level * SLOT_BITS)) & (SLOTS - 1)]);
+        for (auto& entry : entries) {
+            place(std::move(entry));
+        }
+    }
+};
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,150 @@
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include "core/http_server.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// WebSocket帧解析（RFC 6455 第5节）
+// 每次从输入中取出一个完整的帧并去掉掩码；保留位、未知操作码、控制帧分片或超长、
+// 客户端帧未加掩码等协议错误返回ERROR，close_code()给出应回复的关闭码。
+class WebSocketFrameParser {
+public:
+    enum class Result { FRAME, INCOMPLETE, ERROR };
+
+    struct Frame {
+        bool fin = false;
+        bool rsv1 = false;    // permessage-deflate：消息已压缩，只出现在消息的第一帧
+        uint8_t opcode = 0;
+        std::string payload;  // 已去掉掩码
+    };
+
+    explicit WebSocketFrameParser(size_t max_payload = SIZE_MAX, bool require_mask = true)
+        : max_payload_(max_payload), require_mask_(require_mask) {}
+
+    Result parse(std::string_view in, size_t& consumed, Frame& frame);
+    uint16_t close_code() const { return close_code_; }
+
+private:
+    size_t max_payload_;
+    bool require_mask_;
+    uint16_t close_code_ = 0;
+};
+
+// 升级后的WebSocket连接
+// 收到的帧由持有连接的工作线程解析，完整的消息（分片已合并、已解压）依次交给on_message回调，
+// 同一连接的回调不会并发执行；on_close在连接关闭后由线程池调用一次，可能与最后的on_message并发。
+// 发送可在任意线程进行，服务器帧不加掩码，同一份编码好的帧可以发给多个连接：
+// prepare()只编码、压缩一次，适合向大量连接广播。permessage-deflate固定协商server_no_context_takeover，
+// 每条消息独立压缩，压缩结果与连接无关。输出积压超过output_high_water_mark时发送失败并断开连接。
+class WebSocket : public std::enable_shared_from_this<WebSocket> {
+public:
+    enum Opcode : uint8_t {
+        CONTINUATION = 0x0,
+        TEXT = 0x1,
+        BINARY = 0x2,
+        CLOSE = 0x8,
+        PING = 0x9,
+        PONG = 0xA
+    };
+
+    // 常用关闭码
+    static constexpr uint16_t NORMAL_CLOSURE = 1000;
+    static constexpr uint16_t GOING_AWAY = 1001;
+    static constexpr uint16_t PROTOCOL_ERROR = 1002;
+    static constexpr uint16_t NO_STATUS = 1005;        // 关闭帧未携带关闭码，不可发送
+    static constexpr uint16_t ABNORMAL_CLOSURE = 1006; // 未经关闭握手断开，不可发送
+    static constexpr uint16_t INVALID_DATA = 1007;
+    static constexpr uint16_t MESSAGE_TOO_BIG = 1009;
+    static constexpr uint16_t INTERNAL_ERROR = 1011;
+
+    using MessageHandler = std::function<void(WebSocket& ws, std::string_view data, bool binary)>;
+    using CloseHandler = std::function<void(WebSocket& ws, uint16_t code, std::string_view reason)>;
+
+    // 预先编码的消息
+    struct Message {
+        std::shared_ptr<const std::string> frame;
+        std::shared_ptr<const std::string> deflated_frame;  // 过短、压缩无收益或不支持压缩时为空
+    };
+    static std::shared_ptr<const Message> prepare(std::string_view data, bool binary = false);
+
+    // 握手参数，由HttpServer::accept_websocket协商
+    struct Options {
+        bool deflate = false;
+        bool client_no_context_takeover = false;  // 客户端每条消息独立压缩，解压上下文随之重置
+        size_t max_message_size = SIZE_MAX;
+    };
+
+    WebSocket(HttpServer& server, HttpServer::Connection& conn, uint64_t sequence,
+              std::string path, const Options& options);
+    ~WebSocket();
+
+    // 应在accept_websocket返回后、处理器返回前注册，之后才开始解析收到的帧；
+    // 回调参数已给出连接本身，回调中无需捕获其shared_ptr（会形成循环引用）
+    void on_message(MessageHandler handler) { message_handler_ = std::move(handler); }
+    void on_close(CloseHandler handler) { close_handler_ = std::move(handler); }
+
+    bool send_text(std::string_view data);
+    bool send_binary(std::string_view data);
+    bool send(const std::shared_ptr<const Message>& message);
+    bool ping(std::string_view payload = {});
+    // 发起关闭握手；对端回复关闭帧后断开，未回复时在keep_alive_timeout后断开
+    void close(uint16_t code = NORMAL_CLOSURE, std::string_view reason = {});
+
+    bool is_open() const;
+    bool deflate() const { return options_.deflate; }
+    const std::string& path() const { return path_; }
+
+    // 编码一个不加掩码的完整帧
+    static std::string encode_frame(uint8_t opcode, std::string_view payload, bool rsv1 = false);
+    static bool valid_utf8(std::string_view data);
+
+private:
+    friend class HttpServer;
+    using Connection = HttpServer::Connection;
+    struct Inflater;
+
+    HttpServer& server_;
+    std::weak_ptr<Connection> conn_;
+    uint64_t sequence_;
+    std::string path_;
+    Options options_;
+    MessageHandler message_handler_;
+    CloseHandler close_handler_;
+
+    // 发送端：关闭帧发出后不再发送（send_mutex_保护）
+    mutable std::mutex send_mutex_;
+    bool close_sent_ = false;
+
+    // 接收端：只由持有连接的工作线程访问
+    WebSocketFrameParser parser_;
+    std::string message_;
+    uint8_t message_opcode_ = 0;  // 正在接收的分片消息，0表示没有
+    bool message_deflated_ = false;
+    std::unique_ptr<Inflater> inflater_;
+
+    // 关闭原因：关闭前由持有者记录，on_close经线程池在关闭后读取
+    uint16_t close_code_ = ABNORMAL_CLOSURE;
+    std::string close_reason_;
+    std::atomic<bool> close_notified_{false};
+
+    // 解析缓冲区中的完整帧并从中移除，完整的消息追加到messages（第二项表示二进制）；
+    // 返回false表示不再读取（收到关闭帧或协议错误，关闭帧已回复）
+    bool receive(std::string& buffer, std::vector<std::pair<std::string, bool>>& messages);
+    bool finish_message(std::vector<std::pair<std::string, bool>>& messages);
+    bool send_message(uint8_t opcode, std::string_view data);
+    bool send_frame(HttpServer::OutputChunk frame);
+    // 协议错误：记录关闭码，回复关闭帧后断开
+    void fail(uint16_t code);
+    // 关闭帧是本连接的最后输出；close_after表示写出后立即断开，否则等待对端的关闭帧
+    void send_close(uint16_t code, std::string_view reason, bool close_after);
+    void notify_closed();
+};
+
+#endif // WEBSOCKET_H
@@ -0,0 +1,43 @@
+#!/usr/bin/env bash
+# 热重启部署：新进程经 server.handoff_path 从旧进程接收监听套接字后立即开始服务，
+# 旧进程停止accept，排空已有连接（至多 server.drain_timeout_seconds）后自行退出。
+# 用法: scripts/deploy.sh [配置文件]
+set -euo pipefail
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+CONFIG="${1:-config/server.json}"
+BUILD_DIR="$ROOT/build"
+BINARY="$BUILD_DIR/oj_server"
+PID_FILE="$ROOT/logs/oj_server.pid"
+
+cd "$ROOT"
+cmake -S . -B "$BUILD_DIR" -DCMAKE_BUILD_TYPE=Release
+cmake --build "$BUILD_DIR" --target oj_server -j"$(nproc)"
+
+mkdir -p logs
+OLD_PID=""
+if [[ -f "$PID_FILE" ]] && kill -0 "$(cat "$PID_FILE")" 2>/dev/null; then
+    OLD_PID="$(cat "$PID_FILE")"
+fi
+
+# 运行中的可执行文件不能被覆盖，先复制一份再启动
+RELEASE="$BUILD_DIR/oj_server.$(date +%Y%m%d%H%M%S)"
+cp "$BINARY" "$RELEASE"
+nohup "$RELEASE" "$CONFIG" >> logs/oj_server.out 2>&1 &
+NEW_PID=$!
+echo "$NEW_PID" > "$PID_FILE"
+echo "Started oj_server (pid $NEW_PID)"
+
+sleep 1
+if ! kill -0 "$NEW_PID" 2>/dev/null; then
+    echo "New process exited during startup, see logs/oj_server.out" >&2
+    exit 1
+fi
+
+if [[ -n "$OLD_PID" ]]; then
+    echo "Waiting for previous process (pid $OLD_PID) to drain..."
+    while kill -0 "$OLD_PID" 2>/dev/null; do
+        sleep 1
+    done
+    echo "Previous process exited"
+fi
@@ -0,0 +1,250 @@
+#include "core/compression.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <strings.h>
+#ifdef XKOJ_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+std::string_view trim(std::string_view s) {
+    while(!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while(!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && strncasecmp(a.data(), b.data(), a.size()) == 0;
+}
+
+bool istarts_with(std::string_view s, std::string_view prefix) {
+    return s.size() >= prefix.size() && strncasecmp(s.data(), prefix.data(), prefix.size()) == 0;
+}
+
+bool iends_with(std::string_view s, std::string_view suffix) {
+    return s.size() >= suffix.size() &&
+           strncasecmp(s.data() + s.size() - suffix.size(), suffix.data(), suffix.size()) == 0;
+}
+
+// q参数，缺省为1；无法解析时按0处理
+double parse_q(std::string_view params) {
+    while(!params.empty()) {
+        size_t semi = params.find(';');
+        std::string_view param = trim(params.substr(0, semi));
+        params = semi == std::string_view::npos ? std::string_view() : params.substr(semi + 1);
+        if(param.size() >= 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+            std::string value(trim(param.substr(2)));
+            char* end = nullptr;
+            double q = std::strtod(value.c_str(), &end);
+            return end == value.c_str() + value.size() && q >= 0 && q <= 1 ? q : 0;
+        }
+    }
+    return 1;
+}
+
+#ifdef XKOJ_HAVE_ZLIB
+// gzip与deflate（zlib格式，RFC 9110 8.4.1.2）只差窗口参数中的格式位
+int window_bits(ContentCoding coding) {
+    return coding == ContentCoding::GZIP ? MAX_WBITS + 16 : MAX_WBITS;
+}
+
+// 每个线程每种编码一个上下文，每次压缩前重置，省去deflateInit分配约256KB状态的开销
+struct DeflateContext {
+    z_stream zs{};
+    bool ok = false;
+    int level = Z_DEFAULT_COMPRESSION;
+    explicit DeflateContext(ContentCoding coding) {
+        ok = deflateInit2(&zs, level, Z_DEFLATED, window_bits(coding), 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+    ~DeflateContext() {
+        if(ok) {
+            deflateEnd(&zs);
+        }
+    }
+};
+
+// 压缩全部输入追加到out；flush为Z_SYNC_FLUSH或Z_FINISH
+bool run_deflate(z_stream& zs, std::string_view in, std::string& out, int flush) {
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(in.size());
+    size_t total = out.size();
+    out.resize(total + deflateBound(&zs, in.size()) + 16);
+    int ret;
+    while(true) {
+        zs.next_out = reinterpret_cast<Bytef*>(&out[total]);
+        zs.avail_out = static_cast<uInt>(out.size() - total);
+        ret = deflate(&zs, flush);
+        total = out.size() - zs.avail_out;
+        if(ret == Z_STREAM_END) {
+            break;
+        }
+        if(ret != Z_OK && ret != Z_BUF_ERROR) {
+            out.resize(total);
+            return false;
+        }
+        // 输出空间未用完说明已刷新完毕；Z_BUF_ERROR表示没有可输出的内容
+        if(zs.avail_out != 0 && (flush != Z_FINISH || ret == Z_BUF_ERROR)) {
+            break;
+        }
+        out.resize(out.size() * 2);
+    }
+    out.resize(total);
+    return zs.avail_in == 0;
+}
+#endif
+
+}
+
+namespace compression {
+
+ContentCoding negotiate(std::string_view accept_encoding) {
+#ifdef XKOJ_HAVE_ZLIB
+    double gzip_q = -1;
+    double deflate_q = -1;
+    double any_q = -1;
+    while(!accept_encoding.empty()) {
+        size_t comma = accept_encoding.find(',');
+        std::string_view item = accept_encoding.substr(0, comma);
+        accept_encoding = comma == std::string_view::npos ? std::string_view() : accept_encoding.substr(comma + 1);
+        size_t semi = item.find(';');
+        std::string_view coding = trim(item.substr(0, semi));
+        double q = semi == std::string_view::npos ? 1 : parse_q(item.substr(semi + 1));
+        if(iequals(coding, "gzip") || iequals(coding, "x-gzip")) {
+            gzip_q = std::max(gzip_q, q);
+        }
+        else if(iequals(coding, "deflate")) {
+            deflate_q = q;
+        }
+        else if(coding == "*") {
+            any_q = q;
+        }
+    }
+    // 未列出的编码按*的q值处理
+    if(gzip_q < 0) {
+        gzip_q = any_q;
+    }
+    if(deflate_q < 0) {
+        deflate_q = any_q;
+    }
+    if(gzip_q > 0 && gzip_q >= deflate_q) {
+        return ContentCoding::GZIP;
+    }
+    if(deflate_q > 0) {
+        return ContentCoding::DEFLATE;
+    }
+#else
+    (void)accept_encoding;
+#endif
+    return ContentCoding::IDENTITY;
+}
+
+const char* coding_name(ContentCoding coding) {
+    switch(coding) {
+        case ContentCoding::GZIP: return "gzip";
+        case ContentCoding::DEFLATE: return "deflate";
+        default: return "identity";
+    }
+}
+
+bool compressible_type(std::string_view content_type) {
+    content_type = trim(content_type.substr(0, content_type.find(';')));
+    if(istarts_with(content_type, "text/")) {
+        return !iequals(content_type, "text/event-stream");
+    }
+    if(iends_with(content_type, "+json") || iends_with(content_type, "+xml")) {
+        return true;
+    }
+    static const char* const types[] = {
+        "application/json", "application/javascript", "application/x-javascript", "application/xml",
+        "application/x-www-form-urlencoded", "application/wasm", "application/x-ndjson",
+        "application/vnd.ms-fontobject", "font/ttf", "font/otf", "image/x-icon", "image/bmp",
+    };
+    for(const char* type : types) {
+        if(iequals(content_type, type)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool compress(ContentCoding coding, int level, std::string_view in, std::string& out) {
+#ifdef XKOJ_HAVE_ZLIB
+    if(coding == ContentCoding::IDENTITY) {
+        return false;
+    }
+    thread_local DeflateContext gzip_ctx(ContentCoding::GZIP);
+    thread_local DeflateContext deflate_ctx(ContentCoding::DEFLATE);
+    DeflateContext& ctx = coding == ContentCoding::GZIP ? gzip_ctx : deflate_ctx;
+    if(!ctx.ok) {
+        return false;
+    }
+    deflateReset(&ctx.zs);
+    if(ctx.level != level) {
+        // 刚重置的流上调整级别不会产生输出
+        if(deflateParams(&ctx.zs, level, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return false;
+        }
+        ctx.level = level;
+    }
+    out.clear();
+    return run_deflate(ctx.zs, in, out, Z_FINISH) && out.size() < in.size();
+#else
+    (void)coding;
+    (void)level;
+    (void)in;
+    (void)out;
+    return false;
+#endif
+}
+
+}
+
+struct StreamCompressor::State {
+#ifdef XKOJ_HAVE_ZLIB
+    z_stream zs{};
+#endif
+    bool ok = false;
+    bool finished = false;
+};
+
+StreamCompressor::StreamCompressor(ContentCoding coding, int level) : state_(std::make_unique<State>()) {
+#ifdef XKOJ_HAVE_ZLIB
+    state_->ok = coding != ContentCoding::IDENTITY &&
+                 deflateInit2(&state_->zs, level, Z_DEFLATED, window_bits(coding), 8, Z_DEFAULT_STRATEGY) == Z_OK;
+#else
+    (void)coding;
+    (void)level;
+#endif
+}
+
+StreamCompressor::~StreamCompressor() {
+#ifdef XKOJ_HAVE_ZLIB
+    if(state_->ok) {
+        deflateEnd(&state_->zs);
+    }
+#endif
+}
+
+bool StreamCompressor::ok() const {
+    return state_->ok;
+}
+
+bool StreamCompressor::write(std::string_view in, std::string& out, bool finish) {
+    if(!state_->ok || state_->finished) {
+        return false;
+    }
+#ifdef XKOJ_HAVE_ZLIB
+    state_->finished = finish;
+    return run_deflate(state_->zs, in, out, finish ? Z_FINISH : Z_SYNC_FLUSH);
+#else
+    (void)in;
+    (void)out;
+    return false;
+#endif
+}
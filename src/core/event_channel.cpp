@@ -0,0 +1,246 @@
+#include "core/event_channel.h"
+#include "core/http_request.h"
+#include "core/http_response.h"
+#include <cstdio>
+#include <cstdlib>
+
+// 心跳为SSE注释行，客户端忽略；订阅连接不再读取请求，对端断开只能在写出时发现
+static const char HEARTBEAT[] = ":\n\n";
+static const char CHUNKED_HEARTBEAT[] = "3\r\n:\n\n\r\n";
+static const char LAST_CHUNK[] = "0\r\n\r\n";
+
+EventChannel::EventChannel(HttpServer& server, std::string name, size_t replay_capacity)
+    : server_(server), name_(std::move(name)), replay_capacity_(replay_capacity) {}
+
+uint64_t EventChannel::publish(std::string_view data, std::string_view event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t id = next_id_++;
+
+    std::string frame = "id: " + std::to_string(id) + "\n";
+    if(!event.empty()) {
+        frame.append("event: ").append(event).append("\n");
+    }
+    size_t start = 0;
+    while(true) {
+        size_t end = data.find('\n', start);
+        std::string_view line = data.substr(start, end == std::string_view::npos ? end : end - start);
+        if(!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        frame.append("data: ").append(line).append("\n");
+        if(end == std::string_view::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    frame.append("\n");
+
+    char size_line[24];
+    int n = snprintf(size_line, sizeof(size_line), "%zx\r\n", frame.size());
+    std::string chunked;
+    chunked.reserve(n + frame.size() + 2);
+    chunked.append(size_line, n).append(frame).append("\r\n");
+
+    Event ev{id, std::make_shared<const std::string>(std::move(frame)),
+             std::make_shared<const std::string>(std::move(chunked))};
+    if(replay_capacity_ > 0) {
+        if(replay_.size() >= replay_capacity_) {
+            replay_.pop_front();
+        }
+        replay_.push_back(ev);
+    }
+
+    // 所有订阅者共享同一份帧；失效的订阅者与末尾交换后移除
+    int64_t now = HttpServer::now_ms();
+    size_t delivered = 0;
+    for(size_t i = 0; i < subscribers_.size();) {
+        Subscriber& subscriber = subscribers_[i];
+        if(deliver(subscriber, HttpServer::OutputChunk(subscriber.chunked ? ev.chunked_frame : ev.frame), now)) {
+            ++delivered;
+            ++i;
+        }
+        else {
+            subscribers_[i] = std::move(subscribers_.back());
+            subscribers_.pop_back();
+        }
+    }
+    server_.stats_.total_events_published.fetch_add(1);
+    server_.stats_.total_event_deliveries.fetch_add(delivered);
+    return id;
+}
+
+size_t EventChannel::subscriber_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return subscribers_.size();
+}
+
+uint64_t EventChannel::last_event_id() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return next_id_ - 1;
+}
+
+void EventChannel::close() {
+    std::vector<Subscriber> subscribers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscribers.swap(subscribers_);
+    }
+    for(auto& subscriber : subscribers) {
+        auto conn = subscriber.conn.lock();
+        if(!conn) {
+            continue;
+        }
+        std::vector<HttpServer::OutputChunk> chunks;
+        if(subscriber.chunked) {
+            chunks.emplace_back(LAST_CHUNK, sizeof(LAST_CHUNK) - 1);
+        }
+        server_.enqueue_output(*conn, subscriber.sequence, std::move(chunks), true, true);
+    }
+}
+
+void EventChannel::add_subscriber(Connection& conn, uint64_t sequence, bool chunked,
+                                  bool resume, uint64_t after_id) {
+    // 补发与加入在同一把锁内完成，补发期间发布的事件不会遗漏或重复
+    std::lock_guard<std::mutex> lock(mutex_);
+    Subscriber subscriber{conn.weak_from_this(), sequence, chunked, HttpServer::now_ms()};
+    if(resume) {
+        std::vector<HttpServer::OutputChunk> chunks;
+        for(const auto& ev : replay_) {
+            if(ev.id > after_id) {
+                chunks.emplace_back(chunked ? ev.chunked_frame : ev.frame);
+            }
+        }
+        if(!chunks.empty()) {
+            server_.stats_.total_event_deliveries.fetch_add(chunks.size());
+            server_.enqueue_output(conn, sequence, std::move(chunks), false, false);
+        }
+    }
+    subscribers_.push_back(std::move(subscriber));
+}
+
+void EventChannel::send_heartbeats(int64_t now, int64_t interval_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for(size_t i = 0; i < subscribers_.size();) {
+        Subscriber& subscriber = subscribers_[i];
+        bool alive = true;
+        if(now - subscriber.last_sent_ms >= interval_ms) {
+            HttpServer::OutputChunk chunk = subscriber.chunked ?
+                HttpServer::OutputChunk(CHUNKED_HEARTBEAT, sizeof(CHUNKED_HEARTBEAT) - 1) :
+                HttpServer::OutputChunk(HEARTBEAT, sizeof(HEARTBEAT) - 1);
+            alive = deliver(subscriber, std::move(chunk), now);
+        }
+        else {
+            auto conn = subscriber.conn.lock();
+            alive = conn && !conn->closed.load();
+        }
+        if(alive) {
+            ++i;
+        }
+        else {
+            subscribers_[i] = std::move(subscribers_.back());
+            subscribers_.pop_back();
+        }
+    }
+}
+
+bool EventChannel::deliver(Subscriber& subscriber, HttpServer::OutputChunk chunk, int64_t now) {
+    auto conn = subscriber.conn.lock();
+    if(!conn || conn->closed.load()) {
+        return false;
+    }
+    // 跟不上的订阅者被断开，由客户端按Last-Event-ID续传
+    std::vector<HttpServer::OutputChunk> chunks;
+    chunks.push_back(std::move(chunk));
+    if(!server_.push_output(*conn, subscriber.sequence, std::move(chunks))) {
+        return false;
+    }
+    subscriber.last_sent_ms = now;
+    return true;
+}
+
+// HttpServer中与SSE相关的部分
+
+std::shared_ptr<EventChannel> HttpServer::event_channel(const std::string& name) {
+    std::lock_guard<std::mutex> lock(channels_mutex_);
+    auto& channel = channels_[name];
+    if(!channel) {
+        channel = std::make_shared<EventChannel>(*this, name, config_.sse_replay_capacity);
+    }
+    return channel;
+}
+
+void HttpServer::remove_event_channel(const std::string& name) {
+    std::shared_ptr<EventChannel> channel;
+    {
+        std::lock_guard<std::mutex> lock(channels_mutex_);
+        auto it = channels_.find(name);
+        if(it == channels_.end()) {
+            return;
+        }
+        channel = std::move(it->second);
+        channels_.erase(it);
+    }
+    channel->close();
+}
+
+bool HttpServer::subscribe(const HttpRequest& request, HttpResponse& response,
+                           const std::shared_ptr<EventChannel>& channel) {
+    // 只有经handle_request分发的HTTP/1.1响应才挂有连接上的流，HTTP/2的流不能转为长连接推送
+    auto* stream = dynamic_cast<ConnectionResponseStream*>(response.stream());
+    if(!stream || !channel) {
+        return false;
+    }
+    response.set_header("Content-Type", "text/event-stream");
+    response.set_header("Cache-Control", "no-cache");
+    response.set_header("X-Accel-Buffering", "no");  // 提示反向代理不要缓冲
+    if(!response.start_streaming()) {
+        return false;
+    }
+    if(request.method() == "HEAD") {
+        return true;  // 只回复头部，响应照常结束
+    }
+
+    // 响应不再由处理器结束；连接上不会再有后续请求
+    stream->detach();
+    Connection& conn = stream->connection();
+    conn.input_closed = true;
+    conn.event_stream = true;
+    {
+        // 订阅连接可能长期存在，释放不再使用的读缓冲区
+        std::lock_guard<std::mutex> lock(conn.io_mutex);
+        std::string().swap(conn.buffer);
+    }
+
+    bool resume = request.has_header("Last-Event-ID");
+    uint64_t after_id = 0;
+    if(resume) {
+        std::string last_id = request.get_header("Last-Event-ID");
+        char* end = nullptr;
+        after_id = strtoull(last_id.c_str(), &end, 10);
+        resume = end != last_id.c_str() && *end == '\0';
+    }
+    channel->add_subscriber(conn, stream->sequence(), stream->chunked(), resume, after_id);
+    return true;
+}
+
+void HttpServer::send_event_heartbeats() {
+    // 由0号Reactor每秒调用一次，只向空闲达到间隔的订阅者发送
+    if(config_.sse_heartbeat_seconds <= 0) {
+        return;
+    }
+    int64_t now = now_ms();
+    if(now < next_heartbeat_scan_ms_) {
+        return;
+    }
+    next_heartbeat_scan_ms_ = now + 1000;
+    std::vector<std::shared_ptr<EventChannel>> channels;
+    {
+        std::lock_guard<std::mutex> lock(channels_mutex_);
+        for(auto& [name, channel] : channels_) {
+            channels.push_back(channel);
+        }
+    }
+    for(auto& channel : channels) {
+        channel->send_heartbeats(now, config_.sse_heartbeat_seconds * 1000);
+    }
+}
@@ -0,0 +1,418 @@
+#include "core/hpack.h"
+#include <algorithm>
+
+// RFC 7541 附录A：静态表
+static const struct {
+    const char* name;
+    const char* value;
+} STATIC_TABLE[HpackTable::STATIC_COUNT] = {
+    {":authority", ""}, {":method", "GET"}, {":method", "POST"}, {":path", "/"},
+    {":path", "/index.html"}, {":scheme", "http"}, {":scheme", "https"}, {":status", "200"},
+    {":status", "204"}, {":status", "206"}, {":status", "304"}, {":status", "400"},
+    {":status", "404"}, {":status", "500"}, {"accept-charset", ""}, {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""}, {"accept-ranges", ""}, {"accept", ""}, {"access-control-allow-origin", ""},
+    {"age", ""}, {"allow", ""}, {"authorization", ""}, {"cache-control", ""},
+    {"content-disposition", ""}, {"content-encoding", ""}, {"content-language", ""}, {"content-length", ""},
+    {"content-location", ""}, {"content-range", ""}, {"content-type", ""}, {"cookie", ""},
+    {"date", ""}, {"etag", ""}, {"expect", ""}, {"expires", ""},
+    {"from", ""}, {"host", ""}, {"if-match", ""}, {"if-modified-since", ""},
+    {"if-none-match", ""}, {"if-range", ""}, {"if-unmodified-since", ""}, {"last-modified", ""},
+    {"link", ""}, {"location", ""}, {"max-forwards", ""}, {"proxy-authenticate", ""},
+    {"proxy-authorization", ""}, {"range", ""}, {"referer", ""}, {"refresh", ""},
+    {"retry-after", ""}, {"server", ""}, {"set-cookie", ""}, {"strict-transport-security", ""},
+    {"transfer-encoding", ""}, {"user-agent", ""}, {"vary", ""}, {"via", ""},
+    {"www-authenticate", ""},
+};
+
+// RFC 7541 附录B：Huffman编码表，下标为符号，256为EOS
+static const struct {
+    uint32_t code;
+    uint8_t bits;
+} HUFFMAN_CODES[257] = {
+    {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28}, {0xfffffe4, 28}, {0xfffffe5, 28},
+    {0xfffffe6, 28}, {0xfffffe7, 28}, {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},
+    {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28}, {0xfffffed, 28}, {0xfffffee, 28},
+    {0xfffffef, 28}, {0xffffff0, 28}, {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+    {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28}, {0xffffff8, 28}, {0xffffff9, 28},
+    {0xffffffa, 28}, {0xffffffb, 28}, {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12},
+    {0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11}, {0x3fa, 10}, {0x3fb, 10},
+    {0xf9, 8}, {0x7fb, 11}, {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},
+    {0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6}, {0x1a, 6}, {0x1b, 6},
+    {0x1c, 6}, {0x1d, 6}, {0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8},
+    {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10}, {0x1ffa, 13}, {0x21, 6},
+    {0x5d, 7}, {0x5e, 7}, {0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},
+    {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7}, {0x67, 7}, {0x68, 7},
+    {0x69, 7}, {0x6a, 7}, {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},
+    {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7}, {0xfc, 8}, {0x73, 7},
+    {0xfd, 8}, {0x1ffb, 13}, {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+    {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5}, {0x24, 6}, {0x5, 5},
+    {0x25, 6}, {0x26, 6}, {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7},
+    {0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5}, {0x2b, 6}, {0x76, 7},
+    {0x2c, 6}, {0x8, 5}, {0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},
+    {0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15}, {0x7fc, 11}, {0x3ffd, 14},
+    {0x1ffd, 13}, {0xffffffc, 28}, {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20},
+    {0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23}, {0x3fffd6, 22}, {0x7fffda, 23},
+    {0x7fffdb, 23}, {0x7fffdc, 23}, {0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},
+    {0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23}, {0xffffee, 24}, {0x7fffe1, 23},
+    {0x7fffe2, 23}, {0x7fffe3, 23}, {0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23},
+    {0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24}, {0x3fffda, 22}, {0x1fffdd, 21},
+    {0xfffe9, 20}, {0x3fffdb, 22}, {0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},
+    {0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24}, {0x1fffdf, 21}, {0x3fffdf, 22},
+    {0x7fffeb, 23}, {0x7fffec, 23}, {0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21},
+    {0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23}, {0xfffea, 20}, {0x3fffe2, 22},
+    {0x3fffe3, 22}, {0x3fffe4, 22}, {0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},
+    {0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19}, {0x3fffe7, 22}, {0x7ffff2, 23},
+    {0x3fffe8, 22}, {0x1ffffec, 25}, {0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27},
+    {0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25}, {0x7fff2, 19}, {0x1fffe3, 21},
+    {0x3ffffe6, 26}, {0x7ffffe0, 27}, {0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},
+    {0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26}, {0xffffffd, 28}, {0x7ffffe3, 27},
+    {0x7ffffe4, 27}, {0x7ffffe5, 27}, {0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21},
+    {0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23}, {0x3fffea, 22}, {0x3fffeb, 22},
+    {0x1ffffee, 25}, {0x1ffffef, 25}, {0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},
+    {0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26}, {0x7ffffe7, 27}, {0x7ffffe8, 27},
+    {0x7ffffe9, 27}, {0x7ffffea, 27}, {0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
+    {0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26}, {0x3fffffff, 30},
+};
+
+static constexpr size_t ENTRY_OVERHEAD = 32;
+static constexpr size_t ENCODER_TABLE_LIMIT = 4096;  // 对端允许更大时编码端也只用4KB
+
+// 编码表是规范Huffman码：同一长度的码字连续，且按符号顺序递增，按长度分段即可逐位查找
+namespace {
+struct HuffmanDecodeTable {
+    uint32_t first[31] = {};
+    uint16_t count[31] = {};
+    uint16_t offset[31] = {};
+    uint16_t symbols[257] = {};
+
+    HuffmanDecodeTable() {
+        uint16_t next = 0;
+        for(int bits = 5; bits <= 30; ++bits) {
+            offset[bits] = next;
+            for(uint16_t sym = 0; sym < 257; ++sym) {
+                if(HUFFMAN_CODES[sym].bits == bits) {
+                    if(count[bits] == 0) {
+                        first[bits] = HUFFMAN_CODES[sym].code;
+                    }
+                    ++count[bits];
+                    symbols[next++] = sym;
+                }
+            }
+        }
+    }
+};
+}
+
+namespace hpack {
+
+void encode_integer(uint64_t value, int prefix_bits, uint8_t first_byte, std::string& out) {
+    uint64_t max_prefix = (1u << prefix_bits) - 1;
+    if(value < max_prefix) {
+        out.push_back(static_cast<char>(first_byte | value));
+        return;
+    }
+    out.push_back(static_cast<char>(first_byte | max_prefix));
+    value -= max_prefix;
+    while(value >= 128) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool decode_integer(std::string_view in, size_t& pos, int prefix_bits, uint64_t& value) {
+    if(pos >= in.size()) {
+        return false;
+    }
+    uint64_t max_prefix = (1u << prefix_bits) - 1;
+    value = static_cast<uint8_t>(in[pos++]) & max_prefix;
+    if(value < max_prefix) {
+        return true;
+    }
+    // 超过32位的整数在HPACK中没有意义，拒绝以防溢出
+    for(int shift = 0; shift <= 28; shift += 7) {
+        if(pos >= in.size()) {
+            return false;
+        }
+        uint8_t b = static_cast<uint8_t>(in[pos++]);
+        value += static_cast<uint64_t>(b & 0x7F) << shift;
+        if(!(b & 0x80)) {
+            return value <= UINT32_MAX;
+        }
+    }
+    return false;
+}
+
+size_t huffman_encoded_size(std::string_view in) {
+    size_t bits = 0;
+    for(unsigned char c : in) {
+        bits += HUFFMAN_CODES[c].bits;
+    }
+    return (bits + 7) / 8;
+}
+
+void huffman_encode(std::string_view in, std::string& out) {
+    uint64_t acc = 0;
+    int acc_bits = 0;
+    for(unsigned char c : in) {
+        acc = (acc << HUFFMAN_CODES[c].bits) | HUFFMAN_CODES[c].code;
+        acc_bits += HUFFMAN_CODES[c].bits;
+        while(acc_bits >= 8) {
+            acc_bits -= 8;
+            out.push_back(static_cast<char>(acc >> acc_bits));
+        }
+    }
+    if(acc_bits > 0) {
+        // 以EOS的前缀（全1）填充到字节边界
+        out.push_back(static_cast<char>((acc << (8 - acc_bits)) | (0xFF >> acc_bits)));
+    }
+}
+
+bool huffman_decode(std::string_view in, std::string& out) {
+    static const HuffmanDecodeTable table;
+    uint32_t code = 0;
+    int bits = 0;
+    bool all_ones = true;
+    for(unsigned char byte : in) {
+        for(int i = 7; i >= 0; --i) {
+            uint32_t bit = (byte >> i) & 1;
+            code = (code << 1) | bit;
+            all_ones = all_ones && bit;
+            ++bits;
+            if(bits > 30) {
+                return false;
+            }
+            if(code - table.first[bits] < table.count[bits] && code >= table.first[bits]) {
+                uint16_t sym = table.symbols[table.offset[bits] + code - table.first[bits]];
+                if(sym == 256) {
+                    return false;  // 字符串中不得出现EOS
+                }
+                out.push_back(static_cast<char>(sym));
+                code = 0;
+                bits = 0;
+                all_ones = true;
+            }
+        }
+    }
+    // 填充不超过7位且必须全为1
+    return bits < 8 && all_ones;
+}
+
+}  // namespace hpack
+
+void HpackTable::add(std::string name, std::string value) {
+    size_t entry_size = name.size() + value.size() + ENTRY_OVERHEAD;
+    if(entry_size > max_size_) {
+        // 条目比整个表还大：清空表，不插入
+        entries_.clear();
+        size_ = 0;
+        return;
+    }
+    evict(entry_size);
+    size_ += entry_size;
+    entries_.push_front(HpackHeader{std::move(name), std::move(value)});
+}
+
+void HpackTable::set_max_size(size_t max_size) {
+    max_size_ = max_size;
+    evict(0);
+}
+
+void HpackTable::evict(size_t needed) {
+    while(!entries_.empty() && size_ + needed > max_size_) {
+        const HpackHeader& oldest = entries_.back();
+        size_ -= oldest.name.size() + oldest.value.size() + ENTRY_OVERHEAD;
+        entries_.pop_back();
+    }
+}
+
+const HpackHeader* HpackTable::get(size_t index) const {
+    static const std::vector<HpackHeader> statics = [] {
+        std::vector<HpackHeader> table;
+        for(const auto& entry : STATIC_TABLE) {
+            table.push_back(HpackHeader{entry.name, entry.value});
+        }
+        return table;
+    }();
+    if(index == 0) {
+        return nullptr;
+    }
+    if(index <= STATIC_COUNT) {
+        return &statics[index - 1];
+    }
+    index -= STATIC_COUNT + 1;
+    return index < entries_.size() ? &entries_[index] : nullptr;
+}
+
+size_t HpackTable::find(std::string_view name, std::string_view value, size_t& name_index) const {
+    name_index = 0;
+    for(size_t i = 0; i < STATIC_COUNT; ++i) {
+        if(name == STATIC_TABLE[i].name) {
+            if(value == STATIC_TABLE[i].value) {
+                return i + 1;
+            }
+            if(name_index == 0) {
+                name_index = i + 1;
+            }
+        }
+    }
+    for(size_t i = 0; i < entries_.size(); ++i) {
+        if(entries_[i].name == name) {
+            if(entries_[i].value == value) {
+                return STATIC_COUNT + 1 + i;
+            }
+            if(name_index == 0) {
+                name_index = STATIC_COUNT + 1 + i;
+            }
+        }
+    }
+    return 0;
+}
+
+static bool read_string(std::string_view in, size_t& pos, std::string& out) {
+    if(pos >= in.size()) {
+        return false;
+    }
+    bool huffman = static_cast<uint8_t>(in[pos]) & 0x80;
+    uint64_t length;
+    if(!hpack::decode_integer(in, pos, 7, length) || length > in.size() - pos) {
+        return false;
+    }
+    std::string_view data = in.substr(pos, length);
+    pos += length;
+    out.clear();
+    if(huffman) {
+        return hpack::huffman_decode(data, out);
+    }
+    out.assign(data);
+    return true;
+}
+
+HpackDecoder::Result HpackDecoder::decode(std::string_view block, std::vector<HpackHeader>& headers) {
+    size_t pos = 0;
+    size_t list_size = 0;
+    bool too_large = false;
+    bool header_seen = false;
+    while(pos < block.size()) {
+        uint8_t first = static_cast<uint8_t>(block[pos]);
+        uint64_t index;
+        if(first & 0x80) {
+            // 索引字段
+            if(!hpack::decode_integer(block, pos, 7, index)) {
+                return Result::ERROR;
+            }
+            const HpackHeader* entry = table_.get(index);
+            if(!entry) {
+                return Result::ERROR;
+            }
+            header_seen = true;
+            list_size += entry->name.size() + entry->value.size() + ENTRY_OVERHEAD;
+            if(list_size > max_list_size_) {
+                too_large = true;
+            }
+            else {
+                headers.push_back(*entry);
+            }
+            continue;
+        }
+        if((first & 0xE0) == 0x20) {
+            // 动态表大小更新只能出现在头部块开头
+            if(header_seen || !hpack::decode_integer(block, pos, 5, index) || index > max_table_size_) {
+                return Result::ERROR;
+            }
+            table_.set_max_size(index);
+            continue;
+        }
+        bool incremental = (first & 0xC0) == 0x40;
+        if(!hpack::decode_integer(block, pos, incremental ? 6 : 4, index)) {
+            return Result::ERROR;
+        }
+        HpackHeader header;
+        if(index != 0) {
+            const HpackHeader* entry = table_.get(index);
+            if(!entry) {
+                return Result::ERROR;
+            }
+            header.name = entry->name;
+        }
+        else if(!read_string(block, pos, header.name)) {
+            return Result::ERROR;
+        }
+        if(!read_string(block, pos, header.value)) {
+            return Result::ERROR;
+        }
+        header_seen = true;
+        list_size += header.name.size() + header.value.size() + ENTRY_OVERHEAD;
+        if(incremental) {
+            table_.add(header.name, header.value);
+        }
+        if(list_size > max_list_size_) {
+            too_large = true;
+        }
+        else {
+            headers.push_back(std::move(header));
+        }
+    }
+    return too_large ? Result::TOO_LARGE : Result::OK;
+}
+
+void HpackEncoder::set_max_table_size(size_t max_size) {
+    max_size = std::min(max_size, ENCODER_TABLE_LIMIT);
+    if(max_size == table_.max_size() && pending_table_size_ == SIZE_MAX) {
+        return;
+    }
+    min_table_size_ = std::min(min_table_size_, max_size);
+    pending_table_size_ = max_size;
+}
+
+void HpackEncoder::begin_block(std::string& out) {
+    if(pending_table_size_ == SIZE_MAX) {
+        return;
+    }
+    if(min_table_size_ < pending_table_size_) {
+        hpack::encode_integer(min_table_size_, 5, 0x20, out);
+    }
+    hpack::encode_integer(pending_table_size_, 5, 0x20, out);
+    table_.set_max_size(pending_table_size_);
+    pending_table_size_ = SIZE_MAX;
+    min_table_size_ = SIZE_MAX;
+}
+
+static void write_string(std::string_view value, std::string& out) {
+    size_t huffman_size = hpack::huffman_encoded_size(value);
+    if(huffman_size < value.size()) {
+        hpack::encode_integer(huffman_size, 7, 0x80, out);
+        hpack::huffman_encode(value, out);
+    }
+    else {
+        hpack::encode_integer(value.size(), 7, 0x00, out);
+        out.append(value);
+    }
+}
+
+void HpackEncoder::encode(std::string_view name, std::string_view value, std::string& out, Indexing indexing) {
+    size_t name_index = 0;
+    size_t index = table_.find(name, value, name_index);
+    if(index != 0 && indexing != Indexing::NEVER) {
+        hpack::encode_integer(index, 7, 0x80, out);
+        return;
+    }
+    switch(indexing) {
+        case Indexing::INCREMENTAL:
+            hpack::encode_integer(name_index, 6, 0x40, out);
+            break;
+        case Indexing::NONE:
+            hpack::encode_integer(name_index, 4, 0x00, out);
+            break;
+        case Indexing::NEVER:
+            hpack::encode_integer(name_index, 4, 0x10, out);
+            break;
+    }
+    if(name_index == 0) {
+        write_string(name, out);
+    }
+    write_string(value, out);
+    if(indexing == Indexing::INCREMENTAL) {
+        table_.add(std::string(name), std::string(value));
+    }
+}
@@ -0,0 +1,1182 @@
+#include "core/http2.h"
+#include "core/http_response.h"
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
+
+// 本端接收窗口：连接级在SETTINGS之后以WINDOW_UPDATE放大，流级经SETTINGS_INITIAL_WINDOW_SIZE通告，
+// 消费过半后补足
+static constexpr uint32_t LOCAL_CONNECTION_WINDOW = 1024 * 1024;
+static constexpr uint32_t LOCAL_STREAM_WINDOW = 256 * 1024;
+// 流式响应超出发送窗口时暂存的上限，超过后挂起处理器等待对端的WINDOW_UPDATE
+static constexpr size_t STREAM_BUFFER_LIMIT = 64 * 1024;
+
+namespace http2 {
+
+FrameHeader parse_frame_header(std::string_view in) {
+    const auto* p = reinterpret_cast<const unsigned char*>(in.data());
+    FrameHeader header;
+    header.length = (static_cast<uint32_t>(p[0]) << 16) | (static_cast<uint32_t>(p[1]) << 8) | p[2];
+    header.type = p[3];
+    header.flags = p[4];
+    header.stream_id = (static_cast<uint32_t>(p[5] & 0x7f) << 24) | (static_cast<uint32_t>(p[6]) << 16) |
+                       (static_cast<uint32_t>(p[7]) << 8) | p[8];
+    return header;
+}
+
+void append_frame_header(std::string& out, uint32_t length, uint8_t type, uint8_t flags, uint32_t stream_id) {
+    char header[FRAME_HEADER_SIZE] = {
+        static_cast<char>(length >> 16), static_cast<char>(length >> 8), static_cast<char>(length),
+        static_cast<char>(type), static_cast<char>(flags),
+        static_cast<char>((stream_id >> 24) & 0x7f), static_cast<char>(stream_id >> 16),
+        static_cast<char>(stream_id >> 8), static_cast<char>(stream_id)
+    };
+    out.append(header, FRAME_HEADER_SIZE);
+}
+
+}
+
+static uint32_t read_u32(const char* p) {
+    const auto* u = reinterpret_cast<const unsigned char*>(p);
+    return (static_cast<uint32_t>(u[0]) << 24) | (static_cast<uint32_t>(u[1]) << 16) |
+           (static_cast<uint32_t>(u[2]) << 8) | u[3];
+}
+
+static void append_u32(std::string& out, uint32_t value) {
+    char bytes[4] = {static_cast<char>(value >> 24), static_cast<char>(value >> 16),
+                     static_cast<char>(value >> 8), static_cast<char>(value)};
+    out.append(bytes, 4);
+}
+
+static void append_setting(std::string& out, uint16_t id, uint32_t value) {
+    out.push_back(static_cast<char>(id >> 8));
+    out.push_back(static_cast<char>(id));
+    append_u32(out, value);
+}
+
+static void append_window_update(std::string& out, uint32_t stream_id, uint32_t increment) {
+    http2::append_frame_header(out, 4, http2::WINDOW_UPDATE, 0, stream_id);
+    append_u32(out, increment);
+}
+
+static void append_rst_stream(std::string& out, uint32_t stream_id, uint32_t error) {
+    http2::append_frame_header(out, 4, http2::RST_STREAM, 0, stream_id);
+    append_u32(out, error);
+}
+
+// 连接专用头部在HTTP/2中无意义，请求中出现即为格式错误，响应中直接略去
+static bool connection_specific(const std::string& name) {
+    return name == "connection" || name == "keep-alive" || name == "proxy-connection" ||
+           name == "transfer-encoding" || name == "upgrade";
+}
+
+// 校验请求头部块并填入流：伪头部在前且只出现一次，名称为小写，不含连接专用头部
+static bool parse_request_headers(const std::vector<HpackHeader>& headers, Http2Session::Stream& stream) {
+    bool regular = false;
+    std::string scheme;
+    std::unordered_map<std::string, std::string> fields;
+    for(const auto& header : headers) {
+        const std::string& name = header.name;
+        if(name.empty() || std::any_of(name.begin(), name.end(), [](char c) { return c >= 'A' && c <= 'Z'; }) ||
+           header.value.find_first_of(std::string_view("\0\r\n", 3)) != std::string::npos) {
+            return false;
+        }
+        if(name[0] == ':') {
+            std::string* target = name == ":method" ? &stream.method : name == ":path" ? &stream.path :
+                                  name == ":scheme" ? &scheme : name == ":authority" ? &stream.authority : nullptr;
+            if(regular || !target || !target->empty() || header.value.empty()) {
+                return false;
+            }
+            *target = header.value;
+            continue;
+        }
+        regular = true;
+        if(connection_specific(name) || (name == "te" && header.value != "trailers")) {
+            return false;
+        }
+        if(name == "content-length") {
+            if(header.value.empty() || header.value.size() > 18 ||
+               header.value.find_first_not_of("0123456789") != std::string::npos) {
+                return false;
+            }
+            stream.content_length = std::stoll(header.value);
+        }
+        // 重复的头部合并为一行；Cookie可能被拆成多个字段以便压缩，以"; "拼回
+        auto [it, inserted] = fields.emplace(name, header.value);
+        if(!inserted) {
+            it->second.append(name == "cookie" ? "; " : ", ").append(header.value);
+        }
+    }
+    if(stream.method.empty() || stream.path.empty() || scheme.empty()) {
+        return false;
+    }
+    for(auto& [name, value] : fields) {
+        stream.request.add_header(name, value);
+    }
+    if(!stream.authority.empty() && fields.find("host") == fields.end()) {
+        stream.request.add_header("host", stream.authority);
+    }
+    return true;
+}
+
+// 流式响应的写出端：数据成帧后进入连接输出队列，发送窗口不足时暂存于流中，
+// 暂存超过上限时等待对端的WINDOW_UPDATE
+class Http2Session::ResponseWriter : public ResponseStream {
+public:
+    ResponseWriter(Http2Session& session, std::shared_ptr<Stream> stream, bool head)
+        : session_(session), stream_(std::move(stream)), head_(head) {}
+
+    bool begin(HttpResponse& response) override {
+        if(started_) {
+            return !failed_;
+        }
+        started_ = true;
+        response.remove_header("Content-Length");
+        HttpServer& server = session_.server_;
+        ContentCoding coding = server.choose_encoding(stream_->request, response, true);
+        if(coding != ContentCoding::IDENTITY) {
+            if(!head_) {
+                compressor_ = std::make_unique<StreamCompressor>(coding, server.config_.compression_level);
+            }
+            if(head_ || compressor_->ok()) {
+                server.set_encoding(response, coding);
+            }
+            else {
+                compressor_.reset();
+            }
+        }
+        std::lock_guard<std::mutex> lock(session_.mutex_);
+        Stream& stream = *stream_;
+        if(stream.closed) {
+            failed_ = true;
+            return false;
+        }
+        std::vector<HttpServer::OutputChunk> chunks;
+        session_.send_headers_locked(stream, response, head_, chunks);
+        stream.end_sent = head_;
+        session_.send_locked(chunks);
+        if(stream.end_sent) {
+            session_.close_stream_locked(stream);
+        }
+        return true;
+    }
+
+    bool write(std::string_view data) override {
+        if(!started_ || ended_ || failed_) {
+            return false;
+        }
+        HttpServer& server = session_.server_;
+        HttpServer::Connection& conn = session_.conn_;
+        if(data.empty() || head_) {
+            return !conn.closed.load();
+        }
+        std::string compressed;
+        if(compressor_) {
+            if(!compressor_->write(data, compressed)) {
+                failed_ = true;
+                return false;
+            }
+            data = compressed;
+        }
+        {
+            std::unique_lock<std::mutex> lock(session_.mutex_);
+            Stream& stream = *stream_;
+            if(stream.closed) {
+                failed_ = true;
+                return false;
+            }
+            stream.pending.append(data);
+            std::vector<HttpServer::OutputChunk> chunks;
+            session_.flush_stream_locked(stream, chunks);
+            session_.send_locked(chunks);
+
+            // 线程池可能全被等待窗口的处理器占用，持有者任务得不到运行：等待方直接读取并处理帧，
+            // 对端的WINDOW_UPDATE不依赖其他工作线程。窗口迟迟不打开视同写超时，重置该流
+            size_t backlog = session_.pending_bytes(stream);
+            int64_t progress_ms = HttpServer::now_ms();
+            while(backlog > STREAM_BUFFER_LIMIT && !stream.closed && !conn.closed.load() && server.running_.load()) {
+                if(HttpServer::now_ms() - progress_ms > server.config_.write_timeout_seconds * 1000) {
+                    session_.reset_stream_locked(stream, http2::CANCEL);
+                    break;
+                }
+                lock.unlock();
+                if(server.poll_readable(conn, static_cast<int>(HttpServer::TIMER_TICK_MS))) {
+                    server.handle_http2(conn.shared_from_this());
+                }
+                lock.lock();
+                size_t now_backlog = session_.pending_bytes(stream);
+                if(now_backlog < backlog) {
+                    progress_ms = HttpServer::now_ms();
+                }
+                backlog = now_backlog;
+            }
+            if(stream.closed) {
+                failed_ = true;
+                return false;
+            }
+        }
+        // 窗口之内的帧同样受连接输出积压限制
+        failed_ = !server.wait_output_drained(conn, session_.sequence_);
+        return !failed_;
+    }
+
+    bool end() override {
+        if(!started_ || ended_) {
+            return false;
+        }
+        ended_ = true;
+        session_.server_.stats_.total_streamed_responses.fetch_add(1);
+        std::lock_guard<std::mutex> lock(session_.mutex_);
+        Stream& stream = *stream_;
+        if(stream.closed) {
+            return !failed_ && head_;
+        }
+        // 压缩流的结尾随最后的DATA帧发出
+        if(compressor_) {
+            compressor_->write({}, stream.pending, true);
+        }
+        stream.end_after_pending = true;
+        std::vector<HttpServer::OutputChunk> chunks;
+        session_.flush_stream_locked(stream, chunks);
+        session_.send_locked(chunks);
+        if(stream.end_sent) {
+            session_.close_stream_locked(stream);
+        }
+        return !failed_;
+    }
+
+    bool started() const { return started_; }
+
+private:
+    Http2Session& session_;
+    std::shared_ptr<Stream> stream_;
+    bool head_;
+    bool started_ = false;
+    bool ended_ = false;
+    bool failed_ = false;
+    std::unique_ptr<StreamCompressor> compressor_;
+};
+
+Http2Session::Http2Session(HttpServer& server, HttpServer::Connection& conn, uint64_t sequence)
+    : server_(server), conn_(conn), sequence_(sequence),
+      decoder_(4096, server.config_.max_header_size) {}
+
+bool Http2Session::decode_settings_header(const std::string& value, std::string& payload) {
+    // base64url且不带填充；解码结果是SETTINGS帧的载荷
+    uint32_t bits = 0;
+    int count = 0;
+    payload.clear();
+    for(char c : value) {
+        int v;
+        if(c >= 'A' && c <= 'Z') v = c - 'A';
+        else if(c >= 'a' && c <= 'z') v = c - 'a' + 26;
+        else if(c >= '0' && c <= '9') v = c - '0' + 52;
+        else if(c == '-') v = 62;
+        else if(c == '_') v = 63;
+        else if(c == '=') break;
+        else return false;
+        bits = (bits << 6) | v;
+        count += 6;
+        if(count >= 8) {
+            count -= 8;
+            payload.push_back(static_cast<char>((bits >> count) & 0xff));
+        }
+    }
+    return payload.size() % 6 == 0;
+}
+
+bool Http2Session::start(bool upgrade, std::string_view client_settings) {
+    uint32_t error = 0;
+    if(!client_settings.empty() && !apply_settings(client_settings, error)) {
+        return false;
+    }
+    std::string out;
+    if(upgrade) {
+        out = "HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\nUpgrade: h2c\r\n\r\n";
+    }
+    http2::append_frame_header(out, 18, http2::SETTINGS, 0, 0);
+    append_setting(out, http2::SETTINGS_MAX_CONCURRENT_STREAMS, server_.config_.http2_max_concurrent_streams);
+    append_setting(out, http2::SETTINGS_INITIAL_WINDOW_SIZE, LOCAL_STREAM_WINDOW);
+    append_setting(out, http2::SETTINGS_MAX_HEADER_LIST_SIZE, static_cast<uint32_t>(server_.config_.max_header_size));
+    append_window_update(out, 0, LOCAL_CONNECTION_WINDOW - http2::DEFAULT_WINDOW_SIZE);
+    conn_recv_window_ = LOCAL_CONNECTION_WINDOW;
+
+    std::vector<HttpServer::OutputChunk> chunks;
+    chunks.emplace_back(std::move(out));
+    server_.enqueue_output(conn_, sequence_, std::move(chunks), false, false);
+    return true;
+}
+
+void Http2Session::open_upgrade_stream(HttpRequest&& request) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_stream_id_ = 1;
+    auto stream = std::make_shared<Stream>();
+    stream->id = 1;
+    open_stream_locked(stream);
+    stream->request = std::move(request);
+    stream->headers_done = true;
+    stream->request_complete = true;
+    upgrade_stream_ = std::move(stream);
+}
+
+void Http2Session::open_stream_locked(const std::shared_ptr<Stream>& stream) {
+    stream->recv_window = LOCAL_STREAM_WINDOW;
+    stream->send_window = peer_initial_window_;
+    streams_.emplace(stream->id, stream);
+    server_.stats_.total_http2_streams.fetch_add(1);
+    // 处理中的流计入in_flight：有流时不受keep-alive空闲超时约束
+    std::lock_guard<std::mutex> output_lock(conn_.output_mutex);
+    ++conn_.in_flight;
+    server_.update_deadline(conn_);
+}
+
+bool Http2Session::receive(std::string& buffer, std::vector<std::shared_ptr<Stream>>& ready) {
+    std::string control;  // 本次产生的SETTINGS确认、PING应答、WINDOW_UPDATE等，最后一并写出
+    size_t offset = 0;
+    bool ok = true;
+    if(!preface_received_) {
+        size_t n = std::min(buffer.size(), http2::PREFACE_SIZE);
+        if(buffer.compare(0, n, http2::CONNECTION_PREFACE, n) != 0) {
+            ok = fail(http2::PROTOCOL_ERROR, control);
+        }
+        else if(n < http2::PREFACE_SIZE) {
+            return true;
+        }
+        else {
+            preface_received_ = true;
+            offset = http2::PREFACE_SIZE;
+        }
+    }
+    while(ok && buffer.size() - offset >= http2::FRAME_HEADER_SIZE) {
+        http2::FrameHeader header = http2::parse_frame_header(std::string_view(buffer).substr(offset));
+        if(header.length > http2::DEFAULT_MAX_FRAME_SIZE) {
+            ok = fail(http2::FRAME_SIZE_ERROR, control);
+            break;
+        }
+        if(buffer.size() - offset - http2::FRAME_HEADER_SIZE < header.length) {
+            break;
+        }
+        std::string_view payload(buffer.data() + offset + http2::FRAME_HEADER_SIZE, header.length);
+        offset += http2::FRAME_HEADER_SIZE + header.length;
+        ok = handle_frame(header, payload, control, ready);
+    }
+    buffer.erase(0, offset);
+
+    if(!control.empty()) {
+        std::vector<HttpServer::OutputChunk> chunks;
+        chunks.emplace_back(std::move(control));
+        server_.enqueue_output(conn_, sequence_, std::move(chunks), false, false);
+    }
+    if(!ok) {
+        close_after_flush();
+    }
+    return ok;
+}
+
+bool Http2Session::handle_frame(const http2::FrameHeader& header, std::string_view payload,
+                                std::string& control, std::vector<std::shared_ptr<Stream>>& ready) {
+    // 前言之后的第一帧必须是SETTINGS；头部块的CONTINUATION之间不能夹杂其他帧
+    if(!settings_received_ && (header.type != http2::SETTINGS || (header.flags & http2::FLAG_ACK))) {
+        return fail(http2::PROTOCOL_ERROR, control);
+    }
+    if(continuation_stream_ != 0 &&
+       (header.type != http2::CONTINUATION || header.stream_id != continuation_stream_)) {
+        return fail(http2::PROTOCOL_ERROR, control);
+    }
+
+    switch(header.type) {
+        case http2::DATA:
+            return handle_data(header, payload, control, ready);
+        case http2::HEADERS:
+            return handle_headers(header, payload, control, ready);
+        case http2::PRIORITY:
+            if(header.stream_id == 0) {
+                return fail(http2::PROTOCOL_ERROR, control);
+            }
+            if(payload.size() != 5) {
+                reset_frame(header.stream_id, http2::FRAME_SIZE_ERROR, control);
+            }
+            else if((read_u32(payload.data()) & 0x7fffffff) == header.stream_id) {
+                reset_frame(header.stream_id, http2::PROTOCOL_ERROR, control);
+            }
+            return true;
+        case http2::RST_STREAM: {
+            if(header.stream_id == 0) {
+                return fail(http2::PROTOCOL_ERROR, control);
+            }
+            if(payload.size() != 4) {
+                return fail(http2::FRAME_SIZE_ERROR, control);
+            }
+            bool idle = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                idle = header.stream_id > last_stream_id_;
+                auto it = streams_.find(header.stream_id);
+                if(!idle && it != streams_.end()) {
+                    auto stream = it->second;
+                    close_stream_locked(*stream);
+                }
+            }
+            return !idle || fail(http2::PROTOCOL_ERROR, control);  // 空闲状态的流不能被重置
+        }
+        case http2::SETTINGS: {
+            if(header.stream_id != 0) {
+                return fail(http2::PROTOCOL_ERROR, control);
+            }
+            if(header.flags & http2::FLAG_ACK) {
+                return payload.empty() || fail(http2::FRAME_SIZE_ERROR, control);
+            }
+            if(payload.size() % 6 != 0) {
+                return fail(http2::FRAME_SIZE_ERROR, control);
+            }
+            uint32_t error = 0;
+            if(!apply_settings(payload, error)) {
+                return fail(error, control);
+            }
+            settings_received_ = true;
+            http2::append_frame_header(control, 0, http2::SETTINGS, http2::FLAG_ACK, 0);
+            if(upgrade_stream_) {
+                ready.push_back(std::move(upgrade_stream_));
+            }
+            return true;
+        }
+        case http2::PUSH_PROMISE:
+            return fail(http2::PROTOCOL_ERROR, control);  // 客户端不能推送
+        case http2::PING:
+            if(header.stream_id != 0) {
+                return fail(http2::PROTOCOL_ERROR, control);
+            }
+            if(payload.size() != 8) {
+                return fail(http2::FRAME_SIZE_ERROR, control);
+            }
+            if(!(header.flags & http2::FLAG_ACK)) {
+                http2::append_frame_header(control, 8, http2::PING, http2::FLAG_ACK, 0);
+                control.append(payload);
+            }
+            return true;
+        case http2::GOAWAY:
+            // 客户端不再发起新流，已有的流照常完成，由客户端关闭连接
+            return header.stream_id == 0 || fail(http2::PROTOCOL_ERROR, control);
+        case http2::WINDOW_UPDATE:
+            return handle_window_update(header, payload, control);
+        case http2::CONTINUATION: {
+            if(continuation_stream_ == 0) {
+                return fail(http2::PROTOCOL_ERROR, control);
+            }
+            header_block_.append(payload);
+            // 压缩后的头部块不会比头部列表上限大出太多，无休止的CONTINUATION视为攻击
+            if(header_block_.size() > server_.config_.max_header_size * 2 + http2::DEFAULT_MAX_FRAME_SIZE) {
+                return fail(http2::ENHANCE_YOUR_CALM, control);
+            }
+            if(!(header.flags & http2::FLAG_END_HEADERS)) {
+                return true;
+            }
+            uint32_t stream_id = continuation_stream_;
+            continuation_stream_ = 0;
+            return handle_header_block(stream_id, continuation_flags_, control, ready);
+        }
+        default:
+            return true;  // 未知类型的帧必须忽略
+    }
+}
+
+bool Http2Session::handle_headers(const http2::FrameHeader& header, std::string_view payload,
+                                  std::string& control, std::vector<std::shared_ptr<Stream>>& ready) {
+    if(header.stream_id == 0) {
+        return fail(http2::PROTOCOL_ERROR, control);
+    }
+    size_t start = 0;
+    size_t padding = 0;
+    if(header.flags & http2::FLAG_PADDED) {
+        if(payload.empty()) {
+            return fail(http2::FRAME_SIZE_ERROR, control);
+        }
+        padding = static_cast<unsigned char>(payload[0]);
+        start = 1;
+    }
+    if(header.flags & http2::FLAG_PRIORITY) {
+        if(payload.size() < start + 5) {
+            return fail(http2::FRAME_SIZE_ERROR, control);
+        }
+        // 优先级被忽略，只检查不能依赖自身
+        if((read_u32(payload.data() + start) & 0x7fffffff) == header.stream_id) {
+            return fail(http2::PROTOCOL_ERROR, control);
+        }
+        start += 5;
+    }
+    if(start + padding > payload.size()) {
+        return fail(http2::PROTOCOL_ERROR, control);
+    }
+    header_block_.assign(payload.substr(start, payload.size() - start - padding));
+    if(!(header.flags & http2::FLAG_END_HEADERS)) {
+        continuation_stream_ = header.stream_id;
+        continuation_flags_ = header.flags;
+        return true;
+    }
+    return handle_header_block(header.stream_id, header.flags, control, ready);
+}
+
+bool Http2Session::handle_header_block(uint32_t stream_id, uint8_t flags, std::string& control,
+                                       std::vector<std::shared_ptr<Stream>>& ready) {
+    // 即使随后拒绝该流，也必须解码头部块以保持动态表同步
+    std::vector<HpackHeader> headers;
+    HpackDecoder::Result result = decoder_.decode(header_block_, headers);
+    if(header_block_.capacity() > http2::DEFAULT_MAX_FRAME_SIZE) {
+        std::string().swap(header_block_);
+    }
+    header_block_.clear();
+    if(result == HpackDecoder::Result::ERROR) {
+        return fail(http2::COMPRESSION_ERROR, control);
+    }
+    bool end_stream = flags & http2::FLAG_END_STREAM;
+
+    std::shared_ptr<Stream> stream;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = streams_.find(stream_id);
+        if(it != streams_.end()) {
+            stream = it->second;
+        }
+        else if(stream_id > last_stream_id_ && (stream_id & 1) && !goaway_sent_) {
+            last_stream_id_ = stream_id;
+            if(streams_.size() >= server_.config_.http2_max_concurrent_streams) {
+                reset_frame(stream_id, http2::REFUSED_STREAM, control);
+                return true;
+            }
+            stream = std::make_shared<Stream>();
+            stream->id = stream_id;
+            if(!parse_request_headers(headers, *stream)) {
+                reset_frame(stream_id, http2::PROTOCOL_ERROR, control);
+                return true;
+            }
+            stream->headers_done = true;
+            if(result == HpackDecoder::Result::TOO_LARGE) {
+                stream->error_status = HttpStatus::REQUEST_HEADER_FIELDS_TOO_LARGE;
+            }
+            open_stream_locked(stream);
+            if(end_stream) {
+                finish_request(stream, ready);
+            }
+            return true;
+        }
+        else if(goaway_sent_ && stream_id > last_stream_id_) {
+            return true;  // GOAWAY之后发起的流被忽略
+        }
+    }
+
+    if(!stream) {
+        // 已关闭的流，或编号不递增、为偶数的新流
+        return fail((stream_id & 1) && stream_id <= last_stream_id_ ? http2::STREAM_CLOSED : http2::PROTOCOL_ERROR,
+                    control);
+    }
+    // 尾部字段：必须结束流，不能含伪头部；内容不传给处理器
+    if(stream->request_complete) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reset_stream_locked(*stream, http2::STREAM_CLOSED);
+        return true;
+    }
+    if(!end_stream) {
+        return fail(http2::PROTOCOL_ERROR, control);
+    }
+    for(const auto& header : headers) {
+        if(header.name.empty() || header.name[0] == ':') {
+            std::lock_guard<std::mutex> lock(mutex_);
+            reset_stream_locked(*stream, http2::PROTOCOL_ERROR);
+            return true;
+        }
+    }
+    finish_request(stream, ready);
+    return true;
+}
+
+bool Http2Session::handle_data(const http2::FrameHeader& header, std::string_view payload,
+                               std::string& control, std::vector<std::shared_ptr<Stream>>& ready) {
+    if(header.stream_id == 0) {
+        return fail(http2::PROTOCOL_ERROR, control);
+    }
+    // 整个载荷（含填充）计入流量控制，无论流是否还存在
+    conn_recv_window_ -= payload.size();
+    if(conn_recv_window_ < 0) {
+        return fail(http2::FLOW_CONTROL_ERROR, control);
+    }
+    conn_recv_unacked_ += payload.size();
+    if(conn_recv_unacked_ >= LOCAL_CONNECTION_WINDOW / 2) {
+        append_window_update(control, 0, conn_recv_unacked_);
+        conn_recv_window_ += conn_recv_unacked_;
+        conn_recv_unacked_ = 0;
+    }
+
+    std::string_view data = payload;
+    if(header.flags & http2::FLAG_PADDED) {
+        if(payload.empty() || static_cast<unsigned char>(payload[0]) >= payload.size()) {
+            return fail(http2::PROTOCOL_ERROR, control);
+        }
+        data = payload.substr(1, payload.size() - 1 - static_cast<unsigned char>(payload[0]));
+    }
+
+    std::shared_ptr<Stream> stream;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = streams_.find(header.stream_id);
+        if(it == streams_.end()) {
+            if(header.stream_id <= last_stream_id_ || goaway_sent_) {
+                reset_frame(header.stream_id, http2::STREAM_CLOSED, control);
+                return true;
+            }
+        }
+        else {
+            stream = it->second;
+            if(stream->request_complete) {
+                reset_stream_locked(*stream, http2::STREAM_CLOSED);
+                return true;
+            }
+            stream->recv_window -= payload.size();
+            if(stream->recv_window < 0) {
+                reset_stream_locked(*stream, http2::FLOW_CONTROL_ERROR);
+                return true;
+            }
+        }
+    }
+    if(!stream) {
+        return fail(http2::PROTOCOL_ERROR, control);  // 空闲状态的流
+    }
+
+    if(stream->error_status == HttpStatus::OK) {
+        if(stream->body.size() + data.size() > server_.config_.max_request_size) {
+            // 继续接收并丢弃其余数据，流结束后回复413
+            stream->error_status = HttpStatus::PAYLOAD_TOO_LARGE;
+            std::string().swap(stream->body);
+        }
+        else {
+            stream->body.append(data);
+        }
+    }
+    if(header.flags & http2::FLAG_END_STREAM) {
+        finish_request(stream, ready);
+        return true;
+    }
+    stream->recv_unacked += payload.size();
+    if(stream->recv_unacked >= LOCAL_STREAM_WINDOW / 2) {
+        append_window_update(control, stream->id, stream->recv_unacked);
+        stream->recv_window += stream->recv_unacked;
+        stream->recv_unacked = 0;
+    }
+    return true;
+}
+
+void Http2Session::finish_request(const std::shared_ptr<Stream>& stream, std::vector<std::shared_ptr<Stream>>& ready) {
+    stream->request_complete = true;
+    if(stream->error_status == HttpStatus::OK && stream->content_length >= 0 &&
+       static_cast<uint64_t>(stream->content_length) != stream->body.size()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reset_stream_locked(*stream, http2::PROTOCOL_ERROR);
+        return;
+    }
+    stream->request.set_client_ip(conn_.ip);
+    stream->request.populate(stream->method, stream->path, "HTTP/2.0", std::move(stream->body));
+    ready.push_back(stream);
+}
+
+bool Http2Session::apply_settings(std::string_view payload, uint32_t& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool window_grew = false;
+    for(size_t i = 0; i + 6 <= payload.size(); i += 6) {
+        uint16_t id = (static_cast<uint16_t>(static_cast<unsigned char>(payload[i])) << 8) |
+                      static_cast<unsigned char>(payload[i + 1]);
+        uint32_t value = read_u32(payload.data() + i + 2);
+        switch(id) {
+            case http2::SETTINGS_HEADER_TABLE_SIZE:
+                encoder_.set_max_table_size(value);
+                break;
+            case http2::SETTINGS_ENABLE_PUSH:
+                if(value > 1) {
+                    error = http2::PROTOCOL_ERROR;
+                    return false;
+                }
+                break;
+            case http2::SETTINGS_INITIAL_WINDOW_SIZE: {
+                if(value > http2::MAX_WINDOW_SIZE) {
+                    error = http2::FLOW_CONTROL_ERROR;
+                    return false;
+                }
+                // 已打开的流按差值调整发送窗口，可能变为负数
+                int64_t delta = static_cast<int64_t>(value) - peer_initial_window_;
+                for(auto& [stream_id, stream] : streams_) {
+                    stream->send_window += delta;
+                    if(stream->send_window > http2::MAX_WINDOW_SIZE) {
+                        error = http2::FLOW_CONTROL_ERROR;
+                        return false;
+                    }
+                }
+                peer_initial_window_ = value;
+                window_grew = window_grew || delta > 0;
+                break;
+            }
+            case http2::SETTINGS_MAX_FRAME_SIZE:
+                if(value < http2::DEFAULT_MAX_FRAME_SIZE || value > http2::MAX_FRAME_SIZE_LIMIT) {
+                    error = http2::PROTOCOL_ERROR;
+                    return false;
+                }
+                peer_max_frame_size_ = value;
+                break;
+            default:
+                break;  // 不推送，不限制响应头部大小；未知设置忽略
+        }
+    }
+    if(window_grew) {
+        flush_all_locked();
+    }
+    return true;
+}
+
+bool Http2Session::handle_window_update(const http2::FrameHeader& header, std::string_view payload,
+                                        std::string& control) {
+    if(payload.size() != 4) {
+        return fail(http2::FRAME_SIZE_ERROR, control);
+    }
+    uint32_t increment = read_u32(payload.data()) & 0x7fffffff;
+    if(header.stream_id == 0) {
+        if(increment == 0) {
+            return fail(http2::PROTOCOL_ERROR, control);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            conn_send_window_ += increment;
+            if(conn_send_window_ <= http2::MAX_WINDOW_SIZE) {
+                flush_all_locked();
+                return true;
+            }
+        }
+        return fail(http2::FLOW_CONTROL_ERROR, control);
+    }
+
+    bool idle = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = streams_.find(header.stream_id);
+        if(it == streams_.end()) {
+            idle = header.stream_id > last_stream_id_;  // 否则是已关闭的流，窗口更新可能已在途
+        }
+        else {
+            auto stream = it->second;
+            stream->send_window += increment;
+            if(increment == 0) {
+                reset_stream_locked(*stream, http2::PROTOCOL_ERROR);
+            }
+            else if(stream->send_window > http2::MAX_WINDOW_SIZE) {
+                reset_stream_locked(*stream, http2::FLOW_CONTROL_ERROR);
+            }
+            else {
+                std::vector<HttpServer::OutputChunk> chunks;
+                flush_stream_locked(*stream, chunks);
+                send_locked(chunks);
+                if(stream->end_sent) {
+                    close_stream_locked(*stream);
+                }
+            }
+        }
+    }
+    return !idle || fail(http2::PROTOCOL_ERROR, control);
+}
+
+bool Http2Session::fail(uint32_t error, std::string& control) {
+    // 连接错误：GOAWAY告知已处理的最大流编号，写完后关闭连接
+    uint32_t last_stream_id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_stream_id = last_stream_id_;
+        goaway_sent_ = true;
+    }
+    http2::append_frame_header(control, 8, http2::GOAWAY, 0, 0);
+    append_u32(control, last_stream_id);
+    append_u32(control, error);
+    return false;
+}
+
+void Http2Session::reset_frame(uint32_t stream_id, uint32_t error, std::string& control) {
+    append_rst_stream(control, stream_id, error);
+}
+
+void Http2Session::handle_stream(const std::shared_ptr<Stream>& stream) {
+    HttpRequest& request = stream->request;
+    bool head = request.method() == "HEAD";
+    server_.stats_.total_requests.fetch_add(1);
+
+    HttpResponse response;
+    response.set_header("Server", server_.config_.server_name);
+    response.set_header("Date", server_.get_current_time_string());
+    if(stream->error_status != HttpStatus::OK) {
+        response.set_status(stream->error_status);
+        response.text(server_.status_to_string(stream->error_status));
+        std::lock_guard<std::mutex> lock(mutex_);
+        send_response_locked(*stream, response, head);
+        return;
+    }
+
+    ResponseWriter writer(*this, stream, head);
+    response.set_stream(&writer);
+    try {
+        server_.route_request(request, response);
+        if(writer.started()) {
+            response.end_streaming();
+        }
+        else {
+            server_.compress_response(request, response);
+            std::lock_guard<std::mutex> lock(mutex_);
+            send_response_locked(*stream, response, head);
+        }
+        server_.stats_.total_responses.fetch_add(1);
+        if(server_.config_.enable_logging) {
+            server_.log_request(request, response);
+        }
+    }
+    catch(const std::exception& e) {
+        server_.log("ERROR", "Exception in HTTP/2 stream handler: " + std::string(e.what()));
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(writer.started()) {
+            reset_stream_locked(*stream, http2::INTERNAL_ERROR);  // 头部已发出，只能重置该流
+        }
+        else {
+            HttpResponse error;
+            error.set_status(HttpStatus::INTERNAL_SERVER_ERROR);
+            error.set_header("Server", server_.config_.server_name);
+            error.text(server_.status_to_string(HttpStatus::INTERNAL_SERVER_ERROR));
+            send_response_locked(*stream, error, head);
+        }
+    }
+}
+
+void Http2Session::go_away() {
+    bool idle = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(goaway_sent_) {
+            return;
+        }
+        goaway_sent_ = true;
+        std::string frame;
+        http2::append_frame_header(frame, 8, http2::GOAWAY, 0, 0);
+        append_u32(frame, last_stream_id_);
+        append_u32(frame, http2::NO_ERROR);
+        std::vector<HttpServer::OutputChunk> chunks;
+        chunks.emplace_back(std::move(frame));
+        send_locked(chunks);
+        idle = streams_.empty();
+    }
+    if(idle) {
+        close_after_flush();
+    }
+}
+
+void Http2Session::send_response_locked(Stream& stream, HttpResponse& response, bool head) {
+    if(stream.closed) {
+        return;  // 已被对端重置
+    }
+    int code = response.status_code();
+    if(!head && code != 204 && code != 304 && code >= 200) {
+        if(response.has_file_body()) {
+            stream.file = response.file_body();
+            stream.file_sent = 0;
+        }
+        else if(response.has_body_parts()) {
+            stream.parts.assign(response.body_parts().begin(), response.body_parts().end());
+        }
+        else {
+            stream.pending = response.take_body();
+            stream.pending_offset = 0;
+        }
+    }
+    std::vector<HttpServer::OutputChunk> chunks;
+    if(pending_bytes(stream) == 0) {
+        stream.file.reset();
+        stream.parts.clear();
+        send_headers_locked(stream, response, true, chunks);
+        stream.end_sent = true;
+    }
+    else {
+        send_headers_locked(stream, response, false, chunks);
+        stream.end_after_pending = true;
+        flush_stream_locked(stream, chunks);
+    }
+    send_locked(chunks);
+    if(stream.end_sent) {
+        close_stream_locked(stream);
+    }
+}
+
+void Http2Session::send_headers_locked(Stream& stream, HttpResponse& response, bool end_stream,
+                                       std::vector<HttpServer::OutputChunk>& chunks) {
+    std::string block;
+    encoder_.begin_block(block);
+    encoder_.encode(":status", std::to_string(response.status_code()), block);
+    for(const auto& [name, value] : response.headers()) {
+        if(connection_specific(name)) {
+            continue;
+        }
+        // 每个响应都不同的值不进入动态表，以免挤掉可复用的条目
+        bool volatile_value = name == "content-length" || name == "date" || name == "etag" ||
+                              name == "last-modified";
+        encoder_.encode(name, value, block,
+                        volatile_value ? HpackEncoder::Indexing::NONE : HpackEncoder::Indexing::INCREMENTAL);
+    }
+    // Set-Cookie各自成为一个字段，不经中间代理重新索引
+    std::string cookies = response.render_cookies();
+    static const char COOKIE_PREFIX[] = "Set-Cookie: ";
+    size_t start = 0;
+    while(start < cookies.size()) {
+        size_t end = cookies.find("\r\n", start);
+        if(end == std::string::npos) {
+            end = cookies.size();
+        }
+        std::string_view line(cookies.data() + start, end - start);
+        if(line.size() >= sizeof(COOKIE_PREFIX) - 1) {
+            encoder_.encode("set-cookie", line.substr(sizeof(COOKIE_PREFIX) - 1), block,
+                            HpackEncoder::Indexing::NEVER);
+        }
+        start = end + 2;
+    }
+
+    // 超过对端帧大小上限的头部块拆成HEADERS与紧随其后的CONTINUATION
+    std::string frames;
+    frames.reserve(block.size() + http2::FRAME_HEADER_SIZE);
+    size_t offset = 0;
+    do {
+        size_t n = std::min<size_t>(block.size() - offset, peer_max_frame_size_);
+        uint8_t flags = offset + n == block.size() ? http2::FLAG_END_HEADERS : 0;
+        if(offset == 0 && end_stream) {
+            flags |= http2::FLAG_END_STREAM;
+        }
+        http2::append_frame_header(frames, n, offset == 0 ? http2::HEADERS : http2::CONTINUATION, flags, stream.id);
+        frames.append(block, offset, n);
+        offset += n;
+    } while(offset < block.size());
+    chunks.emplace_back(std::move(frames));
+}
+
+void Http2Session::flush_stream_locked(Stream& stream, std::vector<HttpServer::OutputChunk>& chunks) {
+    // 按连接与流两级发送窗口及对端帧大小切分DATA帧；文件响应体此时才读入
+    if(stream.closed || stream.end_sent) {
+        return;
+    }
+    while(true) {
+        // 当前段发完后取出下一段
+        while(stream.pending.size() == stream.pending_offset && !stream.file && !stream.parts.empty()) {
+            BodyPart& part = stream.parts.front();
+            stream.pending = std::move(part.data);
+            stream.pending_offset = 0;
+            stream.file = std::move(part.file);
+            stream.file_sent = 0;
+            stream.parts.pop_front();
+        }
+        size_t remaining = pending_bytes(stream);
+        if(remaining == 0) {
+            if(stream.end_after_pending) {
+                std::string frame;
+                http2::append_frame_header(frame, 0, http2::DATA, http2::FLAG_END_STREAM, stream.id);
+                chunks.emplace_back(std::move(frame));
+                stream.end_sent = true;
+            }
+            return;
+        }
+        int64_t window = std::min(conn_send_window_, stream.send_window);
+        if(window <= 0) {
+            return;
+        }
+        // 一帧只取自当前段，多段响应体在段边界处分帧
+        size_t segment = stream.pending.size() > stream.pending_offset ? stream.pending.size() - stream.pending_offset
+                                                                        : stream.file->length - stream.file_sent;
+        size_t n = std::min<size_t>({segment, static_cast<size_t>(window), peer_max_frame_size_});
+        bool last = n == remaining && stream.end_after_pending;
+        std::string frame;
+        frame.reserve(http2::FRAME_HEADER_SIZE + n);
+        http2::append_frame_header(frame, n, http2::DATA, last ? http2::FLAG_END_STREAM : 0, stream.id);
+        if(stream.pending.size() > stream.pending_offset) {
+            frame.append(stream.pending, stream.pending_offset, n);
+            stream.pending_offset += n;
+            if(stream.pending_offset == stream.pending.size()) {
+                std::string().swap(stream.pending);
+                stream.pending_offset = 0;
+            }
+        }
+        else {
+            size_t start = frame.size();
+            frame.resize(start + n);
+            ssize_t got = pread(stream.file->fd, &frame[start], n, stream.file->offset + stream.file_sent);
+            if(got != static_cast<ssize_t>(n)) {
+                server_.log("ERROR", "Failed to read file body for HTTP/2 stream");
+                std::string reset;
+                append_rst_stream(reset, stream.id, http2::INTERNAL_ERROR);
+                chunks.emplace_back(std::move(reset));
+                stream.file.reset();
+                stream.end_sent = true;  // 由调用方关闭流
+                return;
+            }
+            stream.file_sent += n;
+            if(stream.file_sent == stream.file->length) {
+                stream.file.reset();
+            }
+        }
+        conn_send_window_ -= n;
+        stream.send_window -= n;
+        chunks.emplace_back(std::move(frame));
+        if(last) {
+            stream.end_sent = true;
+            return;
+        }
+    }
+}
+
+void Http2Session::flush_all_locked() {
+    // 连接窗口或初始窗口增大后，依次发送各流暂存的数据
+    std::vector<std::shared_ptr<Stream>> streams;
+    for(auto& [stream_id, stream] : streams_) {
+        if(pending_bytes(*stream) > 0) {
+            streams.push_back(stream);
+        }
+    }
+    std::vector<HttpServer::OutputChunk> chunks;
+    for(auto& stream : streams) {
+        flush_stream_locked(*stream, chunks);
+    }
+    send_locked(chunks);
+    for(auto& stream : streams) {
+        if(stream->end_sent) {
+            close_stream_locked(*stream);
+        }
+    }
+}
+
+void Http2Session::send_locked(std::vector<HttpServer::OutputChunk>& chunks) {
+    if(!chunks.empty()) {
+        server_.enqueue_output(conn_, sequence_, std::move(chunks), false, false);
+        chunks.clear();
+    }
+}
+
+void Http2Session::reset_stream_locked(Stream& stream, uint32_t error) {
+    if(stream.closed) {
+        return;
+    }
+    std::string frame;
+    append_rst_stream(frame, stream.id, error);
+    std::vector<HttpServer::OutputChunk> chunks;
+    chunks.emplace_back(std::move(frame));
+    send_locked(chunks);
+    close_stream_locked(stream);
+}
+
+void Http2Session::close_stream_locked(Stream& stream) {
+    if(stream.closed) {
+        return;
+    }
+    stream.closed = true;
+    stream.pending.clear();
+    stream.file.reset();
+    stream.parts.clear();
+    streams_.erase(stream.id);
+    {
+        std::lock_guard<std::mutex> lock(conn_.output_mutex);
+        --conn_.in_flight;
+        if(conn_.in_flight == 0 && conn_.output_queue.empty()) {
+            conn_.idle_since_ms = HttpServer::now_ms();
+        }
+        server_.update_deadline(conn_);
+    }
+    if(goaway_sent_ && streams_.empty()) {
+        close_after_flush();
+    }
+}
+
+void Http2Session::close_after_flush() {
+    HttpServer::OutputAction action;
+    {
+        std::lock_guard<std::mutex> lock(conn_.output_mutex);
+        if(conn_.closed.load()) {
+            return;
+        }
+        conn_.close_when_flushed = true;
+        action = server_.flush_output(conn_);
+    }
+    server_.apply_output_action(conn_, action);
+}
+
+size_t Http2Session::pending_bytes(const Stream& stream) const {
+    size_t bytes = stream.pending.size() - stream.pending_offset +
+                   (stream.file ? stream.file->length - stream.file_sent : 0);
+    for(const auto& part : stream.parts) {
+        bytes += part.data.size() + (part.file ? part.file->length : 0);
+    }
+    return bytes;
+}
+
+// HttpServer中与HTTP/2相关的部分
+
+bool HttpServer::start_http2(Connection& conn, uint64_t sequence, HttpRequest* upgrade_request) {
+    // 持有者线程，持有io_mutex；sequence已计入in_flight
+    std::string settings;
+    if(upgrade_request) {
+        // 带请求体的Upgrade请求已被完整读入，不支持时按普通HTTP/1.1请求处理
+        if(upgrade_request->version() != "HTTP/1.1" || upgrade_request->body_streaming() ||
+           !header_has_token(upgrade_request->get_header("Upgrade"), "h2c") ||
+           !upgrade_request->has_header("HTTP2-Settings") ||
+           !Http2Session::decode_settings_header(upgrade_request->get_header("HTTP2-Settings"), settings)) {
+            return false;
+        }
+    }
+    auto session = std::make_shared<Http2Session>(*this, conn, sequence);
+    if(!session->start(upgrade_request != nullptr, settings)) {
+        return false;
+    }
+    conn.http2 = session;
+    conn.upgraded = true;
+    stats_.total_http2_sessions.fetch_add(1);
+    if(upgrade_request) {
+        // 1号流另计in_flight，升级请求占用的序号由会话沿用
+        session->open_upgrade_stream(std::move(*upgrade_request));
+        std::lock_guard<std::mutex> lock(conn.output_mutex);
+        --conn.in_flight;
+    }
+    else {
+        std::lock_guard<std::mutex> lock(conn.output_mutex);
+        --conn.in_flight;  // 连接前言占用的序号不对应请求
+        conn.idle_since_ms = now_ms();
+        update_deadline(conn);
+    }
+    return true;
+}
+
+void HttpServer::handle_http2(const std::shared_ptr<Connection>& conn_ptr) {
+    // 持有者线程：解析帧并维护流状态，请求完整的流交给线程池并发处理
+    Connection& conn = *conn_ptr;
+    Http2Session& session = *conn.http2;
+    const size_t limit = config_.max_header_size + config_.max_request_size;
+    bool reading = true;
+    bool peer_open = true;
+    bool buffer_full = false;
+    std::vector<std::shared_ptr<Http2Session::Stream>> ready;
+    do {
+        std::lock_guard<std::mutex> lock(conn.io_mutex);
+        if(conn.closed.load() || conn.input_closed || !input_allowed(conn)) {
+            break;
+        }
+        peer_open = fill_read_buffer(conn);
+        buffer_full = peer_open && conn.buffer.size() >= limit;
+        reading = session.receive(conn.buffer, ready);
+        conn.read_phase.store(ReadPhase::IDLE);
+    } while(reading && peer_open && buffer_full && !conn.closed.load());
+
+    for(auto& stream : ready) {
+        thread_pool_->enqueue([conn_ptr, stream]() {
+            conn_ptr->http2->handle_stream(stream);
+        });
+    }
+    if(!reading) {
+        conn.input_closed = true;  // GOAWAY已发出，写完后关闭
+    }
+    else if(!peer_open) {
+        close_connection(conn);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(conn.output_mutex);
+    update_deadline(conn);
+}
@@ -0,0 +1,489 @@
+#include "core/http_parser.h"
+#include "core/http_server.h"
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+
+namespace {
+
+bool is_token_char(char c) {
+    // RFC 7230 tchar
+    return std::isalnum(static_cast<unsigned char>(c)) || std::strchr("!#$%&'*+-.^_`|~", c) != nullptr;
+}
+
+std::string_view trim_ows(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+}  // namespace
+
+void BodyDecoder::reset(uint64_t content_length) {
+    chunked_ = false;
+    state_ = State::DATA;
+    remaining_ = content_length;
+    decoded_size_ = 0;
+}
+
+void BodyDecoder::reset_chunked() {
+    chunked_ = true;
+    decoded_size_ = 0;
+    start_chunk();
+}
+
+void BodyDecoder::start_chunk() {
+    state_ = State::SIZE;
+    remaining_ = 0;
+    size_digits_ = 0;
+}
+
+void BodyDecoder::end_size_line() {
+    // 大小为0的块表示结束，其后是可选的trailer字段和空行
+    line_length_ = 0;
+    state_ = remaining_ == 0 ? State::TRAILER : State::DATA;
+}
+
+BodyDecoder::Result BodyDecoder::decode(std::string_view in, size_t& consumed,
+                                        std::string_view& data, size_t max_data) {
+    size_t pos = 0;
+    data = std::string_view();
+    while (true) {
+        if (state_ == State::DONE || state_ == State::ERROR) {
+            consumed = pos;
+            return state_ == State::DONE ? Result::DONE : Result::ERROR;
+        }
+        if (state_ == State::DATA) {
+            if (remaining_ == 0) {
+                state_ = chunked_ ? State::DATA_CR : State::DONE;
+                continue;
+            }
+            if (pos == in.size()) {
+                break;
+            }
+            size_t n = std::min<uint64_t>(std::min(in.size() - pos, max_data), remaining_);
+            data = in.substr(pos, n);
+            remaining_ -= n;
+            decoded_size_ += n;
+            consumed = pos + n;
+            return Result::DATA;
+        }
+        if (pos == in.size()) {
+            break;
+        }
+
+        // 分块框架逐字节推进，半行数据在下次调用时继续
+        char c = in[pos++];
+        switch (state_) {
+            case State::SIZE: {
+                int digit = hex_value(c);
+                if (digit >= 0) {
+                    if (remaining_ >> 56) {
+                        state_ = State::ERROR;  // 块大小溢出
+                        break;
+                    }
+                    remaining_ = remaining_ * 16 + digit;
+                    ++size_digits_;
+                }
+                else if (size_digits_ == 0) {
+                    state_ = State::ERROR;
+                }
+                else if (c == ';' || c == ' ' || c == '\t') {
+                    line_length_ = 0;
+                    state_ = State::SIZE_EXT;
+                }
+                else if (c == '\r') {
+                    state_ = State::SIZE_LF;
+                }
+                else if (c == '\n') {
+                    end_size_line();
+                }
+                else {
+                    state_ = State::ERROR;
+                }
+                break;
+            }
+            case State::SIZE_EXT:
+                if (c == '\n') {
+                    end_size_line();
+                }
+                else if (++line_length_ > MAX_LINE_LENGTH) {
+                    state_ = State::ERROR;
+                }
+                break;
+            case State::SIZE_LF:
+                if (c == '\n') {
+                    end_size_line();
+                }
+                else {
+                    state_ = State::ERROR;
+                }
+                break;
+            case State::DATA_CR:
+                if (c == '\r') {
+                    state_ = State::DATA_LF;
+                }
+                else if (c == '\n') {
+                    start_chunk();
+                }
+                else {
+                    state_ = State::ERROR;
+                }
+                break;
+            case State::DATA_LF:
+                if (c == '\n') {
+                    start_chunk();
+                }
+                else {
+                    state_ = State::ERROR;
+                }
+                break;
+            case State::TRAILER:
+                // 行首：空行结束请求体，否则跳过一个trailer字段
+                if (c == '\n') {
+                    state_ = State::DONE;
+                }
+                else if (c == '\r') {
+                    state_ = State::TRAILER_LF;
+                }
+                else {
+                    ++line_length_;
+                    state_ = State::TRAILER_LINE;
+                }
+                break;
+            case State::TRAILER_LINE:
+                if (c == '\n') {
+                    state_ = State::TRAILER;
+                }
+                else if (++line_length_ > MAX_LINE_LENGTH) {
+                    state_ = State::ERROR;
+                }
+                break;
+            case State::TRAILER_LF:
+                state_ = c == '\n' ? State::DONE : State::ERROR;
+                break;
+            default:
+                break;
+        }
+    }
+    consumed = pos;
+    return Result::INCOMPLETE;
+}
+
+HttpParser::HttpParser() : HttpParser(Limits{}) {}
+
+HttpParser::HttpParser(const Limits& limits)
+    : limits_(limits), error_status_(HttpStatus::BAD_REQUEST) {}
+
+void HttpParser::reset() {
+    state_ = State::REQUEST_LINE;
+    line_start_ = 0;
+    scan_offset_ = 0;
+    header_end_ = 0;
+    content_length_ = 0;
+    has_content_length_ = false;
+    chunked_ = false;
+    body_started_ = false;
+    streaming_ = false;
+    body_consumed_ = 0;
+    // 解码后的请求体已由调用方复制，过大的缓冲不跨请求保留
+    if (decoded_body_.capacity() > 64 * 1024) {
+        std::string().swap(decoded_body_);
+    }
+    decoded_body_.clear();
+    error_status_ = HttpStatus::BAD_REQUEST;
+    header_spans_.clear();
+    headers_.clear();
+    method_ = target_ = path_ = query_ = version_ = body_ = std::string_view();
+}
+
+HttpParser::Result HttpParser::parse(std::string_view data) {
+    if (state_ == State::ERROR) {
+        return Result::ERROR;
+    }
+
+    // 逐行推进：只扫描新到达的字节，半行数据在下次调用时继续
+    while (state_ == State::REQUEST_LINE || state_ == State::HEADERS) {
+        const void* nl = scan_offset_ < data.size() ?
+            std::memchr(data.data() + scan_offset_, '\n', data.size() - scan_offset_) : nullptr;
+        if (!nl) {
+            scan_offset_ = data.size();
+            if (scan_offset_ > limits_.max_header_size) {
+                return fail(state_ == State::REQUEST_LINE ?
+                    HttpStatus::URI_TOO_LONG : HttpStatus::BAD_REQUEST);
+            }
+            return Result::INCOMPLETE;
+        }
+        size_t eol = static_cast<const char*>(nl) - data.data();
+        if (eol + 1 > limits_.max_header_size) {
+            return fail(state_ == State::REQUEST_LINE ?
+                HttpStatus::URI_TOO_LONG : HttpStatus::BAD_REQUEST);
+        }
+        size_t line_offset = line_start_;
+        size_t line_end = (eol > line_offset && data[eol - 1] == '\r') ? eol - 1 : eol;
+        std::string_view line = data.substr(line_offset, line_end - line_offset);
+        line_start_ = scan_offset_ = eol + 1;
+
+        if (state_ == State::REQUEST_LINE) {
+            if (line.empty()) {
+                continue;  // 允许请求前的空行（RFC 7230 3.5）
+            }
+            if (!parse_request_line(line, line_offset)) {
+                return Result::ERROR;
+            }
+            state_ = State::HEADERS;
+            continue;
+        }
+
+        if (line.empty()) {
+            header_end_ = eol + 1;
+            // 同时带有两种长度信息的请求可被用于请求走私，直接拒绝（RFC 7230 3.3.3）
+            if (chunked_ && has_content_length_) {
+                return fail(HttpStatus::BAD_REQUEST);
+            }
+            state_ = State::BODY;
+            if (pause_after_headers_ && (chunked_ || content_length_ > 0)) {
+                materialize(data.data());
+                return Result::HEADERS;
+            }
+            break;
+        }
+        if (!parse_header_line(line, line_offset)) {
+            return Result::ERROR;
+        }
+    }
+
+    if (state_ == State::BODY) {
+        if (!streaming_) {
+            Result result = buffer_body(data);
+            if (result != Result::COMPLETE) {
+                return result;
+            }
+        }
+        state_ = State::COMPLETE;
+    }
+
+    materialize(data.data());
+    return Result::COMPLETE;
+}
+
+void HttpParser::stream_body() {
+    streaming_ = true;
+    if (chunked_) {
+        decoder_.reset_chunked();
+    }
+    else {
+        decoder_.reset(content_length_);
+    }
+}
+
+HttpParser::Result HttpParser::buffer_body(std::string_view data) {
+    if (!body_started_) {
+        if (!chunked_ && content_length_ > limits_.max_request_size) {
+            return fail(HttpStatus::PAYLOAD_TOO_LARGE);
+        }
+        if (chunked_) {
+            decoder_.reset_chunked();
+        }
+        body_started_ = true;
+    }
+    if (!chunked_) {
+        return data.size() - header_end_ < content_length_ ? Result::INCOMPLETE : Result::COMPLETE;
+    }
+
+    // chunked：只解码新到达的字节，数据部分拼接为连续的请求体
+    while (true) {
+        size_t consumed = 0;
+        std::string_view chunk;
+        BodyDecoder::Result result = decoder_.decode(data.substr(header_end_ + body_consumed_), consumed, chunk);
+        body_consumed_ += consumed;
+        switch (result) {
+            case BodyDecoder::Result::DATA:
+                if (decoded_body_.size() + chunk.size() > limits_.max_request_size) {
+                    return fail(HttpStatus::PAYLOAD_TOO_LARGE);
+                }
+                decoded_body_.append(chunk);
+                break;
+            case BodyDecoder::Result::DONE:
+                return Result::COMPLETE;
+            case BodyDecoder::Result::ERROR:
+                return fail(HttpStatus::BAD_REQUEST);
+            case BodyDecoder::Result::INCOMPLETE:
+                // 分块框架同样占用读缓冲区，缓冲区已满仍未结束时按超限处理
+                if (data.size() >= limits_.max_header_size + limits_.max_request_size) {
+                    return fail(HttpStatus::PAYLOAD_TOO_LARGE);
+                }
+                return Result::INCOMPLETE;
+        }
+    }
+}
+
+HttpParser::Result HttpParser::fail(HttpStatus status) {
+    state_ = State::ERROR;
+    error_status_ = status;
+    return Result::ERROR;
+}
+
+bool HttpParser::parse_request_line(std::string_view line, size_t offset) {
+    size_t sp1 = line.find(' ');
+    if (sp1 == std::string_view::npos || sp1 == 0) {
+        fail(HttpStatus::BAD_REQUEST);
+        return false;
+    }
+    size_t sp2 = line.find(' ', sp1 + 1);
+    if (sp2 == std::string_view::npos || sp2 == sp1 + 1) {
+        fail(HttpStatus::BAD_REQUEST);
+        return false;
+    }
+    std::string_view method = line.substr(0, sp1);
+    std::string_view version = line.substr(sp2 + 1);
+    for (char c : method) {
+        if (!is_token_char(c)) {
+            fail(HttpStatus::BAD_REQUEST);
+            return false;
+        }
+    }
+    if (version.size() != 8 || version.compare(0, 5, "HTTP/") != 0 ||
+        !std::isdigit(static_cast<unsigned char>(version[5])) || version[6] != '.' ||
+        !std::isdigit(static_cast<unsigned char>(version[7]))) {
+        fail(HttpStatus::BAD_REQUEST);
+        return false;
+    }
+    if (version[5] != '1') {
+        fail(HttpStatus::HTTP_VERSION_NOT_SUPPORTED);
+        return false;
+    }
+
+    method_span_ = {static_cast<uint32_t>(offset), static_cast<uint32_t>(sp1)};
+    target_span_ = {static_cast<uint32_t>(offset + sp1 + 1), static_cast<uint32_t>(sp2 - sp1 - 1)};
+    version_span_ = {static_cast<uint32_t>(offset + sp2 + 1), 8};
+    return true;
+}
+
+bool HttpParser::parse_header_line(std::string_view line, size_t offset) {
+    if (line.front() == ' ' || line.front() == '\t') {
+        // 已废弃的多行折叠头部（obs-fold）
+        fail(HttpStatus::BAD_REQUEST);
+        return false;
+    }
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos || colon == 0) {
+        fail(HttpStatus::BAD_REQUEST);
+        return false;
+    }
+    std::string_view name = line.substr(0, colon);
+    for (char c : name) {
+        if (!is_token_char(c)) {
+            fail(HttpStatus::BAD_REQUEST);
+            return false;
+        }
+    }
+    if (header_spans_.size() >= limits_.max_header_count) {
+        fail(HttpStatus::BAD_REQUEST);
+        return false;
+    }
+
+    std::string_view value = trim_ows(line.substr(colon + 1));
+    size_t value_offset = value.empty() ? offset + line.size() : offset + (value.data() - line.data());
+
+    if (iequals(name, "content-length")) {
+        if (value.empty()) {
+            fail(HttpStatus::BAD_REQUEST);
+            return false;
+        }
+        // 与max_request_size的比较推迟到请求头结束：流式读取的请求体不受其限制
+        size_t length = 0;
+        for (char c : value) {
+            if (!std::isdigit(static_cast<unsigned char>(c)) || length > (SIZE_MAX >> 4)) {
+                fail(std::isdigit(static_cast<unsigned char>(c)) ?
+                    HttpStatus::PAYLOAD_TOO_LARGE : HttpStatus::BAD_REQUEST);
+                return false;
+            }
+            length = length * 10 + (c - '0');
+        }
+        if (has_content_length_ && length != content_length_) {
+            fail(HttpStatus::BAD_REQUEST);
+            return false;
+        }
+        has_content_length_ = true;
+        content_length_ = length;
+    }
+    else if (iequals(name, "transfer-encoding")) {
+        // 只支持单独的chunked编码，其他传输编码无法解出请求体
+        if (iequals(value, "chunked")) {
+            chunked_ = true;
+        }
+        else if (!iequals(value, "identity")) {
+            fail(HttpStatus::NOT_IMPLEMENTED);
+            return false;
+        }
+    }
+
+    header_spans_.push_back({
+        Span{static_cast<uint32_t>(offset), static_cast<uint32_t>(colon)},
+        Span{static_cast<uint32_t>(value_offset), static_cast<uint32_t>(value.size())}
+    });
+    return true;
+}
+
+void HttpParser::materialize(const char* base) {
+    method_ = method_span_.in(base);
+    target_ = target_span_.in(base);
+    version_ = version_span_.in(base);
+
+    size_t query_pos = target_.find('?');
+    path_ = target_.substr(0, query_pos);
+    query_ = query_pos == std::string_view::npos ? std::string_view() : target_.substr(query_pos + 1);
+
+    headers_.clear();
+    for (const auto& [name, value] : header_spans_) {
+        headers_.push_back({name.in(base), value.in(base)});
+    }
+    if (streaming_ || state_ != State::COMPLETE) {
+        body_ = std::string_view();
+    }
+    else {
+        body_ = chunked_ ? std::string_view(decoded_body_) : std::string_view(base + header_end_, content_length_);
+    }
+}
+
+std::string_view HttpParser::header(std::string_view name) const {
+    for (const auto& h : headers_) {
+        if (iequals(h.name, name)) {
+            return h.value;
+        }
+    }
+    return std::string_view();
+}
+
+bool HttpParser::keep_alive() const {
+    std::string_view connection = header("Connection");
+    if (version_ == "HTTP/1.0") {
+        return iequals(connection, "keep-alive");
+    }
+    return !iequals(connection, "close");
+}
+
+bool HttpParser::iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
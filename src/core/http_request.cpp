@@ -1,4 +1,5 @@
 #include "core/http_request.h"
+#include "core/http_parser.h"
 #include <sstream>
 #include <algorithm>
 
@@ -30,13 +31,27 @@ bool HttpRequest::has_param(const std::string& key) const {
     return params_.find(key) != params_.end();
 }
 
-void HttpRequest::set_path_param(const std::string& key, const std::string& value) {
-    path_params_[key] = value;
+std::string_view HttpRequest::path_param(std::string_view key) const {
+    for (size_t i = 0; i < path_params_.count; ++i) {
+        const auto& param = path_params_.items[i];
+        if (param.name == key) {
+            return std::string_view(path_).substr(param.offset, param.length);
+        }
+    }
+    return {};
 }
 
 std::string HttpRequest::get_path_param(const std::string& key) const {
-    auto it = path_params_.find(key);
-    return it != path_params_.end() ? it->second : "";
+    return std::string(path_param(key));
+}
+
+bool HttpRequest::has_path_param(const std::string& key) const {
+    for (size_t i = 0; i < path_params_.count; ++i) {
+        if (path_params_.items[i].name == key) {
+            return true;
+        }
+    }
+    return false;
 }
 
 std::string HttpRequest::get_form_data(const std::string& key) const {
@@ -53,75 +68,98 @@ bool HttpRequest::is_json() const {
     return content_type.find("application/json") != std::string::npos;
 }
 
+ssize_t HttpRequest::read_body(char* buf, size_t len) const {
+    if (body_source_) {
+        return body_source_->read(buf, len);
+    }
+    size_t n = std::min(len, body_.size() - body_offset_);
+    std::copy_n(body_.data() + body_offset_, n, buf);
+    body_offset_ += n;
+    return static_cast<ssize_t>(n);
+}
+
+bool HttpRequest::consume_body(const std::function<bool(std::string_view)>& sink) const {
+    char buf[16 * 1024];
+    while (true) {
+        ssize_t n = read_body(buf, sizeof(buf));
+        if (n <= 0) {
+            return n == 0;
+        }
+        if (!sink(std::string_view(buf, n))) {
+            return false;
+        }
+    }
+}
+
+bool HttpRequest::body_complete() const {
+    return !body_source_ || body_source_->complete();
+}
+
 bool HttpRequest::parse(const std::string& raw_request) {
-    std::istringstream stream(raw_request);
-    std::string line;
-    
-    // 解析请求行
-    if (!std::getline(stream, line)) {
+    // 与服务器共用增量解析器；原始请求已完整给出，不再额外限制大小
+    HttpParser::Limits limits;
+    limits.max_header_size = raw_request.size();
+    limits.max_request_size = raw_request.size();
+    HttpParser parser(limits);
+    if (parser.parse(raw_request) != HttpParser::Result::COMPLETE) {
         return false;
     }
-    
-    // 移除回车符
-    if (!line.empty() && line.back() == '\r') {
-        line.pop_back();
+    populate(parser);
+    return true;
+}
+
+void HttpRequest::populate(const HttpParser& parser) {
+    method_.assign(parser.method());
+    std::string_view path = parser.path();
+    if (path.find_first_of("%+") != std::string_view::npos) {
+        path_ = url_decode(std::string(path));
+    } else {
+        path_.assign(path);
     }
-    
-    std::istringstream line_stream(line);
-    std::string path_with_query, version;
-    if (!(line_stream >> method_ >> path_with_query >> version_)) {
-        return false;
+    query_string_.assign(parser.query());
+    version_.assign(parser.version());
+
+    // 头部名称在插入时一次性转为小写，不产生中间副本
+    for (const auto& header : parser.headers()) {
+        std::string key(header.name.size(), '\0');
+        std::transform(header.name.begin(), header.name.end(), key.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        headers_[std::move(key)].assign(header.value);
     }
-    
-    // 分离路径和查询字符串
-    size_t query_pos = path_with_query.find('?');
-    if (query_pos != std::string::npos) {
-        path_ = path_with_query.substr(0, query_pos);
-        query_string_ = path_with_query.substr(query_pos + 1);
-        parse_query_string();
+    body_.assign(parser.body());
+    parse_query_and_form();
+}
+
+void HttpRequest::populate(const std::string& method, std::string_view target, const std::string& version,
+                           std::string body) {
+    method_ = method;
+    size_t query = target.find('?');
+    std::string_view path = target.substr(0, query);
+    if (path.find_first_of("%+") != std::string_view::npos) {
+        path_ = url_decode(std::string(path));
     } else {
-        path_ = path_with_query;
+        path_.assign(path);
     }
-    
+    query_string_.assign(query == std::string_view::npos ? std::string_view() : target.substr(query + 1));
     version_ = version;
-    
-    // 解析请求头
-    while (std::getline(stream, line) && !line.empty()) {
-        if (!line.empty() && line.back() == '\r') {
-            line.pop_back();
-        }
-        
-        size_t colon_pos = line.find(':');
-        if (colon_pos != std::string::npos) {
-            std::string key = line.substr(0, colon_pos);
-            std::string value = line.substr(colon_pos + 1);
-            
-            // 去除前后空格
-            key.erase(0, key.find_first_not_of(" \t"));
-            key.erase(key.find_last_not_of(" \t") + 1);
-            value.erase(0, value.find_first_not_of(" \t"));
-            value.erase(value.find_last_not_of(" \t") + 1);
-            
-            add_header(key, value);
-        }
+    body_ = std::move(body);
+    parse_query_and_form();
+}
+
+void HttpRequest::parse_query_and_form() {
+    if (!query_string_.empty()) {
+        parse_query_string();
     }
     
-    // 读取请求体
-    std::string remaining((std::istreambuf_iterator<char>(stream)),
-                         std::istreambuf_iterator<char>());
-    body_ = remaining;
-    
     // 解析表单数据
-    if (has_header("Content-Type")) {
-        std::string content_type = get_header("Content-Type");
-        if (content_type.find("application/x-www-form-urlencoded") != std::string::npos) {
+    auto content_type = headers_.find("content-type");
+    if (content_type != headers_.end()) {
+        if (content_type->second.find("application/x-www-form-urlencoded") != std::string::npos) {
             parse_form_data();
-        } else if (content_type.find("multipart/form-data") != std::string::npos) {
+        } else if (content_type->second.find("multipart/form-data") != std::string::npos) {
             parse_multipart_data();
         }
     }
-    
-    return true;
 }
 
 void HttpRequest::parse_query_string() {
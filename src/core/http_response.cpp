@@ -1,11 +1,144 @@
 #include "core/http_response.h"
+#include "core/http_request.h"
 #include <sstream>
 #include <fstream>
 #include <algorithm>
 #include <ctime>
 #include <iomanip>
+#include <random>
+#include <strings.h>
+#include <sys/stat.h>
 
-HttpResponse::HttpResponse() : status_(HttpStatus::OK) {
+namespace {
+// 实体标签列表（If-Match/If-None-Match/If-Range）中是否有与etag匹配的；强比较要求两者都不是弱标签
+bool etag_list_matches(const std::string& list, const std::string& etag, bool strong) {
+    if (etag.empty()) {
+        return false;
+    }
+    bool weak = etag.compare(0, 2, "W/") == 0;
+    if (strong && weak) {
+        return false;
+    }
+    std::string_view opaque = std::string_view(etag).substr(weak ? 2 : 0);
+    size_t pos = 0;
+    while (pos < list.size()) {
+        char c = list[pos];
+        if (c == ' ' || c == '\t' || c == ',') {
+            ++pos;
+            continue;
+        }
+        if (c == '*') {
+            return true;
+        }
+        bool candidate_weak = list.compare(pos, 2, "W/") == 0;
+        if (candidate_weak) {
+            pos += 2;
+        }
+        if (pos >= list.size() || list[pos] != '"') {
+            return false;  // 格式错误，按不匹配处理
+        }
+        size_t end = list.find('"', pos + 1);
+        if (end == std::string::npos) {
+            return false;
+        }
+        if (std::string_view(list).substr(pos, end + 1 - pos) == opaque && !(strong && candidate_weak)) {
+            return true;
+        }
+        pos = end + 1;
+    }
+    return false;
+}
+
+constexpr size_t MAX_RANGES = 16;
+
+// 解析Range: bytes=...，区间按起点排序并合并重叠或相邻的；不可满足的区间丢弃。
+// 单位不是bytes、格式错误或区间过多时返回false，按没有Range处理
+bool parse_byte_ranges(const std::string& value, size_t length, std::vector<std::pair<size_t, size_t>>& ranges) {
+    if (value.size() < 6 || strncasecmp(value.c_str(), "bytes=", 6) != 0) {
+        return false;
+    }
+    auto parse_number = [](std::string_view text, size_t& number) {
+        if (text.empty() || text.size() > 18) {
+            return false;
+        }
+        number = 0;
+        for (char c : text) {
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            number = number * 10 + (c - '0');
+        }
+        return true;
+    };
+    size_t specs = 0;
+    std::string_view rest = std::string_view(value).substr(6);
+    while (!rest.empty()) {
+        size_t comma = rest.find(',');
+        std::string_view spec = rest.substr(0, comma);
+        rest = comma == std::string_view::npos ? std::string_view() : rest.substr(comma + 1);
+        while (!spec.empty() && (spec.front() == ' ' || spec.front() == '\t')) {
+            spec.remove_prefix(1);
+        }
+        while (!spec.empty() && (spec.back() == ' ' || spec.back() == '\t')) {
+            spec.remove_suffix(1);
+        }
+        if (spec.empty()) {
+            continue;
+        }
+        if (++specs > MAX_RANGES) {
+            return false;  // 大量小区间只会放大开销，整体发送
+        }
+        size_t dash = spec.find('-');
+        if (dash == std::string_view::npos) {
+            return false;
+        }
+        size_t first, last;
+        if (dash == 0) {
+            // 后缀区间：最后N个字节
+            if (!parse_number(spec.substr(1), last)) {
+                return false;
+            }
+            if (last > 0 && length > 0) {
+                ranges.emplace_back(length - std::min(last, length), length - 1);
+            }
+            continue;
+        }
+        if (!parse_number(spec.substr(0, dash), first)) {
+            return false;
+        }
+        if (dash + 1 == spec.size()) {
+            last = length - 1;
+        }
+        else if (!parse_number(spec.substr(dash + 1), last) || last < first) {
+            return false;
+        }
+        if (first < length) {
+            ranges.emplace_back(first, std::min(last, length - 1));
+        }
+    }
+    if (specs == 0) {
+        return false;
+    }
+    std::sort(ranges.begin(), ranges.end());
+    size_t merged = 0;
+    for (size_t i = 1; i < ranges.size(); ++i) {
+        if (ranges[i].first <= ranges[merged].second + 1) {
+            ranges[merged].second = std::max(ranges[merged].second, ranges[i].second);
+        }
+        else {
+            ranges[++merged] = ranges[i];
+        }
+    }
+    if (!ranges.empty()) {
+        ranges.resize(merged + 1);
+    }
+    return true;
+}
+}
+
+HttpResponse::HttpResponse()
+    : status_(HttpStatus::OK), streaming_(false), stream_ended_(false),
+      content_length_set_(false), cache_valid_(false) {
     // 设置默认头部
     set_header("Content-Type", "text/html; charset=utf-8");
     set_header("Connection", "close");
@@ -42,45 +175,317 @@ bool HttpResponse::has_header(const std::string& key) const {
     return headers_.find(lower_key) != headers_.end();
 }
 
+void HttpResponse::remove_header(const std::string& key) {
+    std::string lower_key = key;
+    std::transform(lower_key.begin(), lower_key.end(), lower_key.begin(), ::tolower);
+    headers_.erase(lower_key);
+}
+
 void HttpResponse::set_body(const std::string& body) {
+    file_body_.reset();
+    shared_body_.reset();
+    body_parts_.clear();
     body_ = body;
     set_header("Content-Length", std::to_string(body_.size()));
 }
 
+void HttpResponse::set_body(std::string&& body) {
+    file_body_.reset();
+    shared_body_.reset();
+    body_parts_.clear();
+    body_ = std::move(body);
+    set_header("Content-Length", std::to_string(body_.size()));
+}
+
 void HttpResponse::append_body(const std::string& content) {
+    if (shared_body_) {
+        body_ = *shared_body_;
+        shared_body_.reset();
+    }
+    body_parts_.clear();
     body_ += content;
     set_header("Content-Length", std::to_string(body_.size()));
 }
 
-void HttpResponse::json(const std::string& json_str) {
+void HttpResponse::json(std::string json_str) {
     set_header("Content-Type", "application/json; charset=utf-8");
-    set_body(json_str);
+    set_body(std::move(json_str));
 }
 
-void HttpResponse::html(const std::string& html_str) {
+void HttpResponse::html(std::string html_str) {
     set_header("Content-Type", "text/html; charset=utf-8");
-    set_body(html_str);
+    set_body(std::move(html_str));
 }
 
-void HttpResponse::text(const std::string& text_str) {
+void HttpResponse::text(std::string text_str) {
     set_header("Content-Type", "text/plain; charset=utf-8");
-    set_body(text_str);
+    set_body(std::move(text_str));
 }
 
 void HttpResponse::file(const std::string& file_path) {
-    std::ifstream file(file_path, std::ios::binary);
-    if (!file.is_open()) {
+    file(file_path, get_mime_type(file_path));
+}
+
+void HttpResponse::file(const std::string& file_path, const std::string& mime_type) {
+    if (!open_file_body(file_path)) {
         set_status(HttpStatus::NOT_FOUND);
         html("<h1>404 Not Found</h1><p>File not found: " + file_path + "</p>");
         return;
     }
-    
-    // 读取文件内容
-    std::string content((std::istreambuf_iterator<char>(file)),
-                       std::istreambuf_iterator<char>());
-    
-    set_header("Content-Type", get_mime_type(file_path));
-    set_body(content);
+    set_header("Content-Type", mime_type);
+}
+
+bool HttpResponse::open_file_body(const std::string& file_path) {
+    int fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+        close(fd);
+        return false;
+    }
+    set_file_body(fd, 0, static_cast<size_t>(file_stat.st_size));
+    set_file_validators(file_stat);
+    return true;
+}
+
+void HttpResponse::set_etag(const std::string& etag) {
+    set_header("ETag", etag);
+}
+
+void HttpResponse::set_last_modified(const std::string& last_modified) {
+    set_header("Last-Modified", last_modified);
+}
+
+void HttpResponse::set_file_validators(const struct stat& file_stat) {
+    set_header("ETag", file_etag(file_stat));
+    set_header("Last-Modified", http_date(file_stat.st_mtime));
+}
+
+std::string HttpResponse::file_etag(const struct stat& file_stat) {
+    // 修改时间精确到纳秒，同一秒内的多次写入也能区分；替换文件（新inode）即使大小与时间相同也会变化
+    char buf[80];
+    snprintf(buf, sizeof(buf), "\"%lx-%llx-%llx.%lx\"", static_cast<unsigned long>(file_stat.st_ino),
+             static_cast<unsigned long long>(file_stat.st_size),
+             static_cast<unsigned long long>(file_stat.st_mtim.tv_sec),
+             static_cast<unsigned long>(file_stat.st_mtim.tv_nsec));
+    return buf;
+}
+
+std::string HttpResponse::http_date(time_t time) {
+    struct tm tm;
+    gmtime_r(&time, &tm);
+    char buf[64];
+    strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return buf;
+}
+
+bool HttpResponse::parse_http_date(const std::string& value, time_t& time) {
+    static const char* const formats[] = {
+        "%a, %d %b %Y %H:%M:%S GMT",  // IMF-fixdate
+        "%A, %d-%b-%y %H:%M:%S GMT",  // RFC 850
+        "%a %b %e %H:%M:%S %Y",       // asctime
+    };
+    for (const char* format : formats) {
+        struct tm tm{};
+        const char* end = strptime(value.c_str(), format, &tm);
+        if (end && *end == '\0') {
+            time = timegm(&tm);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HttpResponse::evaluate_preconditions(const HttpRequest& request) {
+    // 其他方法的前置条件须在修改状态之前判断，由处理器自行处理
+    int status = status_code();
+    if ((request.method() != "GET" && request.method() != "HEAD") || status < 200 || status >= 300 || streaming_) {
+        return false;
+    }
+    std::string etag = get_header("ETag");
+    time_t modified = 0;
+    bool has_modified = parse_http_date(get_header("Last-Modified"), modified);
+    if (etag.empty() && !has_modified) {
+        return false;
+    }
+    // RFC 9110 13.2.2：If-Match优先于If-Unmodified-Since，If-None-Match优先于If-Modified-Since；
+    // 无法解析的日期忽略
+    time_t since;
+    std::string if_match = request.get_header("If-Match");
+    std::string if_unmodified_since = request.get_header("If-Unmodified-Since");
+    if ((!if_match.empty() && !etag_list_matches(if_match, etag, true)) ||
+        (if_match.empty() && has_modified && parse_http_date(if_unmodified_since, since) && modified > since)) {
+        set_status(HttpStatus::PRECONDITION_FAILED);
+        text("Precondition Failed");
+        return true;
+    }
+    std::string if_none_match = request.get_header("If-None-Match");
+    if (!if_none_match.empty()) {
+        if (etag_list_matches(if_none_match, etag, false)) {
+            not_modified();
+            return true;
+        }
+        return false;
+    }
+    if (has_modified && parse_http_date(request.get_header("If-Modified-Since"), since) && modified <= since) {
+        not_modified();
+        return true;
+    }
+    return false;
+}
+
+bool HttpResponse::apply_range(const HttpRequest& request) {
+    // 已编码的表示不按区间发送：区间需针对原始字节，而压缩结果不稳定
+    if (status_ != HttpStatus::OK || streaming_ || has_header("Content-Encoding") ||
+        (!file_body_ && !shared_body_)) {
+        return false;
+    }
+    set_header("Accept-Ranges", "bytes");
+    std::string range = request.get_header("Range");
+    if (request.method() != "GET" || range.empty()) {
+        return false;
+    }
+    // If-Range：实体标签须强匹配，日期须与Last-Modified一致，否则发送完整内容
+    std::string if_range = request.get_header("If-Range");
+    if (!if_range.empty()) {
+        if (if_range[0] == '"' || if_range.compare(0, 2, "W/") == 0) {
+            if (!etag_list_matches(if_range, get_header("ETag"), true)) {
+                return false;
+            }
+        }
+        else {
+            time_t since, modified;
+            if (!parse_http_date(if_range, since) || !parse_http_date(get_header("Last-Modified"), modified) ||
+                since != modified) {
+                return false;
+            }
+        }
+    }
+
+    size_t length = file_body_ ? file_body_->length : shared_body_->size();
+    std::vector<std::pair<size_t, size_t>> ranges;  // [first, last]
+    if (!parse_byte_ranges(range, length, ranges)) {
+        return false;
+    }
+    if (ranges.empty()) {
+        set_status(HttpStatus::RANGE_NOT_SATISFIABLE);
+        std::string total = std::to_string(length);
+        text("Range Not Satisfiable");
+        set_header("Content-Range", "bytes */" + total);
+        return true;
+    }
+
+    set_status(HttpStatus::PARTIAL_CONTENT);
+    auto content_range = [length](const std::pair<size_t, size_t>& r) {
+        return "bytes " + std::to_string(r.first) + "-" + std::to_string(r.second) + "/" + std::to_string(length);
+    };
+    if (ranges.size() == 1) {
+        const auto& r = ranges[0];
+        set_header("Content-Range", content_range(r));
+        if (file_body_) {
+            std::shared_ptr<const FileBody> file = file_body_;
+            file_body_ = std::make_shared<FileBody>(file, file->offset + r.first, r.second - r.first + 1);
+            set_header("Content-Length", std::to_string(file_body_->length));
+        }
+        else {
+            set_body(shared_body_->substr(r.first, r.second - r.first + 1));
+        }
+        return true;
+    }
+
+    // 多区间：multipart/byteranges，每段带各自的Content-Type与Content-Range
+    static thread_local std::mt19937_64 rng(std::random_device{}());
+    char boundary[24];
+    snprintf(boundary, sizeof(boundary), "%016llx", static_cast<unsigned long long>(rng()));
+    std::string content_type = get_header("Content-Type");
+    std::vector<BodyPart> parts;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        BodyPart part;
+        part.data = std::string(i == 0 ? "" : "\r\n") + "--" + boundary + "\r\n";
+        if (!content_type.empty()) {
+            part.data += "Content-Type: " + content_type + "\r\n";
+        }
+        part.data += "Content-Range: " + content_range(ranges[i]) + "\r\n\r\n";
+        size_t count = ranges[i].second - ranges[i].first + 1;
+        if (file_body_) {
+            part.file = std::make_shared<FileBody>(file_body_, file_body_->offset + ranges[i].first, count);
+        }
+        else {
+            part.data.append(*shared_body_, ranges[i].first, count);
+        }
+        parts.push_back(std::move(part));
+    }
+    parts.push_back(BodyPart{std::string("\r\n--") + boundary + "--\r\n", nullptr});
+    set_header("Content-Type", std::string("multipart/byteranges; boundary=") + boundary);
+    set_body_parts(std::move(parts));
+    return true;
+}
+
+void HttpResponse::not_modified() {
+    set_status(HttpStatus::NOT_MODIFIED);
+    body_.clear();
+    file_body_.reset();
+    shared_body_.reset();
+    body_parts_.clear();
+    for (const char* name : {"content-length", "content-type", "content-encoding", "content-range"}) {
+        headers_.erase(name);
+    }
+}
+
+void HttpResponse::set_file_body(int fd, off_t offset, size_t length) {
+    body_.clear();
+    shared_body_.reset();
+    body_parts_.clear();
+    file_body_ = std::make_shared<FileBody>(fd, offset, length);
+    set_header("Content-Length", std::to_string(length));
+}
+
+void HttpResponse::set_shared_body(std::shared_ptr<const std::string> body) {
+    file_body_.reset();
+    body_.clear();
+    body_parts_.clear();
+    shared_body_ = std::move(body);
+    set_header("Content-Length", std::to_string(shared_body_ ? shared_body_->size() : 0));
+}
+
+void HttpResponse::set_body_parts(std::vector<BodyPart> parts) {
+    body_.clear();
+    file_body_.reset();
+    shared_body_.reset();
+    size_t length = 0;
+    for (const auto& part : parts) {
+        length += part.data.size() + (part.file ? part.file->length : 0);
+    }
+    body_parts_ = std::move(parts);
+    set_header("Content-Length", std::to_string(length));
+}
+
+void HttpResponse::download(const std::string& file_path, const std::string& download_name) {
+    file(file_path, "application/octet-stream");
+    if (!file_body_) {
+        return;
+    }
+    std::string name = download_name.empty() ? file_path.substr(file_path.rfind('/') + 1) : download_name;
+    // 文件名中的引号与反斜杠需转义（RFC 6266的quoted-string）
+    std::string quoted;
+    for (char c : name) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    set_header("Content-Disposition", "attachment; filename=\"" + quoted + "\"");
+}
+
+std::string HttpResponse::take_body() {
+    if (shared_body_) {
+        std::string copy = *shared_body_;
+        shared_body_.reset();
+        return copy;
+    }
+    return std::move(body_);
 }
 
 void HttpResponse::redirect(const std::string& url, HttpStatus status) {
@@ -109,43 +514,127 @@ void HttpResponse::clear_cookie(const std::string& name, const std::string& path
 }
 
 std::string HttpResponse::to_string() const {
-    std::ostringstream response;
-    
-    // 状态行
-    response << "HTTP/1.1 " << static_cast<int>(status_) << " " 
-             << status_to_string(status_) << "\r\n";
-    
-    // 响应头
+    std::string headers = render_headers();
+    std::string cookies = render_cookies();
+    const std::string& line = status_line();
+
+    std::string response;
+    response.reserve(line.size() + headers.size() + cookies.size() + 2 + body_size());
+    response += line;
+    response += headers;
+    response += cookies;
+    // 空行分隔符
+    response += "\r\n";
+    if (body_omitted_) {
+        return response;
+    }
+    // 响应体；文件内容仅在调试和测试时读入，正常发送路径使用sendfile
+    auto append_file = [&response](const FileBody& file) {
+        size_t start = response.size();
+        response.resize(start + file.length);
+        ssize_t n = pread(file.fd, &response[start], file.length, file.offset);
+        response.resize(start + std::max<ssize_t>(n, 0));
+    };
+    if (file_body_) {
+        append_file(*file_body_);
+    } else if (!body_parts_.empty()) {
+        for (const auto& part : body_parts_) {
+            response += part.data;
+            if (part.file) {
+                append_file(*part.file);
+            }
+        }
+    } else {
+        response += body();
+    }
+    return response;
+}
+
+bool HttpResponse::start_streaming() {
+    if (streaming_) {
+        return !stream_ended_;
+    }
+    streaming_ = true;
+    if (!stream_) {
+        body_.clear();
+        shared_body_.reset();
+        body_parts_.clear();
+        set_header("Content-Length", "0");
+        return true;
+    }
+    return stream_->begin(*this);
+}
+
+bool HttpResponse::write_chunk(std::string_view chunk) {
+    if (!start_streaming()) {
+        return false;
+    }
+    if (!stream_) {
+        body_.append(chunk);
+        set_header("Content-Length", std::to_string(body_.size()));
+        return true;
+    }
+    return stream_->write(chunk);
+}
+
+bool HttpResponse::end_streaming() {
+    if (!streaming_ || stream_ended_) {
+        return false;
+    }
+    stream_ended_ = true;
+    return stream_ ? stream_->end() : true;
+}
+
+const std::string& HttpResponse::status_line() const {
+    static const std::vector<std::string> lines = []() {
+        std::vector<std::string> table(600);
+        for (int code = 100; code < 600; ++code) {
+            table[code] = "HTTP/1.1 " + std::to_string(code) + " " +
+                          status_to_string(static_cast<HttpStatus>(code)) + "\r\n";
+        }
+        return table;
+    }();
+    int code = static_cast<int>(status_);
+    if (code >= 100 && code < 600) {
+        return lines[code];
+    }
+    thread_local std::string custom;
+    custom = "HTTP/1.1 " + std::to_string(code) + " " + status_to_string(status_) + "\r\n";
+    return custom;
+}
+
+std::string HttpResponse::render_headers() const {
+    size_t total = 0;
     for (const auto& [key, value] : headers_) {
-        // 首字母大写的头部名称
-        std::string header_name = key;
+        total += key.size() + value.size() + 4;
+    }
+    std::string block;
+    block.reserve(total);
+    for (const auto& [key, value] : headers_) {
+        // 首字母大写的头部名称，直接写入头部块
         bool capitalize_next = true;
-        for (char& c : header_name) {
-            if (capitalize_next) {
-                c = std::toupper(c);
-                capitalize_next = false;
-            } else if (c == '-') {
-                capitalize_next = true;
-            }
+        for (char c : key) {
+            block.push_back(capitalize_next ? static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : c);
+            capitalize_next = (c == '-');
         }
-        response << header_name << ": " << value << "\r\n";
+        block += ": ";
+        block += value;
+        block += "\r\n";
     }
-    
-    // Cookie
+    return block;
+}
+
+std::string HttpResponse::render_cookies() const {
+    std::string block;
     for (const auto& cookie : cookies_) {
-        response << "Set-Cookie: " << cookie_to_string(cookie) << "\r\n";
+        block += "Set-Cookie: ";
+        block += cookie_to_string(cookie);
+        block += "\r\n";
     }
-    
-    // 空行分隔符
-    response << "\r\n";
-    
-    // 响应体
-    response << body_;
-    
-    return response.str();
+    return block;
 }
 
-std::string HttpResponse::status_to_string(HttpStatus status) const {
+std::string HttpResponse::status_to_string(HttpStatus status) {
     switch (status) {
         case HttpStatus::CONTINUE: return "Continue";
         case HttpStatus::SWITCHING_PROTOCOLS: return "Switching Protocols";
@@ -173,13 +662,16 @@ std::string HttpResponse::status_to_string(HttpStatus status) const {
         case HttpStatus::CONFLICT: return "Conflict";
         case HttpStatus::GONE: return "Gone";
         case HttpStatus::LENGTH_REQUIRED: return "Length Required";
+        case HttpStatus::PRECONDITION_FAILED: return "Precondition Failed";
         case HttpStatus::PAYLOAD_TOO_LARGE: return "Payload Too Large";
         case HttpStatus::URI_TOO_LONG: return "URI Too Long";
         case HttpStatus::UNSUPPORTED_MEDIA_TYPE: return "Unsupported Media Type";
         case HttpStatus::RANGE_NOT_SATISFIABLE: return "Range Not Satisfiable";
         case HttpStatus::EXPECTATION_FAILED: return "Expectation Failed";
         case HttpStatus::UNPROCESSABLE_ENTITY: return "Unprocessable Entity";
+        case HttpStatus::UPGRADE_REQUIRED: return "Upgrade Required";
         case HttpStatus::TOO_MANY_REQUESTS: return "Too Many Requests";
+        case HttpStatus::REQUEST_HEADER_FIELDS_TOO_LARGE: return "Request Header Fields Too Large";
         case HttpStatus::INTERNAL_SERVER_ERROR: return "Internal Server Error";
         case HttpStatus::NOT_IMPLEMENTED: return "Not Implemented";
         case HttpStatus::BAD_GATEWAY: return "Bad Gateway";
@@ -1,11 +1,15 @@
 #include "core/http_server.h"
 #include "core/http_request.h"
 #include "core/http_response.h"
+#include "core/http2.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <cstring>
+#include <strings.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <dirent.h>
 #include <chrono>
@@ -14,33 +18,7 @@
 HttpServer* HttpServer::instance_ = nullptr;
 
 Route::Route(HttpMethod m, const std::string& path, RouteHandler h)
-    : method(m), original_path(path), handler(std::move(h)) {
-    compile_path(path);
-}
-
-void Route::compile_path(const std::string& path) {
-    std::string pattern = path;
-    std::regex param_regex(R"(:([a-zA-Z_][a-zA-Z0-9_]*))");
-    std::sregex_iterator iter(pattern.begin(), pattern.end(), param_regex);
-    std::sregex_iterator end;
-
-    for(; iter != end; ++iter) {
-        param_names.push_back(iter->str(1));
-    }
-
-    // 将路径参数转换为正则表达式
-    pattern = std::regex_replace(pattern, param_regex, R"(([^/]+))");
-    
-    // 转义特殊字符
-    pattern = std::regex_replace(pattern, std::regex(R"(\.)"), R"(\.)");
-    pattern = std::regex_replace(pattern, std::regex(R"(\+)"), R"(\+)");
-    pattern = std::regex_replace(pattern, std::regex(R"(\*)"), R"(.*)");
-    
-    // 添加开始和结束锚点
-    pattern = "^" + pattern + "$";
-
-    this->pattern = std::regex(pattern);
-}
+    : method(m), original_path(path), handler(std::move(h)) {}
 
 ThreadPool::ThreadPool(size_t num_threads) : stop_(false) {
     for(size_t i = 0; i < num_threads; ++i) {
@@ -86,13 +64,38 @@ HttpServer::HttpServer(const ServerConfig& config)
     : config_(config)
     , running_(false)
     , shutting_down_(false)
-    , server_fd_(-1)
-    , epoll_fd_(-1)
-    , thread_pool_(std::make_unique<ThreadPool>(config.thread_pool_size)) {
+    , thread_pool_(std::make_unique<ThreadPool>(config.thread_pool_size))
+    , static_cache_(std::make_unique<StaticFileCache>(config.static_cache_bytes, config.static_cache_max_file_size,
+                                                      config.enable_compression ? STATIC_GZIP_LEVEL : 0)) {
     
     instance_ = this;
     stats_.start_time = std::chrono::steady_clock::now();
 
+    if(config_.reactor_count <= 0) {
+        config_.reactor_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // 未配置监听列表时沿用host:port
+    if(config_.listeners.empty()) {
+        ListenerConfig listener;
+        listener.address = config_.host;
+        config_.listeners.push_back(listener);
+    }
+    for(auto& listener : config_.listeners) {
+        if(listener.port == 0) {
+            listener.port = config_.port;
+        }
+        if(listener.backlog <= 0) {
+            listener.backlog = config_.max_connections;
+        }
+    }
+    overload_response_ = "HTTP/1.1 503 Service Unavailable\r\n"
+                         "Content-Type: text/plain\r\n"
+                         "Content-Length: 19\r\n"
+                         "Retry-After: " + std::to_string(config_.retry_after_seconds) + "\r\n"
+                         "Connection: close\r\n"
+                         "Server: " + config_.server_name + "\r\n\r\n"
+                         "Service Unavailable";
+
     // 设置默认错误处理器
     default_error_handler_ = [this](const HttpRequest& req, HttpResponse& res, int error_code) {
         res.set_status(static_cast<HttpStatus>(error_code));
@@ -122,28 +125,87 @@ bool HttpServer::start() {
         log("INFO", "Server is already running");
         return true;
     }
-    log("INFO", "Starting HTTP server on" + config_.host + ":" + std::to_string(config_.port));
-    if(!create_socket()) {
-        log("ERROR", "Failed to create socket");
-        return false;
+    std::string addresses;
+    for(const auto& listener : config_.listeners) {
+        addresses += (addresses.empty() ? "" : ", ") + listener_name(listener);
     }
-    if(!bind_socket()) {
-        log("ERROR", "Failed to bind socket");
-        return false;
+    log("INFO", "Starting HTTP server on " + addresses +
+        " with " + std::to_string(config_.reactor_count) + " reactor(s)");
+
+    // 热重启时先从旧进程接收监听套接字，跳过重新绑定
+    draining_.store(false);
+    drained_.store(false);
+    handed_off_.store(false);
+    auto handoff_begin = std::chrono::steady_clock::now();
+    if(!config_.handoff_path.empty() && receive_listeners()) {
+        log("INFO", "Inherited listening sockets from the previous process in " +
+            std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - handoff_begin).count()) + " us");
     }
-    if(!listen_socket()){
-        log("ERROR", "Failed to listen on socket");
-        return false;
+
+    // 每个Reactor独立创建监听套接字，由内核通过SO_REUSEPORT分发新连接
+    reactors_.clear();
+    for(int i = 0; i < config_.reactor_count; ++i) {
+        reactors_.push_back(std::make_unique<Reactor>());
+        Reactor& reactor = *reactors_.back();
+        reactor.index = i;
+        if(!open_listeners(reactor)) {
+            log("ERROR", "Failed to initialize reactor " + std::to_string(i));
+            reactors_.clear();
+            return false;
+        }
+    }
+    // 旧进程的Reactor多于本进程时，多出的SO_REUSEPORT套接字中可能已有排队的连接，轮流分给各Reactor继续accept
+    for(size_t i = 0; i < inherited_fds_.size(); ++i) {
+        for(size_t j = 0; j < inherited_fds_[i].size(); ++j) {
+            reactors_[j % reactors_.size()]->listen_fds.push_back(inherited_fds_[i][j]);
+        }
+    }
+    inherited_fds_.clear();
+    for(auto& reactor : reactors_) {
+        // 请求io_uring时优先使用，初始化失败（内核过旧或被禁用）则回退到epoll
+        bool uring = config_.io_backend == "io_uring";
+        if(!(uring && setup_uring(*reactor)) && !setup_epoll(*reactor)) {
+            log("ERROR", "Failed to initialize reactor " + std::to_string(reactor->index));
+            reactors_.clear();
+            return false;
+        }
+        reactor->timers.reset(now_ms() / TIMER_TICK_MS);
     }
-    if(!setup_epoll()){
-        log("ERROR", "Failed to setup epoll");
+    if(!config_.handoff_path.empty() && !open_handoff_socket()) {
+        reactors_.clear();
         return false;
     }
 
     running_.store(true);
+    shutting_down_.store(false);
+    if(config_.static_cache_bytes > 0 && !static_paths_.empty()) {
+        if(static_cache_->start()) {
+            for(const auto& [url_path, root_dir] : static_paths_) {
+                if(!static_cache_->watch(root_dir)) {
+                    log("WARN", "Static cache cannot watch " + root_dir + ", files under it are not cached");
+                }
+            }
+        }
+        else {
+            log("WARN", "inotify unavailable, static file cache disabled");
+        }
+    }
+    if(handoff_fd_ >= 0) {
+        handoff_thread_ = std::thread([this]() { handoff_loop(); });
+    }
 
-    main_thread_ = std::thread(&HttpServer::main_loop, this);
-    cleanup_thread_ = std::thread(&HttpServer::cleanup_loop, this);
+    for(auto& reactor : reactors_) {
+        Reactor* r = reactor.get();
+        r->thread = std::thread([this, r]() {
+            if(r->ring) {
+                uring_loop(*r);
+            }
+            else {
+                main_loop(*r);
+            }
+        });
+    }
 
     log("INFO", "Server started successfully");
     return true;
@@ -158,107 +220,259 @@ void HttpServer::stop() {
     shutting_down_.store(true);
     running_.store(false);
 
-    if(server_fd_ >= 0) {
-        close(server_fd_);
-        server_fd_ = -1;
-    }
-    if(epoll_fd_ >= 0) {
-        close(epoll_fd_);
-        epoll_fd_ = -1;
+    for(auto& reactor : reactors_) {
+        if(reactor->thread.joinable()) {
+            reactor->thread.join();
+        }
     }
-    if(main_thread_.joinable()) {
-        main_thread_.join();
+    if(handoff_thread_.joinable()) {
+        handoff_thread_.join();
     }
-    if(cleanup_thread_.joinable()) {
-        cleanup_thread_.join();
+    static_cache_->stop();
+    if(handoff_fd_ >= 0) {
+        close(handoff_fd_);
+        handoff_fd_ = -1;
+        if(!handed_off_.load()) {
+            unlink(config_.handoff_path.c_str());
+        }
     }
     
-    {
-        std::lock_guard<std::mutex> lock(connections_mutex_);
-        for(auto& [fd, conn] : connections_) {
-            close(fd);
+    for(auto& reactor : reactors_) {
+        reactor->close_fds();
+        reactor->connections.for_each([](const std::shared_ptr<Connection>& conn) {
+            if(!conn->closed.exchange(true)) {
+                shutdown(conn->fd, SHUT_RDWR);
+                close(conn->fd);
+            }
+        });
+        reactor->connections.clear();
+        // 关闭ring取消在途请求后才能释放其引用的连接
+        reactor->ring.reset();
+        reactor->ring_refs.clear();
+    }
+    // 监听套接字已交给新进程时，套接字文件归新进程所有
+    for(const auto& listener : config_.listeners) {
+        sockaddr_storage addr;
+        socklen_t addr_len;
+        if(!handed_off_.load() && parse_listen_address(listener, addr, addr_len) && addr.ss_family == AF_UNIX) {
+            unlink(reinterpret_cast<const sockaddr_un&>(addr).sun_path);
         }
-        connections_.clear();
     }
     log("INFO", "Server stopped");
 }
 
-bool HttpServer::create_socket() {
-    server_fd_ = socket(AF_INET, SOCK_STREAM, 0);
-    if(server_fd_ < 0) {
+bool HttpServer::open_listeners(Reactor& reactor) {
+    for(size_t i = 0; i < config_.listeners.size(); ++i) {
+        const ListenerConfig& listener = config_.listeners[i];
+        sockaddr_storage addr;
+        socklen_t addr_len = 0;
+        if(!parse_listen_address(listener, addr, addr_len)) {
+            log("ERROR", "Invalid listen address: " + listener.address);
+            return false;
+        }
+        if(i < inherited_fds_.size() && !inherited_fds_[i].empty()) {
+            reactor.listen_fds.push_back(inherited_fds_[i].front());
+            inherited_fds_[i].erase(inherited_fds_[i].begin());
+            continue;
+        }
+        // Unix域套接字只绑定一次，其余Reactor复制第一个Reactor的套接字，由各自事件循环竞争accept
+        if(addr.ss_family == AF_UNIX && reactor.index > 0) {
+            int fd = fcntl(reactors_.front()->listen_fds[i], F_DUPFD_CLOEXEC, 0);
+            if(fd < 0) {
+                log("ERROR", "Failed to duplicate listener " + listener.address + ": " + strerror(errno));
+                return false;
+            }
+            reactor.listen_fds.push_back(fd);
+            continue;
+        }
+        int fd = create_socket(listener, addr);
+        if(fd < 0) {
+            return false;
+        }
+        reactor.listen_fds.push_back(fd);
+        if(!bind_socket(fd, listener, addr, addr_len) || !listen_socket(fd, listener)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int HttpServer::create_socket(const ListenerConfig& listener, const sockaddr_storage& addr) {
+    int fd = socket(addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(fd < 0) {
         log("ERROR", "Socket creation failed: " + std::string(strerror(errno)));
-        return false;
+        return -1;
+    }
+    if(addr.ss_family == AF_UNIX) {
+        return fd;
     }
     int opt = 1;
-    if(setsockopt(server_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+    if(setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
         log("ERROR", "Failed to set SO_REUSEADDR: " + std::string(strerror(errno)));
-        close(server_fd_);
-        server_fd_ = -1;
-        return false;
+        close(fd);
+        return -1;
     }
-    //设置非阻塞模式
-    int flags = fcntl(server_fd_, F_GETFL, 0);
-    if(flags < 0 || fcntl(server_fd_, F_SETFL, flags | O_NONBLOCK) < 0) {
-        log("ERROR", "Failed to set non-blocking mode: " + std::string(strerror(errno)));
-        close(server_fd_);
-        server_fd_ = -1;
-        return false;
+    // 多个Reactor共享同一端口，由内核按四元组哈希做负载均衡
+    if(config_.reactor_count > 1 &&
+       setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        log("ERROR", "Failed to set SO_REUSEPORT: " + std::string(strerror(errno)));
+        close(fd);
+        return -1;
     }
-    return true;
+    if(addr.ss_family == AF_INET6) {
+        int v6only = listener.ipv6_only ? 1 : 0;
+        if(setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &v6only, sizeof(v6only)) < 0) {
+            log("ERROR", "Failed to set IPV6_V6ONLY: " + std::string(strerror(errno)));
+            close(fd);
+            return -1;
+        }
+    }
+    // 以下为优化项，内核不支持时只记录警告
+    if(listener.defer_accept_seconds > 0 &&
+       setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &listener.defer_accept_seconds,
+                  sizeof(listener.defer_accept_seconds)) < 0) {
+        log("WARN", "Failed to set TCP_DEFER_ACCEPT: " + std::string(strerror(errno)));
+    }
+    if(listener.fastopen_queue > 0 &&
+       setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN, &listener.fastopen_queue,
+                  sizeof(listener.fastopen_queue)) < 0) {
+        log("WARN", "Failed to set TCP_FASTOPEN: " + std::string(strerror(errno)));
+    }
+    return fd;
 }
 
-bool HttpServer::bind_socket() {
-    memset(&server_addr_, 0, sizeof(server_addr_));
-    server_addr_.sin_family = AF_INET;
-    server_addr_.sin_port = htons(config_.port);
-
-    if(config_.host == "0.0.0.0" || config_.host == "*"){
-        server_addr_.sin_addr.s_addr = INADDR_ANY;
-    }
-    else {
-        if (inet_pton(AF_INET, config_.host.c_str(), &server_addr_.sin_addr) <= 0) {
-            log("ERROR", "Invalid host address: " + config_.host);
-            return false;
+bool HttpServer::bind_socket(int fd, const ListenerConfig& listener, const sockaddr_storage& addr,
+                             socklen_t addr_len) {
+    if(addr.ss_family == AF_UNIX) {
+        // 清理上次运行遗留的套接字文件；路径上若是普通文件则不覆盖
+        const char* path = reinterpret_cast<const sockaddr_un&>(addr).sun_path;
+        struct stat st;
+        if(lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+            unlink(path);
         }
     }
-
-    if(bind(server_fd_, (struct sockaddr*)&server_addr_, sizeof(server_addr_)) < 0) {
-        log("ERROR", "Bind failed: " + std::string(strerror(errno)));
+    if(bind(fd, reinterpret_cast<const sockaddr*>(&addr), addr_len) < 0) {
+        log("ERROR", "Bind " + listener_name(listener) + " failed: " + std::string(strerror(errno)));
         return false;
     }
+    if(addr.ss_family == AF_UNIX &&
+       chmod(reinterpret_cast<const sockaddr_un&>(addr).sun_path, listener.unix_mode) < 0) {
+        log("WARN", "Failed to chmod " + listener.address + ": " + std::string(strerror(errno)));
+    }
     return true;
 }
 
-bool HttpServer::listen_socket() {
-    if(listen(server_fd_, config_.max_connections) < 0) {
+bool HttpServer::listen_socket(int fd, const ListenerConfig& listener) {
+    if(listen(fd, listener.backlog) < 0) {
         log("ERROR", "Listen failed: " + std::string(strerror(errno)));
         return false;
     }
     return true;
 }
 
-bool HttpServer::setup_epoll() {
-    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
-    if(epoll_fd_ < 0) {
+bool HttpServer::parse_listen_address(const ListenerConfig& listener, sockaddr_storage& addr,
+                                      socklen_t& addr_len) {
+    memset(&addr, 0, sizeof(addr));
+    const std::string& address = listener.address;
+    if(address.compare(0, 5, "unix:") == 0) {
+        auto& un = reinterpret_cast<sockaddr_un&>(addr);
+        std::string path = address.substr(5);
+        if(path.empty() || path.size() >= sizeof(un.sun_path)) {
+            return false;
+        }
+        un.sun_family = AF_UNIX;
+        memcpy(un.sun_path, path.c_str(), path.size() + 1);
+        addr_len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + 1);
+        return true;
+    }
+    if(address.empty() || address == "0.0.0.0" || address == "*") {
+        auto& in = reinterpret_cast<sockaddr_in&>(addr);
+        in.sin_family = AF_INET;
+        in.sin_port = htons(listener.port);
+        in.sin_addr.s_addr = INADDR_ANY;
+        addr_len = sizeof(in);
+        return true;
+    }
+    auto& in = reinterpret_cast<sockaddr_in&>(addr);
+    if(inet_pton(AF_INET, address.c_str(), &in.sin_addr) == 1) {
+        in.sin_family = AF_INET;
+        in.sin_port = htons(listener.port);
+        addr_len = sizeof(in);
+        return true;
+    }
+    // IPv6地址可带方括号，如 [::1]
+    std::string host = address;
+    if(host.size() > 2 && host.front() == '[' && host.back() == ']') {
+        host = host.substr(1, host.size() - 2);
+    }
+    auto& in6 = reinterpret_cast<sockaddr_in6&>(addr);
+    if(inet_pton(AF_INET6, host.c_str(), &in6.sin6_addr) == 1) {
+        in6.sin6_family = AF_INET6;
+        in6.sin6_port = htons(listener.port);
+        addr_len = sizeof(in6);
+        return true;
+    }
+    return false;
+}
+
+std::string HttpServer::listener_name(const ListenerConfig& listener) {
+    if(listener.address.compare(0, 5, "unix:") == 0) {
+        return listener.address;
+    }
+    if(listener.address.find(':') != std::string::npos && listener.address.front() != '[') {
+        return "[" + listener.address + "]:" + std::to_string(listener.port);
+    }
+    return listener.address + ":" + std::to_string(listener.port);
+}
+
+std::string HttpServer::peer_address(const sockaddr_storage& addr) {
+    char ip[INET6_ADDRSTRLEN] = "";
+    if(addr.ss_family == AF_INET) {
+        inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in&>(addr).sin_addr, ip, sizeof(ip));
+    }
+    else if(addr.ss_family == AF_INET6) {
+        const in6_addr& in6 = reinterpret_cast<const sockaddr_in6&>(addr).sin6_addr;
+        // 双栈监听收到的IPv4连接还原为点分形式，与IPv4监听得到的地址一致
+        if(IN6_IS_ADDR_V4MAPPED(&in6)) {
+            inet_ntop(AF_INET, &in6.s6_addr[12], ip, sizeof(ip));
+        }
+        else {
+            inet_ntop(AF_INET6, &in6, ip, sizeof(ip));
+        }
+    }
+    else if(addr.ss_family == AF_UNIX) {
+        // 同机反向代理，真实客户端地址由代理通过请求头传递
+        return "unix";
+    }
+    return ip;
+}
+
+bool HttpServer::setup_epoll(Reactor& reactor) {
+    reactor.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if(reactor.epoll_fd < 0) {
         log("ERROR", "Epoll create failed: " + std::string(strerror(errno)));
         return false;
     }
-    struct epoll_event ev;
-    ev.events = EPOLLIN | EPOLLET;
-    ev.data.fd = server_fd_;
-    if(epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, server_fd_, &ev) < 0) {
-        log("ERROR", "Epoll ctl failed: " + std::string(strerror(errno)));
-        return false;
+    for(int listen_fd : reactor.listen_fds) {
+        // 多个Reactor共享的Unix域套接字每次只唤醒其中一个
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLET | EPOLLEXCLUSIVE;
+        ev.data.u64 = static_cast<uint64_t>(listen_fd);  // 代数为0，不会与连接句柄相同
+        if(epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev) < 0) {
+            log("ERROR", "Epoll ctl failed: " + std::string(strerror(errno)));
+            return false;
+        }
     }
     return true;
 }
 
-void HttpServer::main_loop() {
+void HttpServer::main_loop(Reactor& reactor) {
     const int MAX_EVENTS = 1000;
     struct epoll_event events[MAX_EVENTS];
 
     while(running_.load()) {
-        int nfds = epoll_wait(epoll_fd_, events, MAX_EVENTS, 1000);
+        // 以定时器精度为等待上限，保证超时及时处理
+        int nfds = epoll_wait(reactor.epoll_fd, events, MAX_EVENTS, TIMER_TICK_MS);
         if(nfds < 0) {
             if (errno == EINTR) {
                 continue;
@@ -267,48 +481,51 @@ void HttpServer::main_loop() {
             break;
         }
         for(int i = 0; i < nfds; ++i) {
-            int fd = events[i].data.fd;
-            if(fd == server_fd_) {
-                accept_connection();
+            uint64_t handle = events[i].data.u64;
+            if(ConnectionTable<Connection>::is_raw_fd(handle)) {
+                accept_connection(reactor, static_cast<int>(handle));
+                continue;
+            }
+            // 同一批事件中fd可能已被关闭并由新连接复用，代数不符的旧事件直接丢弃
+            const std::shared_ptr<Connection>& conn = reactor.connections.find(handle);
+            if(!conn) {
+                continue;
+            }
+            // EPOLLONESHOT：事件触发后fd已失效，直到持有者重新布防
+            conn->armed_events.store(0);
+            if(events[i].events & (EPOLLERR | EPOLLHUP)) {
+                close_connection(*conn);
             }
             else {
-                if(events[i].events & (EPOLLERR | EPOLLHUP)) {
-                    close_connection(fd);
-                }
-                else if(events[i].events & EPOLLIN) {
-                    handle_client_data(fd);
-                }
+                dispatch_events(conn, events[i].events & (EPOLLIN | EPOLLOUT));
             }
         }
-    }
-}
-
-void HttpServer::cleanup_loop() {
-    while(running_.load()) {
-        std::this_thread::sleep_for(std::chrono::seconds(30));
-        auto now = std::chrono::steady_clock::now();
-        std::vector<int> to_close;
-        {
-            std::lock_guard<std::mutex> lock(connections_mutex_);
-            for(auto& [fd, conn] : connections_) {
-                auto idle_time = std::chrono::duration_cast<std::chrono::seconds>(now - conn.last_activity).count();
-                if(idle_time > config_.timeout_seconds) {
-                    to_close.push_back(fd);
-                }
-            }
+        release_connections(reactor);
+        process_timers(reactor);
+        resume_accept(reactor);
+        if(reactor.index == 0) {
+            send_event_heartbeats();
         }
-        for(int fd : to_close) {
-            close_connection(fd);
+        if(draining_.load() && !reactor.draining) {
+            begin_drain(reactor);
         }
     }
 }
 
-void HttpServer::accept_connection() {
-    while(true) {
-        struct sockaddr_in client_addr;
+void HttpServer::accept_connection(Reactor& reactor, int listen_fd) {
+    while(!reactor.accept_paused) {
+        struct sockaddr_storage client_addr;
         socklen_t client_len = sizeof(client_addr);
 
-        int client_fd = accept(server_fd_, (struct sockaddr*)&client_addr, &client_len);
+        // 暂停策略下名额已满时不再accept，新连接留在backlog中
+        if(config_.overload_policy == OverloadPolicy::PAUSE_ACCEPT &&
+           stats_.active_connections.load() >= static_cast<uint64_t>(std::max(config_.max_connections, 1))) {
+            pause_accept(reactor);
+            break;
+        }
+        // 直接得到非阻塞套接字，省去两次fcntl
+        int client_fd = accept4(listen_fd, (struct sockaddr*)&client_addr, &client_len,
+                                SOCK_NONBLOCK | SOCK_CLOEXEC);
         if(client_fd < 0) {
             if(errno == EAGAIN || errno == EWOULDBLOCK) {
                 break;
@@ -316,147 +533,732 @@ void HttpServer::accept_connection() {
             log("ERROR", "Accept failed: " + std::string(strerror(errno)));
             break;
         }
-
-        int flags = fcntl(client_fd, F_GETFL, 0);
-        if(flags < 0 || fcntl(client_fd, F_SETFL, flags | O_NONBLOCK) < 0) {
-            log("ERROR", "Failed to set client socket non-blocking");
-            close(client_fd);
+        if(!admit_connection(reactor)) {
+            reject_connection(client_fd);
             continue;
         }
-        char client_ip[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, INET_ADDRSTRLEN);
+        std::string client_ip = peer_address(client_addr);
 
+        // 先登记连接再加入epoll，避免事件先于连接记录到达
+        auto conn = create_connection(reactor, client_fd, client_ip.c_str());
+        // 只关注可读事件；输出积压时由持有者或写出方重新布防可写事件
         struct epoll_event ev;
-        ev.events = EPOLLIN | EPOLLET;
-        ev.data.fd = client_fd;
-        if(epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_fd, &ev) < 0) {
+        ev.events = EPOLLIN | EPOLLET | EPOLLONESHOT;
+        ev.data.u64 = conn->handle;
+        conn->armed_events.store(EPOLLIN);
+        if(epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, client_fd, &ev) < 0) {
             log("ERROR", "Failed to add client to epoll");
+            reactor.connections.remove(conn->handle);
             close(client_fd);
+            stats_.active_connections.fetch_sub(1);
             continue;
         }
-        {
-            std::lock_guard<std::mutex> lock(connections_mutex_);
-            connections_[client_fd] = Connection{
-                client_fd,
-                std::string(client_ip),
-                std::chrono::steady_clock::now(),
-                config_.enable_keep_alive,
-                "",
-                0
-            };
-        }
-        stats_.active_connections.fetch_add(1);
+        schedule_timer(reactor, *conn);
         on_connection_accepted(client_fd, client_ip);
     }
 }
 
-void HttpServer::handle_client_data(int client_fd) {
-    thread_pool_->enqueue([this, client_fd]() {
-        std::string client_ip;
+bool HttpServer::admit_connection(Reactor& reactor) {
+    // 已接受的连接以比较交换占用名额，多个Reactor同时accept时连接总数也不会超过上限；
+    // 其他Reactor抢先占满名额时，暂停策略同样暂停本Reactor
+    auto reserve = [this]() {
+        uint64_t limit = static_cast<uint64_t>(std::max(config_.max_connections, 1));
+        uint64_t active = stats_.active_connections.load();
+        while(active < limit) {
+            if(stats_.active_connections.compare_exchange_weak(active, active + 1)) {
+                return true;
+            }
+        }
+        return false;
+    };
+    if(reserve()) {
+        return true;
+    }
+    if(config_.overload_policy == OverloadPolicy::DROP_IDLE) {
+        return drop_idle_connection(reactor) && reserve();
+    }
+    if(config_.overload_policy == OverloadPolicy::PAUSE_ACCEPT && !reactor.accept_paused) {
+        pause_accept(reactor);
+    }
+    return false;
+}
+
+bool HttpServer::drop_idle_connection(Reactor& reactor) {
+    // 只在连接数达到上限时扫描本Reactor的连接，选出空闲最久的keep-alive连接
+    std::shared_ptr<Connection> oldest;
+    int64_t oldest_idle_ms = 0;
+    reactor.connections.for_each([&](const std::shared_ptr<Connection>& conn) {
+        if(connection_idle(*conn) && (!oldest || conn->idle_since_ms < oldest_idle_ms)) {
+            oldest = conn;
+            oldest_idle_ms = conn->idle_since_ms;
+        }
+    });
+    if(!oldest) {
+        return false;
+    }
+    stats_.total_shed_idle_dropped.fetch_add(1);
+    close_connection(*oldest);
+    return true;
+}
+
+bool HttpServer::connection_idle(Connection& conn) {
+    // 两个请求之间的keep-alive连接：没有处理中的请求，也没有待写出的数据
+    if(conn.closed.load() || conn.owned.load() || conn.read_phase.load() != ReadPhase::IDLE) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(conn.output_mutex);
+    return conn.in_flight == 0 && conn.output_queue.empty();
+}
+
+void HttpServer::reject_connection(int client_fd) {
+    stats_.total_shed_rejected.fetch_add(1);
+    // 尽力写出预先生成的503，发送缓冲区满也不等待
+    ssize_t ignored = send(client_fd, overload_response_.data(), overload_response_.size(),
+                           MSG_NOSIGNAL | MSG_DONTWAIT);
+    (void)ignored;
+    close(client_fd);
+}
+
+void HttpServer::shed_request(Connection& conn) {
+    // 调用方持有连接所有权；已有响应在排队时不能插入503，只能直接关闭
+    stats_.total_shed_requests.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(conn.output_mutex);
+        if(!conn.closed.load() && conn.in_flight == 0 && conn.completed.empty() && conn.output_queue.empty()) {
+            ssize_t ignored = send(conn.fd, overload_response_.data(), overload_response_.size(),
+                                   MSG_NOSIGNAL | MSG_DONTWAIT);
+            (void)ignored;
+        }
+    }
+    close_connection(conn);
+}
+
+void HttpServer::pause_accept(Reactor& reactor) {
+    reactor.accept_paused = true;
+    stats_.total_accept_pauses.fetch_add(1);
+    for(int listen_fd : reactor.listen_fds) {
+        if(reactor.ring) {
+            submit_ring_op(reactor, nullptr, RingOp::CANCEL, listen_fd);
+        }
+        else {
+            epoll_ctl(reactor.epoll_fd, EPOLL_CTL_DEL, listen_fd, nullptr);
+        }
+    }
+}
+
+void HttpServer::resume_accept(Reactor& reactor) {
+    // 回落到上限的90%以下才恢复，避免在上限附近反复暂停
+    uint64_t limit = static_cast<uint64_t>(std::max(config_.max_connections, 1));
+    if(!reactor.accept_paused || reactor.draining || stats_.active_connections.load() >= limit - limit / 10) {
+        return;
+    }
+    reactor.accept_paused = false;
+    if(reactor.ring) {
+        // 先登记暂停期间已被接受的连接；名额再次用尽时重新暂停，剩余的继续等待
+        size_t registered = 0;
+        for(; registered < reactor.deferred_fds.size() && admit_connection(reactor); ++registered) {
+            register_ring_connection(reactor, reactor.deferred_fds[registered]);
+        }
+        reactor.deferred_fds.erase(reactor.deferred_fds.begin(), reactor.deferred_fds.begin() + registered);
+        if(reactor.accept_paused) {
+            return;
+        }
+    }
+    for(size_t i = 0; i < reactor.listen_fds.size(); ++i) {
+        int listen_fd = reactor.listen_fds[i];
+        if(reactor.ring) {
+            // 取消尚未完成的在收到最终完成事件时自行重新提交
+            if(!reactor.accepting[i]) {
+                submit_ring_op(reactor, nullptr, RingOp::ACCEPT, listen_fd);
+            }
+            continue;
+        }
+        // 重新加入时若backlog中已有连接会立即触发
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLET | EPOLLEXCLUSIVE;
+        ev.data.u64 = static_cast<uint64_t>(listen_fd);
+        if(epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev) < 0) {
+            log("ERROR", "Failed to resume accept: " + std::string(strerror(errno)));
+        }
+    }
+}
+
+std::shared_ptr<HttpServer::Connection> HttpServer::create_connection(Reactor& reactor, int client_fd,
+                                                                     const char* client_ip) {
+    auto conn = std::make_shared<Connection>();
+    conn->parser.set_limits({config_.max_header_size, config_.max_request_size});
+    conn->parser.set_pause_after_headers(has_streaming_routes_);
+    conn->fd = client_fd;
+    conn->ip = client_ip;
+    conn->reactor = &reactor;
+    conn->keep_alive = config_.enable_keep_alive;
+
+    // 首个请求适用请求头超时
+    int64_t now = now_ms();
+    conn->request_start_ms.store(now);
+    conn->last_read_ms.store(now);
+    conn->deadline_ms.store(now + config_.header_timeout_seconds * 1000);
+    conn->handle = reactor.connections.insert(client_fd, conn);
+    return conn;
+}
+
+HttpServer::Reactor::~Reactor() {
+    close_fds();
+}
+
+void HttpServer::dispatch_events(const std::shared_ptr<Connection>& conn, uint32_t events) {
+    // 先登记事件再争夺所有权，与process_events的先释放后检查配对，事件不会丢失
+    conn->missed_events.fetch_or(events);
+    if(conn->owned.exchange(true)) {
+        stats_.total_coalesced_events.fetch_add(1);
+        return;
+    }
+    conn->owned_since_us.store(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    stats_.total_dispatches.fetch_add(1);
+    // 请求队列只限制读事件，写事件总要处理以便已生成的响应能够写完
+    size_t max_queued = (events & EPOLLIN) ? config_.max_queued_requests : 0;
+    if(!thread_pool_->try_enqueue([this, conn]() {
+        process_events(conn, conn->missed_events.exchange(0));
+    }, max_queued)) {
+        shed_request(*conn);
+    }
+}
+
+void HttpServer::process_events(const std::shared_ptr<Connection>& conn, uint32_t events) {
+    while(true) {
+        if(events & EPOLLOUT) {
+            OutputAction action = OutputAction::NONE;
+            {
+                std::lock_guard<std::mutex> lock(conn->output_mutex);
+                if(!conn->closed.load()) {
+                    action = flush_output(*conn);
+                }
+            }
+            apply_output_action(*conn, action);
+        }
+        if(events & EPOLLIN) {
+            handle_connection(conn);
+        }
+
         {
-            std::lock_guard<std::mutex> lock(connections_mutex_);
-            auto it = connections_.find(client_fd);
-            if (it == connections_.end()) {
+            std::lock_guard<std::mutex> lock(conn->output_mutex);
+            conn->owned.store(false);
+            if(conn->closed.load()) {
+                return;
+            }
+            if(conn->missed_events.load() == 0) {
+                arm_events(*conn);
+                int64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+                stats_.total_rearms.fetch_add(1);
+                stats_.total_rearm_latency_us.fetch_add(now_us - conn->owned_since_us.load());
                 return;
             }
-            client_ip = it->second.ip;
-            it->second.last_activity = std::chrono::steady_clock::now();
         }
-        
-        handle_request(client_fd, client_ip);
-    });
+        // 持有期间又有事件到达：若未被其他线程取得所有权，继续处理
+        if(conn->owned.exchange(true)) {
+            return;
+        }
+        events = conn->missed_events.exchange(0);
+    }
 }
 
-void HttpServer::close_connection(int client_fd) {
+void HttpServer::arm_events(Connection& conn) {
+    // 调用方持有output_mutex且连接当前无持有者；按连接状态决定关注的事件
+    if(conn.reactor->ring) {
+        return;  // io_uring后端的接收始终在途，发送由完成事件驱动
+    }
+    uint32_t events = 0;
+    if(!conn.read_paused && !conn.peer_closed && !conn.input_closed.load()) {
+        events |= EPOLLIN;
+    }
+    if(!conn.output_queue.empty()) {
+        events |= EPOLLOUT;
+    }
+    // 暂停读取且无待发送数据时保持失效，由恢复读取或写出响应的线程重新布防
+    if(events == 0 || events == conn.armed_events.load()) {
+        return;
+    }
+    // 先记录再布防：布防后立即触发的事件由Reactor清零，不会被这里的记录覆盖
+    conn.armed_events.store(events);
+    struct epoll_event ev;
+    ev.events = events | EPOLLET | EPOLLONESHOT;
+    ev.data.u64 = conn.handle;
+    if(epoll_ctl(conn.reactor->epoll_fd, EPOLL_CTL_MOD, conn.fd, &ev) < 0) {
+        conn.armed_events.store(0);
+    }
+}
+
+void HttpServer::close_connection(Connection& conn) {
+    if(conn.closed.exchange(true)) {
+        return;  // 已被其他线程关闭
+    }
+    Reactor& reactor = *conn.reactor;
     {
-        std::lock_guard<std::mutex> lock(connections_mutex_);
-        auto it = connections_.find(client_fd);
-        if (it != connections_.end()) {
-            connections_.erase(it);
+        // 等待正在写响应的线程结束，避免其写入被复用的fd
+        std::lock_guard<std::mutex> lock(conn.output_mutex);
+        if(reactor.ring) {
+            // 在途的io_uring请求持有文件引用，close不会终止它们；先shutdown使其尽快完成
+            shutdown(conn.fd, SHUT_RDWR);
         }
+        else {
+            epoll_ctl(reactor.epoll_fd, EPOLL_CTL_DEL, conn.fd, nullptr);
+        }
+        close(conn.fd);
+        conn.output_cv.notify_all();
+    }
+    {
+        // 连接表只由Reactor线程修改；此后fd即使被复用，旧句柄的代数也已失效
+        std::lock_guard<std::mutex> lock(reactor.released_mutex);
+        reactor.released.push_back(conn.handle);
     }
-    
-    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, client_fd, nullptr);
-    close(client_fd);
     stats_.active_connections.fetch_sub(1);
-    on_connection_closed(client_fd);
+    if(conn.upgraded.load() && conn.websocket) {
+        notify_websocket_closed(conn);
+    }
+    on_connection_closed(conn.fd);
 }
 
-void HttpServer::handle_request(int client_fd, const std::string& client_ip) {
-    try {
+void HttpServer::release_connections(Reactor& reactor) {
+    std::vector<uint64_t> released;
+    {
+        std::lock_guard<std::mutex> lock(reactor.released_mutex);
+        released.swap(reactor.released);
+    }
+    for(uint64_t handle : released) {
+        reactor.connections.remove(handle);
+    }
+}
+
+void HttpServer::handle_connection(const std::shared_ptr<Connection>& conn_ptr) {
+    Connection& conn = *conn_ptr;
+    if(conn.upgraded.load()) {
+        if(conn.http2) {
+            handle_http2(conn_ptr);
+        }
+        else {
+            handle_websocket(conn);
+        }
+        return;
+    }
+    std::vector<std::pair<uint64_t, HttpRequest>> batch;
+    bool peer_open = true;
+    {
+        std::lock_guard<std::mutex> lock(conn.io_mutex);
+        if(conn.closed.load() || conn.input_closed) {
+            return;
+        }
+
+        // 边缘触发：一次性读空内核缓冲区，再解析缓冲区中所有完整请求
+        const size_t limit = config_.max_header_size + config_.max_request_size;
+        bool buffer_full = false;
+        do {
+            if(!input_allowed(conn)) {
+                break;
+            }
+            peer_open = fill_read_buffer(conn);
+            // 缓冲区读满时内核中可能仍有数据，解析完已有请求后需要继续读取
+            buffer_full = peer_open && conn.buffer.size() >= limit;
+            if(!collect_requests(conn, batch)) {
+                break;
+            }
+        } while(buffer_full && !conn.closed.load());
+
+        // 缓冲区中剩余的是下一个请求的开头
+        if(conn.buffer.empty()) {
+            conn.read_phase.store(ReadPhase::IDLE);
+        }
+        else if(conn.parser.reading_body()) {
+            conn.read_phase.store(ReadPhase::BODY);
+        }
+        else if(conn.read_phase.exchange(ReadPhase::HEADER) != ReadPhase::HEADER) {
+            conn.request_start_ms.store(now_ms());
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(conn.output_mutex);
+        update_deadline(conn);
+    }
+
+    if(!peer_open) {
+        bool idle = false;
+        {
+            std::lock_guard<std::mutex> lock(conn.output_mutex);
+            conn.peer_closed = true;
+            idle = conn.in_flight == 0 && conn.output_queue.empty();
+        }
+        if(idle) {
+            close_connection(conn);
+            return;
+        }
+    }
+
+    // 最后一个请求在当前工作线程内执行，其余交给线程池并发处理
+    for(size_t i = 0; i + 1 < batch.size(); ++i) {
+        thread_pool_->enqueue([this, conn_ptr, sequence = batch[i].first,
+                               request = std::move(batch[i].second)]() mutable {
+            handle_request(*conn_ptr, request, sequence);
+        });
+    }
+    if(!batch.empty()) {
+        handle_request(conn, batch.back().second, batch.back().first);
+    }
+}
+
+bool HttpServer::collect_requests(Connection& conn, std::vector<std::pair<uint64_t, HttpRequest>>& batch) {
+    while(!conn.input_closed && !conn.closed.load()) {
+        if(!input_allowed(conn)) {
+            return false;
+        }
+        // 连接以HTTP/2前言开头（先验知识）：前言未收全时等待，收全后切换协议
+        if(conn.next_sequence == 0 && config_.enable_http2 && !conn.buffer.empty()) {
+            size_t n = std::min(conn.buffer.size(), http2::PREFACE_SIZE);
+            if(conn.buffer.compare(0, n, http2::CONNECTION_PREFACE, n) == 0) {
+                if(n < http2::PREFACE_SIZE) {
+                    return true;
+                }
+                uint64_t sequence = conn.next_sequence++;
+                {
+                    std::lock_guard<std::mutex> lock(conn.output_mutex);
+                    ++conn.in_flight;
+                }
+                start_http2(conn, sequence, nullptr);
+                conn.missed_events.fetch_or(EPOLLIN);
+                return false;
+            }
+        }
+
         HttpRequest request;
-        request.set_client_ip(client_ip);
+        request.set_client_ip(conn.ip);
+        ParseResult result = parse_request(conn, request);
+        if(result == ParseResult::INCOMPLETE) {
+            return true;
+        }
+
+        uint64_t sequence = conn.next_sequence++;
+        {
+            std::lock_guard<std::mutex> lock(conn.output_mutex);
+            if(conn.in_flight > 0) {
+                stats_.total_pipelined_requests.fetch_add(1);
+            }
+            ++conn.in_flight;
+        }
+        if(result == ParseResult::ERROR) {
+            // 错误响应排在此前所有请求的响应之后
+            conn.input_closed = true;
+            send_error_response(conn, sequence, conn.parser.error_status());
+            return false;
+        }
+        if(!wants_keep_alive(request)) {
+            conn.input_closed = true;
+        }
+        conn.read_phase.store(ReadPhase::IDLE);
+        bool streaming = request.body_streaming();
+        bool upgrade = request.has_header("Upgrade");
+        if(upgrade && config_.enable_http2 && !conn.input_closed && start_http2(conn, sequence, &request)) {
+            // 升级请求作为1号流交给线程池，其后的字节是HTTP/2帧
+            conn.missed_events.fetch_or(EPOLLIN);
+            return false;
+        }
+        batch.emplace_back(sequence, std::move(request));
+        if(streaming) {
+            // 其后的字节属于请求体，由处理器读取；读完后再继续解析后续请求
+            return false;
+        }
+        if(upgrade) {
+            // 升级请求在当前线程最后处理，其后的字节可能已属于新协议；处理完后回到事件循环再读
+            conn.missed_events.fetch_or(EPOLLIN);
+            return false;
+        }
+    }
+    return false;
+}
+
+int64_t HttpServer::now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void HttpServer::update_deadline(Connection& conn) {
+    // 调用方持有output_mutex；按连接当前状态选择适用的超时
+    int64_t deadline = 0;
+    if(!conn.output_queue.empty()) {
+        deadline = conn.last_write_ms + config_.write_timeout_seconds * 1000;
+    }
+    else if(conn.in_flight == 0) {
+        switch(conn.read_phase.load()) {
+            case ReadPhase::IDLE:
+                deadline = conn.idle_since_ms + config_.keep_alive_timeout * 1000;
+                break;
+            case ReadPhase::HEADER:
+                deadline = conn.request_start_ms.load() + config_.header_timeout_seconds * 1000;
+                break;
+            case ReadPhase::BODY:
+                deadline = conn.last_read_ms.load() + config_.body_timeout_seconds * 1000;
+                break;
+        }
+    }
+    // 请求处理中不设超时
+    conn.deadline_ms.store(deadline);
+
+    // 截止时间推迟时由到期的定时器自行重新调度；只有提前或没有有效定时器时才通知Reactor。
+    // 先写deadline_ms再读scheduled_tick，与process_timers的先清除后读取配对，不会丢失更新
+    uint64_t scheduled = conn.scheduled_tick.load();
+    if(deadline != 0 && (scheduled == 0 ||
+       static_cast<uint64_t>((deadline + TIMER_TICK_MS - 1) / TIMER_TICK_MS) < scheduled)) {
+        Reactor& reactor = *conn.reactor;
+        std::lock_guard<std::mutex> lock(reactor.timer_mutex);
+        reactor.timer_requests.push_back(conn.weak_from_this());
+    }
+}
+
+void HttpServer::schedule_timer(Reactor& reactor, Connection& conn) {
+    int64_t deadline = conn.deadline_ms.load();
+    if(deadline == 0) {
+        return;
+    }
+    uint64_t tick = (deadline + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+    uint64_t scheduled = conn.scheduled_tick.load();
+    if(scheduled != 0 && scheduled <= tick) {
+        return;  // 已有不晚于此的定时器，到期时按最新截止时间处理
+    }
+    conn.scheduled_tick.store(tick);
+    reactor.timers.schedule(tick, conn.weak_from_this());
+}
+
+void HttpServer::process_timers(Reactor& reactor) {
+    std::vector<std::weak_ptr<Connection>> requests;
+    {
+        std::lock_guard<std::mutex> lock(reactor.timer_mutex);
+        requests.swap(reactor.timer_requests);
+    }
+    for(auto& weak : requests) {
+        if(auto conn = weak.lock()) {
+            schedule_timer(reactor, *conn);
+        }
+    }
 
-        if(!parse_request(client_fd, request)) {
-            send_error_response(client_fd, HttpStatus::BAD_REQUEST);
-            close_connection(client_fd);
+    int64_t now = now_ms();
+    std::vector<std::shared_ptr<Connection>> expired;
+    reactor.timers.advance(now / TIMER_TICK_MS, [&](std::weak_ptr<Connection>& weak, uint64_t tick) {
+        auto conn = weak.lock();
+        if(!conn || conn->closed.load() || conn->scheduled_tick.load() != tick) {
+            return;  // 连接已关闭或该定时器已被更早的取代
+        }
+        conn->scheduled_tick.store(0);
+        int64_t deadline = conn->deadline_ms.load();
+        if(deadline == 0) {
+            return;
+        }
+        if(deadline > now) {
+            schedule_timer(reactor, *conn);  // 截止时间已被推迟
             return;
         }
+        expired.push_back(conn);
+    });
+
+    for(auto& conn : expired) {
+        stats_.total_timeouts.fetch_add(1);
+        close_connection(*conn);
+    }
+}
+
+bool HttpServer::input_allowed(Connection& conn) {
+    // 管线深度或输出积压达到上限时停止读取和解析，剩余字节留在缓冲区或内核中，
+    // 由写出响应的线程在条件解除后恢复
+    // WebSocket连接的101响应始终未结束，不计入管线深度
+    std::lock_guard<std::mutex> lock(conn.output_mutex);
+    if((conn.in_flight >= config_.max_pipeline_depth && !conn.upgraded.load()) ||
+       conn.output_bytes > config_.output_high_water_mark) {
+        conn.read_paused = true;
+        return false;
+    }
+    return true;
+}
+
+bool HttpServer::wants_keep_alive(const HttpRequest& request) const {
+    // 排空期间每个响应后关闭连接，客户端重连到新进程
+    if(!config_.enable_keep_alive || draining_.load()) {
+        return false;
+    }
+    std::string connection = request.get_header("Connection");
+    if(request.version() == "HTTP/1.0") {
+        return strcasecmp(connection.c_str(), "keep-alive") == 0;
+    }
+    return strcasecmp(connection.c_str(), "close") != 0;
+}
+
+ContentCoding HttpServer::choose_encoding(const HttpRequest& request, HttpResponse& response, bool streaming) {
+    // 206的区间针对原始表示，204/304没有响应体；已编码的、文件（sendfile发送）和过短的响应体跳过
+    int status = response.status_code();
+    if(!config_.enable_compression || response.compression_disabled() || status < 200 ||
+       status == 204 || status == 206 || status == 304 || response.has_header("Content-Encoding") ||
+       !compression::compressible_type(response.get_header("Content-Type"))) {
+        return ContentCoding::IDENTITY;
+    }
+    if(!streaming && (response.has_file_body() || response.body_size() < config_.compression_min_size)) {
+        return ContentCoding::IDENTITY;
+    }
+    // 同一URL的响应随Accept-Encoding变化，缓存需要按它区分
+    std::string vary = response.get_header("Vary");
+    if(vary.empty()) {
+        response.set_header("Vary", "Accept-Encoding");
+    }
+    else if(vary != "*" && strcasestr(vary.c_str(), "Accept-Encoding") == nullptr) {
+        response.set_header("Vary", vary + ", Accept-Encoding");
+    }
+    return compression::negotiate(request.get_header("Accept-Encoding"));
+}
+
+void HttpServer::set_encoding(HttpResponse& response, ContentCoding coding) {
+    response.set_header("Content-Encoding", compression::coding_name(coding));
+    // 编码后的表示与原表示字节不同，强校验器降为弱校验器
+    std::string etag = response.get_header("ETag");
+    if(!etag.empty() && etag[0] == '"') {
+        response.set_header("ETag", "W/" + etag);
+    }
+    stats_.total_compressed_responses.fetch_add(1);
+}
+
+void HttpServer::compress_response(const HttpRequest& request, HttpResponse& response) {
+    // HEAD同样协商并压缩，Content-Length、Content-Encoding、Vary与ETag才与GET一致；只是不写出响应体
+    if(response.is_streaming()) {
+        return;
+    }
+    ContentCoding coding = choose_encoding(request, response, false);
+    std::string compressed;
+    // 压缩无收益（如已是随机数据）时按原样发送
+    if(coding == ContentCoding::IDENTITY ||
+       !compression::compress(coding, config_.compression_level, response.body(), compressed)) {
+        return;
+    }
+    stats_.total_compression_saved_bytes.fetch_add(response.body_size() - compressed.size());
+    response.set_body(std::move(compressed));
+    set_encoding(response, coding);
+}
+
+void HttpServer::handle_request(Connection& conn, HttpRequest& request, uint64_t sequence) {
+    bool responded = false;
+    ConnectionResponseStream stream(*this, conn, request, sequence);
+    try {
         stats_.total_requests.fetch_add(1);
 
         HttpResponse response;
         response.set_header("Server", config_.server_name);
         response.set_header("Date", get_current_time_string());
+        response.set_stream(&stream);
 
-        // 执行全局中间件
-        bool continue_processing = true;
-        for(auto& middleware : global_middlewares_) {
-            if(!middleware(request, response)) {
-                continue_processing = false;
-                break;
-            }
+        route_request(request, response);
+        // 设置 Keep-Alive 头；流式请求体未能读完时连接无法复用
+        bool keep_alive = wants_keep_alive(request);
+        if(request.body_streaming() && !finish_body_stream(conn, request)) {
+            keep_alive = false;
         }
-        if(continue_processing) {
-            Route* matched_route = nullptr;
-            std::smatch matches;
-            if(match_route(request, matched_route, matches)) {
-                for(size_t i = 1; i < matches.size(); ++i) {
-                    if(i - 1 < matched_route->param_names.size()) {
-                        request.set_path_param(matched_route->param_names[i-1], matches[i].str());
-                    }
-                }
-                // 执行路由中间件
-                execute_middlewares(matched_route->middlewares, request, response);
-                matched_route->handler(request, response);
+        if(stream.started() || stream.detached()) {
+            // 头部与已生成的分块已经写出，补上结束块即可；脱离的响应由订阅频道或WebSocket结束
+            responded = true;
+            if(stream.started()) {
+                response.end_streaming();
             }
-            else {
-                handle_static_file(request, response);
-                if(response.status() == HttpStatus::OK) {
-                    ;
-                }
-                else {
-                    auto it = error_handlers_.find(404);
-                    if(it != error_handlers_.end()) {
-                        it->second(request, response, 404);
-                    }
-                    else {
-                        default_error_handler_(request, response, 404);
-                    }
-                }
+            stats_.total_responses.fetch_add(1);
+            if (config_.enable_logging) {
+                log_request(request, response);
             }
+            return;
         }
-        // 设置 Keep-Alive 头
-        if(config_.enable_keep_alive && request.get_header("Connection") != "close") {
+        compress_response(request, response);
+        if(keep_alive) {
             response.set_header("Connection", "keep-alive");
             response.set_header("Keep-Alive", "timeout=" + std::to_string(config_.keep_alive_timeout));
         }
         else {
             response.set_header("Connection", "close");
         }
-        send_response(client_fd, response);
+        responded = true;
+        send_response(conn, sequence, response, !keep_alive);
         stats_.total_responses.fetch_add(1);
         if (config_.enable_logging) {
             log_request(request, response);
         }
-        if (!config_.enable_keep_alive || request.get_header("Connection") == "close" ||
-            response.get_header("Connection") == "close") {
-            close_connection(client_fd);
-        }
     }
     catch(const std::exception& e) {
         log("ERROR", "Exception in handle_request: " + std::string(e.what()));
-        send_error_response(client_fd, HttpStatus::INTERNAL_SERVER_ERROR);
-        close_connection(client_fd);
+        if(request.body_streaming() && !request.body_complete()) {
+            conn.input_closed = true;
+        }
+        if(stream.started() || stream.detached()) {
+            // 头部已发出，无法再回复错误；关闭连接，客户端据此得知响应不完整
+            close_connection(conn);
+        }
+        else if(!responded) {
+            send_error_response(conn, sequence, HttpStatus::INTERNAL_SERVER_ERROR);
+        }
+    }
+}
+
+void HttpServer::route_request(HttpRequest& request, HttpResponse& response) {
+    // 中间件、路由与静态文件，HTTP/1.1与HTTP/2的请求共用
+    // 先查路由表（中间件不能修改请求），路径已注册时不再尝试静态文件
+    HttpMethod method;
+    if(!parse_method(request.method(), method)) {
+        handle_error(request, response, 501);  // 解析器接受任意方法名
+        return;
+    }
+    RouteParams params;
+    Router::Match match = router_.lookup(method, request.path(), params);
+    if(method == HttpMethod::HEAD) {
+        response.omit_body();
+    }
+    if(method == HttpMethod::OPTIONS && match.allow && !match.route) {
+        response.set_header("Allow", *match.allow);  // CORS预检由中间件应答时同样带上
+    }
+    // 执行全局中间件
+    bool continue_processing = true;
+    for(auto& middleware : global_middlewares_) {
+        if(!middleware(request, response)) {
+            continue_processing = false;
+            break;
+        }
+    }
+    if(continue_processing) {
+        if(match.route) {
+            request.set_path_params(params);
+            // 执行路由中间件
+            execute_middlewares(match.route->middlewares, request, response);
+            match.route->handler(request, response);
+        }
+        else if(match.allow && method == HttpMethod::OPTIONS) {
+            response.set_status(HttpStatus::NO_CONTENT);
+            response.remove_header("Content-Type");
+        }
+        else if(match.allow) {
+            response.set_header("Allow", *match.allow);
+            handle_error(request, response, 405);
+        }
+        else {
+            handle_static_file(request, response);
+            HttpStatus status = response.status();
+            if(status != HttpStatus::OK && status != HttpStatus::NOT_MODIFIED &&
+               status != HttpStatus::PRECONDITION_FAILED) {
+                handle_error(request, response, 404);
+            }
+        }
+    }
+    // 带校验器的响应（文件、静态文件缓存或处理器自行设置的ETag）按条件头部改写为304/412，
+    // 之后按Range截取区间
+    if(!response.evaluate_preconditions(request)) {
+        response.apply_range(request);
+    }
+}
+
+void HttpServer::handle_error(const HttpRequest& request, HttpResponse& response, int status_code) {
+    auto it = error_handlers_.find(status_code);
+    if(it != error_handlers_.end()) {
+        it->second(request, response, status_code);
+    }
+    else {
+        default_error_handler_(request, response, status_code);
     }
 }
 
@@ -489,7 +1291,24 @@ void HttpServer::head(const std::string& path, RouteHandler handler) {
 }
 
 void HttpServer::route(HttpMethod method, const std::string& path, RouteHandler handler) {
-    routes_.push_back(std::make_unique<Route>(method, path, std::move(handler)));
+    add_route(std::make_unique<Route>(method, path, std::move(handler)));
+}
+
+void HttpServer::stream(HttpMethod method, const std::string& path, RouteHandler handler) {
+    auto route = std::make_unique<Route>(method, path, std::move(handler));
+    route->stream_body = true;
+    add_route(std::move(route));
+    has_streaming_routes_ = true;
+}
+
+void HttpServer::add_route(std::unique_ptr<Route> route) {
+    // 与已注册的路由冲突时保留先注册的，与原先按注册顺序匹配的结果一致
+    if(!router_.add(route->method, route->original_path, route.get())) {
+        log("WARN", "Ignoring route " + method_to_string(route->method) + " " + route->original_path +
+                    ": invalid pattern or already registered");
+        return;
+    }
+    routes_.push_back(std::move(route));
 }
 
 void HttpServer::use(MiddlewareFunc middleware) {
@@ -502,6 +1321,10 @@ void HttpServer::use(const std::string& path, MiddlewareFunc middleware) {
 
 void HttpServer::static_files(const std::string& url_path, const std::string& root_dir) {
     static_paths_[url_path] = root_dir;
+    if(running_.load() && config_.static_cache_bytes > 0 &&
+       (static_cache_->enabled() || static_cache_->start()) && !static_cache_->watch(root_dir)) {
+        log("WARN", "Static cache cannot watch " + root_dir + ", files under it are not cached");
+    }
 }
 
 void HttpServer::set_error_handler(int status_code, ErrorHandler handler) {
@@ -512,87 +1335,257 @@ void HttpServer::set_default_error_handler(ErrorHandler handler) {
     default_error_handler_ = std::move(handler);
 }
 
-bool HttpServer::parse_request(int client_fd, HttpRequest& request) {
-    try {
-        std::string request_line = read_request_line(client_fd);
-        if(request_line.empty()) {
-            return false;
-        }
-        std::istringstream iss(request_line);
-        std::string method, path, version;
-        if(!(iss >> method >> path >> version)) {
-            return false;
+HttpServer::ParseResult HttpServer::parse_request(Connection& conn, HttpRequest& request) {
+    // 解析器只扫描新到达的字节，半包请求在下次唤醒时继续
+    HttpParser::Result result = conn.parser.parse(conn.buffer);
+    if(result == HttpParser::Result::HEADERS) {
+        // 请求头已完整：流式路由不再缓冲请求体，其余请求继续等待完整的请求体
+        if(streams_body(conn.parser.method(), conn.parser.path())) {
+            conn.parser.stream_body();
         }
-        request.set_method(method);
+        result = conn.parser.parse(conn.buffer);
+    }
+    switch(result) {
+        case HttpParser::Result::INCOMPLETE:
+        case HttpParser::Result::HEADERS:
+            return ParseResult::INCOMPLETE;
+        case HttpParser::Result::ERROR:
+            return ParseResult::ERROR;
+        case HttpParser::Result::COMPLETE:
+            break;
+    }
+    request.populate(conn.parser);
+    if(conn.parser.body_streaming()) {
+        request.set_body_source(open_body_stream(conn, request));
+    }
+
+    // 消费已处理的请求字节，保留后续请求
+    conn.buffer.erase(0, conn.parser.message_size());
+    conn.parser.reset();
+    return ParseResult::COMPLETE;
+}
 
-        size_t query_pos = path.find('?');
-        if (query_pos != std::string::npos) {
-            request.set_query_string(path.substr(query_pos + 1));
-            path = path.substr(0, query_pos);
+void HttpServer::send_response(Connection& conn, uint64_t sequence,
+                               HttpResponse& response, bool close_after) {
+    // 状态行使用缓存，头部块与Cookie各渲染一次，响应体直接移入，均不做拼接
+    static const char CRLF[] = "\r\n";
+    std::vector<OutputChunk> chunks;
+    chunks.reserve(5);
+    const std::string& status_line = response.status_line();
+    chunks.emplace_back(status_line.data(), status_line.size());
+    chunks.emplace_back(response.render_headers());
+    std::string cookies = response.render_cookies();
+    if(!cookies.empty()) {
+        chunks.emplace_back(std::move(cookies));
+    }
+    chunks.emplace_back(CRLF, 2);
+    if(response.body_omitted()) {
+        ;
+    }
+    else if(response.has_file_body()) {
+        chunks.emplace_back(response.file_body());
+    }
+    else if(response.shared_body()) {
+        chunks.emplace_back(response.shared_body());
+    }
+    else if(response.has_body_parts()) {
+        for(const auto& part : response.body_parts()) {
+            chunks.emplace_back(part.data);
+            if(part.file) {
+                chunks.emplace_back(part.file);
+            }
         }
-        request.set_path(url_decode(path));
-        request.set_version(version);
+    }
+    else {
+        std::string body = response.take_body();
+        if(!body.empty()) {
+            chunks.emplace_back(std::move(body));
+        }
+    }
 
-        std::string headers_str = read_headers(client_fd);
-        std::istringstream header_stream(headers_str);
-        std::string header_line;
-        while (std::getline(header_stream, header_line) && !header_line.empty()) {
-            if (!header_line.empty() && header_line.back() == '\r') {
-                header_line.pop_back();
+    enqueue_output(conn, sequence, std::move(chunks), true, close_after);
+}
+
+void HttpServer::enqueue_output(Connection& conn, uint64_t sequence, std::vector<OutputChunk> chunks,
+                                bool complete, bool close_after) {
+    // complete为false时是流式响应的一部分，本响应之后的响应继续等待
+    OutputAction action = OutputAction::NONE;
+    {
+        std::lock_guard<std::mutex> lock(conn.output_mutex);
+        if(conn.closed.load()) {
+            return;
+        }
+        if(conn.output_queue.empty()) {
+            conn.last_write_ms = now_ms();
+        }
+        auto enqueue_next = [&conn](std::vector<OutputChunk>& data, bool done, bool close) {
+            for(auto& chunk : data) {
+                if(chunk.size() == 0) {
+                    continue;  // 空片段会让发送循环无法推进
+                }
+                conn.output_bytes += chunk.size();
+                conn.output_queue.push_back(std::move(chunk));
             }
-            size_t colon_pos = header_line.find(':');
-            if (colon_pos != std::string::npos) {
-                std::string key = header_line.substr(0, colon_pos);
-                std::string value = header_line.substr(colon_pos + 1);
-                // 去除前后空格
-                key.erase(0, key.find_first_not_of(" \t"));
-                key.erase(key.find_last_not_of(" \t") + 1);
-                value.erase(0, value.find_first_not_of(" \t"));
-                value.erase(value.find_last_not_of(" \t") + 1);
-                request.add_header(key, value);
+            if(done) {
+                conn.close_when_flushed = close;
+                ++conn.next_to_send;
+                --conn.in_flight;
             }
+        };
+
+        if(sequence == conn.next_to_send) {
+            // 常见情况：轮到本响应，无需进入等待队列
+            enqueue_next(chunks, complete, close_after);
         }
-        std::string content_length_str = request.get_header("Content-Length");
-        if(!content_length_str.empty()) {
-            size_t content_length = std::stoull(content_length_str);
-            // 请求体过大
-            if(content_length > config_.max_request_size) {
-                return false; 
+        else {
+            // 流式响应可能分多次到达，在前序响应写出前累积在一起
+            PendingResponse& pending = conn.completed[sequence];
+            for(auto& chunk : chunks) {
+                pending.bytes += chunk.size();
+                pending.chunks.push_back(std::move(chunk));
             }
-            if(content_length > 0) {
-                std::string body = read_body(client_fd, content_length);
-                request.set_body(body);
-                stats_.total_bytes_received.fetch_add(body.size());
+            pending.complete = complete;
+            pending.close_after = close_after;
+        }
+        // 只放行编号连续的响应，乱序完成的响应等待前序请求
+        auto it = conn.completed.begin();
+        while(it != conn.completed.end() && it->first == conn.next_to_send && !conn.close_when_flushed) {
+            bool done = it->second.complete;
+            enqueue_next(it->second.chunks, done, it->second.close_after);
+            it = conn.completed.erase(it);
+            if(!done) {
+                break;  // 此后该流式响应的数据直接进入输出队列
             }
         }
-        return true;
+        action = flush_output(conn);
     }
-    catch(const std::exception& e) {
-        log("ERROR", "Failed to parse request: " + std::string(e.what()));
-        return false;
+    apply_output_action(conn, action);
+}
+
+HttpServer::OutputAction HttpServer::flush_output(Connection& conn) {
+    // 调用方持有output_mutex
+    if(conn.reactor->ring) {
+        // io_uring后端：交给Reactor与其他连接的发送一起批量提交，完成后再做收尾
+        if(!conn.output_queue.empty()) {
+            if(!conn.send_busy) {
+                conn.send_busy = true;
+                post_ring_request(conn, RingOp::SEND);
+            }
+            return OutputAction::NONE;
+        }
+        return conn.send_busy ? OutputAction::NONE : finish_output(conn, false);
+    }
+    bool progressed = false;
+    while(!conn.output_queue.empty()) {
+        ssize_t bytes_sent = 0;
+        const OutputChunk& front = conn.output_queue.front();
+        if(front.file) {
+            // 文件片段：由内核从页缓存直接发送，每次最多SENDFILE_CHUNK_SIZE字节
+            off_t file_offset = front.file->offset + conn.output_offset;
+            size_t count = std::min(SENDFILE_CHUNK_SIZE, front.size() - conn.output_offset);
+            bytes_sent = sendfile(conn.fd, front.file->fd, &file_offset, count);
+            stats_.total_send_calls.fetch_add(1);
+            if(bytes_sent == 0) {
+                // 文件在发送过程中被截断，已声明的Content-Length无法满足
+                return OutputAction::CLOSE;
+            }
+        }
+        else {
+            // 把队列中连续的内存片段（跨响应）一次交给内核，遇到文件片段为止
+            struct iovec iov[MAX_IOVECS];
+            int count = 0;
+            size_t offset = conn.output_offset;
+            auto it = conn.output_queue.begin();
+            for(; it != conn.output_queue.end() && !it->file && count < MAX_IOVECS; ++it) {
+                iov[count].iov_base = const_cast<char*>(it->data() + offset);
+                iov[count].iov_len = it->size() - offset;
+                offset = 0;
+                ++count;
+            }
+            struct msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = count;
+            // 紧随其后的是文件内容时，提示内核与之合并成完整报文
+            int flags = MSG_NOSIGNAL | (it != conn.output_queue.end() && it->file ? MSG_MORE : 0);
+            bytes_sent = sendmsg(conn.fd, &msg, flags);
+            stats_.total_send_calls.fetch_add(1);
+        }
+        if(bytes_sent < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            if(errno == EAGAIN || errno == EWOULDBLOCK) {
+                // 发送缓冲区已满，剩余数据在EPOLLOUT时继续发送
+                stats_.total_write_waits.fetch_add(1);
+                break;
+            }
+            return OutputAction::CLOSE;
+        }
+        progressed = progressed || bytes_sent > 0;
+        consume_output(conn, bytes_sent);
     }
+    return finish_output(conn, progressed);
 }
 
-void HttpServer::send_response(int client_fd, const HttpResponse& response) {
-    std::string response_str = response.to_string();
-    ssize_t bytes_sent = write_to_socket(client_fd, response_str.c_str(), response_str.size());
-    
-    if (bytes_sent > 0) {
-        stats_.total_bytes_sent.fetch_add(bytes_sent);
+void HttpServer::consume_output(Connection& conn, size_t bytes) {
+    // 调用方持有output_mutex；弹出已完整发送的片段
+    stats_.total_bytes_sent.fetch_add(bytes);
+    conn.output_bytes -= bytes;
+    while(bytes > 0) {
+        size_t left = conn.output_queue.front().size() - conn.output_offset;
+        if(bytes < left) {
+            conn.output_offset += bytes;
+            break;
+        }
+        bytes -= left;
+        conn.output_queue.pop_front();
+        conn.output_offset = 0;
     }
 }
 
-bool HttpServer::match_route(const HttpRequest& request, Route*& matched_route, std::smatch& matches) {
-    HttpMethod method = string_to_method(request.method());
-    for (auto& route : routes_) {
-        if (route->method == method) {
-            if (std::regex_match(request.path(), matches, route->pattern)) {
-                matched_route = route.get();
-                return true;
-            }
+HttpServer::OutputAction HttpServer::finish_output(Connection& conn, bool progressed) {
+    // 调用方持有output_mutex；根据发送结果更新超时、恢复读取或关闭连接
+    if(conn.stream_waiters > 0) {
+        conn.output_cv.notify_all();
+    }
+    int64_t now = progressed || conn.output_queue.empty() ? now_ms() : 0;
+    if(progressed) {
+        conn.last_write_ms = now;
+    }
+
+    if(conn.output_queue.empty()) {
+        if(conn.close_when_flushed) {
+            return OutputAction::CLOSE;
+        }
+        if(conn.in_flight == 0) {
+            conn.idle_since_ms = now;
         }
     }
-    return false;
+    update_deadline(conn);
+    if(conn.read_paused && (conn.in_flight < config_.max_pipeline_depth || conn.upgraded.load()) &&
+       conn.output_bytes <= config_.output_high_water_mark / 2) {
+        conn.read_paused = false;
+        return OutputAction::RESUME_READ;
+    }
+    // 对端已关闭时，缓冲区中的请求全部应答并发送完毕后再关闭
+    if(conn.peer_closed && conn.in_flight == 0 && conn.output_queue.empty()) {
+        return OutputAction::CLOSE;
+    }
+    // 无持有者时（如并发处理的管线化请求）由写出方布防，发送缓冲区满时等待EPOLLOUT
+    if(!conn.owned.load()) {
+        arm_events(conn);
+    }
+    return OutputAction::NONE;
+}
+
+void HttpServer::apply_output_action(Connection& conn, OutputAction action) {
+    if(action == OutputAction::CLOSE) {
+        close_connection(conn);
+    }
+    else if(action == OutputAction::RESUME_READ) {
+        // 边缘触发不会再次通知已到达的数据，需主动恢复读取和解析
+        dispatch_events(conn.shared_from_this(), EPOLLIN);
+    }
 }
 
 void HttpServer::execute_middlewares(const std::vector<MiddlewareFunc>& middlewares,
@@ -615,6 +1608,14 @@ void HttpServer::handle_static_file(const HttpRequest& request, HttpResponse& re
                 response.set_status(HttpStatus::FORBIDDEN);
                 return;
             }
+            // 缓存命中时直接使用内存中的内容，不访问文件系统
+            bool cached = static_cache_->enabled();
+            std::shared_ptr<const StaticFileCache::Entry> entry;
+            if (cached && (entry = static_cache_->find(file_path))) {
+                serve_cached_file(request, response, *entry);
+                return;
+            }
+            std::string key = file_path;
             // 检查文件是否存在
             struct stat file_stat;
             if (stat(file_path.c_str(), &file_stat) != 0) {
@@ -629,25 +1630,52 @@ void HttpServer::handle_static_file(const HttpRequest& request, HttpResponse& re
                     return;
                 }
             }
-            // 读取文件内容
-            std::ifstream file(file_path, std::ios::binary);
-            if (!file.is_open()) {
+            // 校验器由stat得出，条件请求命中时不打开文件
+            response.set_status(HttpStatus::OK);
+            response.set_file_validators(file_stat);
+            if (S_ISREG(file_stat.st_mode) && response.evaluate_preconditions(request)) {
+                return;
+            }
+            if (cached && (entry = static_cache_->load(key, file_path, get_mime_type(file_path)))) {
+                serve_cached_file(request, response, *entry);
+                return;
+            }
+            // 打开文件作为响应体，由输出路径sendfile发送
+            if (!response.open_file_body(file_path)) {
                 response.set_status(HttpStatus::INTERNAL_SERVER_ERROR);
                 return;
             }
-            std::string content((std::istreambuf_iterator<char>(file)),
-                              std::istreambuf_iterator<char>());
             response.set_status(HttpStatus::OK);
             response.set_header("Content-Type", get_mime_type(file_path));
-            response.set_header("Content-Length", std::to_string(content.size()));
-            response.set_body(content);
             return;
         }
     }
     response.set_status(HttpStatus::NOT_FOUND);
 }
 
-void HttpServer::send_error_response(int client_fd, HttpStatus status, const std::string& message) {
+void HttpServer::serve_cached_file(const HttpRequest& request, HttpResponse& response,
+                                   const StaticFileCache::Entry& entry) {
+    response.set_status(HttpStatus::OK);
+    response.set_header("Content-Type", entry.content_type);
+    response.set_header("ETag", entry.etag);
+    response.set_header("Last-Modified", HttpResponse::http_date(entry.mtime));
+    if (entry.gzip_body) {
+        response.set_header("Vary", "Accept-Encoding");
+    }
+    if (response.evaluate_preconditions(request)) {
+        return;
+    }
+    // 预先压缩的变体只在客户端首选gzip时使用，其余情况交给compress_response；区间请求针对原始内容
+    if (entry.gzip_body && config_.enable_compression && !request.has_header("Range") &&
+        compression::negotiate(request.get_header("Accept-Encoding")) == ContentCoding::GZIP) {
+        response.set_shared_body(entry.gzip_body);
+        set_encoding(response, ContentCoding::GZIP);
+        return;
+    }
+    response.set_shared_body(entry.body);
+}
+
+void HttpServer::send_error_response(Connection& conn, uint64_t sequence, HttpStatus status, const std::string& message) {
     HttpResponse response;
     response.set_status(status);
     response.set_header("Content-Type", "text/html; charset=utf-8");
@@ -665,22 +1693,50 @@ void HttpServer::send_error_response(int client_fd, HttpStatus status, const std
     html << "</body></html>";
     
     response.set_body(html.str());
-    send_response(client_fd, response);
+    send_response(conn, sequence, response, true);
 }
 
 // 工具方法实现
+bool HttpServer::parse_method(std::string_view method, HttpMethod& result) {
+    if (method == "GET") result = HttpMethod::GET;
+    else if (method == "POST") result = HttpMethod::POST;
+    else if (method == "PUT") result = HttpMethod::PUT;
+    else if (method == "DELETE") result = HttpMethod::DELETE;
+    else if (method == "PATCH") result = HttpMethod::PATCH;
+    else if (method == "OPTIONS") result = HttpMethod::OPTIONS;
+    else if (method == "HEAD") result = HttpMethod::HEAD;
+    else if (method == "TRACE") result = HttpMethod::TRACE;
+    else if (method == "CONNECT") result = HttpMethod::CONNECT;
+    else return false;
+    return true;
+}
+
 HttpMethod HttpServer::string_to_method(const std::string& method) {
-    if (method == "GET") return HttpMethod::GET;
-    if (method == "POST") return HttpMethod::POST;
-    if (method == "PUT") return HttpMethod::PUT;
-    if (method == "DELETE") return HttpMethod::DELETE;
-    if (method == "PATCH") return HttpMethod::PATCH;
-    if (method == "OPTIONS") return HttpMethod::OPTIONS;
-    if (method == "HEAD") return HttpMethod::HEAD;
-    if (method == "TRACE") return HttpMethod::TRACE;
-    if (method == "CONNECT") return HttpMethod::CONNECT;
-    
-    throw std::invalid_argument("Unknown HTTP method: " + method);
+    HttpMethod result;
+    if (!parse_method(method, result)) {
+        throw std::invalid_argument("Unknown HTTP method: " + method);
+    }
+    return result;
+}
+
+bool HttpServer::header_has_token(const std::string& value, const char* token) {
+    size_t start = 0;
+    size_t token_len = strlen(token);
+    while(start <= value.size()) {
+        size_t end = value.find(',', start);
+        if(end == std::string::npos) {
+            end = value.size();
+        }
+        size_t b = start;
+        size_t e = end;
+        while(b < e && (value[b] == ' ' || value[b] == '\t')) ++b;
+        while(e > b && (value[e - 1] == ' ' || value[e - 1] == '\t')) --e;
+        if(e - b == token_len && strncasecmp(value.c_str() + b, token, token_len) == 0) {
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
 }
 
 std::string HttpServer::method_to_string(HttpMethod method) {
@@ -726,13 +1782,16 @@ std::string HttpServer::status_to_string(HttpStatus status) {
         case HttpStatus::CONFLICT: return "Conflict";
         case HttpStatus::GONE: return "Gone";
         case HttpStatus::LENGTH_REQUIRED: return "Length Required";
+        case HttpStatus::PRECONDITION_FAILED: return "Precondition Failed";
         case HttpStatus::PAYLOAD_TOO_LARGE: return "Payload Too Large";
         case HttpStatus::URI_TOO_LONG: return "URI Too Long";
         case HttpStatus::UNSUPPORTED_MEDIA_TYPE: return "Unsupported Media Type";
         case HttpStatus::RANGE_NOT_SATISFIABLE: return "Range Not Satisfiable";
         case HttpStatus::EXPECTATION_FAILED: return "Expectation Failed";
         case HttpStatus::UNPROCESSABLE_ENTITY: return "Unprocessable Entity";
+        case HttpStatus::UPGRADE_REQUIRED: return "Upgrade Required";
         case HttpStatus::TOO_MANY_REQUESTS: return "Too Many Requests";
+        case HttpStatus::REQUEST_HEADER_FIELDS_TOO_LARGE: return "Request Header Fields Too Large";
         case HttpStatus::INTERNAL_SERVER_ERROR: return "Internal Server Error";
         case HttpStatus::NOT_IMPLEMENTED: return "Not Implemented";
         case HttpStatus::BAD_GATEWAY: return "Bad Gateway";
@@ -816,141 +1875,72 @@ std::string HttpServer::url_decode(const std::string& encoded) {
     return decoded;
 }
 
-ssize_t HttpServer::read_from_socket(int fd, char* buffer, size_t size) {
-    ssize_t total_read = 0;
-    ssize_t bytes_read;
-    while (total_read < static_cast<ssize_t>(size)) {
-        bytes_read = recv(fd, buffer + total_read, size - total_read, 0);
-        if (bytes_read < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // 非阻塞模式下没有数据可读
-                break;
-            }
-            return -1;  // 错误
-        } else if (bytes_read == 0) {
-            break;  // 连接关闭
-        }
-        
-        total_read += bytes_read;
-    }
-    return total_read;
-}
-
-ssize_t HttpServer::write_to_socket(int fd, const char* data, size_t size) {
-    ssize_t total_written = 0;
-    ssize_t bytes_written;
-    while (total_written < static_cast<ssize_t>(size)) {
-        bytes_written = send(fd, data + total_written, size - total_written, MSG_NOSIGNAL);
-        if (bytes_written < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // 暂时无法写入，等待下次
-                break;
+bool HttpServer::fill_read_buffer(Connection& conn) {
+    // 缓冲区上限：一个完整的最大请求，超出部分留在内核中等待消费
+    const size_t limit = config_.max_header_size + config_.max_request_size;
+    if(conn.reactor->ring) {
+        // io_uring后端：取走Reactor已接收的数据
+        size_t taken = 0;
+        bool eof = false;
+        bool resume = false;
+        {
+            std::lock_guard<std::mutex> lock(conn.inbox_mutex);
+            taken = std::min(conn.inbox.size(), limit > conn.buffer.size() ? limit - conn.buffer.size() : 0);
+            conn.buffer.append(conn.inbox, 0, taken);
+            conn.inbox.erase(0, taken);
+            eof = conn.inbox_eof && conn.inbox.empty();
+            if(conn.recv_stopped && conn.inbox.empty() && !conn.inbox_eof) {
+                conn.recv_stopped = false;
+                resume = true;
             }
-            return -1;  // 错误
-        } else if (bytes_written == 0) {
-            break;  // 连接关闭
         }
-        total_written += bytes_written;
-    }
-    return total_written;
-}
-
-std::string HttpServer::read_request_line(int client_fd) {
-    std::string line;
-    char ch;
-    
-    while (true) {
-        ssize_t result = recv(client_fd, &ch, 1, 0);
-        if (result <= 0) {
-            break;
+        if(resume) {
+            post_ring_request(conn, RingOp::RECV);
         }
-        
-        if (ch == '\r') {
-            // 检查下一个字符是否为\n
-            result = recv(client_fd, &ch, 1, MSG_PEEK);
-            if (result > 0 && ch == '\n') {
-                recv(client_fd, &ch, 1, 0);  // 消费\n
+        if(taken > 0) {
+            conn.bytes_read += taken;
+            int64_t now = now_ms();
+            conn.last_read_ms.store(now);
+            if(conn.read_phase.load() == ReadPhase::IDLE) {
+                conn.read_phase.store(ReadPhase::HEADER);
+                conn.request_start_ms.store(now);
             }
-            break;
-        } else if (ch == '\n') {
-            break;
-        }
-        
-        line.push_back(ch);
-        
-        // 防止请求行过长
-        if (line.size() > config_.max_header_size) {
-            break;
         }
+        return !eof;
     }
-    
-    return line;
-}
+    while(conn.buffer.size() < limit) {
+        size_t old_size = conn.buffer.size();
+        size_t to_read = std::min(READ_CHUNK_SIZE, limit - old_size);
+        conn.buffer.resize(old_size + to_read);
 
-std::string HttpServer::read_headers(int client_fd) {
-    std::string headers;
-    std::string line;
-    char ch;
-    
-    while (true) {
-        line.clear();
-        
-        // 读取一行
-        while (true) {
-            ssize_t result = recv(client_fd, &ch, 1, 0);
-            if (result <= 0) {
-                return headers;
-            }
-            
-            if (ch == '\r') {
-                result = recv(client_fd, &ch, 1, MSG_PEEK);
-                if (result > 0 && ch == '\n') {
-                    recv(client_fd, &ch, 1, 0);
-                }
-                break;
-            } else if (ch == '\n') {
-                break;
+        ssize_t bytes_read = recv(conn.fd, &conn.buffer[old_size], to_read, 0);
+        stats_.total_recv_calls.fetch_add(1);
+        conn.buffer.resize(old_size + std::max<ssize_t>(bytes_read, 0));
+
+        if(bytes_read < 0) {
+            if(errno == EINTR) {
+                continue;
             }
-            
-            line.push_back(ch);
+            // 非阻塞模式下已读空
+            return errno == EAGAIN || errno == EWOULDBLOCK;
         }
-        
-        // 空行表示头部结束
-        if (line.empty()) {
-            break;
+        if(bytes_read == 0) {
+            return false;  // 对端关闭
         }
-        
-        headers += line + "\n";
-        
-        // 防止头部过长
-        if (headers.size() > config_.max_header_size) {
-            break;
+        conn.bytes_read += bytes_read;
+        stats_.total_bytes_received.fetch_add(bytes_read);
+        int64_t now = now_ms();
+        conn.last_read_ms.store(now);
+        if(conn.read_phase.load() == ReadPhase::IDLE) {
+            conn.read_phase.store(ReadPhase::HEADER);
+            conn.request_start_ms.store(now);
         }
-    }
-    
-    return headers;
-}
-
-std::string HttpServer::read_body(int client_fd, size_t content_length) {
-    std::string body;
-    body.reserve(content_length);
-    
-    char buffer[8192];
-    size_t total_read = 0;
-    
-    while (total_read < content_length) {
-        size_t to_read = std::min(sizeof(buffer), content_length - total_read);
-        ssize_t bytes_read = recv(client_fd, buffer, to_read, 0);
-        
-        if (bytes_read <= 0) {
-            break;
+        if(static_cast<size_t>(bytes_read) < to_read) {
+            // 短读说明内核缓冲区已空，省去一次必然返回EAGAIN的recv
+            return true;
         }
-        
-        body.append(buffer, bytes_read);
-        total_read += bytes_read;
     }
-    
-    return body;
+    return true;
 }
 
 void HttpServer::signal_handler(int signal) {
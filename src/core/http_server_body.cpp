@@ -0,0 +1,165 @@
+#include "core/http_server.h"
+#include "core/http_request.h"
+#include <cstring>
+#include <strings.h>
+#include <algorithm>
+#include <poll.h>
+
+// 流式请求体：处理器运行在持有连接所有权的工作线程中（EPOLLONESHOT保证不会有其他线程读取该连接），
+// 直接从读缓冲区解码请求体，缓冲区读空后从套接字（io_uring后端为inbox）补充，
+// 内存占用不超过一个读缓冲区。请求体结束后剩余的字节留在缓冲区，作为下一个请求解析
+
+class HttpServer::ConnectionBodySource : public BodySource {
+public:
+    ConnectionBodySource(HttpServer& server, std::shared_ptr<Connection> conn,
+                         const BodyDecoder& decoder, uint64_t sequence, bool expect_continue)
+        : server_(server), conn_(std::move(conn)), decoder_(decoder),
+          sequence_(sequence), expect_continue_(expect_continue) {}
+
+    ssize_t read(char* buf, size_t len) override;
+    bool complete() const override { return decoder_.done(); }
+
+private:
+    HttpServer& server_;
+    std::shared_ptr<Connection> conn_;
+    BodyDecoder decoder_;
+    uint64_t sequence_;
+    bool expect_continue_;
+    bool failed_ = false;
+
+    void send_continue();
+};
+
+ssize_t HttpServer::ConnectionBodySource::read(char* buf, size_t len) {
+    if(failed_) {
+        return -1;
+    }
+    if(decoder_.done() || len == 0) {
+        return 0;
+    }
+    Connection& conn = *conn_;
+    int64_t deadline = now_ms() + server_.config_.body_timeout_seconds * 1000;
+    while(true) {
+        {
+            std::lock_guard<std::mutex> lock(conn.io_mutex);
+            while(true) {
+                size_t consumed = 0;
+                std::string_view data;
+                BodyDecoder::Result result = decoder_.decode(conn.buffer, consumed, data, len);
+                size_t n = data.size();
+                if(n > 0) {
+                    memcpy(buf, data.data(), n);
+                }
+                conn.buffer.erase(0, consumed);
+                switch(result) {
+                    case BodyDecoder::Result::DATA:
+                        return static_cast<ssize_t>(n);
+                    case BodyDecoder::Result::DONE:
+                        return 0;
+                    case BodyDecoder::Result::ERROR:
+                        failed_ = true;
+                        return -1;
+                    case BodyDecoder::Result::INCOMPLETE:
+                        break;
+                }
+
+                // 缓冲区已读空；客户端等待100 Continue时先确认再读取
+                if(expect_continue_) {
+                    expect_continue_ = false;
+                    send_continue();
+                }
+                bool open = server_.fill_read_buffer(conn);
+                if(conn.buffer.empty()) {
+                    if(!open || conn.closed.load()) {
+                        failed_ = true;
+                        return -1;
+                    }
+                    break;
+                }
+                deadline = now_ms() + server_.config_.body_timeout_seconds * 1000;
+            }
+        }
+        if(!server_.wait_readable(conn, deadline)) {
+            failed_ = true;
+            return -1;
+        }
+    }
+}
+
+void HttpServer::ConnectionBodySource::send_continue() {
+    // 只在前序响应均已写出时发送，避免插入到其他响应中间；否则客户端超时后会自行发送请求体
+    static const char CONTINUE[] = "HTTP/1.1 100 Continue\r\n\r\n";
+    Connection& conn = *conn_;
+    std::lock_guard<std::mutex> lock(conn.output_mutex);
+    if(conn.next_to_send == sequence_ && conn.output_queue.empty() && !conn.send_busy) {
+        ssize_t sent = send(conn.fd, CONTINUE, sizeof(CONTINUE) - 1, MSG_NOSIGNAL);
+        server_.stats_.total_send_calls.fetch_add(1);
+        if(sent > 0) {
+            server_.stats_.total_bytes_sent.fetch_add(sent);
+        }
+    }
+}
+
+std::shared_ptr<BodySource> HttpServer::open_body_stream(Connection& conn, const HttpRequest& request) {
+    // 解析器已停在请求头之后，解码器从读缓冲区开头继续；next_sequence即随后分配给本请求的编号
+    bool expect_continue = strcasecmp(request.get_header("Expect").c_str(), "100-continue") == 0;
+    return std::make_shared<ConnectionBodySource>(*this, conn.shared_from_this(), conn.parser.body_decoder(),
+                                                  conn.next_sequence, expect_continue);
+}
+
+bool HttpServer::streams_body(std::string_view method, std::string_view path) {
+    // 在工作线程的解析路径上调用，不能抛出：解析器接受任意方法名，未知方法没有路由
+    HttpMethod route_method;
+    if(!parse_method(method, route_method)) {
+        return false;
+    }
+    RouteParams params;
+    Route* route = router_.find(route_method, path, params);
+    return route && route->stream_body;
+}
+
+bool HttpServer::wait_readable(Connection& conn, int64_t deadline_ms) {
+    // 分段等待，连接关闭或服务器停止时及时返回
+    while(!conn.closed.load() && running_.load()) {
+        int64_t remaining = deadline_ms - now_ms();
+        if(remaining <= 0) {
+            stats_.total_timeouts.fetch_add(1);
+            return false;
+        }
+        if(poll_readable(conn, static_cast<int>(std::min<int64_t>(remaining, TIMER_TICK_MS)))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HttpServer::poll_readable(Connection& conn, int wait_ms) {
+    if(conn.reactor->ring) {
+        std::unique_lock<std::mutex> lock(conn.inbox_mutex);
+        return conn.inbox_cv.wait_for(lock, std::chrono::milliseconds(wait_ms),
+                                      [&conn]() { return !conn.inbox.empty() || conn.inbox_eof; });
+    }
+    pollfd pfd{conn.fd, POLLIN, 0};
+    return poll(&pfd, 1, wait_ms) > 0;  // 包括对端关闭与错误，由读取方识别
+}
+
+bool HttpServer::finish_body_stream(Connection& conn, const HttpRequest& request) {
+    // 处理器未读完的请求体在max_request_size以内读出丢弃，连接仍可复用；
+    // 超出或出错时回复后关闭连接，不再解析后续字节
+    char buf[READ_CHUNK_SIZE];
+    size_t budget = config_.max_request_size;
+    while(!request.body_complete() && budget > 0) {
+        ssize_t n = request.read_body(buf, std::min(sizeof(buf), budget));
+        if(n <= 0) {
+            break;
+        }
+        budget -= n;
+    }
+    if(!request.body_complete()) {
+        conn.input_closed = true;
+        return false;
+    }
+    // 缓冲区中可能已有下一个请求，交给持有者在本轮处理结束前继续解析
+    conn.missed_events.fetch_or(EPOLLIN);
+    return true;
+}
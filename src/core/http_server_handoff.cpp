@@ -0,0 +1,233 @@
+#include "core/http_server.h"
+#include "core/http2.h"
+#include <cstring>
+#include <algorithm>
+#include <poll.h>
+#include <sys/stat.h>
+
+// HttpServer热重启：旧进程在handoff_path上等待新进程连接，经SCM_RIGHTS交出全部监听套接字，
+// 随后停止accept并在期限内排空已有连接。新进程直接使用继承的套接字，无需重新绑定，
+// 两个进程交接期间到达的连接留在内核backlog中，不会被拒绝。
+
+bool HttpServer::receive_listeners() {
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if(fd < 0) {
+        return false;
+    }
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, config_.handoff_path.c_str(), sizeof(addr.sun_path) - 1);
+    // 没有旧进程在运行（首次启动）时连接失败，按正常流程绑定
+    if(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return false;
+    }
+
+    std::vector<int> received;
+    while(true) {
+        uint32_t count = 0;
+        iovec iov{&count, sizeof(count)};
+        alignas(cmsghdr) char control[CMSG_SPACE(HANDOFF_BATCH * sizeof(int))];
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        ssize_t n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+        if(n < 0 && errno == EINTR) {
+            continue;
+        }
+        if(n <= 0) {
+            break;  // 旧进程发送完毕后关闭连接
+        }
+        for(cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+                size_t fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                const int* data = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+                received.insert(received.end(), data, data + fds);
+            }
+        }
+    }
+    close(fd);
+
+    // 按本地地址归到对应的监听配置；配置中已删除的地址直接关闭
+    inherited_fds_.assign(config_.listeners.size(), {});
+    for(int listen_fd : received) {
+        sockaddr_storage local;
+        socklen_t local_len = sizeof(local);
+        size_t i = 0;
+        if(getsockname(listen_fd, reinterpret_cast<sockaddr*>(&local), &local_len) == 0) {
+            for(; i < config_.listeners.size(); ++i) {
+                sockaddr_storage addr;
+                socklen_t addr_len;
+                if(parse_listen_address(config_.listeners[i], addr, addr_len) && same_address(local, addr)) {
+                    break;
+                }
+            }
+        }
+        else {
+            i = config_.listeners.size();
+        }
+        // 各Reactor持有的Unix域套接字是同一个套接字的副本，保留一个即可
+        if(i == config_.listeners.size() ||
+           (local.ss_family == AF_UNIX && !inherited_fds_[i].empty())) {
+            close(listen_fd);
+            continue;
+        }
+        inherited_fds_[i].push_back(listen_fd);
+    }
+    return !received.empty();
+}
+
+bool HttpServer::same_address(const sockaddr_storage& a, const sockaddr_storage& b) {
+    if(a.ss_family != b.ss_family) {
+        return false;
+    }
+    if(a.ss_family == AF_INET) {
+        const auto& x = reinterpret_cast<const sockaddr_in&>(a);
+        const auto& y = reinterpret_cast<const sockaddr_in&>(b);
+        return x.sin_port == y.sin_port && x.sin_addr.s_addr == y.sin_addr.s_addr;
+    }
+    if(a.ss_family == AF_INET6) {
+        const auto& x = reinterpret_cast<const sockaddr_in6&>(a);
+        const auto& y = reinterpret_cast<const sockaddr_in6&>(b);
+        return x.sin6_port == y.sin6_port && memcmp(&x.sin6_addr, &y.sin6_addr, sizeof(in6_addr)) == 0;
+    }
+    if(a.ss_family == AF_UNIX) {
+        return strcmp(reinterpret_cast<const sockaddr_un&>(a).sun_path,
+                      reinterpret_cast<const sockaddr_un&>(b).sun_path) == 0;
+    }
+    return false;
+}
+
+bool HttpServer::open_handoff_socket() {
+    sockaddr_un addr{};
+    if(config_.handoff_path.size() >= sizeof(addr.sun_path)) {
+        log("ERROR", "Handoff path too long: " + config_.handoff_path);
+        return false;
+    }
+    handoff_fd_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(handoff_fd_ < 0) {
+        log("ERROR", "Handoff socket creation failed: " + std::string(strerror(errno)));
+        return false;
+    }
+    // 旧进程的交接套接字仍在监听，但已完成交接，直接替换其路径
+    struct stat st;
+    if(lstat(config_.handoff_path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(config_.handoff_path.c_str());
+    }
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, config_.handoff_path.c_str(), config_.handoff_path.size() + 1);
+    if(bind(handoff_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+       chmod(config_.handoff_path.c_str(), 0600) < 0 || listen(handoff_fd_, 1) < 0) {
+        log("ERROR", "Handoff socket setup failed: " + std::string(strerror(errno)));
+        close(handoff_fd_);
+        handoff_fd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+void HttpServer::handoff_loop() {
+    // 以短超时轮询，stop()时能及时退出
+    while(running_.load()) {
+        pollfd pfd{handoff_fd_, POLLIN, 0};
+        if(poll(&pfd, 1, static_cast<int>(TIMER_TICK_MS)) <= 0) {
+            continue;
+        }
+        int peer = accept4(handoff_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if(peer < 0) {
+            continue;
+        }
+        bool sent = send_listeners(peer);
+        close(peer);
+        if(sent) {
+            break;
+        }
+    }
+    if(!running_.load()) {
+        return;
+    }
+
+    // 交出后各Reactor在下一轮循环中停止accept；已有连接处理完当前请求后关闭
+    handed_off_.store(true);
+    draining_.store(true);
+    log("INFO", "Listening sockets handed off, draining " +
+        std::to_string(stats_.active_connections.load()) + " connection(s)");
+    int64_t deadline = now_ms() + config_.drain_timeout_seconds * 1000;
+    while(running_.load() && stats_.active_connections.load() > 0 && now_ms() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(TIMER_TICK_MS));
+    }
+    if(stats_.active_connections.load() > 0) {
+        log("WARN", "Drain deadline reached with " + std::to_string(stats_.active_connections.load()) +
+            " connection(s) still open");
+    }
+    drained_.store(true);
+}
+
+bool HttpServer::send_listeners(int peer_fd) {
+    // 按Reactor顺序发送全部监听套接字，新进程按本地地址重新归类
+    std::vector<int> fds;
+    for(auto& reactor : reactors_) {
+        fds.insert(fds.end(), reactor->listen_fds.begin(), reactor->listen_fds.end());
+    }
+    for(size_t offset = 0; offset < fds.size(); offset += HANDOFF_BATCH) {
+        uint32_t count = static_cast<uint32_t>(std::min(HANDOFF_BATCH, fds.size() - offset));
+        iovec iov{&count, sizeof(count)};
+        alignas(cmsghdr) char control[CMSG_SPACE(HANDOFF_BATCH * sizeof(int))];
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(count * sizeof(int));
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(count * sizeof(int));
+        memcpy(CMSG_DATA(cmsg), fds.data() + offset, count * sizeof(int));
+        if(sendmsg(peer_fd, &msg, MSG_NOSIGNAL) < 0) {
+            log("ERROR", "Failed to hand off listening sockets: " + std::string(strerror(errno)));
+            return false;
+        }
+    }
+    return !fds.empty();
+}
+
+void HttpServer::begin_drain(Reactor& reactor) {
+    // 新进程已持有同一批套接字，这里只撤销本进程的注册并关闭自己的副本
+    reactor.draining = true;
+    for(int listen_fd : reactor.listen_fds) {
+        if(reactor.ring) {
+            submit_ring_op(reactor, nullptr, RingOp::CANCEL, listen_fd);
+        }
+        else {
+            epoll_ctl(reactor.epoll_fd, EPOLL_CTL_DEL, listen_fd, nullptr);
+        }
+        close(listen_fd);
+    }
+    reactor.listen_fds.clear();
+    // 暂停期间暂存的连接尚未处理任何请求，让客户端稍后重试到新进程
+    for(int fd : reactor.deferred_fds) {
+        reject_connection(fd);
+    }
+    reactor.deferred_fds.clear();
+
+    // 空闲的keep-alive连接与不会结束的SSE订阅立即关闭，客户端自动重连到新进程，
+    // 其余连接在当前请求的响应写完后关闭；HTTP/2连接先通告GOAWAY，已受理的流处理完后关闭
+    std::vector<std::shared_ptr<Connection>> idle;
+    std::vector<std::shared_ptr<Connection>> http2;
+    reactor.connections.for_each([&](const std::shared_ptr<Connection>& conn) {
+        if(conn->upgraded.load() && conn->http2) {
+            http2.push_back(conn);
+        }
+        else if(connection_idle(*conn) || conn->event_stream.load()) {
+            idle.push_back(conn);
+        }
+    });
+    for(auto& conn : idle) {
+        close_connection(*conn);
+    }
+    for(auto& conn : http2) {
+        conn->http2->go_away();
+    }
+}
@@ -0,0 +1,209 @@
+#include "core/http_server.h"
+#include "core/http_request.h"
+#include "core/http_response.h"
+#include <cstdio>
+#include <poll.h>
+
+// 流式响应：处理器生成的每段数据立即按chunked编码进入连接的输出队列，
+// 输出积压超过output_high_water_mark时挂起处理器，降到一半以下再继续，内存占用与响应大小无关
+
+bool HttpServer::ConnectionResponseStream::begin(HttpResponse& response) {
+    if(started_) {
+        return !failed_;
+    }
+    started_ = true;
+    head_ = request_.method() == "HEAD";
+    chunked_ = request_.version() != "HTTP/1.0";
+    keep_alive_ = chunked_ && server_.wants_keep_alive(request_);
+
+    response.remove_header("Content-Length");
+    // 逐段压缩：每段同步刷新，客户端收到即可解压；HEAD只需与GET一致的头部
+    ContentCoding coding = server_.choose_encoding(request_, response, true);
+    if(coding != ContentCoding::IDENTITY) {
+        if(!head_) {
+            compressor_ = std::make_unique<StreamCompressor>(coding, server_.config_.compression_level);
+        }
+        if(head_ || compressor_->ok()) {
+            server_.set_encoding(response, coding);
+        }
+        else {
+            compressor_.reset();
+        }
+    }
+    if(chunked_) {
+        response.set_header("Transfer-Encoding", "chunked");
+    }
+    if(keep_alive_) {
+        response.set_header("Connection", "keep-alive");
+        response.set_header("Keep-Alive", "timeout=" + std::to_string(server_.config_.keep_alive_timeout));
+    }
+    else {
+        response.set_header("Connection", "close");
+    }
+
+    send_head(response);
+    return !failed_;
+}
+
+bool HttpServer::ConnectionResponseStream::upgrade(HttpResponse& response) {
+    if(started_ || detached_) {
+        return false;
+    }
+    // 101响应没有响应体，之后的输出由新协议写入同一序号，直到其结束响应
+    detached_ = true;
+    send_head(response);
+    return !failed_;
+}
+
+void HttpServer::ConnectionResponseStream::send_head(HttpResponse& response) {
+    static const char CRLF[] = "\r\n";
+    std::vector<OutputChunk> chunks;
+    const std::string& status_line = response.status_line();
+    chunks.emplace_back(status_line.data(), status_line.size());
+    chunks.emplace_back(response.render_headers());
+    chunks.emplace_back(response.render_cookies());
+    chunks.emplace_back(CRLF, 2);
+    server_.enqueue_output(conn_, sequence_, std::move(chunks), false, false);
+    failed_ = conn_.closed.load();
+}
+
+bool HttpServer::ConnectionResponseStream::write(std::string_view data) {
+    if(!started_ || ended_ || failed_) {
+        return false;
+    }
+    // 空分块会被客户端当作响应结束
+    if(data.empty() || head_) {
+        return !conn_.closed.load();
+    }
+    std::string compressed;
+    if(compressor_) {
+        if(!compressor_->write(data, compressed)) {
+            failed_ = true;
+            return false;
+        }
+        data = compressed;
+    }
+    std::string framed;
+    if(chunked_) {
+        char size_line[24];
+        int n = snprintf(size_line, sizeof(size_line), "%zx\r\n", data.size());
+        framed.reserve(n + data.size() + 2);
+        framed.append(size_line, n);
+        framed.append(data);
+        framed.append("\r\n", 2);
+    }
+    else {
+        framed.assign(data);
+    }
+    std::vector<OutputChunk> chunks;
+    chunks.emplace_back(std::move(framed));
+    server_.enqueue_output(conn_, sequence_, std::move(chunks), false, false);
+    failed_ = !server_.wait_output_drained(conn_, sequence_);
+    return !failed_;
+}
+
+bool HttpServer::ConnectionResponseStream::end() {
+    if(!started_ || ended_ || detached_) {
+        return false;
+    }
+    ended_ = true;
+    // 先计数再写出结束块，客户端收到结束块时统计已经可见（处理器可能自行结束响应）
+    server_.stats_.total_streamed_responses.fetch_add(1);
+    // 请求要求关闭、请求体未读完等情况下，写完后关闭连接
+    bool close_after = !keep_alive_ || conn_.input_closed.load();
+    static const char LAST_CHUNK[] = "0\r\n\r\n";
+    std::vector<OutputChunk> chunks;
+    // 压缩流的结尾作为最后一个数据分块
+    std::string tail;
+    if(compressor_ && compressor_->write({}, tail, true) && !tail.empty()) {
+        if(chunked_) {
+            char size_line[24];
+            int n = snprintf(size_line, sizeof(size_line), "%zx\r\n", tail.size());
+            tail.insert(0, size_line, n);
+            tail.append("\r\n", 2);
+        }
+        chunks.emplace_back(std::move(tail));
+    }
+    if(chunked_ && !head_) {
+        chunks.emplace_back(LAST_CHUNK, sizeof(LAST_CHUNK) - 1);
+    }
+    server_.enqueue_output(conn_, sequence_, std::move(chunks), true, close_after);
+    return !failed_ && !conn_.closed.load();
+}
+
+void HttpServer::ConnectionResponseStream::detach() {
+    // 之后由事件频道写入并结束响应
+    detached_ = true;
+}
+
+size_t HttpServer::stream_backlog(Connection& conn, uint64_t sequence) {
+    // 调用方持有output_mutex
+    if(conn.next_to_send == sequence) {
+        return conn.output_bytes;
+    }
+    auto it = conn.completed.find(sequence);  // 前序响应尚未写完，本响应仍在等待队列中
+    return it == conn.completed.end() ? 0 : it->second.bytes;
+}
+
+bool HttpServer::push_output(Connection& conn, uint64_t sequence, std::vector<OutputChunk> chunks) {
+    bool slow = false;
+    {
+        std::lock_guard<std::mutex> lock(conn.output_mutex);
+        slow = stream_backlog(conn, sequence) > config_.output_high_water_mark;
+    }
+    if(slow) {
+        // 推送方不等待慢连接，也不为其无限缓存
+        stats_.total_slow_subscribers.fetch_add(1);
+        close_connection(conn);
+        return false;
+    }
+    enqueue_output(conn, sequence, std::move(chunks), false, false);
+    return !conn.closed.load();
+}
+
+bool HttpServer::wait_output_drained(Connection& conn, uint64_t sequence) {
+    // 处理器所在线程可能正持有连接，其他线程不会代为布防EPOLLOUT；
+    // epoll后端由等待方自行等待可写并发送，io_uring后端由Reactor的发送完成事件唤醒
+    const size_t high = config_.output_high_water_mark;
+    std::unique_lock<std::mutex> lock(conn.output_mutex);
+    auto backlog = [this, &conn, sequence]() { return stream_backlog(conn, sequence); };
+    if(backlog() <= high) {
+        return !conn.closed.load();
+    }
+
+    stats_.total_stream_waits.fetch_add(1);
+    ++conn.stream_waiters;
+    bool timed_out = false;
+    while(!conn.closed.load() && running_.load() && backlog() > high / 2) {
+        if(!conn.output_queue.empty() &&
+           now_ms() - conn.last_write_ms > config_.write_timeout_seconds * 1000) {
+            timed_out = true;
+            break;
+        }
+        if(!conn.reactor->ring && !conn.output_queue.empty()) {
+            OutputAction action = flush_output(conn);
+            if(action != OutputAction::NONE) {
+                lock.unlock();
+                apply_output_action(conn, action);
+                lock.lock();
+                continue;
+            }
+            if(!conn.output_queue.empty()) {
+                lock.unlock();
+                pollfd pfd{conn.fd, POLLOUT, 0};
+                poll(&pfd, 1, static_cast<int>(TIMER_TICK_MS));
+                lock.lock();
+            }
+            continue;
+        }
+        conn.output_cv.wait_for(lock, std::chrono::milliseconds(TIMER_TICK_MS));
+    }
+    --conn.stream_waiters;
+    bool open = !conn.closed.load() && !timed_out && running_.load();
+    lock.unlock();
+    if(timed_out) {
+        stats_.total_timeouts.fetch_add(1);
+        close_connection(conn);
+    }
+    return open;
+}
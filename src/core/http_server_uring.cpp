@@ -0,0 +1,390 @@
+#include "core/http_server.h"
+#include <cstring>
+#include <algorithm>
+
+// HttpServer的io_uring后端：请求解析、路由分发与线程池集成与epoll后端共用，
+// 只替换Reactor的事件循环与套接字读写
+
+#ifdef XKOJ_HAVE_IO_URING
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+
+bool HttpServer::setup_uring(Reactor& reactor) {
+    auto ring = std::make_unique<IoUring>();
+    std::string error;
+    if(!ring->init(RING_ENTRIES, error) ||
+       !ring->setup_buffers(RING_BUFFER_GROUP, RING_BUFFER_COUNT, READ_CHUNK_SIZE, error)) {
+        log("WARN", "io_uring unavailable, falling back to epoll: " + error);
+        return false;
+    }
+    reactor.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(reactor.wake_fd < 0) {
+        log("WARN", "eventfd failed, falling back to epoll: " + std::string(strerror(errno)));
+        return false;
+    }
+    reactor.ring = std::move(ring);
+    reactor.accepting.assign(reactor.listen_fds.size(), false);
+    for(int listen_fd : reactor.listen_fds) {
+        submit_ring_op(reactor, nullptr, RingOp::ACCEPT, listen_fd);
+    }
+    submit_ring_op(reactor, nullptr, RingOp::WAKE);
+    return true;
+}
+
+void HttpServer::uring_loop(Reactor& reactor) {
+    IoUring& ring = *reactor.ring;
+    std::vector<std::pair<std::shared_ptr<Connection>, RingOp>> requests;
+
+    while(running_.load()) {
+        {
+            std::lock_guard<std::mutex> lock(reactor.ring_mutex);
+            requests.swap(reactor.ring_requests);
+        }
+        // 工作线程交来的发送在本轮与其他请求一起提交
+        for(auto& [conn, op] : requests) {
+            if(conn->closed.load()) {
+                continue;
+            }
+            if(op == RingOp::SEND) {
+                OutputAction action = OutputAction::NONE;
+                {
+                    std::lock_guard<std::mutex> lock(conn->output_mutex);
+                    if(!conn->closed.load()) {
+                        action = start_ring_send(reactor, *conn, false);
+                    }
+                }
+                apply_output_action(*conn, action);
+            }
+            else if(op == RingOp::RECV && !conn->recv_active) {
+                submit_ring_op(reactor, conn.get(), RingOp::RECV);
+            }
+        }
+        requests.clear();
+        release_connections(reactor);
+        process_timers(reactor);
+        resume_accept(reactor);
+        if(reactor.index == 0) {
+            send_event_heartbeats();
+        }
+        if(draining_.load() && !reactor.draining) {
+            begin_drain(reactor);
+        }
+
+        // 先声明即将等待再检查请求队列，与post_ring_request的先入队后检查配对，不会错过唤醒
+        reactor.sleeping.store(true);
+        bool idle = false;
+        {
+            std::lock_guard<std::mutex> lock(reactor.ring_mutex);
+            idle = reactor.ring_requests.empty();
+        }
+        if(idle || ring.pending() > 0) {
+            stats_.total_ring_enters.fetch_add(1);
+        }
+        // 以定时器精度为等待上限，保证超时及时处理
+        int ret = ring.submit(idle, TIMER_TICK_MS);
+        reactor.sleeping.store(false);
+        if(ret < 0 && ret != -EBUSY) {
+            log("ERROR", "io_uring_enter failed: " + std::string(strerror(-ret)));
+            break;
+        }
+        ring.for_each_cqe([&](const io_uring_cqe& cqe) {
+            handle_ring_completion(reactor, cqe.user_data, cqe.res, cqe.flags);
+        });
+    }
+}
+
+void HttpServer::post_ring_request(Connection& conn, RingOp op) {
+    Reactor& reactor = *conn.reactor;
+    {
+        std::lock_guard<std::mutex> lock(reactor.ring_mutex);
+        reactor.ring_requests.emplace_back(conn.shared_from_this(), op);
+    }
+    // Reactor忙碌时会在下一轮自行取走请求，只有等待中才需要唤醒
+    if(reactor.sleeping.load()) {
+        uint64_t one = 1;
+        ssize_t ignored = write(reactor.wake_fd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void HttpServer::submit_ring_op(Reactor& reactor, Connection* conn, RingOp op, int listen_fd) {
+    io_uring_sqe* sqe = reactor.ring->get_sqe();
+    if(!sqe) {
+        log("ERROR", "io_uring submission queue full");
+        return;
+    }
+    // Connection至少按8字节对齐，低3位用于请求类型
+    sqe->user_data = reinterpret_cast<uint64_t>(conn) | static_cast<uint64_t>(op);
+    switch(op) {
+        case RingOp::ACCEPT:
+            // 多路accept：一次提交持续产生新连接，直接得到非阻塞套接字
+            // 没有连接对象，高32位记录监听套接字
+            sqe->user_data |= static_cast<uint64_t>(listen_fd) << 32;
+            sqe->opcode = IORING_OP_ACCEPT;
+            sqe->fd = listen_fd;
+            sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+            sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+            reactor.accepting[std::find(reactor.listen_fds.begin(), reactor.listen_fds.end(), listen_fd) -
+                              reactor.listen_fds.begin()] = true;
+            break;
+        case RingOp::WAKE:
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = reactor.wake_fd;
+            sqe->len = IORING_POLL_ADD_MULTI;
+            sqe->poll32_events = POLLIN;
+            break;
+        case RingOp::RECV:
+            // 多路recv：数据到达时由内核从提供缓冲区环中挑选缓冲区
+            sqe->opcode = IORING_OP_RECV;
+            sqe->fd = conn->fd;
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = RING_BUFFER_GROUP;
+            conn->recv_active = true;
+            break;
+        case RingOp::SEND:
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->fd = conn->fd;
+            sqe->addr = reinterpret_cast<uint64_t>(&conn->send_msg);
+            sqe->len = 1;
+            sqe->msg_flags = MSG_NOSIGNAL;
+            break;
+        case RingOp::POLL_OUT:
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = conn->fd;
+            sqe->poll32_events = POLLOUT;
+            break;
+        case RingOp::CANCEL:
+            // 取消连接的多路recv，或者（没有连接时）监听套接字的多路accept
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = conn ? reinterpret_cast<uint64_t>(conn) | static_cast<uint64_t>(RingOp::RECV)
+                             : static_cast<uint64_t>(listen_fd) << 32 | static_cast<uint64_t>(RingOp::ACCEPT);
+            return;  // 取消请求本身不引用连接的缓冲区
+    }
+    if(conn && conn->ring_ops++ == 0) {
+        reactor.ring_refs[conn] = conn->shared_from_this();
+    }
+}
+
+void HttpServer::register_ring_connection(Reactor& reactor, int client_fd) {
+    struct sockaddr_storage client_addr;
+    socklen_t client_len = sizeof(client_addr);
+    std::string client_ip;
+    if(getpeername(client_fd, (struct sockaddr*)&client_addr, &client_len) == 0) {
+        client_ip = peer_address(client_addr);
+    }
+    auto conn = create_connection(reactor, client_fd, client_ip.c_str());
+    submit_ring_op(reactor, conn.get(), RingOp::RECV);
+    schedule_timer(reactor, *conn);
+    on_connection_accepted(client_fd, client_ip);
+}
+
+HttpServer::OutputAction HttpServer::start_ring_send(Reactor& reactor, Connection& conn, bool progressed) {
+    // 调用方持有output_mutex；发送完毕前send_busy保持为true
+    while(!conn.output_queue.empty()) {
+        const OutputChunk& front = conn.output_queue.front();
+        if(front.file) {
+            // io_uring没有sendfile，文件片段在Reactor线程上以非阻塞sendfile发送
+            off_t file_offset = front.file->offset + conn.output_offset;
+            size_t count = std::min(SENDFILE_CHUNK_SIZE, front.size() - conn.output_offset);
+            ssize_t bytes_sent = sendfile(conn.fd, front.file->fd, &file_offset, count);
+            if(bytes_sent > 0) {
+                consume_output(conn, bytes_sent);
+                progressed = true;
+                continue;
+            }
+            if(bytes_sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if(bytes_sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                stats_.total_write_waits.fetch_add(1);
+                submit_ring_op(reactor, &conn, RingOp::POLL_OUT);
+                return progressed ? finish_output(conn, true) : OutputAction::NONE;
+            }
+            conn.send_busy = false;
+            return OutputAction::CLOSE;
+        }
+
+        // 把队列中连续的内存片段一次交给内核，完成前片段不会被弹出
+        conn.send_iov.clear();
+        size_t offset = conn.output_offset;
+        for(auto it = conn.output_queue.begin();
+            it != conn.output_queue.end() && !it->file && conn.send_iov.size() < MAX_IOVECS; ++it) {
+            conn.send_iov.push_back({const_cast<char*>(it->data() + offset), it->size() - offset});
+            offset = 0;
+        }
+        conn.send_msg = msghdr{};
+        conn.send_msg.msg_iov = conn.send_iov.data();
+        conn.send_msg.msg_iovlen = conn.send_iov.size();
+        submit_ring_op(reactor, &conn, RingOp::SEND);
+        return progressed ? finish_output(conn, true) : OutputAction::NONE;
+    }
+    conn.send_busy = false;
+    return finish_output(conn, progressed);
+}
+
+void HttpServer::handle_ring_completion(Reactor& reactor, uint64_t user_data, int32_t res, uint32_t flags) {
+    RingOp op = static_cast<RingOp>(user_data & 7);
+    Connection* raw = reinterpret_cast<Connection*>(user_data & ~uint64_t{7});
+    bool more = flags & IORING_CQE_F_MORE;
+
+    if(op == RingOp::ACCEPT) {
+        int listen_fd = static_cast<int>(user_data >> 32);
+        if(res >= 0) {
+            if(admit_connection(reactor)) {
+                register_ring_connection(reactor, res);
+            }
+            else if(reactor.accept_paused) {
+                // 取消生效前多路accept仍可能接受连接，暂存到恢复时再登记，与epoll后端留在backlog中等价
+                reactor.deferred_fds.push_back(res);
+            }
+            else {
+                reject_connection(res);
+            }
+        }
+        else if(res != -EAGAIN && res != -ECANCELED) {
+            log("ERROR", "Accept failed: " + std::string(strerror(-res)));
+        }
+        if(!more && !reactor.draining) {
+            reactor.accepting[std::find(reactor.listen_fds.begin(), reactor.listen_fds.end(), listen_fd) -
+                              reactor.listen_fds.begin()] = false;
+            if(running_.load() && !reactor.accept_paused) {
+                submit_ring_op(reactor, nullptr, RingOp::ACCEPT, listen_fd);
+            }
+        }
+        return;
+    }
+    if(op == RingOp::WAKE) {
+        uint64_t value;
+        ssize_t ignored = read(reactor.wake_fd, &value, sizeof(value));
+        (void)ignored;
+        if(!more && running_.load()) {
+            submit_ring_op(reactor, nullptr, RingOp::WAKE);
+        }
+        return;
+    }
+    if(op == RingOp::CANCEL) {
+        return;
+    }
+
+    // 在途请求持有连接的引用，本次处理结束前不会释放
+    auto ref = reactor.ring_refs.find(raw);
+    if(ref == reactor.ring_refs.end()) {
+        return;
+    }
+    std::shared_ptr<Connection> conn = ref->second;
+    if(!more && --conn->ring_ops == 0) {
+        reactor.ring_refs.erase(ref);
+    }
+
+    if(op == RingOp::RECV) {
+        const size_t limit = config_.max_header_size + config_.max_request_size;
+        bool notify = false;
+        bool stopped = false;
+        bool eof = false;
+        if(res > 0 && (flags & IORING_CQE_F_BUFFER)) {
+            uint16_t buffer_id = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+            bool cancel = false;
+            {
+                std::lock_guard<std::mutex> lock(conn->inbox_mutex);
+                conn->inbox.append(reactor.ring->buffer(buffer_id), res);
+                // 积压超过一个完整请求时停止接收，由工作线程取走数据后恢复
+                if(conn->inbox.size() > limit && !conn->recv_stopped) {
+                    conn->recv_stopped = true;
+                    cancel = more;
+                }
+                stopped = conn->recv_stopped;
+            }
+            reactor.ring->recycle_buffer(buffer_id);
+            stats_.total_bytes_received.fetch_add(res);
+            notify = true;
+            if(cancel) {
+                submit_ring_op(reactor, conn.get(), RingOp::CANCEL);
+            }
+        }
+        else if(res == 0 || (res < 0 && res != -ENOBUFS && res != -ECANCELED)) {
+            // 对端关闭或连接出错，交给工作线程按对端关闭处理
+            std::lock_guard<std::mutex> lock(conn->inbox_mutex);
+            conn->inbox_eof = true;
+            eof = true;
+            notify = true;
+        }
+        else {
+            std::lock_guard<std::mutex> lock(conn->inbox_mutex);
+            stopped = conn->recv_stopped;
+        }
+        if(!more) {
+            conn->recv_active = false;
+            // 提供缓冲区暂时耗尽等原因结束时重新提交
+            if(!conn->closed.load() && !stopped && !eof) {
+                submit_ring_op(reactor, conn.get(), RingOp::RECV);
+            }
+        }
+        if(notify && !conn->closed.load()) {
+            // 流式读取请求体的处理器持有连接，直接唤醒它；否则按读事件分发
+            conn->inbox_cv.notify_all();
+            dispatch_events(conn, EPOLLIN);
+        }
+        return;
+    }
+
+    // SEND / POLL_OUT
+    OutputAction action = OutputAction::NONE;
+    {
+        std::lock_guard<std::mutex> lock(conn->output_mutex);
+        if(conn->closed.load()) {
+            return;
+        }
+        if(op == RingOp::SEND && res > 0) {
+            // 内核在发送缓冲区满时只完成一部分，等同于epoll后端的一次等待可写
+            size_t requested = 0;
+            for(const iovec& iov : conn->send_iov) {
+                requested += iov.iov_len;
+            }
+            if(static_cast<size_t>(res) < requested) {
+                stats_.total_write_waits.fetch_add(1);
+            }
+            consume_output(*conn, res);
+            action = start_ring_send(reactor, *conn, true);
+        }
+        else if((op == RingOp::SEND && res == -EAGAIN) || (op == RingOp::POLL_OUT && res == -EINTR)) {
+            // 发送缓冲区已满，等待可写后继续
+            stats_.total_write_waits.fetch_add(1);
+            submit_ring_op(reactor, conn.get(), RingOp::POLL_OUT);
+        }
+        else if(op == RingOp::SEND && res == -EINTR) {
+            submit_ring_op(reactor, conn.get(), RingOp::SEND);
+        }
+        else if(op == RingOp::POLL_OUT && res >= 0) {
+            action = start_ring_send(reactor, *conn, false);
+        }
+        else {
+            conn->send_busy = false;
+            action = OutputAction::CLOSE;
+        }
+    }
+    apply_output_action(*conn, action);
+}
+
+#else
+
+bool HttpServer::setup_uring(Reactor&) {
+    log("WARN", "io_uring is not supported by this build, falling back to epoll");
+    return false;
+}
+
+void HttpServer::uring_loop(Reactor&) {}
+void HttpServer::post_ring_request(Connection&, RingOp) {}
+void HttpServer::submit_ring_op(Reactor&, Connection*, RingOp, int) {}
+
+void HttpServer::register_ring_connection(Reactor&, int) {}
+
+HttpServer::OutputAction HttpServer::start_ring_send(Reactor&, Connection&, bool) {
+    return OutputAction::NONE;
+}
+
+void HttpServer::handle_ring_completion(Reactor&, uint64_t, int32_t, uint32_t) {}
+
+#endif // XKOJ_HAVE_IO_URING
@@ -0,0 +1,212 @@
+#include "core/io_uring.h"
+
+#ifdef XKOJ_HAVE_IO_URING
+
+#include <cstring>
+#include <algorithm>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/time_types.h>
+
+namespace {
+
+int sys_io_uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags,
+                       void* arg, size_t arg_size) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size));
+}
+
+int sys_io_uring_register(int fd, unsigned opcode, void* arg, unsigned nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+}  // namespace
+
+IoUring::~IoUring() {
+    if (buf_ring_) {
+        munmap(buf_ring_, buf_ring_size_);
+    }
+    if (buffers_) {
+        munmap(buffers_, buffers_size_);
+    }
+    if (sqes_) {
+        munmap(sqes_, sqes_map_size_);
+    }
+    if (cq_ptr_ && cq_ptr_ != sq_ptr_) {
+        munmap(cq_ptr_, cq_map_size_);
+    }
+    if (sq_ptr_) {
+        munmap(sq_ptr_, sq_map_size_);
+    }
+    // 关闭ring时内核取消所有未完成的请求
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);
+    }
+}
+
+bool IoUring::init(unsigned entries, std::string& error) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+    ring_fd_ = sys_io_uring_setup(entries, &params);
+    if (ring_fd_ < 0 && errno == EINVAL) {
+        // 较旧的内核不支持上述标志
+        memset(&params, 0, sizeof(params));
+        ring_fd_ = sys_io_uring_setup(entries, &params);
+    }
+    if (ring_fd_ < 0) {
+        error = "io_uring_setup: " + std::string(strerror(errno));
+        return false;
+    }
+    if (!(params.features & IORING_FEAT_EXT_ARG)) {
+        error = "kernel lacks IORING_FEAT_EXT_ARG";
+        return false;
+    }
+
+    sq_map_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_map_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_map_size_ = cq_map_size_ = std::max(sq_map_size_, cq_map_size_);
+    }
+    sq_ptr_ = mmap(nullptr, sq_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+        sq_ptr_ = nullptr;
+        error = "mmap sq ring: " + std::string(strerror(errno));
+        return false;
+    }
+    if (single_mmap) {
+        cq_ptr_ = sq_ptr_;
+    } else {
+        cq_ptr_ = mmap(nullptr, cq_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ptr_ == MAP_FAILED) {
+            cq_ptr_ = nullptr;
+            error = "mmap cq ring: " + std::string(strerror(errno));
+            return false;
+        }
+    }
+    sqes_map_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        error = "mmap sqes: " + std::string(strerror(errno));
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sq_ptr_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    // SQ下标数组固定为恒等映射，SQE按环形位置直接填写
+    unsigned* array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    for (unsigned i = 0; i < sq_entries_; ++i) {
+        array[i] = i;
+    }
+    sqe_tail_ = *sq_tail_;
+
+    char* cq = static_cast<char*>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+}
+
+bool IoUring::setup_buffers(uint16_t group, unsigned count, unsigned size, std::string& error) {
+    // 环的条目数必须是2的幂
+    if (count == 0 || (count & (count - 1)) != 0 || count > 32768) {
+        error = "buffer count must be a power of two";
+        return false;
+    }
+    buf_ring_size_ = count * sizeof(io_uring_buf);
+    void* ring = mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) {
+        error = "mmap buffer ring: " + std::string(strerror(errno));
+        return false;
+    }
+    buf_ring_ = static_cast<io_uring_buf_ring*>(ring);
+
+    io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+    reg.ring_entries = count;
+    reg.bgid = group;
+    if (sys_io_uring_register(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        error = "register buffer ring: " + std::string(strerror(errno));
+        return false;
+    }
+
+    buffers_size_ = static_cast<size_t>(count) * size;
+    void* buffers = mmap(nullptr, buffers_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffers == MAP_FAILED) {
+        error = "mmap buffers: " + std::string(strerror(errno));
+        return false;
+    }
+    buffers_ = static_cast<char*>(buffers);
+    buffer_count_ = count;
+    buffer_size_ = size;
+    for (unsigned i = 0; i < count; ++i) {
+        recycle_buffer(static_cast<uint16_t>(i));
+    }
+    return true;
+}
+
+void IoUring::recycle_buffer(uint16_t id) {
+    // C++下内核头文件的柔性数组前多出一个空结构体成员，bufs偏移不为0，
+    // 因此直接按io_uring_buf数组访问环，尾指针与首个条目的resv字段重叠
+    io_uring_buf* bufs = reinterpret_cast<io_uring_buf*>(buf_ring_);
+    io_uring_buf& buf = bufs[buf_tail_ & (buffer_count_ - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(buffer(id));
+    buf.len = buffer_size_;
+    buf.bid = id;
+    ++buf_tail_;
+    __atomic_store_n(&bufs[0].resv, buf_tail_, __ATOMIC_RELEASE);
+}
+
+io_uring_sqe* IoUring::get_sqe() {
+    if (sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+        submit(false, 0);
+        if (sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+            return nullptr;
+        }
+    }
+    io_uring_sqe* sqe = &sqes_[sqe_tail_ & *sq_mask_];
+    memset(sqe, 0, sizeof(*sqe));
+    ++sqe_tail_;
+    return sqe;
+}
+
+int IoUring::submit(bool wait, int timeout_ms) {
+    unsigned to_submit = sqe_tail_ - *sq_tail_;
+    __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+    if (to_submit == 0 && !wait) {
+        return 0;
+    }
+
+    unsigned flags = 0;
+    io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    __kernel_timespec ts{timeout_ms / 1000, (timeout_ms % 1000) * 1000000LL};
+    if (wait) {
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+    int ret = sys_io_uring_enter(ring_fd_, to_submit, wait ? 1 : 0, flags,
+                                 wait ? &arg : nullptr, wait ? sizeof(arg) : 0);
+    // 等待超时（ETIME）或被信号打断不是错误
+    if (ret < 0 && (errno == ETIME || errno == EINTR)) {
+        return 0;
+    }
+    return ret < 0 ? -errno : ret;
+}
+
+#endif // XKOJ_HAVE_IO_URING
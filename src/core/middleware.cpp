@@ -64,6 +64,17 @@ bool CorsMiddleware::process(const HttpRequest& request, HttpResponse& response)
     
     // 设置预检缓存时间
     if (request.method() == "OPTIONS") {
+        // 路由表已给出该路径的方法（Allow）时，只通告其中同时被配置允许的方法
+        if (response.has_header("Allow")) {
+            std::string allow = ", " + response.get_header("Allow") + ",";
+            std::string methods;
+            for (const auto& method : config_.allowed_methods) {
+                if (allow.find(" " + method + ",") != std::string::npos) {
+                    methods += (methods.empty() ? "" : ", ") + method;
+                }
+            }
+            response.set_header("Access-Control-Allow-Methods", methods);
+        }
         response.set_header("Access-Control-Max-Age", std::to_string(config_.max_age));
         response.set_status(HttpStatus::NO_CONTENT);
         return false;  // OPTIONS请求到此为止
@@ -244,7 +255,7 @@ bool StaticFileMiddleware::process(const HttpRequest& request, HttpResponse& res
         // 是目录
         std::string index_path = file_path + "/" + config_.index_file;
         if (stat(index_path.c_str(), &file_stat) == 0) {
-            serve_file(index_path, response);
+            serve_file(request, index_path, file_stat, response);
         } else if (config_.enable_directory_listing) {
             serve_directory(file_path, response);
         } else {
@@ -252,7 +263,7 @@ bool StaticFileMiddleware::process(const HttpRequest& request, HttpResponse& res
         }
     } else {
         // 是文件
-        serve_file(file_path, response);
+        serve_file(request, file_path, file_stat, response);
     }
     
     return false;  // 静态文件处理完成，不继续处理其他路由
@@ -281,27 +292,24 @@ bool StaticFileMiddleware::is_file_allowed(const std::string& file_path) const {
     return true;
 }
 
-void StaticFileMiddleware::serve_file(const std::string& file_path, HttpResponse& response) const {
-    std::ifstream file(file_path, std::ios::binary);
-    if (!file.is_open()) {
-        response.set_status(HttpStatus::INTERNAL_SERVER_ERROR);
+void StaticFileMiddleware::serve_file(const HttpRequest& request, const std::string& file_path,
+                                      const struct stat& file_stat, HttpResponse& response) const {
+    // 设置缓存头与校验器（由inode、大小和修改时间得出，无需读取内容）
+    response.set_status(HttpStatus::OK);
+    response.set_header("Cache-Control", "public, max-age=3600");
+    response.set_file_validators(file_stat);
+    // 客户端缓存仍然有效时直接回复304，不打开文件
+    if (response.evaluate_preconditions(request)) {
         return;
     }
     
-    std::string content((std::istreambuf_iterator<char>(file)),
-                       std::istreambuf_iterator<char>());
+    // 文件内容不读入内存，由服务器输出路径通过sendfile发送
+    if (!response.open_file_body(file_path)) {
+        response.set_status(HttpStatus::INTERNAL_SERVER_ERROR);
+        return;
+    }
     
-    response.set_status(HttpStatus::OK);
     response.set_header("Content-Type", get_mime_type(file_path));
-    response.set_body(content);
-    
-    // 设置缓存头
-    response.set_header("Cache-Control", "public, max-age=3600");
-    
-    // 设置ETag (简化实现)
-    std::hash<std::string> hasher;
-    std::string etag = "\"" + std::to_string(hasher(content)) + "\"";
-    response.set_header("ETag", etag);
 }
 
 void StaticFileMiddleware::serve_directory(const std::string& dir_path, HttpResponse& response) const {
@@ -0,0 +1,197 @@
+#include "core/router.h"
+#include "core/http_server.h"
+#include <limits>
+#include <vector>
+
+struct Router::Node {
+    std::string prefix;                          // 与父节点之间的静态文本
+    std::string indices;                         // 各静态子节点前缀的首字符，与children一一对应
+    std::vector<std::unique_ptr<Node>> children;
+    std::unique_ptr<Node> param;                 // :name，参数名保存在路由中
+    std::unique_ptr<Node> wildcard;              // 末尾的*
+    std::array<Route*, METHOD_COUNT> routes{};   // 按HttpMethod索引
+    uint16_t methods = 0;                        // 已注册方法的位掩码
+    std::string allow;                           // Allow头部值，注册时生成
+};
+
+namespace {
+// 与HttpMethod的声明顺序一致
+const char* const METHOD_NAMES[] = {"GET", "POST", "PUT", "DELETE", "PATCH", "OPTIONS", "HEAD", "TRACE", "CONNECT"};
+
+uint16_t method_bit(HttpMethod method) {
+    return static_cast<uint16_t>(1u << static_cast<unsigned>(method));
+}
+
+bool is_name_char(char c, bool first) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (!first && c >= '0' && c <= '9');
+}
+}
+
+Router::Router() : root_(std::make_unique<Node>()) {}
+Router::~Router() = default;
+
+Router::Node* Router::insert_static(Node* node, std::string_view text) {
+    while(!text.empty()) {
+        size_t index = node->indices.find(text[0]);
+        if(index == std::string::npos) {
+            auto child = std::make_unique<Node>();
+            child->prefix = std::string(text);
+            node->indices.push_back(text[0]);
+            node->children.push_back(std::move(child));
+            return node->children.back().get();
+        }
+        Node* child = node->children[index].get();
+        size_t common = 0;
+        while(common < child->prefix.size() && common < text.size() && child->prefix[common] == text[common]) {
+            ++common;
+        }
+        if(common < child->prefix.size()) {
+            // 在公共前缀处拆分：原子节点下移，保留其余部分
+            auto middle = std::make_unique<Node>();
+            middle->prefix = child->prefix.substr(0, common);
+            std::unique_ptr<Node> old = std::move(node->children[index]);
+            old->prefix.erase(0, common);
+            middle->indices.push_back(old->prefix[0]);
+            middle->children.push_back(std::move(old));
+            node->children[index] = std::move(middle);
+            child = node->children[index].get();
+        }
+        node = child;
+        text.remove_prefix(common);
+    }
+    return node;
+}
+
+bool Router::add(HttpMethod method, const std::string& path, Route* route) {
+    size_t method_index = static_cast<size_t>(method);
+    if(method_index >= METHOD_COUNT || path.empty()) {
+        return false;
+    }
+    Node* node = root_.get();
+    std::vector<std::string> names;
+    std::string_view rest(path);
+    while(!rest.empty()) {
+        if(rest[0] == ':') {
+            size_t end = 1;
+            while(end < rest.size() && is_name_char(rest[end], end == 1)) {
+                ++end;
+            }
+            // 参数值取到下一个'/'为止，参数之后同一段内不能再有静态文本
+            if(end == 1 || (end < rest.size() && rest[end] != '/')) {
+                return false;
+            }
+            names.emplace_back(rest.substr(1, end - 1));
+            if(!node->param) {
+                node->param = std::make_unique<Node>();
+            }
+            node = node->param.get();
+            rest.remove_prefix(end);
+        }
+        else if(rest[0] == '*') {
+            std::string_view name = rest.substr(1);
+            for(size_t i = 0; i < name.size(); ++i) {
+                if(!is_name_char(name[i], i == 0)) {
+                    return false;  // *只能出现在末尾
+                }
+            }
+            names.emplace_back(name.empty() ? "*" : name);
+            if(!node->wildcard) {
+                node->wildcard = std::make_unique<Node>();
+            }
+            node = node->wildcard.get();
+            rest = std::string_view();
+        }
+        else {
+            size_t end = rest.find_first_of(":*");
+            node = insert_static(node, rest.substr(0, end));
+            rest.remove_prefix(end == std::string_view::npos ? rest.size() : end);
+        }
+    }
+    if(names.size() > RouteParams::MAX_PARAMS || node->routes[method_index]) {
+        return false;
+    }
+    node->routes[method_index] = route;
+    node->methods |= method_bit(method);
+    route->param_names = std::move(names);
+    ++size_;
+
+    // GET隐含HEAD，OPTIONS总由服务器应答
+    uint16_t allowed = node->methods | method_bit(HttpMethod::OPTIONS);
+    if(node->routes[static_cast<size_t>(HttpMethod::GET)]) {
+        allowed |= method_bit(HttpMethod::HEAD);
+    }
+    node->allow.clear();
+    for(size_t i = 0; i < METHOD_COUNT; ++i) {
+        if(allowed & (1u << i)) {
+            if(!node->allow.empty()) {
+                node->allow += ", ";
+            }
+            node->allow += METHOD_NAMES[i];
+        }
+    }
+    return true;
+}
+
+const Router::Node* Router::match(const Node* node, const char* begin, std::string_view rest, uint16_t methods,
+                                  RouteParams& params) {
+    if(rest.empty() && (node->methods & methods)) {
+        return node;
+    }
+    if(!rest.empty()) {
+        size_t index = node->indices.find(rest[0]);
+        if(index != std::string::npos) {
+            const Node* child = node->children[index].get();
+            if(rest.compare(0, child->prefix.size(), child->prefix) == 0) {
+                if(const Node* found = match(child, begin, rest.substr(child->prefix.size()), methods, params)) {
+                    return found;
+                }
+            }
+        }
+        if(node->param && rest[0] != '/' && params.count < RouteParams::MAX_PARAMS) {
+            size_t end = std::min(rest.find('/'), rest.size());
+            params.items[params.count++] = {{}, static_cast<uint32_t>(rest.data() - begin), static_cast<uint32_t>(end)};
+            if(const Node* found = match(node->param.get(), begin, rest.substr(end), methods, params)) {
+                return found;
+            }
+            --params.count;
+        }
+    }
+    if(node->wildcard && (node->wildcard->methods & methods) && params.count < RouteParams::MAX_PARAMS) {
+        params.items[params.count++] = {{}, static_cast<uint32_t>(rest.data() - begin),
+                                        static_cast<uint32_t>(rest.size())};
+        return node->wildcard.get();
+    }
+    return nullptr;
+}
+
+Router::Match Router::lookup(HttpMethod method, std::string_view path, RouteParams& params) const {
+    Match result;
+    size_t method_index = static_cast<size_t>(method);
+    params.count = 0;
+    if(method_index >= METHOD_COUNT || path.size() > std::numeric_limits<uint32_t>::max()) {
+        return result;
+    }
+    uint16_t methods = method_bit(method);
+    if(method == HttpMethod::HEAD) {
+        methods |= method_bit(HttpMethod::GET);
+    }
+    const Node* node = match(root_.get(), path.data(), path, methods, params);
+    if(node) {
+        result.route = node->routes[method_index];
+        if(!result.route) {
+            result.route = node->routes[static_cast<size_t>(HttpMethod::GET)];
+        }
+        for(size_t i = 0; i < params.count; ++i) {
+            params.items[i].name = result.route->param_names[i];
+        }
+    }
+    else {
+        // 其他方法的路由：只用于405与OPTIONS，不提取参数
+        node = match(root_.get(), path.data(), path, static_cast<uint16_t>(~0u), params);
+        params.count = 0;
+    }
+    if(node) {
+        result.allow = &node->allow;
+    }
+    return result;
+}
@@ -0,0 +1,420 @@
+#include "core/static_cache.h"
+#include "core/compression.h"
+#include "core/http_response.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr uint32_t WATCH_MASK = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE |
+                                IN_DELETE_SELF | IN_MOVE_SELF | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+
+bool under(const std::string& path, const std::string& dir) {
+    return path.size() > dir.size() && path.compare(0, dir.size(), dir) == 0 && path[dir.size()] == '/';
+}
+}
+
+size_t StaticFileCache::Entry::bytes() const {
+    return sizeof(Entry) + file_path.size() + content_type.size() + etag.size() + (body ? body->size() : 0) +
+           (gzip_body ? gzip_body->size() : 0);
+}
+
+StaticFileCache::StaticFileCache(size_t budget, size_t max_file_size, int gzip_level)
+    : budget_(budget), max_file_size_(max_file_size), gzip_level_(gzip_level) {}
+
+StaticFileCache::~StaticFileCache() {
+    stop();
+}
+
+bool StaticFileCache::start() {
+    if(running_.load()) {
+        return true;
+    }
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(inotify_fd_ < 0 || wake_fd_ < 0) {
+        stop();
+        return false;
+    }
+    running_.store(true);
+    thread_ = std::thread([this]() { watch_loop(); });
+    return true;
+}
+
+void StaticFileCache::stop() {
+    if(running_.exchange(false)) {
+        uint64_t one = 1;
+        ssize_t ignored = write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+    }
+    if(thread_.joinable()) {
+        thread_.join();
+    }
+    if(inotify_fd_ >= 0) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+    if(wake_fd_ >= 0) {
+        close(wake_fd_);
+        wake_fd_ = -1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(watch_mutex_);
+        watches_.clear();
+        links_.clear();
+        roots_.clear();
+        configured_roots_.clear();
+    }
+    clear();
+}
+
+bool StaticFileCache::watch(const std::string& root) {
+    if(!running_.load()) {
+        return false;
+    }
+    char* real = realpath(root.c_str(), nullptr);
+    if(!real) {
+        return false;
+    }
+    std::string dir(real);
+    free(real);
+    std::lock_guard<std::mutex> lock(watch_mutex_);
+    // 路径中的符号链接（如部署时切换的current）改指向时重新解析
+    watch_links(root);
+    if(std::find(configured_roots_.begin(), configured_roots_.end(), root) == configured_roots_.end()) {
+        configured_roots_.push_back(root);
+    }
+    for(const auto& existing : roots_) {
+        if(dir == existing || under(dir, existing)) {
+            return true;
+        }
+    }
+    watch_tree(dir);
+    roots_.push_back(dir);
+    for(const auto& [wd, path] : watches_) {
+        if(path == dir) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void StaticFileCache::watch_tree(const std::string& dir) {
+    // inotify不递归，每个子目录单独监视；符号链接指向的目录不跟随，其中的文件也不会被缓存
+    int wd = inotify_add_watch(inotify_fd_, dir.c_str(), WATCH_MASK);
+    if(wd < 0) {
+        return;
+    }
+    watches_[wd] = dir;
+    DIR* d = opendir(dir.c_str());
+    if(!d) {
+        return;
+    }
+    while(dirent* entry = readdir(d)) {
+        std::string name = entry->d_name;
+        if(name == "." || name == "..") {
+            continue;
+        }
+        std::string child = dir + "/" + name;
+        bool is_dir = entry->d_type == DT_DIR;
+        if(entry->d_type == DT_UNKNOWN) {
+            struct stat st;
+            is_dir = lstat(child.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+        }
+        if(is_dir) {
+            watch_tree(child);
+        }
+    }
+    closedir(d);
+}
+
+void StaticFileCache::watch_links(const std::string& root) {
+    // 对路径中每个符号链接监视其所在目录，以便在链接被替换时收到事件；调用方持有watch_mutex_
+    std::string path = root;
+    if(path.empty() || path[0] != '/') {
+        char* cwd = getcwd(nullptr, 0);
+        if(!cwd) {
+            return;
+        }
+        path = std::string(cwd) + "/" + path;
+        free(cwd);
+    }
+    for(size_t end = path.find('/', 1); ; end = path.find('/', end + 1)) {
+        std::string prefix = path.substr(0, end);
+        size_t slash = prefix.rfind('/');
+        std::string name = prefix.substr(slash + 1);
+        struct stat st;
+        if(!name.empty() && name != "." && name != ".." && lstat(prefix.c_str(), &st) == 0 && S_ISLNK(st.st_mode)) {
+            char* parent = realpath(slash == 0 ? "/" : prefix.substr(0, slash).c_str(), nullptr);
+            if(parent) {
+                int wd = inotify_add_watch(inotify_fd_, parent, WATCH_MASK);
+                if(wd >= 0) {
+                    links_[wd].insert(name);
+                }
+                free(parent);
+            }
+        }
+        if(end == std::string::npos) {
+            break;
+        }
+    }
+}
+
+void StaticFileCache::rewatch_roots() {
+    // 符号链接改指向后重新解析各根目录：监视新的目录树，移除不再属于任何根目录的监视，清空缓存
+    {
+        std::lock_guard<std::mutex> lock(watch_mutex_);
+        std::vector<std::string> roots;
+        for(const auto& root : configured_roots_) {
+            watch_links(root);
+            char* real = realpath(root.c_str(), nullptr);
+            if(real) {
+                roots.emplace_back(real);
+                free(real);
+            }
+        }
+        auto covered = [&roots](const std::string& path) {
+            for(const auto& root : roots) {
+                if(path == root || under(path, root)) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        for(auto w = watches_.begin(); w != watches_.end();) {
+            if(!covered(w->second)) {
+                inotify_rm_watch(inotify_fd_, w->first);
+                w = watches_.erase(w);
+            }
+            else {
+                ++w;
+            }
+        }
+        for(const auto& root : roots) {
+            if(std::find(roots_.begin(), roots_.end(), root) == roots_.end()) {
+                watch_tree(root);
+            }
+        }
+        roots_ = std::move(roots);
+    }
+    clear();
+}
+
+bool StaticFileCache::watched(const std::string& real_path) {
+    // 文件所在目录必须已被监视（子目录的监视可能因inotify数量上限而失败）
+    std::string dir = real_path.substr(0, real_path.rfind('/'));
+    std::lock_guard<std::mutex> lock(watch_mutex_);
+    for(const auto& [wd, path] : watches_) {
+        if(path == dir) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::shared_ptr<const StaticFileCache::Entry> StaticFileCache::find(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if(it == index_.end()) {
+        stats_.misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    stats_.hits.fetch_add(1, std::memory_order_relaxed);
+    return it->second->second;
+}
+
+std::shared_ptr<const StaticFileCache::Entry> StaticFileCache::load(const std::string& key,
+                                                                    const std::string& file_path,
+                                                                    const std::string& content_type) {
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        generation = generation_;
+    }
+    int fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || static_cast<size_t>(st.st_size) > max_file_size_) {
+        close(fd);
+        return nullptr;
+    }
+    // inotify事件按实际路径报告，条目记录解析后的路径；不在监视目录树中的文件（如指向外部的符号链接）不缓存
+    char* real = realpath(file_path.c_str(), nullptr);
+    std::string real_path = real ? real : "";
+    free(real);
+    if(real_path.empty() || !watched(real_path)) {
+        close(fd);
+        return nullptr;
+    }
+
+    std::string content(static_cast<size_t>(st.st_size), '\0');
+    size_t total = 0;
+    while(total < content.size()) {
+        ssize_t n = read(fd, &content[total], content.size() - total);
+        if(n < 0 && errno == EINTR) {
+            continue;
+        }
+        if(n <= 0) {
+            break;
+        }
+        total += n;
+    }
+    close(fd);
+    content.resize(total);
+
+    auto entry = std::make_shared<Entry>();
+    entry->file_path = real_path;
+    entry->content_type = content_type;
+    entry->etag = HttpResponse::file_etag(st);
+    entry->mtime = st.st_mtime;
+    std::string gzip;
+    if(gzip_level_ > 0 && compression::compressible_type(content_type) &&
+       compression::compress(ContentCoding::GZIP, gzip_level_, content, gzip)) {
+        entry->gzip_body = std::make_shared<const std::string>(std::move(gzip));
+    }
+    entry->body = std::make_shared<const std::string>(std::move(content));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(generation != generation_ || entry->bytes() > budget_) {
+        return entry;
+    }
+    auto it = index_.find(key);
+    if(it != index_.end()) {
+        // 并发载入同一文件，保留后到的
+        resident_ -= it->second->second->bytes();
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+    lru_.emplace_front(key, entry);
+    index_[key] = lru_.begin();
+    resident_ += entry->bytes();
+    evict_locked();
+    stats_.resident_bytes.store(resident_, std::memory_order_relaxed);
+    stats_.entries.store(index_.size(), std::memory_order_relaxed);
+    return entry;
+}
+
+void StaticFileCache::evict_locked() {
+    while(resident_ > budget_ && !lru_.empty()) {
+        resident_ -= lru_.back().second->bytes();
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+        stats_.evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void StaticFileCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    lru_.clear();
+    index_.clear();
+    resident_ = 0;
+    stats_.resident_bytes.store(0, std::memory_order_relaxed);
+    stats_.entries.store(0, std::memory_order_relaxed);
+}
+
+void StaticFileCache::invalidate(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    for(auto it = lru_.begin(); it != lru_.end();) {
+        const std::string& file = it->second->file_path;
+        if(file == path || under(file, path)) {
+            resident_ -= it->second->bytes();
+            index_.erase(it->first);
+            it = lru_.erase(it);
+            stats_.invalidations.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+            ++it;
+        }
+    }
+    stats_.resident_bytes.store(resident_, std::memory_order_relaxed);
+    stats_.entries.store(index_.size(), std::memory_order_relaxed);
+}
+
+void StaticFileCache::watch_loop() {
+    pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+    alignas(inotify_event) char buf[16384];
+    while(running_.load()) {
+        if(poll(fds, 2, -1) < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if(fds[0].revents & POLLIN) {
+            ssize_t len;
+            while((len = read(inotify_fd_, buf, sizeof(buf))) > 0) {
+                handle_events(buf, static_cast<size_t>(len));
+            }
+        }
+    }
+}
+
+void StaticFileCache::handle_events(const char* buf, size_t len) {
+    for(size_t offset = 0; offset < len;) {
+        const auto* event = reinterpret_cast<const inotify_event*>(buf + offset);
+        offset += sizeof(inotify_event) + event->len;
+        if(event->mask & IN_Q_OVERFLOW) {
+            clear();  // 丢失了事件，无法判断哪些条目仍然有效
+            continue;
+        }
+        std::string path;
+        bool relinked = false;
+        {
+            std::lock_guard<std::mutex> lock(watch_mutex_);
+            // 同一目录可能既在目录树中又含有根目录路径上的符号链接，两种监视共用一个wd
+            auto link = links_.find(event->wd);
+            if(link != links_.end()) {
+                relinked = event->len > 0 && link->second.count(event->name) > 0;
+                if(event->mask & IN_IGNORED) {
+                    links_.erase(link);
+                }
+            }
+            auto it = watches_.find(event->wd);
+            if(it != watches_.end() && (event->mask & IN_IGNORED)) {
+                watches_.erase(it);
+            }
+            else if(it != watches_.end()) {
+                path = it->second;
+                if(event->len > 0) {
+                    path += "/";
+                    path += event->name;
+                }
+                if(event->mask & IN_ISDIR) {
+                    // 目录移走后其下的监视仍以旧路径登记，一并移除；新出现的目录加入监视
+                    if(event->mask & (IN_MOVED_FROM | IN_DELETE)) {
+                        for(auto w = watches_.begin(); w != watches_.end();) {
+                            if(w->second == path || under(w->second, path)) {
+                                inotify_rm_watch(inotify_fd_, w->first);
+                                w = watches_.erase(w);
+                            }
+                            else {
+                                ++w;
+                            }
+                        }
+                    }
+                    if(event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        watch_tree(path);
+                    }
+                }
+            }
+        }
+        if(relinked) {
+            rewatch_roots();
+        }
+        else if(!path.empty()) {
+            invalidate(path);
+        }
+    }
+}
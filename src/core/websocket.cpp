@@ -0,0 +1,793 @@
+#include "core/websocket.h"
+#include "core/http_request.h"
+#include "core/http_response.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef XKOJ_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+// WebSocket（RFC 6455）与permessage-deflate（RFC 7692）
+
+static const char WEBSOCKET_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+static const size_t DEFLATE_MIN_SIZE = 64;  // 更短的消息压缩收益抵不过开销
+
+// 握手只需要对一个短字符串做SHA-1，不为此引入加密库
+static void sha1(const std::string& input, unsigned char digest[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    std::string msg = input;
+    uint64_t bit_len = static_cast<uint64_t>(input.size()) * 8;
+    msg.push_back(static_cast<char>(0x80));
+    while(msg.size() % 64 != 56) {
+        msg.push_back('\0');
+    }
+    for(int i = 7; i >= 0; --i) {
+        msg.push_back(static_cast<char>(bit_len >> (i * 8)));
+    }
+    auto rol = [](uint32_t x, int n) { return (x << n) | (x >> (32 - n)); };
+    for(size_t off = 0; off < msg.size(); off += 64) {
+        const unsigned char* block = reinterpret_cast<const unsigned char*>(msg.data() + off);
+        uint32_t w[80];
+        for(int i = 0; i < 16; ++i) {
+            w[i] = static_cast<uint32_t>(block[i * 4]) << 24 | static_cast<uint32_t>(block[i * 4 + 1]) << 16 |
+                   static_cast<uint32_t>(block[i * 4 + 2]) << 8 | block[i * 4 + 3];
+        }
+        for(int i = 16; i < 80; ++i) {
+            w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for(int i = 0; i < 80; ++i) {
+            uint32_t f, k;
+            if(i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            }
+            else if(i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if(i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t t = rol(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rol(b, 30);
+            b = a;
+            a = t;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+    for(int i = 0; i < 5; ++i) {
+        for(int j = 0; j < 4; ++j) {
+            digest[i * 4 + j] = static_cast<unsigned char>(h[i] >> (24 - j * 8));
+        }
+    }
+}
+
+static std::string base64_encode(const unsigned char* data, size_t len) {
+    static const char TABLE[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((len + 2) / 3 * 4);
+    for(size_t i = 0; i < len; i += 3) {
+        uint32_t n = static_cast<uint32_t>(data[i]) << 16;
+        if(i + 1 < len) n |= static_cast<uint32_t>(data[i + 1]) << 8;
+        if(i + 2 < len) n |= data[i + 2];
+        out.push_back(TABLE[(n >> 18) & 63]);
+        out.push_back(TABLE[(n >> 12) & 63]);
+        out.push_back(i + 1 < len ? TABLE[(n >> 6) & 63] : '=');
+        out.push_back(i + 2 < len ? TABLE[n & 63] : '=');
+    }
+    return out;
+}
+
+// Sec-WebSocket-Key必须是16字节随机数的base64编码
+static bool valid_websocket_key(const std::string& key) {
+    if(key.size() != 24 || key.compare(22, 2, "==") != 0) {
+        return false;
+    }
+    for(size_t i = 0; i < 22; ++i) {
+        char c = key[i];
+        if(!isalnum(static_cast<unsigned char>(c)) && c != '+' && c != '/') {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string trim(std::string_view s) {
+    size_t b = s.find_first_not_of(" \t");
+    if(b == std::string_view::npos) {
+        return {};
+    }
+    size_t e = s.find_last_not_of(" \t");
+    return std::string(s.substr(b, e - b + 1));
+}
+
+static bool valid_close_code(uint16_t code) {
+    return (code >= 1000 && code <= 1014 && code != 1004 && code != 1005 && code != 1006) ||
+           (code >= 3000 && code <= 4999);
+}
+
+#ifdef XKOJ_HAVE_ZLIB
+// 每个线程一个压缩上下文，每条消息前重置（server_no_context_takeover），压缩结果与连接无关
+struct DeflateContext {
+    z_stream zs{};
+    bool ok = false;
+    DeflateContext() {
+        ok = deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+    ~DeflateContext() {
+        if(ok) {
+            deflateEnd(&zs);
+        }
+    }
+};
+
+static bool deflate_message(std::string_view in, std::string& out) {
+    thread_local DeflateContext ctx;
+    if(!ctx.ok) {
+        return false;
+    }
+    z_stream& zs = ctx.zs;
+    deflateReset(&zs);
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in = static_cast<uInt>(in.size());
+    out.resize(in.size() / 2 + 64);
+    size_t total = 0;
+    int ret;
+    do {
+        if(total == out.size()) {
+            out.resize(out.size() * 2);
+        }
+        zs.next_out = reinterpret_cast<Bytef*>(&out[total]);
+        zs.avail_out = static_cast<uInt>(out.size() - total);
+        ret = deflate(&zs, Z_SYNC_FLUSH);
+        total = out.size() - zs.avail_out;
+    } while(ret == Z_OK && zs.avail_out == 0);
+    if(ret != Z_OK || zs.avail_in != 0) {
+        return false;
+    }
+    // 去掉同步刷新产生的空块结尾 00 00 ff ff（RFC 7692 7.2.1）
+    if(total >= 4 && memcmp(&out[total - 4], "\x00\x00\xff\xff", 4) == 0) {
+        total -= 4;
+    }
+    out.resize(total);
+    return true;
+}
+
+struct WebSocket::Inflater {
+    z_stream zs{};
+    bool ok = false;
+    Inflater() { ok = inflateInit2(&zs, -MAX_WBITS) == Z_OK; }
+    ~Inflater() {
+        if(ok) {
+            inflateEnd(&zs);
+        }
+    }
+};
+
+// 返回0表示成功，否则为应回复的关闭码；解压结果超过limit时停止，防止压缩炸弹
+static uint16_t inflate_message(z_stream& zs, std::string& in, std::string& out, size_t limit) {
+    in.append("\x00\x00\xff\xff", 4);
+    zs.next_in = reinterpret_cast<Bytef*>(&in[0]);
+    zs.avail_in = static_cast<uInt>(in.size());
+    size_t total = 0;
+    out.clear();
+    while(true) {
+        if(total == out.size()) {
+            if(out.size() >= limit) {
+                return WebSocket::MESSAGE_TOO_BIG;
+            }
+            out.resize(std::min(limit, std::max<size_t>(out.size() * 2, 16384)));
+        }
+        zs.next_out = reinterpret_cast<Bytef*>(&out[total]);
+        zs.avail_out = static_cast<uInt>(out.size() - total);
+        int ret = inflate(&zs, Z_SYNC_FLUSH);
+        total = out.size() - zs.avail_out;
+        if(ret == Z_STREAM_END) {
+            // 客户端结束了deflate流（BFINAL），下一条消息从新流开始
+            inflateReset(&zs);
+            break;
+        }
+        if(ret != Z_OK && ret != Z_BUF_ERROR) {
+            return WebSocket::INVALID_DATA;
+        }
+        if(zs.avail_in == 0 && zs.avail_out > 0) {
+            break;
+        }
+        if(ret == Z_BUF_ERROR && zs.avail_out > 0) {
+            return WebSocket::INVALID_DATA;
+        }
+    }
+    out.resize(total);
+    return 0;
+}
+#else
+struct WebSocket::Inflater {};
+#endif
+
+WebSocketFrameParser::Result WebSocketFrameParser::parse(std::string_view in, size_t& consumed, Frame& frame) {
+    consumed = 0;
+    if(in.size() < 2) {
+        return Result::INCOMPLETE;
+    }
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(in.data());
+    uint8_t opcode = p[0] & 0x0F;
+    bool control = (opcode & 0x08) != 0;
+    bool masked = (p[1] & 0x80) != 0;
+    uint64_t length = p[1] & 0x7F;
+    // RSV2/RSV3未经协商不得使用；3-7与0xB-0xF为保留操作码；控制帧不得分片且不超过125字节
+    if((p[0] & 0x30) || (opcode > 0x2 && opcode < 0x8) || opcode > 0xA ||
+       (control && (!(p[0] & 0x80) || length > 125)) || (require_mask_ && !masked)) {
+        close_code_ = 1002;
+        return Result::ERROR;
+    }
+    size_t header = 2;
+    if(length == 126) {
+        if(in.size() < 4) {
+            return Result::INCOMPLETE;
+        }
+        length = static_cast<uint64_t>(p[2]) << 8 | p[3];
+        header = 4;
+    }
+    else if(length == 127) {
+        if(in.size() < 10) {
+            return Result::INCOMPLETE;
+        }
+        length = 0;
+        for(int i = 2; i < 10; ++i) {
+            length = length << 8 | p[i];
+        }
+        if(length >> 63) {
+            close_code_ = 1002;
+            return Result::ERROR;
+        }
+        header = 10;
+    }
+    if(length > max_payload_) {
+        close_code_ = 1009;
+        return Result::ERROR;
+    }
+    size_t mask_offset = header;
+    if(masked) {
+        header += 4;
+    }
+    if(in.size() - header < length || in.size() < header) {
+        return Result::INCOMPLETE;
+    }
+
+    frame.fin = (p[0] & 0x80) != 0;
+    frame.rsv1 = (p[0] & 0x40) != 0;
+    frame.opcode = opcode;
+    frame.payload.assign(in.data() + header, length);
+    if(masked) {
+        const unsigned char* key = p + mask_offset;
+        char* data = &frame.payload[0];
+        for(size_t i = 0; i < length; ++i) {
+            data[i] ^= key[i & 3];
+        }
+    }
+    consumed = header + length;
+    return Result::FRAME;
+}
+
+WebSocket::WebSocket(HttpServer& server, HttpServer::Connection& conn, uint64_t sequence,
+                     std::string path, const Options& options)
+    : server_(server), conn_(conn.weak_from_this()), sequence_(sequence), path_(std::move(path)),
+      options_(options), parser_(options.max_message_size) {
+#ifdef XKOJ_HAVE_ZLIB
+    if(options_.deflate) {
+        inflater_ = std::make_unique<Inflater>();
+    }
+#endif
+}
+
+WebSocket::~WebSocket() = default;
+
+std::string WebSocket::encode_frame(uint8_t opcode, std::string_view payload, bool rsv1) {
+    std::string frame;
+    frame.reserve(payload.size() + 10);
+    frame.push_back(static_cast<char>(0x80 | (rsv1 ? 0x40 : 0) | opcode));
+    if(payload.size() < 126) {
+        frame.push_back(static_cast<char>(payload.size()));
+    }
+    else if(payload.size() <= 0xFFFF) {
+        frame.push_back(static_cast<char>(126));
+        frame.push_back(static_cast<char>(payload.size() >> 8));
+        frame.push_back(static_cast<char>(payload.size()));
+    }
+    else {
+        frame.push_back(static_cast<char>(127));
+        for(int i = 7; i >= 0; --i) {
+            frame.push_back(static_cast<char>(static_cast<uint64_t>(payload.size()) >> (i * 8)));
+        }
+    }
+    frame.append(payload);
+    return frame;
+}
+
+bool WebSocket::valid_utf8(std::string_view data) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data());
+    size_t n = data.size();
+    size_t i = 0;
+    while(i < n) {
+        // ASCII占绝大多数（JSON），每次跳过8字节
+        if(i + 8 <= n) {
+            uint64_t word;
+            memcpy(&word, p + i, 8);
+            if((word & 0x8080808080808080ULL) == 0) {
+                i += 8;
+                continue;
+            }
+        }
+        unsigned char c = p[i];
+        if(c < 0x80) {
+            ++i;
+            continue;
+        }
+        size_t len;
+        uint32_t cp;
+        if((c & 0xE0) == 0xC0) {
+            len = 2;
+            cp = c & 0x1F;
+        }
+        else if((c & 0xF0) == 0xE0) {
+            len = 3;
+            cp = c & 0x0F;
+        }
+        else if((c & 0xF8) == 0xF0) {
+            len = 4;
+            cp = c & 0x07;
+        }
+        else {
+            return false;
+        }
+        if(i + len > n) {
+            return false;
+        }
+        for(size_t j = 1; j < len; ++j) {
+            if((p[i + j] & 0xC0) != 0x80) {
+                return false;
+            }
+            cp = cp << 6 | (p[i + j] & 0x3F);
+        }
+        // 过长编码、代理项与超出Unicode范围的码点均无效
+        if((len == 2 && cp < 0x80) || (len == 3 && cp < 0x800) || (len == 4 && (cp < 0x10000 || cp > 0x10FFFF)) ||
+           (cp >= 0xD800 && cp <= 0xDFFF)) {
+            return false;
+        }
+        i += len;
+    }
+    return true;
+}
+
+std::shared_ptr<const WebSocket::Message> WebSocket::prepare(std::string_view data, bool binary) {
+    auto message = std::make_shared<Message>();
+    uint8_t opcode = binary ? BINARY : TEXT;
+    message->frame = std::make_shared<const std::string>(encode_frame(opcode, data));
+#ifdef XKOJ_HAVE_ZLIB
+    std::string compressed;
+    if(data.size() >= DEFLATE_MIN_SIZE && deflate_message(data, compressed) && compressed.size() < data.size()) {
+        message->deflated_frame = std::make_shared<const std::string>(encode_frame(opcode, compressed, true));
+    }
+#endif
+    return message;
+}
+
+bool WebSocket::send_text(std::string_view data) {
+    return send_message(TEXT, data);
+}
+
+bool WebSocket::send_binary(std::string_view data) {
+    return send_message(BINARY, data);
+}
+
+bool WebSocket::send_message(uint8_t opcode, std::string_view data) {
+#ifdef XKOJ_HAVE_ZLIB
+    if(options_.deflate && data.size() >= DEFLATE_MIN_SIZE) {
+        std::string compressed;
+        if(deflate_message(data, compressed) && compressed.size() < data.size()) {
+            return send_frame(HttpServer::OutputChunk(encode_frame(opcode, compressed, true)));
+        }
+    }
+#endif
+    return send_frame(HttpServer::OutputChunk(encode_frame(opcode, data)));
+}
+
+bool WebSocket::send(const std::shared_ptr<const Message>& message) {
+    if(options_.deflate && message->deflated_frame) {
+        return send_frame(HttpServer::OutputChunk(message->deflated_frame));
+    }
+    return send_frame(HttpServer::OutputChunk(message->frame));
+}
+
+bool WebSocket::ping(std::string_view payload) {
+    if(payload.size() > 125) {
+        return false;
+    }
+    return send_frame(HttpServer::OutputChunk(encode_frame(PING, payload)));
+}
+
+bool WebSocket::send_frame(HttpServer::OutputChunk frame) {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    auto conn = conn_.lock();
+    if(close_sent_ || !conn) {
+        return false;
+    }
+    std::vector<HttpServer::OutputChunk> chunks;
+    chunks.push_back(std::move(frame));
+    return server_.push_output(*conn, sequence_, std::move(chunks));
+}
+
+void WebSocket::close(uint16_t code, std::string_view reason) {
+    send_close(code, reason.substr(0, 123), false);
+}
+
+bool WebSocket::is_open() const {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    auto conn = conn_.lock();
+    return conn && !conn->closed.load() && !close_sent_;
+}
+
+void WebSocket::send_close(uint16_t code, std::string_view reason, bool close_after) {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    auto conn = conn_.lock();
+    if(!conn) {
+        return;
+    }
+    if(close_sent_) {
+        // 本端先发起的关闭握手已完成
+        if(close_after) {
+            server_.close_connection(*conn);
+        }
+        return;
+    }
+    close_sent_ = true;
+    std::string payload;
+    payload.push_back(static_cast<char>(code >> 8));
+    payload.push_back(static_cast<char>(code));
+    payload.append(reason);
+    std::vector<HttpServer::OutputChunk> chunks;
+    chunks.emplace_back(encode_frame(CLOSE, payload));
+    // 作为101响应的结束：此后in_flight归零，等待对端关闭帧期间受keep_alive_timeout约束
+    server_.enqueue_output(*conn, sequence_, std::move(chunks), true, close_after);
+}
+
+void WebSocket::fail(uint16_t code) {
+    close_code_ = code;
+    close_reason_.clear();
+    send_close(code, {}, true);
+}
+
+bool WebSocket::receive(std::string& buffer, std::vector<std::pair<std::string, bool>>& messages) {
+    size_t offset = 0;
+    bool reading = true;
+    WebSocketFrameParser::Frame frame;
+    while(reading) {
+        size_t consumed = 0;
+        auto result = parser_.parse(std::string_view(buffer).substr(offset), consumed, frame);
+        if(result == WebSocketFrameParser::Result::INCOMPLETE) {
+            break;
+        }
+        if(result == WebSocketFrameParser::Result::ERROR) {
+            fail(parser_.close_code());
+            reading = false;
+            break;
+        }
+        offset += consumed;
+
+        // 控制帧可以插在分片消息中间
+        if(frame.opcode == PING) {
+            send_frame(HttpServer::OutputChunk(encode_frame(PONG, frame.payload)));
+            continue;
+        }
+        if(frame.opcode == PONG) {
+            continue;
+        }
+        if(frame.opcode == CLOSE) {
+            uint16_t code = NO_STATUS;
+            std::string_view reason;
+            if(frame.payload.size() >= 2) {
+                code = static_cast<uint16_t>(static_cast<unsigned char>(frame.payload[0]) << 8 |
+                                             static_cast<unsigned char>(frame.payload[1]));
+                reason = std::string_view(frame.payload).substr(2);
+            }
+            if(frame.payload.size() == 1 || (code != NO_STATUS && !valid_close_code(code))) {
+                fail(PROTOCOL_ERROR);
+            }
+            else if(!valid_utf8(reason)) {
+                fail(INVALID_DATA);
+            }
+            else {
+                close_code_ = code;
+                close_reason_.assign(reason);
+                send_close(code == NO_STATUS ? NORMAL_CLOSURE : code, {}, true);
+            }
+            reading = false;
+            break;
+        }
+
+        // 数据帧：第一帧决定消息类型与是否压缩，后续为CONTINUATION
+        if(frame.opcode == CONTINUATION) {
+            if(message_opcode_ == 0 || frame.rsv1) {
+                fail(PROTOCOL_ERROR);
+                reading = false;
+                break;
+            }
+        }
+        else {
+            if(message_opcode_ != 0 || (frame.rsv1 && !options_.deflate)) {
+                fail(PROTOCOL_ERROR);
+                reading = false;
+                break;
+            }
+            message_opcode_ = frame.opcode;
+            message_deflated_ = frame.rsv1;
+            message_.clear();
+        }
+        if(message_.size() + frame.payload.size() > options_.max_message_size) {
+            fail(MESSAGE_TOO_BIG);
+            reading = false;
+            break;
+        }
+        if(message_.empty()) {
+            message_.swap(frame.payload);
+        }
+        else {
+            message_.append(frame.payload);
+        }
+        if(frame.fin && !finish_message(messages)) {
+            reading = false;
+            break;
+        }
+    }
+    buffer.erase(0, offset);
+    return reading;
+}
+
+bool WebSocket::finish_message(std::vector<std::pair<std::string, bool>>& messages) {
+    uint8_t opcode = message_opcode_;
+    message_opcode_ = 0;
+    std::string data;
+#ifdef XKOJ_HAVE_ZLIB
+    if(message_deflated_) {
+        uint16_t code = inflater_ && inflater_->ok ?
+            inflate_message(inflater_->zs, message_, data, options_.max_message_size) : INTERNAL_ERROR;
+        if(code != 0) {
+            fail(code);
+            return false;
+        }
+        if(options_.client_no_context_takeover) {
+            inflateReset(&inflater_->zs);
+        }
+        message_.clear();
+    }
+    else
+#endif
+    {
+        data.swap(message_);
+    }
+    if(opcode == TEXT && !valid_utf8(data)) {
+        fail(INVALID_DATA);
+        return false;
+    }
+    server_.stats_.total_websocket_messages.fetch_add(1);
+    messages.emplace_back(std::move(data), opcode == BINARY);
+    return true;
+}
+
+void WebSocket::notify_closed() {
+    if(close_notified_.exchange(true)) {
+        return;
+    }
+    CloseHandler handler = std::move(close_handler_);
+    if(handler) {
+        try {
+            handler(*this, close_code_, close_reason_);
+        }
+        catch(const std::exception& e) {
+            server_.log("ERROR", "Exception in WebSocket close handler: " + std::string(e.what()));
+        }
+    }
+}
+
+// HttpServer中与WebSocket相关的部分
+
+#ifdef XKOJ_HAVE_ZLIB
+// 逐个检查客户端提出的permessage-deflate参数组合，接受第一个能满足的；
+// 服务端始终不保留压缩上下文，因此要求服务端窗口小于15位的提议被拒绝
+static bool negotiate_deflate(const std::string& header, WebSocket::Options& options, std::string& response) {
+    size_t start = 0;
+    while(start < header.size()) {
+        size_t end = header.find(',', start);
+        if(end == std::string::npos) {
+            end = header.size();
+        }
+        std::string_view offer(header.data() + start, end - start);
+        start = end + 1;
+
+        size_t semi = offer.find(';');
+        if(trim(offer.substr(0, semi)) != "permessage-deflate") {
+            continue;
+        }
+        bool acceptable = true;
+        bool client_no_context_takeover = false;
+        std::vector<std::string> seen;
+        while(semi != std::string_view::npos && acceptable) {
+            offer.remove_prefix(semi + 1);
+            semi = offer.find(';');
+            std::string param = trim(offer.substr(0, semi));
+            size_t eq = param.find('=');
+            std::string name = trim(std::string_view(param).substr(0, eq));
+            std::string value = eq == std::string::npos ? "" : trim(std::string_view(param).substr(eq + 1));
+            if(value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+                value = value.substr(1, value.size() - 2);
+            }
+            if(std::find(seen.begin(), seen.end(), name) != seen.end()) {
+                acceptable = false;  // 参数重复
+                break;
+            }
+            seen.push_back(name);
+            if(name == "server_no_context_takeover") {
+                acceptable = value.empty();
+            }
+            else if(name == "client_no_context_takeover") {
+                acceptable = value.empty();
+                client_no_context_takeover = true;
+            }
+            else if(name == "server_max_window_bits") {
+                acceptable = value == "15";
+            }
+            else if(name == "client_max_window_bits") {
+                // 解压窗口总是15位，可以接受客户端使用任意窗口
+                acceptable = value.empty() || (value.size() <= 2 && atoi(value.c_str()) >= 8 &&
+                                               atoi(value.c_str()) <= 15);
+            }
+            else {
+                acceptable = false;
+            }
+        }
+        if(!acceptable) {
+            continue;
+        }
+        options.deflate = true;
+        options.client_no_context_takeover = client_no_context_takeover;
+        response = "permessage-deflate; server_no_context_takeover";
+        if(client_no_context_takeover) {
+            response += "; client_no_context_takeover";
+        }
+        return true;
+    }
+    return false;
+}
+#endif
+
+std::shared_ptr<WebSocket> HttpServer::accept_websocket(const HttpRequest& request, HttpResponse& response) {
+    // 只有经handle_request分发的HTTP/1.1响应才挂有连接上的流，HTTP/2的流不能转为长连接推送
+    auto* stream = dynamic_cast<ConnectionResponseStream*>(response.stream());
+    if(!stream) {
+        return nullptr;
+    }
+    std::string key = request.get_header("Sec-WebSocket-Key");
+    if(request.method() != "GET" || request.version() != "HTTP/1.1" ||
+       !HttpServer::header_has_token(request.get_header("Upgrade"), "websocket") ||
+       !HttpServer::header_has_token(request.get_header("Connection"), "upgrade") || !valid_websocket_key(key)) {
+        response.set_status(HttpStatus::BAD_REQUEST);
+        response.text("Invalid WebSocket handshake");
+        return nullptr;
+    }
+    if(request.get_header("Sec-WebSocket-Version") != "13") {
+        response.set_status(HttpStatus::UPGRADE_REQUIRED);
+        response.set_header("Sec-WebSocket-Version", "13");
+        response.text("Unsupported WebSocket version");
+        return nullptr;
+    }
+
+    WebSocket::Options options;
+    options.max_message_size = config_.max_request_size;
+    std::string extensions;
+#ifdef XKOJ_HAVE_ZLIB
+    if(config_.websocket_deflate) {
+        negotiate_deflate(request.get_header("Sec-WebSocket-Extensions"), options, extensions);
+    }
+#endif
+
+    unsigned char digest[20];
+    sha1(key + WEBSOCKET_GUID, digest);
+    response.set_status(HttpStatus::SWITCHING_PROTOCOLS);
+    response.remove_header("Content-Type");
+    response.remove_header("Content-Length");
+    response.set_header("Upgrade", "websocket");
+    response.set_header("Connection", "Upgrade");
+    response.set_header("Sec-WebSocket-Accept", base64_encode(digest, sizeof(digest)));
+    if(!extensions.empty()) {
+        response.set_header("Sec-WebSocket-Extensions", extensions);
+    }
+
+    Connection& conn = stream->connection();
+    auto ws = std::make_shared<WebSocket>(*this, conn, stream->sequence(), request.path(), options);
+    if(!stream->upgrade(response)) {
+        return nullptr;
+    }
+    // 处理器返回后，持有者按帧解析此后的字节（collect_requests已在升级请求处停止解析）
+    conn.websocket = ws;
+    conn.upgraded = true;
+    stats_.total_websocket_upgrades.fetch_add(1);
+    return ws;
+}
+
+void HttpServer::websocket(const std::string& path, WebSocketHandler handler) {
+    get(path, [this, handler = std::move(handler)](const HttpRequest& request, HttpResponse& response) {
+        if(auto ws = accept_websocket(request, response)) {
+            handler(request, ws);
+        }
+    });
+}
+
+void HttpServer::handle_websocket(Connection& conn) {
+    // 持有者线程：读取并解析帧，释放io_mutex后依次调用消息回调，回调中可直接发送
+    WebSocket& ws = *conn.websocket;
+    const size_t limit = config_.max_header_size + config_.max_request_size;
+    bool reading = true;
+    bool peer_open = true;
+    bool buffer_full = false;
+    do {
+        std::vector<std::pair<std::string, bool>> messages;
+        {
+            std::lock_guard<std::mutex> lock(conn.io_mutex);
+            if(conn.closed.load() || conn.input_closed || !input_allowed(conn)) {
+                break;
+            }
+            peer_open = fill_read_buffer(conn);
+            buffer_full = peer_open && conn.buffer.size() >= limit;
+            reading = ws.receive(conn.buffer, messages);
+            conn.read_phase.store(ReadPhase::IDLE);
+            if(conn.buffer.empty()) {
+                // 连接大多时间空闲，不保留按READ_CHUNK_SIZE扩充的读缓冲区
+                std::string().swap(conn.buffer);
+            }
+        }
+        for(auto& [data, binary] : messages) {
+            if(!ws.message_handler_) {
+                break;
+            }
+            try {
+                ws.message_handler_(ws, data, binary);
+            }
+            catch(const std::exception& e) {
+                log("ERROR", "Exception in WebSocket message handler: " + std::string(e.what()));
+                ws.fail(WebSocket::INTERNAL_ERROR);
+                reading = false;
+                break;
+            }
+        }
+    } while(reading && peer_open && buffer_full && !conn.closed.load());
+
+    if(!reading) {
+        conn.input_closed = true;  // 关闭帧已回复，不再读取
+    }
+    else if(!peer_open) {
+        close_connection(conn);  // 对端未经关闭握手断开
+        return;
+    }
+    std::lock_guard<std::mutex> lock(conn.output_mutex);
+    update_deadline(conn);
+}
+
+void HttpServer::notify_websocket_closed(Connection& conn) {
+    // 回调可能获取应用自己的锁（例如正在遍历连接列表广播时断开了慢连接），不在关闭路径上直接调用
+    thread_pool_->enqueue([ws = conn.websocket]() {
+        ws->notify_closed();
+    });
+}
@@ -4,6 +4,7 @@
 #include "core/middleware.h"
 #include "core/config_manager.h"
 #include "core/logger.h"
+#include "core/websocket.h"
 #include <iostream>
 #include <filesystem>
 
@@ -42,9 +43,47 @@ int main(int argc, char* argv[]) {
         server_config.host = config.get<std::string>("server.host", "0.0.0.0");
         server_config.port = config.get<int>("server.port", 8080);
         server_config.thread_pool_size = config.get<int>("server.thread_pool_size", 8);
+        server_config.reactor_count = config.get<int>("server.reactor_count", 1);
+        server_config.io_backend = config.get<std::string>("server.io_backend", "epoll");
         server_config.enable_logging = config.get<bool>("server.enable_logging", true);
         server_config.enable_keep_alive = config.get<bool>("server.enable_keep_alive", true);
-        server_config.timeout_seconds = config.get<int>("server.timeout_seconds", 30);
+        server_config.header_timeout_seconds = config.get<int>("server.header_timeout_seconds", 10);
+        server_config.body_timeout_seconds = config.get<int>("server.body_timeout_seconds", 30);
+        server_config.write_timeout_seconds = config.get<int>("server.write_timeout_seconds", 30);
+        server_config.keep_alive_timeout = config.get<int>("server.keep_alive_timeout", 5);
+        server_config.max_pipeline_depth = config.get<int>("server.max_pipeline_depth", 16);
+        server_config.output_high_water_mark = config.get<int>("server.output_high_water_mark", 1048576);
+        server_config.max_connections = config.get<int>("server.max_connections", 1000);
+        server_config.max_queued_requests = config.get<int>("server.max_queued_requests", 4096);
+        server_config.retry_after_seconds = config.get<int>("server.retry_after_seconds", 1);
+        server_config.handoff_path = config.get<std::string>("server.handoff_path", "");
+        server_config.drain_timeout_seconds = config.get<int>("server.drain_timeout_seconds", 30);
+        server_config.sse_heartbeat_seconds = config.get<int>("server.sse_heartbeat_seconds", 15);
+        server_config.sse_replay_capacity = config.get<int>("server.sse_replay_capacity", 256);
+        server_config.websocket_deflate = config.get<bool>("server.websocket_deflate", true);
+        server_config.enable_http2 = config.get<bool>("server.enable_http2", true);
+        server_config.http2_max_concurrent_streams = config.get<int>("server.http2_max_concurrent_streams", 100);
+        server_config.enable_compression = config.get<bool>("server.enable_compression", true);
+        server_config.compression_level = config.get<int>("server.compression_level", 6);
+        server_config.compression_min_size = config.get<int>("server.compression_min_size", 1024);
+        server_config.static_cache_bytes = config.get<size_t>("server.static_cache_bytes", 64 * 1024 * 1024);
+        server_config.static_cache_max_file_size = config.get<size_t>("server.static_cache_max_file_size", 4 * 1024 * 1024);
+        std::string overload_policy = config.get<std::string>("server.overload_policy", "reject");
+        if (overload_policy == "pause_accept") server_config.overload_policy = HttpServer::OverloadPolicy::PAUSE_ACCEPT;
+        else if (overload_policy == "drop_idle") server_config.overload_policy = HttpServer::OverloadPolicy::DROP_IDLE;
+        else server_config.overload_policy = HttpServer::OverloadPolicy::REJECT;
+        // 可选的多监听地址，例如供同机nginx连接的Unix域套接字
+        for (const auto& item : config.get<nlohmann::json>("server.listeners", nlohmann::json::array())) {
+            HttpServer::ListenerConfig listener;
+            listener.address = item.value("address", listener.address);
+            listener.port = item.value("port", listener.port);
+            listener.backlog = item.value("backlog", listener.backlog);
+            listener.ipv6_only = item.value("ipv6_only", listener.ipv6_only);
+            listener.defer_accept_seconds = item.value("defer_accept_seconds", listener.defer_accept_seconds);
+            listener.fastopen_queue = item.value("fastopen_queue", listener.fastopen_queue);
+            listener.unix_mode = item.value("unix_mode", listener.unix_mode);
+            server_config.listeners.push_back(listener);
+        }
         
         HttpServer server(server_config);
         
@@ -135,11 +174,50 @@ int main(int argc, char* argv[]) {
                     "total_responses": )" + std::to_string(stats.total_responses.load()) + R"(,
                     "active_connections": )" + std::to_string(stats.active_connections.load()) + R"(,
                     "bytes_sent": )" + std::to_string(stats.total_bytes_sent.load()) + R"(,
-                    "bytes_received": )" + std::to_string(stats.total_bytes_received.load()) + R"(
+                    "bytes_received": )" + std::to_string(stats.total_bytes_received.load()) + R"(,
+                    "recv_calls": )" + std::to_string(stats.total_recv_calls.load()) + R"(,
+                    "send_calls": )" + std::to_string(stats.total_send_calls.load()) + R"(,
+                    "ring_enters": )" + std::to_string(stats.total_ring_enters.load()) + R"(,
+                    "pipelined_requests": )" + std::to_string(stats.total_pipelined_requests.load()) + R"(,
+                    "write_waits": )" + std::to_string(stats.total_write_waits.load()) + R"(,
+                    "timeouts": )" + std::to_string(stats.total_timeouts.load()) + R"(,
+                    "shed_rejected": )" + std::to_string(stats.total_shed_rejected.load()) + R"(,
+                    "shed_idle_dropped": )" + std::to_string(stats.total_shed_idle_dropped.load()) + R"(,
+                    "shed_requests": )" + std::to_string(stats.total_shed_requests.load()) + R"(,
+                    "accept_pauses": )" + std::to_string(stats.total_accept_pauses.load()) + R"(,
+                    "streamed_responses": )" + std::to_string(stats.total_streamed_responses.load()) + R"(,
+                    "stream_waits": )" + std::to_string(stats.total_stream_waits.load()) + R"(,
+                    "events_published": )" + std::to_string(stats.total_events_published.load()) + R"(,
+                    "event_deliveries": )" + std::to_string(stats.total_event_deliveries.load()) + R"(,
+                    "slow_subscribers": )" + std::to_string(stats.total_slow_subscribers.load()) + R"(,
+                    "websocket_upgrades": )" + std::to_string(stats.total_websocket_upgrades.load()) + R"(,
+                    "websocket_messages": )" + std::to_string(stats.total_websocket_messages.load()) + R"(,
+                    "http2_sessions": )" + std::to_string(stats.total_http2_sessions.load()) + R"(,
+                    "http2_streams": )" + std::to_string(stats.total_http2_streams.load()) + R"(,
+                    "compressed_responses": )" + std::to_string(stats.total_compressed_responses.load()) + R"(,
+                    "compression_saved_bytes": )" + std::to_string(stats.total_compression_saved_bytes.load()) + R"(,
+                    "static_cache_hits": )" + std::to_string(server.static_cache().stats().hits.load()) + R"(,
+                    "static_cache_misses": )" + std::to_string(server.static_cache().stats().misses.load()) + R"(,
+                    "static_cache_entries": )" + std::to_string(server.static_cache().stats().entries.load()) + R"(,
+                    "static_cache_bytes": )" + std::to_string(server.static_cache().stats().resident_bytes.load()) + R"(,
+                    "dispatches": )" + std::to_string(stats.total_dispatches.load()) + R"(,
+                    "coalesced_events": )" + std::to_string(stats.total_coalesced_events.load()) + R"(,
+                    "avg_rearm_latency_us": )" + std::to_string(stats.total_rearms.load() ?
+                        stats.total_rearm_latency_us.load() / stats.total_rearms.load() : 0) + R"(
                 }
             })");
         });
         
+        // 评测状态推送：评测模块向judge-status频道发布，浏览器以EventSource订阅
+        server.get("/api/judge/events", [&server](const HttpRequest& req, HttpResponse& res) {
+            server.subscribe(req, res, server.event_channel("judge-status"));
+        });
+
+        // 比赛实时榜单：连接建立后先发送当前榜单，之后由榜单模块推送增量
+        server.websocket("/api/contest/scoreboard", [](const HttpRequest& req, const std::shared_ptr<WebSocket>& ws) {
+            ws->send_text(R"({"type": "snapshot", "rows": []})");
+        });
+        
         server.get("/api/problems", [](const HttpRequest& req, HttpResponse& res) {
             res.json(R"({
                 "problems": [
@@ -0,0 +1,74 @@
+#include "core/connection_table.h"
+#include <iostream>
+#include <cassert>
+#include <memory>
+#include <string>
+
+void test_insert_find_remove() {
+    std::cout << "Testing fd-indexed lookup and growth..." << std::endl;
+
+    ConnectionTable<std::string> table(4);
+    auto a = table.insert(3, std::make_shared<std::string>("a"));
+    auto b = table.insert(100, std::make_shared<std::string>("b"));  // 超出初始容量
+    assert(table.size() == 2);
+    assert(ConnectionTable<std::string>::fd_of(a) == 3);
+    assert(ConnectionTable<std::string>::fd_of(b) == 100);
+    assert(*table.find(a) == "a");
+    assert(*table.find(b) == "b");
+    // 句柄不会与裸fd相同（epoll中监听套接字直接使用fd）
+    assert(a != 3 && b != 100);
+    assert(!ConnectionTable<std::string>::is_raw_fd(a));
+    assert(ConnectionTable<std::string>::is_raw_fd(3));
+    assert(!table.find(5));
+    assert(!table.find(1000000));
+
+    table.remove(a);
+    assert(!table.find(a));
+    assert(table.size() == 1);
+    table.remove(a);
+    assert(table.size() == 1);
+
+    int visited = 0;
+    table.for_each([&](const std::shared_ptr<std::string>& conn) {
+        assert(*conn == "b");
+        ++visited;
+    });
+    assert(visited == 1);
+    table.clear();
+    assert(table.size() == 0 && !table.find(b));
+
+    std::cout << "Insert/find/remove test passed!" << std::endl;
+}
+
+void test_fd_reuse() {
+    std::cout << "Testing stale handles after fd reuse..." << std::endl;
+
+    ConnectionTable<std::string> table;
+    auto old_handle = table.insert(7, std::make_shared<std::string>("old"));
+    // 旧连接关闭后、移除之前，fd已被新连接复用
+    auto new_handle = table.insert(7, std::make_shared<std::string>("new"));
+    assert(old_handle != new_handle);
+    assert(table.size() == 1);
+    assert(!table.find(old_handle));
+    assert(*table.find(new_handle) == "new");
+
+    // 旧连接延迟的移除请求不影响新连接
+    table.remove(old_handle);
+    assert(*table.find(new_handle) == "new");
+    assert(table.size() == 1);
+
+    table.remove(new_handle);
+    auto third = table.insert(7, std::make_shared<std::string>("third"));
+    assert(!table.find(old_handle) && !table.find(new_handle));
+    assert(*table.find(third) == "third");
+
+    std::cout << "FD reuse test passed!" << std::endl;
+}
+
+int main() {
+    test_insert_find_remove();
+    test_fd_reuse();
+
+    std::cout << "\nAll tests passed successfully!" << std::endl;
+    return 0;
+}
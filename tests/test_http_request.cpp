@@ -0,0 +1,644 @@
+#include "core/http_server.h"
+#include "core/http_parser.h"
+#include "core/http_request.h"
+#include "core/http_response.h"
+#include "core/websocket.h"
+#include "core/hpack.h"
+#include "core/compression.h"
+#include "core/router.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#ifdef XKOJ_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+static const std::string kSubmitRequest =
+    "POST /api/submissions?contest=12 HTTP/1.1\r\n"
+    "Host: oj.example.com\r\n"
+    "Content-Type: application/json\r\n"
+    "Authorization: Bearer abc.def\r\n"
+    "Content-Length: 27\r\n"
+    "\r\n"
+    "{\"problem\":1,\"lang\":\"cpp\"}\n";
+
+void test_parser_complete_request() {
+    std::cout << "Testing incremental parser on a complete request..." << std::endl;
+
+    HttpParser parser;
+    assert(parser.parse(kSubmitRequest) == HttpParser::Result::COMPLETE);
+    assert(parser.method() == "POST");
+    assert(parser.target() == "/api/submissions?contest=12");
+    assert(parser.path() == "/api/submissions");
+    assert(parser.query() == "contest=12");
+    assert(parser.version() == "HTTP/1.1");
+    assert(parser.headers().size() == 4);
+    assert(parser.header("content-type") == "application/json");
+    assert(parser.header("AUTHORIZATION") == "Bearer abc.def");
+    assert(parser.body() == "{\"problem\":1,\"lang\":\"cpp\"}\n");
+    assert(parser.message_size() == kSubmitRequest.size());
+    assert(parser.keep_alive());
+
+    // 解析结果直接指向输入缓冲区
+    assert(parser.method().data() == kSubmitRequest.data());
+
+    std::cout << "Complete request test passed!" << std::endl;
+}
+
+void test_parser_byte_by_byte() {
+    std::cout << "Testing parser resumption at every byte boundary..." << std::endl;
+
+    HttpParser parser;
+    std::string buffer;
+    for (size_t i = 0; i < kSubmitRequest.size(); ++i) {
+        buffer.push_back(kSubmitRequest[i]);
+        // 每次追加都可能导致缓冲区重新分配，解析器只保存偏移量
+        buffer.shrink_to_fit();
+        HttpParser::Result result = parser.parse(buffer);
+        if (i + 1 < kSubmitRequest.size()) {
+            assert(result == HttpParser::Result::INCOMPLETE);
+        } else {
+            assert(result == HttpParser::Result::COMPLETE);
+        }
+    }
+    assert(parser.path() == "/api/submissions");
+    assert(parser.header("Host") == "oj.example.com");
+    assert(parser.body().size() == 27);
+
+    // 同一缓冲区中的下一个请求
+    parser.reset();
+    std::string pipelined = kSubmitRequest + "GET /api/health HTTP/1.1\r\nHost: x\r\n\r\n";
+    assert(parser.parse(pipelined) == HttpParser::Result::COMPLETE);
+    std::string rest = pipelined.substr(parser.message_size());
+    parser.reset();
+    assert(parser.parse(rest) == HttpParser::Result::COMPLETE);
+    assert(parser.method() == "GET");
+    assert(parser.body().empty());
+
+    std::cout << "Byte-by-byte test passed!" << std::endl;
+}
+
+void test_parser_limits_and_errors() {
+    std::cout << "Testing parser limits and malformed input..." << std::endl;
+
+    HttpParser::Limits limits;
+    limits.max_header_size = 64;
+    limits.max_request_size = 16;
+
+    {
+        HttpParser parser(limits);
+        std::string long_uri = "GET /" + std::string(100, 'a') + " HTTP/1.1\r\n\r\n";
+        assert(parser.parse(long_uri) == HttpParser::Result::ERROR);
+        assert(parser.error_status() == HttpStatus::URI_TOO_LONG);
+    }
+    {
+        // 头部尚未结束时即检测到超限
+        HttpParser parser(limits);
+        std::string partial = "GET / HTTP/1.1\r\nX-Long: " + std::string(80, 'b');
+        assert(parser.parse(partial) == HttpParser::Result::ERROR);
+    }
+    {
+        HttpParser parser(limits);
+        assert(parser.parse("POST / HTTP/1.1\r\nContent-Length: 17\r\n\r\n") == HttpParser::Result::ERROR);
+        assert(parser.error_status() == HttpStatus::PAYLOAD_TOO_LARGE);
+    }
+    {
+        HttpParser parser;
+        assert(parser.parse("POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n") == HttpParser::Result::ERROR);
+        assert(parser.error_status() == HttpStatus::BAD_REQUEST);
+    }
+    {
+        HttpParser parser;
+        assert(parser.parse("GET / HTTP/2.0\r\n\r\n") == HttpParser::Result::ERROR);
+        assert(parser.error_status() == HttpStatus::HTTP_VERSION_NOT_SUPPORTED);
+    }
+    {
+        HttpParser parser;
+        assert(parser.parse("GET /\r\n\r\n") == HttpParser::Result::ERROR);
+    }
+    {
+        HttpParser parser;
+        assert(parser.parse("GET / HTTP/1.1\r\nBad Header: x\r\n\r\n") == HttpParser::Result::ERROR);
+    }
+    {
+        HttpParser parser;
+        assert(parser.parse("GET / HTTP/1.0\r\n\r\n") == HttpParser::Result::COMPLETE);
+        assert(!parser.keep_alive());
+    }
+
+    std::cout << "Limits and errors test passed!" << std::endl;
+}
+
+void test_request_populate() {
+    std::cout << "Testing HttpRequest::parse via shared parser..." << std::endl;
+
+    HttpRequest request;
+    assert(request.parse(kSubmitRequest));
+    assert(request.method() == "POST");
+    assert(request.path() == "/api/submissions");
+    assert(request.get_param("contest") == "12");
+    assert(request.get_header("content-type") == "application/json");
+    assert(request.is_json());
+    assert(request.body() == "{\"problem\":1,\"lang\":\"cpp\"}\n");
+
+    HttpRequest form;
+    assert(form.parse("POST /login%20page HTTP/1.1\r\n"
+                      "Content-Type: application/x-www-form-urlencoded\r\n"
+                      "Content-Length: 21\r\n\r\n"
+                      "user=alice&pass=a%2Bb"));
+    assert(form.path() == "/login page");
+    assert(form.get_form_data("user") == "alice");
+    assert(form.get_form_data("pass") == "a+b");
+
+    HttpRequest truncated;
+    assert(!truncated.parse("POST / HTTP/1.1\r\nContent-Length: 10\r\n\r\nabc"));
+
+    std::cout << "HttpRequest parse test passed!" << std::endl;
+}
+
+void test_parser_chunked() {
+    std::cout << "Testing chunked transfer decoding..." << std::endl;
+
+    const std::string request = "POST /api/import HTTP/1.1\r\n"
+                                "Transfer-Encoding: chunked\r\n\r\n"
+                                "4;name=value\r\nWiki\r\n"
+                                "5\r\npedia\r\n"
+                                "E\r\n in\r\n\r\nchunks.\r\n"
+                                "0\r\nExpires: never\r\n\r\n";
+    const std::string next = "GET / HTTP/1.1\r\n\r\n";
+
+    // 逐字节到达：块大小行、数据与trailer均可在任意位置被截断
+    HttpParser parser;
+    std::string buffer;
+    for (char c : request + next) {
+        buffer.push_back(c);
+        if (parser.parse(buffer) == HttpParser::Result::COMPLETE) {
+            break;
+        }
+    }
+    assert(parser.chunked());
+    assert(parser.body() == "Wikipedia in\r\n\r\nchunks.");
+    assert(parser.message_size() == request.size());
+
+    {
+        // 解码后的请求体同样受max_request_size限制
+        HttpParser::Limits limits;
+        limits.max_request_size = 8;
+        HttpParser limited(limits);
+        assert(limited.parse(request) == HttpParser::Result::ERROR);
+        assert(limited.error_status() == HttpStatus::PAYLOAD_TOO_LARGE);
+    }
+    {
+        HttpParser bad;
+        assert(bad.parse("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n") ==
+               HttpParser::Result::ERROR);
+        assert(bad.error_status() == HttpStatus::BAD_REQUEST);
+    }
+    {
+        HttpParser smuggled;
+        assert(smuggled.parse("POST / HTTP/1.1\r\nContent-Length: 3\r\n"
+                              "Transfer-Encoding: chunked\r\n\r\n0\r\n\r\n") == HttpParser::Result::ERROR);
+        assert(smuggled.error_status() == HttpStatus::BAD_REQUEST);
+    }
+    {
+        HttpParser gzip;
+        assert(gzip.parse("POST / HTTP/1.1\r\nTransfer-Encoding: gzip, chunked\r\n\r\n") ==
+               HttpParser::Result::ERROR);
+        assert(gzip.error_status() == HttpStatus::NOT_IMPLEMENTED);
+    }
+
+    std::cout << "Chunked decoding test passed!" << std::endl;
+}
+
+void test_parser_streaming_body() {
+    std::cout << "Testing streamed bodies via BodyDecoder..." << std::endl;
+
+    // 请求头完整时暂停，由调用方决定流式读取；请求体大小不再受max_request_size限制
+    HttpParser::Limits limits;
+    limits.max_request_size = 4;
+    HttpParser parser(limits);
+    parser.set_pause_after_headers(true);
+    const std::string head = "PUT /data HTTP/1.1\r\nContent-Length: 10\r\n\r\n";
+    std::string buffer = head + "0123";
+    assert(parser.parse(buffer) == HttpParser::Result::HEADERS);
+    assert(parser.path() == "/data");
+    parser.stream_body();
+    assert(parser.parse(buffer) == HttpParser::Result::COMPLETE);
+    assert(parser.body().empty());
+    assert(parser.message_size() == head.size());
+
+    BodyDecoder decoder = parser.body_decoder();
+    buffer.erase(0, parser.message_size());
+    buffer += "456789GET";
+    std::string body;
+    size_t consumed = 0;
+    std::string_view data;
+    // 每次至多取出3字节
+    while (decoder.decode(buffer, consumed, data, 3) == BodyDecoder::Result::DATA) {
+        assert(data.size() <= 3);
+        body.append(data);
+        buffer.erase(0, consumed);
+    }
+    assert(decoder.done());
+    assert(body == "0123456789");
+    assert(buffer == "GET");
+
+    // 不带请求体的请求不暂停
+    HttpParser plain;
+    plain.set_pause_after_headers(true);
+    assert(plain.parse("GET / HTTP/1.1\r\n\r\n") == HttpParser::Result::COMPLETE);
+
+    // 继续缓冲时才检查大小
+    HttpParser buffered(limits);
+    buffered.set_pause_after_headers(true);
+    assert(buffered.parse(head) == HttpParser::Result::HEADERS);
+    assert(buffered.parse(head) == HttpParser::Result::ERROR);
+    assert(buffered.error_status() == HttpStatus::PAYLOAD_TOO_LARGE);
+
+    std::cout << "Streamed body test passed!" << std::endl;
+}
+
+void test_websocket_frames() {
+    std::cout << "Testing WebSocket frame parsing..." << std::endl;
+
+    // RFC 6455 5.7：带掩码的"Hello"，逐字节到达
+    const std::string masked("\x81\x85\x37\xfa\x21\x3d\x7f\x9f\x4d\x51\x58", 11);
+    WebSocketFrameParser parser;
+    WebSocketFrameParser::Frame frame;
+    size_t consumed = 0;
+    for (size_t i = 0; i < masked.size(); ++i) {
+        assert(parser.parse(masked.substr(0, i), consumed, frame) == WebSocketFrameParser::Result::INCOMPLETE);
+    }
+    assert(parser.parse(masked + "\x89", consumed, frame) == WebSocketFrameParser::Result::FRAME);
+    assert(consumed == masked.size());
+    assert(frame.fin && frame.opcode == WebSocket::TEXT && frame.payload == "Hello");
+
+    // 16位与64位长度
+    std::string big(300, 'a');
+    WebSocketFrameParser server_side(SIZE_MAX, false);
+    std::string encoded = WebSocket::encode_frame(WebSocket::BINARY, big);
+    assert(encoded.size() == big.size() + 4);
+    assert(server_side.parse(encoded, consumed, frame) == WebSocketFrameParser::Result::FRAME);
+    assert(frame.payload == big && frame.opcode == WebSocket::BINARY);
+    big.assign(70000, 'b');
+    encoded = WebSocket::encode_frame(WebSocket::TEXT, big);
+    assert(encoded.size() == big.size() + 10);
+    assert(server_side.parse(encoded, consumed, frame) == WebSocketFrameParser::Result::FRAME);
+    assert(frame.payload.size() == 70000);
+
+    // 协议错误：未加掩码、保留位、保留操作码、分片的控制帧、超长的控制帧
+    const std::string errors[] = {
+        WebSocket::encode_frame(WebSocket::TEXT, "x"),
+        std::string("\xA1\x80\0\0\0\0", 6),
+        std::string("\x83\x80\0\0\0\0", 6),
+        std::string("\x09\x80\0\0\0\0", 6),
+        std::string("\x89\xFE\0\x7E", 4),
+    };
+    for (const auto& bad : errors) {
+        WebSocketFrameParser p;
+        assert(p.parse(bad, consumed, frame) == WebSocketFrameParser::Result::ERROR);
+        assert(p.close_code() == WebSocket::PROTOCOL_ERROR);
+    }
+    WebSocketFrameParser limited(100);
+    assert(limited.parse(std::string("\x82\xFE\x01\x00", 4), consumed, frame) == WebSocketFrameParser::Result::ERROR);
+    assert(limited.close_code() == WebSocket::MESSAGE_TOO_BIG);
+
+    assert(WebSocket::valid_utf8("plain ascii text, longer than eight bytes"));
+    assert(WebSocket::valid_utf8("\xE4\xBD\xA0\xE5\xA5\xBD \xF0\x9F\x98\x80"));
+    assert(!WebSocket::valid_utf8("\xC0\xAF"));          // 过长编码
+    assert(!WebSocket::valid_utf8("\xED\xA0\x80"));      // 代理项
+    assert(!WebSocket::valid_utf8("abcdefgh\xE4\xBD"));  // 截断
+
+    std::cout << "WebSocket frame test passed!" << std::endl;
+}
+
+static std::string from_hex(const std::string& hex) {
+    std::string out;
+    for (size_t i = 0; i + 1 < hex.size(); i += 3) {
+        out += static_cast<char>(std::stoi(hex.substr(i, 2), nullptr, 16));
+    }
+    return out;
+}
+
+void test_hpack() {
+    std::cout << "Testing HPACK encoder and decoder..." << std::endl;
+
+    // RFC 7541 C.4：同一连接上的三个请求，使用Huffman编码并共享动态表
+    const char* blocks[] = {
+        "82 86 84 41 8c f1 e3 c2 e5 f2 3a 6b a0 ab 90 f4 ff ",
+        "82 86 84 be 58 86 a8 eb 10 64 9c bf ",
+        "82 87 85 bf 40 88 25 a8 49 e9 5b a9 7d 7f 89 25 a8 49 e9 5b b8 e8 b4 bf ",
+    };
+    HpackDecoder decoder;
+    HpackEncoder encoder;
+    std::vector<HpackHeader> headers;
+    std::vector<std::vector<HpackHeader>> expected = {
+        {{":method", "GET"}, {":scheme", "http"}, {":path", "/"}, {":authority", "www.example.com"}},
+        {{":method", "GET"}, {":scheme", "http"}, {":path", "/"}, {":authority", "www.example.com"},
+         {"cache-control", "no-cache"}},
+        {{":method", "GET"}, {":scheme", "https"}, {":path", "/index.html"}, {":authority", "www.example.com"},
+         {"custom-key", "custom-value"}},
+    };
+    for (size_t i = 0; i < 3; ++i) {
+        headers.clear();
+        assert(decoder.decode(from_hex(blocks[i]), headers) == HpackDecoder::Result::OK);
+        assert(headers.size() == expected[i].size());
+        for (size_t j = 0; j < headers.size(); ++j) {
+            assert(headers[j].name == expected[i][j].name);
+            assert(headers[j].value == expected[i][j].value);
+        }
+        // 编码端的选择与RFC示例一致时，输出逐字节相同
+        std::string block;
+        encoder.begin_block(block);
+        for (const auto& header : expected[i]) {
+            encoder.encode(header.name, header.value, block);
+        }
+        assert(block == from_hex(blocks[i]));
+    }
+
+    // 表大小更新与不索引的字面量往返
+    HpackEncoder small;
+    HpackDecoder peer;
+    small.set_max_table_size(0);
+    std::string block;
+    small.begin_block(block);
+    assert(static_cast<uint8_t>(block[0]) == 0x20);
+    small.encode("set-cookie", "sid=secret", block, HpackEncoder::Indexing::NEVER);
+    small.encode("x-trace", std::string(300, 'a'), block);
+    headers.clear();
+    assert(peer.decode(block, headers) == HpackDecoder::Result::OK);
+    assert(headers.size() == 2 && headers[0].value == "sid=secret" && headers[1].value.size() == 300);
+
+    // 头部列表超限时仍完整解码，保持动态表同步
+    HpackDecoder limited(4096, 64);
+    headers.clear();
+    assert(limited.decode(block, headers) == HpackDecoder::Result::TOO_LARGE);
+    // 截断的整数与越界的索引都是压缩错误
+    assert(peer.decode(std::string("\x3f", 1), headers) == HpackDecoder::Result::ERROR);
+    assert(peer.decode(std::string("\xff\x00", 2), headers) == HpackDecoder::Result::ERROR);
+
+    std::cout << "HPACK test passed!" << std::endl;
+}
+
+#ifdef XKOJ_HAVE_ZLIB
+// gzip与zlib格式自动识别
+static std::string inflate_all(const std::string& data) {
+    z_stream zs{};
+    inflateInit2(&zs, MAX_WBITS + 32);
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    std::string out;
+    char buf[16384];
+    int ret;
+    do {
+        zs.next_out = reinterpret_cast<Bytef*>(buf);
+        zs.avail_out = sizeof(buf);
+        ret = inflate(&zs, Z_NO_FLUSH);
+        out.append(buf, sizeof(buf) - zs.avail_out);
+    } while(ret == Z_OK && zs.avail_in > 0);
+    inflateEnd(&zs);
+    return out;
+}
+#endif
+
+void test_compression() {
+    std::cout << "Testing response compression helpers..." << std::endl;
+
+    assert(compression::compressible_type("application/json; charset=utf-8"));
+    assert(compression::compressible_type("text/html"));
+    assert(compression::compressible_type("image/svg+xml"));
+    assert(!compression::compressible_type("image/png"));
+    assert(!compression::compressible_type("application/zip"));
+    assert(!compression::compressible_type("text/event-stream"));
+    assert(!compression::compressible_type(""));
+
+#ifdef XKOJ_HAVE_ZLIB
+    assert(compression::negotiate("gzip, deflate, br") == ContentCoding::GZIP);
+    assert(compression::negotiate("deflate;q=1, gzip;q=0.5") == ContentCoding::DEFLATE);
+    assert(compression::negotiate("gzip;q=0, deflate") == ContentCoding::DEFLATE);
+    assert(compression::negotiate("br, *;q=0.1") == ContentCoding::GZIP);
+    assert(compression::negotiate("*;q=0.5, gzip;q=0") == ContentCoding::DEFLATE);
+    assert(compression::negotiate("identity") == ContentCoding::IDENTITY);
+    assert(compression::negotiate("gzip;q=0, deflate;q=0.000") == ContentCoding::IDENTITY);
+    assert(compression::negotiate("") == ContentCoding::IDENTITY);
+
+    std::string json = "[";
+    for (int i = 0; i < 500; ++i) {
+        json += "{\"id\":" + std::to_string(i) + ",\"title\":\"A+B Problem\",\"accepted\":" + std::to_string(i * 7) + "},";
+    }
+    json += "{}]";
+    std::string out;
+    for (int level : {1, 9, 6}) {  // 同一线程的上下文在级别之间复用
+        assert(compression::compress(ContentCoding::GZIP, level, json, out));
+        assert(out.size() < json.size() / 5 && out.compare(0, 2, "\x1f\x8b") == 0);
+        assert(inflate_all(out) == json);
+    }
+    assert(compression::compress(ContentCoding::DEFLATE, 6, json, out) && inflate_all(out) == json);
+    assert(!compression::compress(ContentCoding::GZIP, 6, "ab", out));  // 没有收益
+
+    // 流式：每段刷新后即可解出已写入的内容
+    StreamCompressor stream(ContentCoding::GZIP, 6);
+    assert(stream.ok());
+    std::string compressed;
+    assert(stream.write(json.substr(0, 1000), compressed));
+    assert(inflate_all(compressed) == json.substr(0, 1000));
+    assert(stream.write(json.substr(1000), compressed));
+    assert(stream.write({}, compressed, true));
+    assert(!stream.write("late", compressed));
+    assert(inflate_all(compressed) == json);
+#endif
+
+    std::cout << "Compression test passed!" << std::endl;
+}
+
+void test_preconditions() {
+    std::cout << "Testing conditional request evaluation..." << std::endl;
+
+    // RFC 9110 5.6.7中的三种日期格式
+    time_t t1, t2, t3;
+    assert(HttpResponse::parse_http_date("Sun, 06 Nov 1994 08:49:37 GMT", t1));
+    assert(HttpResponse::parse_http_date("Sunday, 06-Nov-94 08:49:37 GMT", t2));
+    assert(HttpResponse::parse_http_date("Sun Nov  6 08:49:37 1994", t3));
+    assert(t1 == 784111777 && t2 == t1 && t3 == t1);
+    assert(HttpResponse::http_date(t1) == "Sun, 06 Nov 1994 08:49:37 GMT");
+    assert(!HttpResponse::parse_http_date("yesterday", t1));
+
+    auto evaluate = [](const std::string& method, const std::string& headers, HttpResponse& response) {
+        HttpRequest request;
+        assert(request.parse(method + " /app.js HTTP/1.1\r\n" + headers + "\r\n"));
+        response.set_status(HttpStatus::OK);
+        response.set_header("ETag", "\"abc\"");
+        response.set_header("Last-Modified", "Sun, 06 Nov 1994 08:49:37 GMT");
+        response.set_body("console.log(1);");
+        return response.evaluate_preconditions(request);
+    };
+    HttpResponse response;
+    assert(evaluate("GET", "If-None-Match: \"x\", W/\"abc\"\r\n", response));
+    assert(response.status() == HttpStatus::NOT_MODIFIED && response.body().empty());
+    assert(!response.has_header("Content-Length") && response.get_header("ETag") == "\"abc\"");
+    assert(evaluate("HEAD", "If-None-Match: *\r\n", response));
+    assert(!evaluate("GET", "If-None-Match: \"x\"\r\nIf-Modified-Since: Sun, 06 Nov 1994 08:49:37 GMT\r\n",
+                     response));
+    assert(response.status() == HttpStatus::OK);  // If-None-Match优先
+    assert(evaluate("GET", "If-Modified-Since: Mon, 07 Nov 1994 00:00:00 GMT\r\n", response));
+    assert(!evaluate("GET", "If-Modified-Since: Sat, 05 Nov 1994 00:00:00 GMT\r\n", response));
+    assert(!evaluate("GET", "If-Modified-Since: garbage\r\n", response));
+    // If-Match使用强比较
+    assert(!evaluate("GET", "If-Match: \"abc\"\r\n", response));
+    assert(evaluate("GET", "If-Match: W/\"abc\"\r\n", response));
+    assert(response.status() == HttpStatus::PRECONDITION_FAILED);
+    assert(evaluate("GET", "If-Unmodified-Since: Sat, 05 Nov 1994 00:00:00 GMT\r\n", response));
+    assert(response.status() == HttpStatus::PRECONDITION_FAILED);
+    // 修改性的方法由处理器自行判断
+    assert(!evaluate("PUT", "If-Match: \"nope\"\r\n", response));
+
+    std::cout << "Conditional request test passed!" << std::endl;
+}
+
+void test_byte_ranges() {
+    std::cout << "Testing Range evaluation..." << std::endl;
+
+    auto body = std::make_shared<const std::string>("0123456789abcdefghij");
+    auto apply = [&body](const std::string& headers, HttpResponse& response) {
+        HttpRequest request;
+        assert(request.parse("GET /data HTTP/1.1\r\n" + headers + "\r\n"));
+        response = HttpResponse();
+        response.set_header("ETag", "\"v2\"");
+        response.set_shared_body(body);
+        return response.apply_range(request);
+    };
+    HttpResponse response;
+    assert(!apply("", response) && response.get_header("Accept-Ranges") == "bytes");
+    assert(apply("Range: bytes=2-4\r\n", response));
+    assert(response.status() == HttpStatus::PARTIAL_CONTENT && response.body() == "234");
+    assert(response.get_header("Content-Range") == "bytes 2-4/20");
+    assert(apply("Range: bytes=-3\r\n", response) && response.body() == "hij");
+    assert(apply("Range: bytes=18-100\r\n", response) && response.body() == "ij");
+    // 重叠与相邻的区间合并为一个
+    assert(apply("Range: bytes=5-7, 0-2,3-4\r\n", response) && response.body() == "01234567");
+    assert(response.get_header("Content-Range") == "bytes 0-7/20");
+    assert(apply("Range: bytes=20-,-0\r\n", response));
+    assert(response.status() == HttpStatus::RANGE_NOT_SATISFIABLE);
+    assert(response.get_header("Content-Range") == "bytes */20");
+    // 格式错误、未知单位、区间过多或If-Range不匹配时发送完整内容
+    for (const char* headers : {"Range: bytes=4-2\r\n", "Range: items=0-1\r\n", "Range: bytes=x-1\r\n",
+                                "Range: bytes=0-0,2-2,4-4,6-6,8-8,10-10,12-12,14-14,16-16,18-18,1-1,3-3,5-5,"
+                                "7-7,9-9,11-11,13-13\r\n",
+                                "Range: bytes=0-1\r\nIf-Range: \"v1\"\r\n",
+                                "Range: bytes=0-1\r\nIf-Range: W/\"v2\"\r\n"}) {
+        assert(!apply(headers, response));
+        assert(response.status() == HttpStatus::OK && response.body() == *body);
+    }
+    assert(apply("Range: bytes=0-1\r\nIf-Range: \"v2\"\r\n", response) && response.body() == "01");
+
+    // 多区间
+    assert(apply("Range: bytes=0-1,-2\r\n", response));
+    std::string type = response.get_header("Content-Type");
+    assert(type.compare(0, 31, "multipart/byteranges; boundary=") == 0);
+    std::string boundary = type.substr(31);
+    std::string multipart = response.to_string();
+    multipart = multipart.substr(multipart.find("\r\n\r\n") + 4);
+    std::string part_type = "Content-Type: text/html; charset=utf-8\r\n";
+    assert(multipart == "--" + boundary + "\r\n" + part_type + "Content-Range: bytes 0-1/20\r\n\r\n01\r\n--" +
+                        boundary + "\r\n" + part_type + "Content-Range: bytes 18-19/20\r\n\r\nij\r\n--" +
+                        boundary + "--\r\n");
+    assert(response.get_header("Content-Length") == std::to_string(multipart.size()));
+
+    std::cout << "Range test passed!" << std::endl;
+}
+
+void test_router() {
+    std::cout << "Testing radix-tree router..." << std::endl;
+
+    std::vector<std::unique_ptr<Route>> routes;
+    Router router;
+    auto add = [&](HttpMethod method, const std::string& path) {
+        routes.push_back(std::make_unique<Route>(method, path, [](const HttpRequest&, HttpResponse&) {}));
+        return router.add(method, path, routes.back().get());
+    };
+    assert(add(HttpMethod::GET, "/api/problems"));
+    assert(add(HttpMethod::GET, "/api/problems/:id"));
+    assert(add(HttpMethod::GET, "/api/problems/random"));
+    assert(add(HttpMethod::GET, "/api/problems/:id/submissions"));
+    assert(add(HttpMethod::GET, "/api/problems/random/stats"));
+    assert(add(HttpMethod::GET, "/api/proxy"));
+    assert(add(HttpMethod::GET, "/api/contests/:cid/problems/:pid"));
+    assert(add(HttpMethod::GET, "/assets/*path"));
+    assert(add(HttpMethod::GET, "/files/*"));
+    assert(add(HttpMethod::POST, "/api/problems/:id"));
+    // 重复的模式（参数名不同也视为相同）与无效的模式
+    assert(!add(HttpMethod::GET, "/api/problems/:pid"));
+    assert(!add(HttpMethod::GET, "/api/:"));
+    assert(!add(HttpMethod::GET, "/api/:id.json"));
+    assert(!add(HttpMethod::GET, "/api/*/tail"));
+    assert(router.size() == 10);
+
+    RouteParams params;
+    auto find = [&](HttpMethod method, const std::string& path) -> std::string {
+        Route* route = router.find(method, path, params);
+        return route ? route->original_path : "";
+    };
+    auto value = [&params](const std::string& path, size_t i) {
+        return path.substr(params.items[i].offset, params.items[i].length);
+    };
+    assert(find(HttpMethod::GET, "/api/problems") == "/api/problems");
+    assert(find(HttpMethod::GET, "/api/problems/") == "");
+    // 静态片段优先，失败时回溯到参数分支
+    assert(find(HttpMethod::GET, "/api/problems/random") == "/api/problems/random" && params.count == 0);
+    assert(find(HttpMethod::GET, "/api/problems/random/submissions") == "/api/problems/:id/submissions");
+    assert(params.count == 1 && params.items[0].name == "id" &&
+           value("/api/problems/random/submissions", 0) == "random");
+    assert(find(HttpMethod::GET, "/api/problems/1001") == "/api/problems/:id");
+    assert(find(HttpMethod::GET, "/api/pro") == "");
+    assert(find(HttpMethod::GET, "/api/problems/1001/x") == "");
+    std::string path = "/api/contests/12/problems/C";
+    assert(find(HttpMethod::GET, path) == "/api/contests/:cid/problems/:pid" && params.count == 2);
+    assert(params.items[0].name == "cid" && value(path, 0) == "12");
+    assert(params.items[1].name == "pid" && value(path, 1) == "C");
+    path = "/assets/js/app.min.js";
+    assert(find(HttpMethod::GET, path) == "/assets/*path" && params.items[0].name == "path");
+    assert(value(path, 0) == "js/app.min.js");
+    assert(find(HttpMethod::GET, "/files/") == "/files/*" && params.items[0].name == "*" && params.items[0].length == 0);
+    assert(find(HttpMethod::POST, "/api/problems/7") == "/api/problems/:id");
+    assert(find(HttpMethod::DELETE, "/api/problems/7") == "");
+
+    // HEAD未单独注册时使用GET的路由；其他方法给出该路径的Allow
+    assert(find(HttpMethod::HEAD, "/api/problems/7") == "/api/problems/:id" && params.items[0].name == "id");
+    Router::Match match = router.lookup(HttpMethod::DELETE, "/api/problems/7", params);
+    assert(!match.route && match.allow && *match.allow == "GET, POST, OPTIONS, HEAD" && params.count == 0);
+    match = router.lookup(HttpMethod::GET, "/api/problems/7", params);
+    assert(match.route && *match.allow == "GET, POST, OPTIONS, HEAD");
+    assert(!router.lookup(HttpMethod::DELETE, "/api/nothing", params).allow);
+    assert(add(HttpMethod::PUT, "/api/proxy/:target"));
+    assert(*router.lookup(HttpMethod::GET, "/api/proxy/x", params).allow == "PUT, OPTIONS");
+    assert(!router.find(HttpMethod::HEAD, "/api/proxy/x", params));
+
+    // 请求对象保存偏移，复制后参数仍指向自己的路径
+    HttpRequest request;
+    assert(request.parse("GET /api/contests/3/problems/A HTTP/1.1\r\n\r\n"));
+    assert(router.find(HttpMethod::GET, request.path(), params));
+    request.set_path_params(params);
+    HttpRequest copy = request;
+    assert(copy.path_param("cid") == "3" && copy.get_path_param("pid") == "A");
+    assert(copy.has_path_param("pid") && !copy.has_path_param("id") && copy.path_param("id").empty());
+
+    std::cout << "Router test passed!" << std::endl;
+}
+
+int main() {
+    test_parser_complete_request();
+    test_parser_byte_by_byte();
+    test_parser_limits_and_errors();
+    test_request_populate();
+    test_parser_chunked();
+    test_parser_streaming_body();
+    test_websocket_frames();
+    test_hpack();
+    test_compression();
+    test_preconditions();
+    test_byte_ranges();
+    test_router();
+
+    std::cout << "\nAll tests passed successfully!" << std::endl;
+    return 0;
+}
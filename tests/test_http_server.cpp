@@ -1,16 +1,92 @@
 #include "core/http_server.h"
 #include "core/http_request.h"
 #include "core/http_response.h"
+#include "core/event_channel.h"
+#include "core/websocket.h"
+#include "core/http2.h"
+#include <map>
+#ifdef XKOJ_HAVE_ZLIB
+#include <zlib.h>
+#endif
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <atomic>
 #include <cassert>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+// 同一组测试分别在两种I/O后端上运行，由命令行参数选择
+static std::string g_io_backend = "epoll";
+
+// 不同后端使用不同端口，便于两组测试并行执行
+static int test_port(int port) {
+    return g_io_backend == "epoll" ? port : port - 100;
+}
+
+// 测试用的简单阻塞客户端
+static int connect_to_server(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void send_raw(int fd, const std::string& data) {
+    send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+}
+
+// 读取直到收到指定数量的完整响应或超时
+static std::string read_responses(int fd, size_t expected, int timeout_ms = 2000) {
+    struct timeval tv{timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    std::string data;
+    char buf[65536];
+    while (true) {
+        size_t count = 0;
+        size_t pos = 0;
+        while ((pos = data.find("HTTP/1.1 ", pos)) != std::string::npos) {
+            ++count;
+            pos += 9;
+        }
+        size_t last = data.rfind("HTTP/1.1 ");
+        if (count >= expected && last != std::string::npos) {
+            size_t header_end = data.find("\r\n\r\n", last);
+            size_t cl = data.find("Content-Length: ", last);
+            if (header_end != std::string::npos && cl != std::string::npos &&
+                data.size() >= header_end + 4 + std::stoul(data.substr(cl + 16))) {
+                break;
+            }
+        }
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            break;
+        }
+        data.append(buf, n);
+    }
+    return data;
+}
 
 void test_basic_functionality() {
     std::cout << "Testing basic HTTP server functionality..." << std::endl;
     
     HttpServer::ServerConfig config;
-    config.port = 9999;  // 使用不同端口避免冲突
+    config.io_backend = g_io_backend;
+    config.port = test_port(9999);  // 使用不同端口避免冲突
     config.enable_logging = false;  // 测试时关闭日志
     
     HttpServer server(config);
@@ -84,11 +160,1797 @@ void test_response_generation() {
     std::cout << "Response generation test passed!" << std::endl;
 }
 
-int main() {
+void test_partial_requests() {
+    std::cout << "Testing partial request reassembly..." << std::endl;
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9998);
+    config.enable_logging = false;
+
+    HttpServer server(config);
+    server.post("/echo", [](const HttpRequest& req, HttpResponse& res) {
+        res.text(req.body());
+    });
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    int fd = connect_to_server(config.port);
+    assert(fd >= 0);
+
+    // 请求行、头部和请求体分多次到达
+    send_raw(fd, "POST /ec");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    send_raw(fd, "ho HTTP/1.1\r\nHost: localhost\r\nContent-Le");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    send_raw(fd, "ngth: 11\r\n\r\nhello ");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    send_raw(fd, "world");
+
+    std::string response = read_responses(fd, 1);
+    assert(response.find("HTTP/1.1 200 OK") != std::string::npos);
+    assert(response.find("\r\n\r\nhello world") != std::string::npos);
+    close(fd);
+
+    assert(server.stats().total_bytes_received.load() > 0);
+    server.stop();
+    std::cout << "Partial request test passed!" << std::endl;
+}
+
+void test_pipelining() {
+    std::cout << "Testing pipelined requests..." << std::endl;
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9997);
+    config.enable_logging = false;
+    config.thread_pool_size = 4;
+    config.max_pipeline_depth = 2;
+
+    HttpServer server(config);
+    server.get("/slow", [](const HttpRequest& req, HttpResponse& res) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        res.text("slow");
+    });
+    server.get("/fast", [](const HttpRequest& req, HttpResponse& res) {
+        res.text("fast-" + req.get_param("id"));
+    });
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    int fd = connect_to_server(config.port);
+    assert(fd >= 0);
+
+    // 一次写入多个请求，超过管线深度上限的部分需在前序响应写出后继续处理
+    std::string batch = "GET /slow HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    for (int i = 1; i <= 4; ++i) {
+        batch += "GET /fast?id=" + std::to_string(i) + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    }
+    send_raw(fd, batch);
+
+    std::string responses = read_responses(fd, 5);
+    size_t slow = responses.find("\r\n\r\nslow");
+    assert(slow != std::string::npos);
+    size_t last = slow;
+    for (int i = 1; i <= 4; ++i) {
+        size_t pos = responses.find("\r\n\r\nfast-" + std::to_string(i));
+        assert(pos != std::string::npos && pos > last);
+        last = pos;
+    }
+
+    // Connection: close 之后的请求不再处理
+    send_raw(fd, "GET /fast?id=5 HTTP/1.1\r\nConnection: close\r\n\r\n"
+                 "GET /fast?id=6 HTTP/1.1\r\n\r\n");
+    std::string closing = read_responses(fd, 2, 500);
+    assert(closing.find("fast-5") != std::string::npos);
+    assert(closing.find("fast-6") == std::string::npos);
+    close(fd);
+
+    assert(server.stats().total_pipelined_requests.load() > 0);
+    server.stop();
+    std::cout << "Pipelining test passed!" << std::endl;
+}
+
+void test_slow_reader() {
+    std::cout << "Testing large responses to a slow reader..." << std::endl;
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9996);
+    config.enable_logging = false;
+    config.output_high_water_mark = 64 * 1024;
+
+    const std::string payload(2 * 1024 * 1024, 'x');
+    HttpServer server(config);
+    server.get("/testdata", [&payload](const HttpRequest& req, HttpResponse& res) {
+        res.text(payload);
+    });
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    int fd = connect_to_server(config.port);
+    assert(fd >= 0);
+    int rcvbuf = 16 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    // 客户端暂不读取，服务器发送缓冲区写满后必须保留剩余数据而不是丢弃
+    std::string batch;
+    for (int i = 0; i < 3; ++i) {
+        batch += "GET /testdata HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    }
+    send_raw(fd, batch);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    std::string responses = read_responses(fd, 3, 5000);
+    size_t count = 0;
+    size_t pos = 0;
+    while ((pos = responses.find("\r\n\r\n", pos)) != std::string::npos) {
+        assert(responses.compare(pos + 4, payload.size(), payload) == 0);
+        pos += 4 + payload.size();
+        ++count;
+    }
+    assert(count == 3);
+    assert(server.stats().total_write_waits.load() > 0);
+    close(fd);
+
+    server.stop();
+    std::cout << "Slow reader test passed!" << std::endl;
+}
+
+void test_static_file() {
+    std::cout << "Testing file-backed static responses..." << std::endl;
+
+    char dir_template[] = "/tmp/xkoj_static_XXXXXX";
+    std::string root = mkdtemp(dir_template);
+    std::string content;
+    for (int i = 0; content.size() < 5 * 1024 * 1024; ++i) {
+        content += "line " + std::to_string(i) + "\n";
+    }
+    {
+        std::ofstream out(root + "/data.txt", std::ios::binary);
+        out << content;
+    }
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9995);
+    config.enable_logging = false;
+
+    HttpServer server(config);
+    server.static_files("/static", root);
+    server.get("/download", [&root](const HttpRequest& req, HttpResponse& res) {
+        res.file(root + "/data.txt");
+    });
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    int fd = connect_to_server(config.port);
+    assert(fd >= 0);
+    send_raw(fd, "GET /static/data.txt HTTP/1.1\r\n\r\nGET /download HTTP/1.1\r\n\r\n");
+    std::string responses = read_responses(fd, 2, 5000);
+    size_t first = responses.find("\r\n\r\n");
+    assert(first != std::string::npos);
+    assert(responses.find("Content-Length: " + std::to_string(content.size())) != std::string::npos);
+    assert(responses.compare(first + 4, content.size(), content) == 0);
+    size_t second = responses.find("\r\n\r\n", first + 4 + content.size());
+    assert(second != std::string::npos);
+    assert(responses.compare(second + 4, content.size(), content) == 0);
+    close(fd);
+
+    server.stop();
+    unlink((root + "/data.txt").c_str());
+    rmdir(root.c_str());
+    std::cout << "Static file test passed!" << std::endl;
+}
+
+static bool wait_for_close(int fd, int timeout_ms) {
+    struct timeval tv{timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    char buf[4096];
+    while (true) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n == 0) {
+            return true;
+        }
+        if (n < 0) {
+            return false;  // 超时仍未关闭
+        }
+    }
+}
+
+void test_timeouts() {
+    std::cout << "Testing connection timeouts..." << std::endl;
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9994);
+    config.enable_logging = false;
+    config.header_timeout_seconds = 1;
+    config.keep_alive_timeout = 1;
+
+    HttpServer server(config);
+    server.get("/ping", [](const HttpRequest& req, HttpResponse& res) {
+        res.text("pong");
+    });
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // 请求头迟迟不完整：持续发送零碎数据也不能延长请求头时限
+    int slow = connect_to_server(config.port);
+    assert(slow >= 0);
+    auto begin = std::chrono::steady_clock::now();
+    send_raw(slow, "GET /ping HTTP/1.1\r\n");
+    for (int i = 0; i < 6; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        send_raw(slow, "X: y\r\n");
+    }
+    assert(wait_for_close(slow, 1000));
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+    assert(elapsed >= 1000 && elapsed < 1800);
+    close(slow);
+
+    // 空闲的keep-alive连接在keep_alive_timeout后关闭
+    int idle = connect_to_server(config.port);
+    assert(idle >= 0);
+    send_raw(idle, "GET /ping HTTP/1.1\r\n\r\n");
+    assert(read_responses(idle, 1).find("pong") != std::string::npos);
+    begin = std::chrono::steady_clock::now();
+    assert(wait_for_close(idle, 2000));
+    elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+    assert(elapsed >= 800 && elapsed < 1500);
+    close(idle);
+
+    assert(server.stats().total_timeouts.load() == 2);
+    server.stop();
+    std::cout << "Timeout test passed!" << std::endl;
+}
+
+void test_single_owner() {
+    std::cout << "Testing one-worker-per-connection dispatch..." << std::endl;
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9993);
+    config.enable_logging = false;
+    config.thread_pool_size = 4;
+
+    std::atomic<int> active{0};
+    std::atomic<int> max_active{0};
+    HttpServer server(config);
+    server.get("/work", [&](const HttpRequest& req, HttpResponse& res) {
+        int now = ++active;
+        int prev = max_active.load();
+        while (now > prev && !max_active.compare_exchange_weak(prev, now)) {}
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        --active;
+        res.text("done");
+    });
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    int fd = connect_to_server(config.port);
+    assert(fd >= 0);
+    const std::string request = "GET /work HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    for (int i = 0; i < 5; ++i) {
+        // 处理期间陆续到达下一个请求的字节，不应再分发给其他工作线程
+        send_raw(fd, request);
+        for (char c : request) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            send_raw(fd, std::string(1, c));
+        }
+        std::string responses = read_responses(fd, 2);
+        assert(responses.find("done") != std::string::npos);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // 每次分发都对应一次释放和重新布防
+    const auto& stats = server.stats();
+    assert(max_active.load() == 1);
+    assert(stats.total_dispatches.load() > 0);
+    assert(stats.total_rearms.load() == stats.total_dispatches.load());
+    close(fd);
+    server.stop();
+    std::cout << "Single owner test passed!" << std::endl;
+}
+
+// 通过任意地址族发一个请求并返回响应体
+static std::string fetch(int family, const std::string& address, int port, const std::string& path) {
+    sockaddr_storage addr{};
+    socklen_t addr_len = 0;
+    if (family == AF_UNIX) {
+        auto& un = reinterpret_cast<sockaddr_un&>(addr);
+        un.sun_family = AF_UNIX;
+        strncpy(un.sun_path, address.c_str(), sizeof(un.sun_path) - 1);
+        addr_len = sizeof(un);
+    } else if (family == AF_INET6) {
+        auto& in6 = reinterpret_cast<sockaddr_in6&>(addr);
+        in6.sin6_family = AF_INET6;
+        in6.sin6_port = htons(port);
+        inet_pton(AF_INET6, address.c_str(), &in6.sin6_addr);
+        addr_len = sizeof(in6);
+    } else {
+        auto& in = reinterpret_cast<sockaddr_in&>(addr);
+        in.sin_family = AF_INET;
+        in.sin_port = htons(port);
+        inet_pton(AF_INET, address.c_str(), &in.sin_addr);
+        addr_len = sizeof(in);
+    }
+    int fd = socket(family, SOCK_STREAM, 0);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), addr_len) < 0) {
+        close(fd);
+        return "";
+    }
+    send_raw(fd, "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    std::string response = read_responses(fd, 1);
+    close(fd);
+    size_t body = response.find("\r\n\r\n");
+    return body == std::string::npos ? "" : response.substr(body + 4);
+}
+
+void test_listeners() {
+    std::cout << "Testing Unix domain and dual-stack listeners..." << std::endl;
+
+    const std::string unix_path = "/tmp/xkoj_test_" + g_io_backend + ".sock";
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9992);
+    config.enable_logging = false;
+    config.reactor_count = 2;  // Unix域套接字由两个Reactor共享
+    HttpServer::ListenerConfig unix_listener;
+    unix_listener.address = "unix:" + unix_path;
+    HttpServer::ListenerConfig dual_stack;
+    dual_stack.address = "::";
+    dual_stack.defer_accept_seconds = 1;
+    dual_stack.fastopen_queue = 16;
+    config.listeners = {unix_listener, dual_stack};
+
+    HttpServer server(config);
+    server.get("/ip", [](const HttpRequest& req, HttpResponse& res) {
+        res.text(req.client_ip());
+    });
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // 双栈监听收到的IPv4连接以点分形式呈现
+    assert(fetch(AF_INET, "127.0.0.1", config.port, "/ip") == "127.0.0.1");
+    assert(fetch(AF_INET6, "::1", config.port, "/ip") == "::1");
+    for (int i = 0; i < 4; ++i) {
+        assert(fetch(AF_UNIX, unix_path, 0, "/ip") == "unix");
+    }
+
+    server.stop();
+    struct stat st;
+    assert(stat(unix_path.c_str(), &st) < 0);
+    std::cout << "Listener test passed!" << std::endl;
+}
+
+// 对端已关闭（读到EOF）时返回true
+static bool peer_closed(int fd, int timeout_ms = 1000) {
+    struct timeval tv{timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    char c;
+    return recv(fd, &c, 1, 0) == 0;
+}
+
+void test_admission_control() {
+    std::cout << "Testing connection cap and overload policies..." << std::endl;
+    const std::string request = "GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    for (auto policy : {HttpServer::OverloadPolicy::REJECT, HttpServer::OverloadPolicy::DROP_IDLE,
+                        HttpServer::OverloadPolicy::PAUSE_ACCEPT}) {
+        HttpServer::ServerConfig config;
+        config.io_backend = g_io_backend;
+        config.port = test_port(9991 - static_cast<int>(policy));
+        config.enable_logging = false;
+        config.max_connections = 2;
+        config.overload_policy = policy;
+        config.retry_after_seconds = 3;
+
+        HttpServer server(config);
+        server.get("/hello", [](const HttpRequest& req, HttpResponse& res) {
+            res.text("hello");
+        });
+        assert(server.start());
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        // 占满名额的两个keep-alive连接，先建立的空闲更久
+        int first = connect_to_server(config.port);
+        send_raw(first, request);
+        assert(read_responses(first, 1).find("hello") != std::string::npos);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        int second = connect_to_server(config.port);
+        send_raw(second, request);
+        assert(read_responses(second, 1).find("hello") != std::string::npos);
+
+        int third = connect_to_server(config.port);
+        assert(third >= 0);
+        const auto& stats = server.stats();
+        if (policy == HttpServer::OverloadPolicy::REJECT) {
+            std::string response = read_responses(third, 1);
+            assert(response.find("HTTP/1.1 503") == 0);
+            assert(response.find("Retry-After: 3\r\n") != std::string::npos);
+            assert(stats.total_shed_rejected.load() == 1);
+        }
+        else if (policy == HttpServer::OverloadPolicy::DROP_IDLE) {
+            send_raw(third, request);
+            assert(read_responses(third, 1).find("hello") != std::string::npos);
+            assert(peer_closed(first));
+            assert(stats.total_shed_idle_dropped.load() == 1);
+        }
+        else {
+            // 连接留在backlog中，名额释放后才被接受
+            send_raw(third, request);
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            assert(stats.total_accept_pauses.load() >= 1);
+            assert(stats.total_requests.load() == 2);
+            close(first);
+            assert(read_responses(third, 1).find("hello") != std::string::npos);
+        }
+        assert(stats.active_connections.load() <= 2);
+        close(first);
+        close(second);
+        close(third);
+        server.stop();
+    }
+
+    // 请求队列已满：工作线程忙于第一个请求，第二个在排队，第三个被拒绝
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9988);
+    config.enable_logging = false;
+    config.thread_pool_size = 1;
+    config.max_queued_requests = 1;
+    HttpServer server(config);
+    server.get("/slow", [](const HttpRequest& req, HttpResponse& res) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        res.text("slow");
+    });
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    int fds[3];
+    for (int& fd : fds) {
+        fd = connect_to_server(config.port);
+        send_raw(fd, "GET /slow HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    assert(read_responses(fds[2], 1).find("HTTP/1.1 503") == 0);
+    assert(read_responses(fds[0], 1).find("slow") != std::string::npos);
+    assert(read_responses(fds[1], 1).find("slow") != std::string::npos);
+    assert(server.stats().total_shed_requests.load() == 1);
+    for (int fd : fds) {
+        close(fd);
+    }
+    server.stop();
+    std::cout << "Admission control test passed!" << std::endl;
+}
+
+void test_hot_restart() {
+    std::cout << "Testing listening socket handoff..." << std::endl;
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9987);
+    config.enable_logging = false;
+    config.handoff_path = "/tmp/xkoj_test_handoff_" + g_io_backend + ".sock";
+    config.drain_timeout_seconds = 5;
+
+    HttpServer old_server(config);
+    old_server.get("/slow", [](const HttpRequest& req, HttpResponse& res) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        res.text("old");
+    });
+    assert(old_server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // 交接时正在处理的请求由旧进程完成，响应后关闭连接
+    int in_flight = connect_to_server(config.port);
+    send_raw(in_flight, "GET /slow HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // 未开启SO_REUSEPORT，新实例若重新绑定同一端口会失败
+    HttpServer new_server(config);
+    new_server.get("/slow", [](const HttpRequest& req, HttpResponse& res) {
+        res.text("new");
+    });
+    assert(new_server.start());
+    // 旧实例在下一轮事件循环（至多一个定时器周期）后停止accept
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    assert(fetch(AF_INET, "127.0.0.1", config.port, "/slow") == "new");
+
+    std::string old_response = read_responses(in_flight, 1);
+    assert(old_response.find("old") != std::string::npos);
+    assert(old_response.find("Connection: close") != std::string::npos);
+    close(in_flight);
+
+    for (int i = 0; i < 50 && old_server.is_running(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    assert(!old_server.is_running());
+    old_server.stop();
+    assert(fetch(AF_INET, "127.0.0.1", config.port, "/slow") == "new");
+
+    new_server.stop();
+    struct stat st;
+    assert(stat(config.handoff_path.c_str(), &st) < 0);
+    std::cout << "Hot restart test passed!" << std::endl;
+}
+
+void test_streaming_body() {
+    std::cout << "Testing streaming request bodies..." << std::endl;
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9986);
+    config.enable_logging = false;
+    config.thread_pool_size = 2;
+    config.max_request_size = 1024;
+
+    HttpServer server(config);
+    // 流式路由的请求体不受max_request_size限制，处理器边接收边累加
+    server.stream(HttpMethod::POST, "/upload", [](const HttpRequest& req, HttpResponse& res) {
+        assert(req.body().empty());
+        size_t total = 0;
+        uint32_t sum = 0;
+        bool complete = req.consume_body([&](std::string_view chunk) {
+            total += chunk.size();
+            for (char c : chunk) {
+                sum += static_cast<unsigned char>(c);
+            }
+            return true;
+        });
+        res.text((complete ? "" : "incomplete-") + std::to_string(total) + ":" + std::to_string(sum));
+    });
+    server.stream(HttpMethod::POST, "/ignore", [](const HttpRequest& req, HttpResponse& res) {
+        res.text("ignored");
+    });
+    server.post("/echo", [](const HttpRequest& req, HttpResponse& res) {
+        res.text(req.body());
+    });
+    server.get("/fast", [](const HttpRequest& req, HttpResponse& res) {
+        res.text("fast");
+    });
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::string payload;
+    uint32_t sum = 0;
+    for (int i = 0; i < 100000; ++i) {
+        payload.push_back(static_cast<char>('a' + i % 26));
+        sum += static_cast<unsigned char>(payload.back());
+    }
+    std::string expected = "100000:" + std::to_string(sum);
+
+    // 定长请求体分多次到达，其后紧跟管线化请求
+    int fd = connect_to_server(config.port);
+    assert(fd >= 0);
+    send_raw(fd, "POST /upload HTTP/1.1\r\nContent-Length: 100000\r\n\r\n" + payload.substr(0, 30000));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    send_raw(fd, payload.substr(30000) + "GET /fast HTTP/1.1\r\n\r\n");
+    std::string responses = read_responses(fd, 2);
+    size_t upload = responses.find("\r\n\r\n" + expected);
+    assert(upload != std::string::npos);
+    assert(responses.find("\r\n\r\nfast", upload) != std::string::npos);
+
+    // chunked请求体：块扩展、跨包的块边界与trailer
+    std::string chunked = "POST /upload HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+    for (size_t offset = 0; offset < payload.size(); offset += 7000) {
+        size_t n = std::min<size_t>(7000, payload.size() - offset);
+        char size_line[32];
+        snprintf(size_line, sizeof(size_line), "%zx;ext=1\r\n", n);
+        chunked += size_line + payload.substr(offset, n) + "\r\n";
+    }
+    chunked += "0\r\nX-Checksum: 1\r\n\r\n";
+    send_raw(fd, chunked.substr(0, 12345));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    send_raw(fd, chunked.substr(12345) + "GET /fast HTTP/1.1\r\n\r\n");
+    responses = read_responses(fd, 2);
+    upload = responses.find("\r\n\r\n" + expected);
+    assert(upload != std::string::npos);
+    assert(responses.find("\r\n\r\nfast", upload) != std::string::npos);
+
+    // 客户端等待100 Continue后才发送请求体
+    send_raw(fd, "POST /upload HTTP/1.1\r\nContent-Length: 3\r\nExpect: 100-continue\r\n\r\n");
+    char interim[64] = {};
+    assert(recv(fd, interim, sizeof(interim) - 1, 0) > 0);
+    assert(std::string(interim) == "HTTP/1.1 100 Continue\r\n\r\n");
+    send_raw(fd, "abc");
+    assert(read_responses(fd, 1).find("\r\n\r\n3:294") != std::string::npos);
+
+    // 处理器未读的请求体在限额内丢弃，连接继续可用
+    send_raw(fd, "POST /ignore HTTP/1.1\r\nContent-Length: 500\r\n\r\n" + std::string(500, 'x') +
+                 "GET /fast HTTP/1.1\r\n\r\n");
+    responses = read_responses(fd, 2);
+    assert(responses.find("ignored") != std::string::npos);
+    assert(responses.find("\r\n\r\nfast") != std::string::npos);
+    assert(responses.find("Connection: close") == std::string::npos);
+    close(fd);
+
+    // 未知方法不会匹配流式路由，按普通请求读完请求体后回复501，服务器继续工作
+    fd = connect_to_server(config.port);
+    send_raw(fd, "PROPFIND /upload HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello"
+                 "GET /fast HTTP/1.1\r\n\r\n");
+    responses = read_responses(fd, 2);
+    assert(responses.find("HTTP/1.1 501") == 0);
+    assert(responses.find("\r\n\r\nfast") != std::string::npos);
+    close(fd);
+
+    // 普通路由：chunked请求体解码后整体交给处理器，超出max_request_size时413
+    fd = connect_to_server(config.port);
+    send_raw(fd, "POST /echo HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                 "4\r\nWiki\r\n5\r\npedia\r\n0\r\n\r\n");
+    assert(read_responses(fd, 1).find("\r\n\r\nWikipedia") != std::string::npos);
+    send_raw(fd, "POST /echo HTTP/1.1\r\nContent-Length: 2000\r\n\r\n");
+    assert(read_responses(fd, 1).find("HTTP/1.1 413") != std::string::npos);
+    close(fd);
+
+    server.stop();
+    std::cout << "Streaming body test passed!" << std::endl;
+}
+
+void test_streaming_response() {
+    std::cout << "Testing chunked streaming responses..." << std::endl;
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9985);
+    config.enable_logging = false;
+    config.thread_pool_size = 2;
+    config.output_high_water_mark = 64 * 1024;
+
+    HttpServer server(config);
+    std::atomic<bool> first_seen{false};
+    std::atomic<bool> seen_before_finish{false};
+    const size_t piece = 16 * 1024;
+    const size_t pieces = 256;
+    server.get("/export", [&](const HttpRequest& req, HttpResponse& res) {
+        res.set_header("Content-Type", "text/csv");
+        assert(res.write_chunk("first\n"));
+        // 第一个分块应在处理器返回前到达客户端
+        for (int i = 0; i < 200 && !first_seen.load(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        seen_before_finish = first_seen.load();
+        std::string line(piece, 'x');
+        for (size_t i = 0; i < pieces; ++i) {
+            if (!res.write_chunk(line)) {
+                return;
+            }
+        }
+    });
+    server.get("/legacy", [](const HttpRequest& req, HttpResponse& res) {
+        res.write_chunk("a");
+        res.write_chunk("b");
+        res.end_streaming();
+    });
+    server.get("/fast", [](const HttpRequest& req, HttpResponse& res) {
+        res.text("fast");
+    });
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    int fd = connect_to_server(config.port);
+    assert(fd >= 0);
+    struct timeval tv{2, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    send_raw(fd, "GET /export HTTP/1.1\r\n\r\nGET /fast HTTP/1.1\r\n\r\n");
+
+    std::string data;
+    char buf[65536];
+    while (data.find("first\n") == std::string::npos) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        assert(n > 0);
+        data.append(buf, n);
+    }
+    first_seen = true;
+    size_t header_end = data.find("\r\n\r\n");
+    assert(data.find("Transfer-Encoding: chunked") < header_end);
+    assert(data.find("Content-Length") > header_end);
+
+    // 客户端暂不读取，生产方应因输出积压而挂起，而不是把全部输出堆在内存中
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    assert(server.stats().total_stream_waits.load() > 0);
+
+    BodyDecoder decoder;
+    decoder.reset_chunked();
+    size_t decoded = 0;
+    size_t offset = header_end + 4;
+    while (!decoder.done()) {
+        size_t consumed = 0;
+        std::string_view chunk;
+        BodyDecoder::Result result = decoder.decode(std::string_view(data).substr(offset), consumed, chunk);
+        assert(result != BodyDecoder::Result::ERROR);
+        offset += consumed;
+        decoded += chunk.size();
+        if (result == BodyDecoder::Result::INCOMPLETE) {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            assert(n > 0);
+            data.append(buf, n);
+        }
+    }
+    assert(decoded == 6 + piece * pieces);
+    assert(seen_before_finish.load());
+
+    // 管线化的后续请求在流式响应结束后按序应答
+    std::string rest = data.substr(offset);
+    while (rest.find("\r\n\r\nfast") == std::string::npos) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        assert(n > 0);
+        rest.append(buf, n);
+    }
+    assert(rest.compare(0, 9, "HTTP/1.1 ") == 0);
+    close(fd);
+
+    // HTTP/1.0客户端不支持chunked：直接发送数据，以关闭连接结束响应体
+    fd = connect_to_server(config.port);
+    send_raw(fd, "GET /legacy HTTP/1.0\r\n\r\n");
+    std::string legacy;
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+        legacy.append(buf, n);
+    }
+    assert(n == 0);
+    assert(legacy.find("Transfer-Encoding") == std::string::npos);
+    assert(legacy.substr(legacy.find("\r\n\r\n") + 4) == "ab");
+    close(fd);
+
+    assert(server.stats().total_streamed_responses.load() == 2);
+    server.stop();
+    std::cout << "Streaming response test passed!" << std::endl;
+}
+
+// 读取直到收到指定内容，返回false表示超时或连接关闭
+static bool read_until(int fd, std::string& data, const std::string& expected, int timeout_ms = 3000) {
+    struct timeval tv{0, 100 * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    char buf[4096];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (data.find(expected) == std::string::npos) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n == 0) {
+            return false;
+        }
+        if (n > 0) {
+            data.append(buf, n);
+        }
+    }
+    return true;
+}
+
+void test_server_sent_events() {
+    std::cout << "Testing server-sent events..." << std::endl;
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9984);
+    config.enable_logging = false;
+    config.thread_pool_size = 1;
+    config.sse_heartbeat_seconds = 1;
+    config.sse_replay_capacity = 4;
+
+    HttpServer server(config);
+    auto channel = server.event_channel("judge");
+    assert(server.event_channel("judge") == channel);
+    server.get("/events", [&server](const HttpRequest& req, HttpResponse& res) {
+        server.subscribe(req, res, server.event_channel("judge"));
+    });
+    server.get("/fast", [](const HttpRequest& req, HttpResponse& res) {
+        res.text("fast");
+    });
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    int a = connect_to_server(config.port);
+    assert(a >= 0);
+    send_raw(a, "GET /events HTTP/1.1\r\n\r\n");
+    std::string data_a;
+    assert(read_until(a, data_a, "\r\n\r\n"));
+    assert(data_a.find("Content-Type: text/event-stream") != std::string::npos);
+    assert(data_a.find("Transfer-Encoding: chunked") != std::string::npos);
+    for (int i = 0; i < 100 && channel->subscriber_count() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    assert(channel->subscriber_count() == 1);
+
+    // 订阅不占用工作线程：唯一的工作线程仍能处理其他请求
+    int b = connect_to_server(config.port);
+    send_raw(b, "GET /fast HTTP/1.1\r\n\r\n");
+    assert(read_responses(b, 1).find("fast") != std::string::npos);
+    close(b);
+
+    assert(channel->publish("hello") == 1);
+    assert(channel->publish("line1\nline2", "status") == 2);
+    assert(read_until(a, data_a, "id: 2\nevent: status\ndata: line1\ndata: line2\n\n"));
+    assert(data_a.find("id: 1\ndata: hello\n\n") != std::string::npos);
+
+    // 回放缓冲区只保留最近4个事件；按Last-Event-ID补发其后的事件
+    for (int i = 3; i <= 6; ++i) {
+        channel->publish("event " + std::to_string(i));
+    }
+    assert(channel->last_event_id() == 6);
+    b = connect_to_server(config.port);
+    send_raw(b, "GET /events HTTP/1.1\r\nLast-Event-ID: 4\r\n\r\n");
+    std::string data_b;
+    assert(read_until(b, data_b, "id: 6\n"));
+    assert(data_b.find("id: 5\n") != std::string::npos);
+    assert(data_b.find("id: 4\n") == std::string::npos);
+    assert(data_b.find("id: 3\n") == std::string::npos);
+    close(b);
+
+    // 空闲的订阅连接收到心跳注释行；已关闭的订阅者在发送心跳时被移除
+    data_a.clear();
+    assert(read_until(a, data_a, ":\n\n", 4000));
+    for (int i = 0; i < 500 && channel->subscriber_count() != 1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    assert(channel->subscriber_count() == 1);
+
+    // 移除频道时结束所有订阅
+    server.remove_event_channel("judge");
+    assert(read_until(a, data_a, "0\r\n\r\n"));
+    assert(wait_for_close(a, 1000));
+    close(a);
+
+    assert(server.stats().total_events_published.load() == 6);
+    server.stop();
+    std::cout << "Server-sent events test passed!" << std::endl;
+}
+
+// 客户端帧必须加掩码
+static std::string client_frame(uint8_t first_byte, const std::string& payload) {
+    std::string frame(1, static_cast<char>(first_byte));
+    if (payload.size() < 126) {
+        frame.push_back(static_cast<char>(0x80 | payload.size()));
+    }
+    else {
+        frame.push_back(static_cast<char>(0x80 | 126));
+        frame.push_back(static_cast<char>(payload.size() >> 8));
+        frame.push_back(static_cast<char>(payload.size()));
+    }
+    const char key[4] = {0x12, 0x34, 0x56, 0x78};
+    frame.append(key, 4);
+    for (size_t i = 0; i < payload.size(); ++i) {
+        frame.push_back(payload[i] ^ key[i & 3]);
+    }
+    return frame;
+}
+
+// 从data开头取出一个服务器帧
+static bool read_frame(int fd, std::string& data, WebSocketFrameParser::Frame& frame) {
+    WebSocketFrameParser parser(SIZE_MAX, false);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(3);
+    while (std::chrono::steady_clock::now() < deadline) {
+        size_t consumed = 0;
+        auto result = parser.parse(data, consumed, frame);
+        if (result == WebSocketFrameParser::Result::FRAME) {
+            data.erase(0, consumed);
+            return true;
+        }
+        if (result == WebSocketFrameParser::Result::ERROR) {
+            return false;
+        }
+        char buf[4096];
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n == 0) {
+            return false;
+        }
+        if (n > 0) {
+            data.append(buf, n);
+        }
+    }
+    return false;
+}
+
+static int open_websocket(int port, const std::string& extra_headers, std::string& data) {
+    int fd = connect_to_server(port);
+    send_raw(fd, "GET /ws HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\nConnection: keep-alive, Upgrade\r\n"
+                 "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n" +
+                 extra_headers + "\r\n");
+    if (!read_until(fd, data, "\r\n\r\n")) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void test_websocket() {
+    std::cout << "Testing WebSocket..." << std::endl;
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9983);
+    config.enable_logging = false;
+    config.thread_pool_size = 2;
+
+    HttpServer server(config);
+    std::atomic<int> closed{0};
+    std::atomic<int> close_code{0};
+    server.websocket("/ws", [&](const HttpRequest& req, const std::shared_ptr<WebSocket>& ws) {
+        assert(req.path() == "/ws");
+        ws->on_message([](WebSocket& socket, std::string_view data, bool binary) {
+            if (data == "bye") {
+                socket.close(WebSocket::GOING_AWAY, "done");
+            }
+            else if (binary) {
+                socket.send_binary(data);
+            }
+            else {
+                socket.send_text(data);
+            }
+        });
+        ws->on_close([&](WebSocket&, uint16_t code, std::string_view) {
+            close_code = code;
+            ++closed;
+        });
+    });
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // 握手：RFC 6455 1.3的示例；头部名按首字母大写规范化
+    std::string data;
+    int fd = open_websocket(config.port, "", data);
+    assert(fd >= 0);
+    assert(data.compare(0, 34, "HTTP/1.1 101 Switching Protocols\r\n") == 0);
+    assert(data.find(": s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n") != std::string::npos);
+    assert(data.find("Content-Length") == std::string::npos);
+    assert(data.find("permessage-deflate") == std::string::npos);
+    data.erase(0, data.find("\r\n\r\n") + 4);
+
+    // 回显；分片消息中间插入ping
+    WebSocketFrameParser::Frame frame;
+    send_raw(fd, client_frame(0x81, "hello"));
+    assert(read_frame(fd, data, frame) && frame.opcode == WebSocket::TEXT && frame.payload == "hello");
+    send_raw(fd, client_frame(0x02, "frag") + client_frame(0x89, "p") + client_frame(0x80, "mented"));
+    assert(read_frame(fd, data, frame) && frame.opcode == WebSocket::PONG && frame.payload == "p");
+    assert(read_frame(fd, data, frame) && frame.opcode == WebSocket::BINARY && frame.payload == "fragmented");
+    std::string large(1000, 'z');
+    send_raw(fd, client_frame(0x81, large));
+    assert(read_frame(fd, data, frame) && frame.payload == large && !frame.rsv1);
+
+    // 客户端发起关闭：回复关闭帧后断开
+    send_raw(fd, client_frame(0x88, std::string("\x03\xE8", 2)));
+    assert(read_frame(fd, data, frame) && frame.opcode == WebSocket::CLOSE);
+    assert(frame.payload == std::string("\x03\xE8", 2));
+    assert(wait_for_close(fd, 1000));
+    close(fd);
+    for (int i = 0; i < 100 && closed.load() < 1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    assert(closed.load() == 1 && close_code.load() == 1000);
+
+    // 服务器发起关闭，等待对端回复
+    data.clear();
+    fd = open_websocket(config.port, "", data);
+    data.erase(0, data.find("\r\n\r\n") + 4);
+    send_raw(fd, client_frame(0x81, "bye"));
+    assert(read_frame(fd, data, frame) && frame.opcode == WebSocket::CLOSE);
+    assert(frame.payload == std::string("\x03\xE9" "done", 6));
+    send_raw(fd, client_frame(0x88, std::string("\x03\xE9", 2)));
+    assert(wait_for_close(fd, 1000));
+    close(fd);
+
+    // 协议错误：未加掩码的帧
+    data.clear();
+    fd = open_websocket(config.port, "", data);
+    data.erase(0, data.find("\r\n\r\n") + 4);
+    send_raw(fd, WebSocket::encode_frame(WebSocket::TEXT, "x"));
+    assert(read_frame(fd, data, frame) && frame.opcode == WebSocket::CLOSE);
+    assert(frame.payload == std::string("\x03\xEA", 2));
+    assert(wait_for_close(fd, 1000));
+    close(fd);
+    for (int i = 0; i < 100 && closed.load() < 3; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    assert(closed.load() == 3 && close_code.load() == 1002);
+
+#ifdef XKOJ_HAVE_ZLIB
+    // permessage-deflate：客户端发送压缩消息，回显同样压缩
+    data.clear();
+    fd = open_websocket(config.port, "Sec-WebSocket-Extensions: permessage-deflate; client_max_window_bits\r\n", data);
+    assert(data.find(": permessage-deflate; server_no_context_takeover\r\n") !=
+           std::string::npos);
+    data.erase(0, data.find("\r\n\r\n") + 4);
+    auto prepared = WebSocket::prepare(large);
+    assert(prepared->deflated_frame && prepared->deflated_frame->size() < 100);
+    WebSocketFrameParser::Frame compressed;
+    size_t consumed = 0;
+    WebSocketFrameParser(SIZE_MAX, false).parse(*prepared->deflated_frame, consumed, compressed);
+    send_raw(fd, client_frame(0xC1, compressed.payload));
+    assert(read_frame(fd, data, frame) && frame.rsv1 && frame.payload == compressed.payload);
+    send_raw(fd, client_frame(0xC1, compressed.payload));  // 解压上下文跨消息保留
+    assert(read_frame(fd, data, frame) && frame.rsv1);
+    close(fd);
+#endif
+
+    // 无效握手
+    int plain = connect_to_server(config.port);
+    send_raw(plain, "GET /ws HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 8\r\n\r\n");
+    std::string response = read_responses(plain, 1);
+    assert(response.find("426") != std::string::npos);
+    assert(response.find("Version: 13\r\n") != std::string::npos);
+    send_raw(plain, "GET /ws HTTP/1.1\r\n\r\n");
+    assert(read_responses(plain, 1).find("400") != std::string::npos);
+    close(plain);
+
+    assert(server.stats().total_websocket_upgrades.load() >= 3);
+    server.stop();
+    std::cout << "WebSocket test passed!" << std::endl;
+}
+
+static std::string h2_frame(uint8_t type, uint8_t flags, uint32_t stream_id, const std::string& payload) {
+    std::string frame;
+    http2::append_frame_header(frame, static_cast<uint32_t>(payload.size()), type, flags, stream_id);
+    return frame + payload;
+}
+
+static std::string h2_request(HpackEncoder& encoder, const std::string& method, const std::string& path) {
+    std::string block;
+    encoder.begin_block(block);
+    encoder.encode(":method", method, block);
+    encoder.encode(":scheme", "http", block);
+    encoder.encode(":path", path, block);
+    encoder.encode(":authority", "localhost", block);
+    return block;
+}
+
+static std::string h2_u32(uint32_t value) {
+    std::string out(4, '\0');
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<char>(value >> (24 - 8 * i));
+    }
+    return out;
+}
+
+// HTTP/2客户端收到的一个流的响应
+struct H2Response {
+    std::string status;
+    std::string body;
+    bool ended = false;
+};
+
+// 读取一个完整的帧，返回false表示超时或连接关闭
+static bool read_h2_frame(int fd, std::string& data, http2::FrameHeader& header, std::string& payload,
+                          int timeout_ms = 3000) {
+    struct timeval tv{0, 50 * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    char buf[65536];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (data.size() < http2::FRAME_HEADER_SIZE ||
+           data.size() < http2::FRAME_HEADER_SIZE + http2::parse_frame_header(data).length) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n == 0) {
+            return false;
+        }
+        if (n > 0) {
+            data.append(buf, n);
+        }
+    }
+    header = http2::parse_frame_header(data);
+    payload = data.substr(http2::FRAME_HEADER_SIZE, header.length);
+    data.erase(0, http2::FRAME_HEADER_SIZE + header.length);
+    return true;
+}
+
+// 处理帧直到done返回true，顺带确认服务器的SETTINGS；超时返回false
+template <typename Done>
+static bool read_h2_until(int fd, std::string& data, HpackDecoder& decoder,
+                          std::map<uint32_t, H2Response>& responses, Done done, int timeout_ms = 3000) {
+    http2::FrameHeader header;
+    std::string payload;
+    while (!done()) {
+        if (!read_h2_frame(fd, data, header, payload, timeout_ms)) {
+            return false;
+        }
+        H2Response& response = responses[header.stream_id];
+        if (header.type == http2::HEADERS) {
+            assert(header.flags & http2::FLAG_END_HEADERS);
+            std::vector<HpackHeader> headers;
+            assert(decoder.decode(payload, headers) == HpackDecoder::Result::OK);
+            for (const auto& h : headers) {
+                if (h.name == ":status") {
+                    response.status = h.value;
+                }
+            }
+        }
+        else if (header.type == http2::DATA) {
+            response.body += payload;
+        }
+        else if (header.type == http2::SETTINGS && !(header.flags & http2::FLAG_ACK)) {
+            send_raw(fd, h2_frame(http2::SETTINGS, http2::FLAG_ACK, 0, ""));
+        }
+        else if (header.type == http2::GOAWAY) {
+            response.status = "goaway";
+            response.body = payload;
+        }
+        if ((header.type == http2::HEADERS || header.type == http2::DATA) &&
+            (header.flags & http2::FLAG_END_STREAM)) {
+            response.ended = true;
+        }
+    }
+    return true;
+}
+
+void test_http2() {
+    std::cout << "Testing HTTP/2..." << std::endl;
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9982);
+    config.enable_logging = false;
+    config.thread_pool_size = 2;
+
+    HttpServer server(config);
+    server.get("/hello", [](const HttpRequest& req, HttpResponse& res) {
+        res.set_body("hello " + req.get_param("n") + " " + req.get_header("host"));
+    });
+    server.post("/echo", [](const HttpRequest& req, HttpResponse& res) {
+        res.set_body(req.body());
+    });
+    const std::string big(100000, 'b');
+    server.get("/big", [&big](const HttpRequest&, HttpResponse& res) {
+        res.set_body(big);
+    });
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // 先验知识：连接前言后多个流并发，流的初始窗口只有100字节
+    int fd = connect_to_server(config.port);
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    std::string settings = std::string("\x00\x04", 2) + h2_u32(100);
+    std::string out = std::string(http2::CONNECTION_PREFACE) + h2_frame(http2::SETTINGS, 0, 0, settings) +
+                      h2_frame(http2::WINDOW_UPDATE, 0, 0, h2_u32(1 << 20));
+    for (uint32_t id = 1; id <= 5; id += 2) {
+        out += h2_frame(http2::HEADERS, http2::FLAG_END_HEADERS | http2::FLAG_END_STREAM, id,
+                        h2_request(encoder, "GET", "/hello?n=" + std::to_string(id)));
+    }
+    out += h2_frame(http2::HEADERS, http2::FLAG_END_HEADERS, 7, h2_request(encoder, "POST", "/echo"));
+    out += h2_frame(http2::DATA, 0, 7, "submit ");
+    out += h2_frame(http2::DATA, http2::FLAG_END_STREAM, 7, "code");
+    send_raw(fd, out);
+
+    std::string data;
+    std::map<uint32_t, H2Response> responses;
+    assert(read_h2_until(fd, data, decoder, responses, [&] {
+        return responses[1].ended && responses[3].ended && responses[5].ended && responses[7].ended;
+    }));
+    for (uint32_t id = 1; id <= 5; id += 2) {
+        assert(responses[id].status == "200");
+        assert(responses[id].body == "hello " + std::to_string(id) + " localhost");
+    }
+    assert(responses[7].body == "submit code");
+
+    // 流量控制：窗口用尽后停止发送，WINDOW_UPDATE之后继续
+    send_raw(fd, h2_frame(http2::HEADERS, http2::FLAG_END_HEADERS | http2::FLAG_END_STREAM, 9,
+                          h2_request(encoder, "GET", "/big")));
+    assert(read_h2_until(fd, data, decoder, responses, [&] { return responses[9].body.size() >= 100; }));
+    assert(!read_h2_until(fd, data, decoder, responses, [&] { return responses[9].body.size() > 100; }, 300));
+    assert(responses[9].body.size() == 100 && !responses[9].ended);
+    send_raw(fd, h2_frame(http2::WINDOW_UPDATE, 0, 9, h2_u32(big.size())));
+    assert(read_h2_until(fd, data, decoder, responses, [&] { return responses[9].ended; }));
+    assert(responses[9].body == big);
+
+    // 没有请求头的流，和流0上的DATA一样是连接错误
+    send_raw(fd, h2_frame(http2::DATA, 0, 0, "x"));
+    assert(read_h2_until(fd, data, decoder, responses, [&] { return responses[0].status == "goaway"; }));
+    assert(responses[0].body.substr(4) == h2_u32(http2::PROTOCOL_ERROR));
+    assert(peer_closed(fd));
+    close(fd);
+
+    // Upgrade: h2c，原请求成为1号流
+    fd = connect_to_server(config.port);
+    send_raw(fd, "GET /hello?n=up HTTP/1.1\r\nHost: upgrade\r\nConnection: Upgrade, HTTP2-Settings\r\n"
+                 "Upgrade: h2c\r\nHTTP2-Settings: AAMAAABkAAQAAP__\r\n\r\n");
+    data.clear();
+    assert(read_until(fd, data, "\r\n\r\n"));
+    assert(data.find("HTTP/1.1 101 Switching Protocols\r\n") == 0);
+    data.erase(0, data.find("\r\n\r\n") + 4);
+    send_raw(fd, std::string(http2::CONNECTION_PREFACE) + h2_frame(http2::SETTINGS, 0, 0, ""));
+    HpackDecoder upgrade_decoder;
+    responses.clear();
+    assert(read_h2_until(fd, data, upgrade_decoder, responses, [&] { return responses[1].ended; }));
+    assert(responses[1].status == "200" && responses[1].body == "hello up upgrade");
+    close(fd);
+
+    assert(server.stats().total_http2_sessions.load() == 2);
+    assert(server.stats().total_http2_streams.load() == 6);
+    server.stop();
+    std::cout << "HTTP/2 test passed!" << std::endl;
+}
+
+#ifdef XKOJ_HAVE_ZLIB
+static std::string gunzip(const std::string& data) {
+    z_stream zs{};
+    inflateInit2(&zs, MAX_WBITS + 32);
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    std::string out;
+    char buf[16384];
+    int ret;
+    do {
+        zs.next_out = reinterpret_cast<Bytef*>(buf);
+        zs.avail_out = sizeof(buf);
+        ret = inflate(&zs, Z_NO_FLUSH);
+        out.append(buf, sizeof(buf) - zs.avail_out);
+    } while(ret == Z_OK && zs.avail_in > 0);
+    inflateEnd(&zs);
+    return out;
+}
+#endif
+
+void test_compression() {
+    std::cout << "Testing response compression..." << std::endl;
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9981);
+    config.enable_logging = false;
+    config.thread_pool_size = 2;
+
+    HttpServer server(config);
+    std::string problems = "[";
+    for (int i = 0; i < 300; ++i) {
+        problems += "{\"id\":" + std::to_string(i) + ",\"title\":\"Problem " + std::to_string(i) + "\"},";
+    }
+    problems += "{}]";
+    server.get("/problems", [&problems](const HttpRequest&, HttpResponse& res) {
+        res.json(problems);
+        res.set_header("ETag", "\"v1\"");
+    });
+    server.get("/tiny", [](const HttpRequest&, HttpResponse& res) {
+        res.json("{\"ok\":true}");
+    });
+    server.get("/image", [&problems](const HttpRequest&, HttpResponse& res) {
+        res.set_header("Content-Type", "image/png");
+        res.set_body(problems);
+    });
+    server.get("/export", [&problems](const HttpRequest&, HttpResponse& res) {
+        res.set_header("Content-Type", "text/csv");
+        for (int i = 0; i < 4; ++i) {
+            assert(res.write_chunk(problems));
+        }
+    });
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    auto body_of = [](const std::string& response) {
+        return response.substr(response.find("\r\n\r\n") + 4);
+    };
+    int fd = connect_to_server(config.port);
+    // 未携带Accept-Encoding：原样发送，但标明响应随其变化
+    send_raw(fd, "GET /problems HTTP/1.1\r\n\r\n");
+    std::string response = read_responses(fd, 1);
+    assert(response.find("Content-Encoding") == std::string::npos);
+    assert(response.find("Vary: Accept-Encoding\r\n") != std::string::npos);
+    assert(body_of(response) == problems);
+
+#ifdef XKOJ_HAVE_ZLIB
+    send_raw(fd, "GET /problems HTTP/1.1\r\nAccept-Encoding: gzip, deflate, br\r\n\r\n");
+    response = read_responses(fd, 1);
+    assert(response.find("Content-Encoding: gzip\r\n") != std::string::npos);
+    assert(response.find("Etag: W/\"v1\"\r\n") != std::string::npos);
+    assert(body_of(response).size() < problems.size() / 4);
+    assert(gunzip(body_of(response)) == problems);
+
+    send_raw(fd, "GET /problems HTTP/1.1\r\nAccept-Encoding: gzip;q=0, deflate\r\n\r\n");
+    response = read_responses(fd, 1);
+    assert(response.find("Content-Encoding: deflate\r\n") != std::string::npos);
+    assert(gunzip(body_of(response)) == problems);
+
+    // 过短的响应体与已压缩的类型不压缩
+    send_raw(fd, "GET /tiny HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n");
+    response = read_responses(fd, 1);
+    assert(response.find("Content-Encoding") == std::string::npos && body_of(response) == "{\"ok\":true}");
+    send_raw(fd, "GET /image HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n");
+    response = read_responses(fd, 1);
+    assert(response.find("Content-Encoding") == std::string::npos && body_of(response) == problems);
+
+    // 流式响应逐段压缩，分块解码后整体解压
+    send_raw(fd, "GET /export HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n");
+    std::string data;
+    assert(read_until(fd, data, "\r\n0\r\n\r\n"));
+    assert(data.find("Content-Encoding: gzip\r\n") != std::string::npos);
+    assert(data.find("Transfer-Encoding: chunked\r\n") != std::string::npos);
+    BodyDecoder decoder;
+    decoder.reset_chunked();
+    std::string compressed;
+    size_t offset = data.find("\r\n\r\n") + 4;
+    while (!decoder.done()) {
+        size_t consumed = 0;
+        std::string_view chunk;
+        assert(decoder.decode(std::string_view(data).substr(offset), consumed, chunk) != BodyDecoder::Result::ERROR);
+        offset += consumed;
+        compressed.append(chunk);
+    }
+    assert(compressed.size() < problems.size());
+    assert(gunzip(compressed) == problems + problems + problems + problems);
+    assert(server.stats().total_compressed_responses.load() == 3);
+    assert(server.stats().total_compression_saved_bytes.load() > problems.size());
+#endif
+    close(fd);
+
+    server.stop();
+    std::cout << "Compression test passed!" << std::endl;
+}
+
+void test_static_cache() {
+    std::cout << "Testing static file cache..." << std::endl;
+
+    char dir_template[] = "/tmp/xkoj_cache_XXXXXX";
+    std::string root = mkdtemp(dir_template);
+    std::string page;
+    for (int i = 0; page.size() < 8192; ++i) {
+        page += "<li>Problem " + std::to_string(i) + "</li>\n";
+    }
+    auto write_file = [](const std::string& path, const std::string& content) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << content;
+    };
+    write_file(root + "/index.html", page);
+    mkdir((root + "/js").c_str(), 0755);
+    write_file(root + "/js/app.js", "console.log(1);");
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9980);
+    config.enable_logging = false;
+    config.thread_pool_size = 2;
+
+    HttpServer server(config);
+    server.static_files("/static", root);
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    assert(server.static_cache().enabled());
+
+    auto body_of = [](const std::string& response) {
+        return response.substr(response.find("\r\n\r\n") + 4);
+    };
+    int fd = connect_to_server(config.port);
+    // 第一次载入，之后命中
+    for (int i = 0; i < 3; ++i) {
+        send_raw(fd, "GET /static/index.html HTTP/1.1\r\n\r\n");
+        std::string response = read_responses(fd, 1);
+        assert(response.find("Content-Type: text/html") != std::string::npos);
+        assert(body_of(response) == page);
+    }
+    send_raw(fd, "GET /static/js/app.js HTTP/1.1\r\n\r\n");
+    assert(body_of(read_responses(fd, 1)) == "console.log(1);");
+    assert(server.static_cache().stats().hits.load() >= 2);
+    assert(server.static_cache().stats().entries.load() == 2);
+
+#ifdef XKOJ_HAVE_ZLIB
+    // 载入时生成的gzip变体
+    send_raw(fd, "GET /static/index.html HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n");
+    std::string response = read_responses(fd, 1);
+    assert(response.find("Content-Encoding: gzip\r\n") != std::string::npos);
+    assert(response.find("Vary: Accept-Encoding\r\n") != std::string::npos);
+    assert(gunzip(body_of(response)) == page);
+#endif
+
+    // 文件修改后缓存经inotify失效，子目录同样被监视
+    write_file(root + "/index.html", "updated");
+    write_file(root + "/js/app.js", "console.log(2);");
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    send_raw(fd, "GET /static/index.html HTTP/1.1\r\n\r\n");
+    assert(body_of(read_responses(fd, 1)) == "updated");
+    send_raw(fd, "GET /static/js/app.js HTTP/1.1\r\n\r\n");
+    assert(body_of(read_responses(fd, 1)) == "console.log(2);");
+    assert(server.static_cache().stats().invalidations.load() >= 2);
+
+    // 删除后不再返回旧内容
+    unlink((root + "/js/app.js").c_str());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    send_raw(fd, "GET /static/js/app.js HTTP/1.1\r\n\r\n");
+    assert(read_responses(fd, 1).find("404") != std::string::npos);
+    close(fd);
+
+    server.stop();
+    assert(server.static_cache().stats().entries.load() == 0);
+
+    // 根目录带多余的'/'或经符号链接（部署时切换的current）同样缓存；链接改指向后返回新内容
+    mkdir((root + "/release-1").c_str(), 0755);
+    mkdir((root + "/release-2").c_str(), 0755);
+    write_file(root + "/release-1/app.js", "v1");
+    write_file(root + "/release-2/app.js", "v2");
+    assert(symlink("release-1", (root + "/current").c_str()) == 0);
+    config.port = test_port(9975);
+    HttpServer linked(config);
+    linked.static_files("/site", root + "/current");
+    linked.static_files("/docs", root + "/release-2/");
+    assert(linked.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    fd = connect_to_server(config.port);
+    for (int i = 0; i < 3; ++i) {
+        send_raw(fd, "GET /site/app.js HTTP/1.1\r\n\r\nGET /docs/app.js HTTP/1.1\r\n\r\n");
+        std::string responses = read_responses(fd, 2);
+        assert(responses.find("\r\n\r\nv1") != std::string::npos && responses.find("\r\n\r\nv2") != std::string::npos);
+    }
+    assert(linked.static_cache().stats().hits.load() >= 4);
+    assert(linked.static_cache().stats().entries.load() == 2);
+    assert(symlink("release-2", (root + "/next").c_str()) == 0);
+    assert(rename((root + "/next").c_str(), (root + "/current").c_str()) == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    send_raw(fd, "GET /site/app.js HTTP/1.1\r\n\r\n");
+    assert(body_of(read_responses(fd, 1)) == "v2");
+    // 新指向的目录树同样被监视
+    write_file(root + "/release-2/app.js", "v3");
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    send_raw(fd, "GET /site/app.js HTTP/1.1\r\n\r\n");
+    assert(body_of(read_responses(fd, 1)) == "v3");
+    close(fd);
+    linked.stop();
+
+    unlink((root + "/current").c_str());
+    unlink((root + "/release-1/app.js").c_str());
+    unlink((root + "/release-2/app.js").c_str());
+    rmdir((root + "/release-1").c_str());
+    rmdir((root + "/release-2").c_str());
+    unlink((root + "/index.html").c_str());
+    rmdir((root + "/js").c_str());
+    rmdir(root.c_str());
+    std::cout << "Static cache test passed!" << std::endl;
+}
+
+void test_conditional_get() {
+    std::cout << "Testing conditional GET..." << std::endl;
+
+    char dir_template[] = "/tmp/xkoj_cond_XXXXXX";
+    std::string root = mkdtemp(dir_template);
+    {
+        std::ofstream out(root + "/app.css", std::ios::binary);
+        out << "body { color: #333; }";
+    }
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9979);
+    config.enable_logging = false;
+
+    HttpServer server(config);
+    server.static_files("/static", root);
+    server.get("/download", [&root](const HttpRequest&, HttpResponse& res) {
+        res.file(root + "/app.css");
+    });
+    server.get("/api/problem", [](const HttpRequest&, HttpResponse& res) {
+        res.json("{\"id\":1}");
+        res.set_header("ETag", "\"rev-7\"");
+    });
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    auto header_of = [](const std::string& response, const std::string& name) {
+        size_t pos = response.find("\r\n" + name + ": ");
+        assert(pos != std::string::npos);
+        pos += name.size() + 4;
+        return response.substr(pos, response.find("\r\n", pos) - pos);
+    };
+    auto request = [](int fd, const std::string& path, const std::string& headers) {
+        send_raw(fd, "GET " + path + " HTTP/1.1\r\n" + headers + "\r\n");
+        std::string data;
+        assert(read_until(fd, data, "\r\n\r\n"));
+        return data;
+    };
+    int fd = connect_to_server(config.port);
+    send_raw(fd, "GET /static/app.css HTTP/1.1\r\n\r\n");
+    std::string response = read_responses(fd, 1);
+    assert(response.find("HTTP/1.1 200") == 0);
+    std::string etag = header_of(response, "Etag");
+    std::string last_modified = header_of(response, "Last-Modified");
+
+    // 304没有响应体，连接保持可用；静态文件缓存命中与未命中时的校验器相同
+    for (int i = 0; i < 2; ++i) {
+        response = request(fd, "/static/app.css", "If-None-Match: " + etag + "\r\n");
+        assert(response.find("HTTP/1.1 304 Not Modified\r\n") == 0);
+        assert(response.find("Content-Length") == std::string::npos);
+        assert(header_of(response, "Etag") == etag);
+    }
+    response = request(fd, "/static/app.css", "If-Modified-Since: " + last_modified + "\r\n");
+    assert(response.find("HTTP/1.1 304") == 0);
+    response = request(fd, "/download", "If-None-Match: " + etag + "\r\n");
+    assert(response.find("HTTP/1.1 304") == 0);
+    response = request(fd, "/api/problem", "If-None-Match: \"rev-7\"\r\n");
+    assert(response.find("HTTP/1.1 304") == 0);
+    send_raw(fd, "GET /static/app.css HTTP/1.1\r\nIf-Match: \"other\"\r\n\r\n");
+    assert(read_responses(fd, 1).find("HTTP/1.1 412") == 0);
+
+    // 文件变化后旧的校验器失效
+    {
+        std::ofstream out(root + "/app.css", std::ios::binary | std::ios::trunc);
+        out << "body { color: #000; margin: 0; }";
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    send_raw(fd, "GET /static/app.css HTTP/1.1\r\nIf-None-Match: " + etag + "\r\n\r\n");
+    response = read_responses(fd, 1);
+    assert(response.find("HTTP/1.1 200") == 0 && header_of(response, "Etag") != etag);
+    assert(response.find("margin: 0;") != std::string::npos);
+    close(fd);
+
+    server.stop();
+    unlink((root + "/app.css").c_str());
+    rmdir(root.c_str());
+    std::cout << "Conditional GET test passed!" << std::endl;
+}
+
+void test_range_requests() {
+    std::cout << "Testing Range requests..." << std::endl;
+
+    char dir_template[] = "/tmp/xkoj_range_XXXXXX";
+    std::string root = mkdtemp(dir_template);
+    std::string content;
+    for (int i = 0; content.size() < 200000; ++i) {
+        content += "case " + std::to_string(i) + ": " + std::to_string(i * 7919 % 100003) + "\n";
+    }
+    {
+        std::ofstream out(root + "/testdata.txt", std::ios::binary);
+        out << content;
+    }
+    const std::string total = std::to_string(content.size());
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9978);
+    config.enable_logging = false;
+
+    HttpServer server(config);
+    server.static_files("/static", root);
+    server.get("/admin/testdata", [&root](const HttpRequest&, HttpResponse& res) {
+        res.download(root + "/testdata.txt", "p1001.txt");
+    });
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    auto body_of = [](const std::string& response) {
+        return response.substr(response.find("\r\n\r\n") + 4);
+    };
+    int fd = connect_to_server(config.port);
+    send_raw(fd, "GET /admin/testdata HTTP/1.1\r\n\r\n");
+    std::string response = read_responses(fd, 1);
+    assert(response.find("HTTP/1.1 200") == 0 && response.find("Accept-Ranges: bytes\r\n") != std::string::npos);
+    assert(response.find("Content-Disposition: attachment; filename=\"p1001.txt\"\r\n") != std::string::npos);
+    assert(body_of(response) == content);
+    std::string etag = response.substr(response.find("Etag: ") + 6);
+    etag = etag.substr(0, etag.find("\r\n"));
+
+    // 文件响应体（sendfile）与静态文件缓存中的内容分别截取区间
+    for (const char* path : {"/admin/testdata", "/static/testdata.txt", "/static/testdata.txt"}) {
+        send_raw(fd, std::string("GET ") + path + " HTTP/1.1\r\nRange: bytes=1000-1999\r\n\r\n");
+        response = read_responses(fd, 1);
+        assert(response.find("HTTP/1.1 206 Partial Content\r\n") == 0);
+        assert(response.find("Content-Range: bytes 1000-1999/" + total + "\r\n") != std::string::npos);
+        assert(body_of(response) == content.substr(1000, 1000));
+    }
+    send_raw(fd, "GET /admin/testdata HTTP/1.1\r\nRange: bytes=150000-\r\n\r\n");
+    assert(body_of(read_responses(fd, 1)) == content.substr(150000));
+    send_raw(fd, "GET /admin/testdata HTTP/1.1\r\nRange: bytes=" + total + "-\r\n\r\n");
+    response = read_responses(fd, 1);
+    assert(response.find("HTTP/1.1 416") == 0 && response.find("Content-Range: bytes */" + total) != std::string::npos);
+
+    // 续传时文件已变化：If-Range不匹配，发送完整内容
+    send_raw(fd, "GET /admin/testdata HTTP/1.1\r\nRange: bytes=0-9\r\nIf-Range: " + etag + "\r\n\r\n");
+    assert(body_of(read_responses(fd, 1)) == content.substr(0, 10));
+    send_raw(fd, "GET /admin/testdata HTTP/1.1\r\nRange: bytes=0-9\r\nIf-Range: \"stale\"\r\n\r\n");
+    response = read_responses(fd, 1);
+    assert(response.find("HTTP/1.1 200") == 0 && body_of(response) == content);
+
+    // 多区间：各段的文件内容仍以sendfile发送
+    send_raw(fd, "GET /admin/testdata HTTP/1.1\r\nRange: bytes=0-99, 100000-100099, -10\r\n\r\n");
+    response = read_responses(fd, 1);
+    assert(response.find("HTTP/1.1 206") == 0);
+    size_t pos = response.find("boundary=");
+    assert(pos != std::string::npos);
+    std::string boundary = response.substr(pos + 9, response.find("\r\n", pos) - pos - 9);
+    std::string body = body_of(response);
+    assert(body.find("Content-Range: bytes 0-99/" + total + "\r\n\r\n" + content.substr(0, 100) + "\r\n--" +
+                     boundary + "\r\n") != std::string::npos);
+    assert(body.find("Content-Range: bytes 100000-100099/" + total + "\r\n\r\n" + content.substr(100000, 100)) !=
+           std::string::npos);
+    assert(body.find(content.substr(content.size() - 10) + "\r\n--" + boundary + "--\r\n") ==
+           body.size() - 10 - boundary.size() - 8);
+    close(fd);
+
+    server.stop();
+    unlink((root + "/testdata.txt").c_str());
+    rmdir(root.c_str());
+    std::cout << "Range request test passed!" << std::endl;
+}
+
+void test_routing() {
+    std::cout << "Testing route matching..." << std::endl;
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9977);
+    config.enable_logging = false;
+
+    HttpServer server(config);
+    server.get("/api/problems/:id", [](const HttpRequest& req, HttpResponse& res) {
+        res.text("problem " + req.get_path_param("id"));
+    });
+    server.get("/api/problems/random", [](const HttpRequest&, HttpResponse& res) {
+        res.text("random");
+    });
+    server.get("/api/contests/:cid/problems/:pid", [](const HttpRequest& req, HttpResponse& res) {
+        res.text(std::string(req.path_param("cid")) + "/" + std::string(req.path_param("pid")));
+    });
+    server.post("/api/problems/:id", [](const HttpRequest& req, HttpResponse& res) {
+        res.text("updated " + req.get_path_param("id"));
+    });
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    auto body_of = [](const std::string& response) {
+        return response.substr(response.find("\r\n\r\n") + 4);
+    };
+    int fd = connect_to_server(config.port);
+    const std::pair<std::string, std::string> cases[] = {
+        {"GET /api/problems/1001?lang=cpp", "problem 1001"},
+        {"GET /api/problems/random", "random"},
+        {"GET /api/contests/12/problems/C", "12/C"},
+        {"POST /api/problems/7", "updated 7"},
+    };
+    for (const auto& [request_line, expected] : cases) {
+        send_raw(fd, request_line + " HTTP/1.1\r\nContent-Length: 0\r\n\r\n");
+        assert(body_of(read_responses(fd, 1)) == expected);
+    }
+    send_raw(fd, "GET /api/problems/1/extra HTTP/1.1\r\n\r\n");
+    assert(read_responses(fd, 1).find("HTTP/1.1 404") == 0);
+    close(fd);
+
+    server.stop();
+    std::cout << "Routing test passed!" << std::endl;
+}
+
+void test_method_dispatch() {
+    std::cout << "Testing 405, HEAD and OPTIONS dispatch..." << std::endl;
+
+    char dir_template[] = "/tmp/xkoj_dispatch_XXXXXX";
+    std::string root = mkdtemp(dir_template);
+    std::ofstream(root + "/index.html") << "static";
+
+    HttpServer::ServerConfig config;
+    config.io_backend = g_io_backend;
+    config.port = test_port(9976);
+    config.enable_logging = false;
+
+    HttpServer server(config);
+    std::atomic<int> get_calls{0};
+    server.get("/api/problems/:id", [&get_calls](const HttpRequest& req, HttpResponse& res) {
+        ++get_calls;
+        res.text("problem " + req.get_path_param("id"));
+    });
+    server.post("/api/problems/:id", [](const HttpRequest&, HttpResponse& res) {
+        res.text("updated");
+    });
+    std::string listing;
+    for (int i = 0; listing.size() < 4096; ++i) {
+        listing += "{\"id\":" + std::to_string(i) + ",\"title\":\"A+B Problem\"},";
+    }
+    server.get("/api/problems", [&listing](const HttpRequest&, HttpResponse& res) {
+        res.json(listing);
+        res.set_etag("\"list-1\"");
+    });
+    server.put("/api/status", [](const HttpRequest&, HttpResponse& res) {
+        res.text("put");
+    });
+    server.options("/api/status", [](const HttpRequest&, HttpResponse& res) {
+        res.set_header("Allow", "PUT, OPTIONS");
+        res.text("custom");
+    });
+    server.static_files("/api/docs", root);
+    assert(server.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    int fd = connect_to_server(config.port);
+    // HEAD使用GET的处理器，头部相同但不发送响应体，后续的流水线响应紧随其后
+    send_raw(fd, "HEAD /api/problems/42 HTTP/1.1\r\n\r\nGET /api/problems/42 HTTP/1.1\r\n\r\n");
+    std::string data = read_responses(fd, 2);
+    size_t head_end = data.find("\r\n\r\n");
+    assert(data.find("HTTP/1.1 200") == 0 && data.find("Content-Length: 10\r\n") < head_end);
+    assert(data.compare(head_end + 4, 12, "HTTP/1.1 200") == 0);
+    assert(data.substr(data.size() - 10) == "problem 42");
+    assert(get_calls.load() == 2);
+
+#ifdef XKOJ_HAVE_ZLIB
+    // 可压缩的响应：HEAD的Content-Length、Content-Encoding、Vary与ETag都与GET相同
+    send_raw(fd, "HEAD /api/problems HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n"
+                 "GET /api/problems HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n");
+    data = read_responses(fd, 2);
+    head_end = data.find("\r\n\r\n");
+    size_t get_start = head_end + 4;
+    assert(data.compare(get_start, 12, "HTTP/1.1 200") == 0);
+    size_t get_end = data.find("\r\n\r\n", get_start);
+    auto header_of = [&data](size_t begin, size_t end, const std::string& name) {
+        size_t pos = data.find("\r\n" + name + ": ", begin);
+        if (pos == std::string::npos || pos >= end) {
+            return std::string();
+        }
+        pos += name.size() + 4;
+        return data.substr(pos, data.find("\r\n", pos) - pos);
+    };
+    for (const char* name : {"Content-Length", "Content-Encoding", "Vary", "Etag"}) {
+        assert(header_of(0, head_end, name) == header_of(get_start, get_end, name));
+    }
+    assert(header_of(0, head_end, "Content-Encoding") == "gzip");
+    assert(header_of(0, head_end, "Etag") == "W/\"list-1\"");
+    assert(std::stoul(header_of(0, head_end, "Content-Length")) < listing.size());
+    assert(data.size() - get_end - 4 == std::stoul(header_of(get_start, get_end, "Content-Length")));
+#endif
+
+    // 路径已注册但方法未注册：405并列出允许的方法，不落到静态文件
+    send_raw(fd, "DELETE /api/problems/42 HTTP/1.1\r\n\r\n");
+    data = read_responses(fd, 1);
+    assert(data.find("HTTP/1.1 405") == 0);
+    assert(data.find("Allow: GET, POST, OPTIONS, HEAD\r\n") != std::string::npos);
+
+    // 未单独注册的OPTIONS由路由表应答
+    send_raw(fd, "OPTIONS /api/problems/42 HTTP/1.1\r\n\r\n");
+    data.clear();
+    assert(read_until(fd, data, "\r\n\r\n"));
+    assert(data.find("HTTP/1.1 204") == 0);
+    assert(data.find("Allow: GET, POST, OPTIONS, HEAD\r\n") != std::string::npos);
+    assert(data.find("Content-Type") == std::string::npos);
+
+    // 注册了OPTIONS的路径交给处理器；没有GET的路径HEAD同样是405
+    send_raw(fd, "OPTIONS /api/status HTTP/1.1\r\n\r\n");
+    data = read_responses(fd, 1);
+    assert(data.find("Allow: PUT, OPTIONS\r\n") != std::string::npos && data.find("custom") != std::string::npos);
+    send_raw(fd, "HEAD /api/status HTTP/1.1\r\n\r\n");
+    data.clear();
+    assert(read_until(fd, data, "\r\n\r\n"));
+    assert(data.find("HTTP/1.1 405") == 0 && data.find("Allow: PUT, OPTIONS\r\n") != std::string::npos);
+
+    // 未注册的路径仍由静态文件处理，HEAD同样不发送文件内容
+    send_raw(fd, "HEAD /api/docs/ HTTP/1.1\r\n\r\nGET /api/docs/ HTTP/1.1\r\n\r\n");
+    data = read_responses(fd, 2);
+    head_end = data.find("\r\n\r\n");
+    assert(data.find("HTTP/1.1 200") == 0 && data.find("Content-Length: 6\r\n") < head_end);
+    assert(data.compare(head_end + 4, 12, "HTTP/1.1 200") == 0);
+    assert(data.substr(data.size() - 6) == "static");
+    close(fd);
+
+    server.stop();
+    unlink((root + "/index.html").c_str());
+    rmdir(root.c_str());
+    std::cout << "Method dispatch test passed!" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        g_io_backend = argv[1];
+    }
+    std::cout << "I/O backend: " << g_io_backend << std::endl;
     try {
         test_request_parsing();
         test_response_generation();
         test_basic_functionality();
+        test_partial_requests();
+        test_pipelining();
+        test_slow_reader();
+        test_static_file();
+        test_timeouts();
+        test_single_owner();
+        test_listeners();
+        test_admission_control();
+        test_hot_restart();
+        test_streaming_body();
+        test_streaming_response();
+        test_server_sent_events();
+        test_websocket();
+        test_http2();
+        test_compression();
+        test_static_cache();
+        test_conditional_get();
+        test_range_requests();
+        test_routing();
+        test_method_dispatch();
         
         std::cout << "\nAll tests passed successfully!" << std::endl;
         return 0;
@@ -0,0 +1,79 @@
+#include "core/timer_wheel.h"
+#include <iostream>
+#include <cassert>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+void test_expiry_order() {
+    std::cout << "Testing timer expiry across levels..." << std::endl;
+
+    TimerWheel<int> wheel;
+    wheel.reset(1000);
+    // 覆盖第0层、第1层、第2层以及截断到最高层的定时器
+    std::vector<uint64_t> deadlines = {1001, 1005, 1063, 1064, 1100, 5095, 5096, 300000};
+    for (size_t i = 0; i < deadlines.size(); ++i) {
+        wheel.schedule(deadlines[i], static_cast<int>(i));
+    }
+    assert(wheel.size() == deadlines.size());
+
+    std::vector<std::pair<uint64_t, int>> fired;
+    for (uint64_t now = 1000; now <= 300000; now += 7) {
+        wheel.advance(now, [&](int& value, uint64_t expire) {
+            // 到期时刻不早于截止时间，且误差不超过一次推进的步长
+            assert(expire <= now);
+            assert(now - expire < 7);
+            fired.emplace_back(expire, value);
+        });
+    }
+    wheel.advance(300000, [&](int& value, uint64_t expire) {
+        fired.emplace_back(expire, value);
+    });
+    assert(fired.size() == deadlines.size());
+    for (size_t i = 0; i < fired.size(); ++i) {
+        assert(fired[i].first == deadlines[i]);
+        assert(fired[i].second == static_cast<int>(i));
+    }
+    assert(wheel.size() == 0);
+
+    std::cout << "Expiry order test passed!" << std::endl;
+}
+
+void test_random_deadlines() {
+    std::cout << "Testing random deadlines..." << std::endl;
+
+    TimerWheel<uint64_t> wheel;
+    wheel.reset(0);
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> expected;
+    for (int i = 0; i < 10000; ++i) {
+        uint64_t deadline = 1 + rng() % 100000;
+        expected.push_back(deadline);
+        wheel.schedule(deadline, deadline);
+    }
+    std::vector<uint64_t> fired;
+    for (uint64_t now = 1; now <= 100000; ++now) {
+        wheel.advance(now, [&](uint64_t& value, uint64_t expire) {
+            assert(value == expire && expire == now);
+            fired.push_back(value);
+        });
+    }
+    std::sort(expected.begin(), expected.end());
+    assert(fired == expected);
+
+    // 已过期的截止时间在下一个tick触发
+    wheel.schedule(50, 50);
+    bool late_fired = false;
+    wheel.advance(100001, [&](uint64_t&, uint64_t) { late_fired = true; });
+    assert(late_fired);
+
+    std::cout << "Random deadlines test passed!" << std::endl;
+}
+
+int main() {
+    test_expiry_order();
+    test_random_deadlines();
+
+    std::cout << "\nAll tests passed successfully!" << std::endl;
+    return 0;
+}